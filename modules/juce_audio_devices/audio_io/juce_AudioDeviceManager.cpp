@@ -728,6 +728,8 @@ void AudioDeviceManager::audioDeviceIOCallbackInt (const float** inputChannelDat
         const double msTaken = Time::getMillisecondCounterHiRes() - callbackStartTime;
         const double filterAmount = 0.2;
         cpuUsageMs += filterAmount * (msTaken - cpuUsageMs);
+
+        callbackTiming.addMeasurement (Time::secondsToHighResolutionTicks (msTaken * 0.001));
     }
     else
     {
@@ -753,6 +755,7 @@ void AudioDeviceManager::audioDeviceIOCallbackInt (const float** inputChannelDat
 void AudioDeviceManager::audioDeviceAboutToStartInt (AudioIODevice* const device)
 {
     cpuUsageMs = 0;
+    callbackTiming.reset();
 
     const double sampleRate = device->getCurrentSampleRate();
     const int blockSize = device->getCurrentBufferSizeSamples();
@@ -795,6 +798,13 @@ double AudioDeviceManager::getCpuUsage() const
     return jlimit (0.0, 1.0, timeToCpuScale * cpuUsageMs);
 }
 
+TimingHistory::Statistics AudioDeviceManager::getCpuUsageStatistics() const
+{
+    const double secondsPerBlock = timeToCpuScale > 0 ? 0.001 / timeToCpuScale : 0.0;
+
+    return callbackTiming.getStatistics().getAsProportionOf (secondsPerBlock);
+}
+
 //==============================================================================
 void AudioDeviceManager::setMidiInputEnabled (const String& name, const bool enabled)
 {
@@ -308,6 +308,15 @@ public:
     */
     double getCpuUsage() const;
 
+    /** Returns statistics about the load of the most recent audio callbacks.
+
+        Each duration is given as a proportion of the length of an audio block, so a
+        value of 1.0 means that the callbacks used all of the time that was available.
+        Whereas getCpuUsage() is a smoothed average, this also gives the worst case and
+        the percentiles, which are what tell you whether you're in danger of glitching.
+    */
+    TimingHistory::Statistics getCpuUsageStatistics() const;
+
     //==============================================================================
     /** Enables or disables a midi input device.
 
@@ -475,6 +484,7 @@ private:
     CriticalSection audioCallbackLock, midiCallbackLock;
 
     double cpuUsageMs, timeToCpuScale;
+    TimingHistory callbackTiming;
 
     //==============================================================================
     class CallbackHandler;
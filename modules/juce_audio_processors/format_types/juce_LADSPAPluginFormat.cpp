@@ -119,8 +119,8 @@ class LADSPAPluginInstance     : public AudioPluginInstance
 {
 public:
     LADSPAPluginInstance (const LADSPAModuleHandle::Ptr& m)
-        : plugin (nullptr), handle (nullptr), initialised (false),
-          tempBuffer (1, 1), module (m)
+        : module (m), plugin (nullptr), handle (nullptr), initialised (false),
+          tempBuffer (1, 1), samplesPerRun (1), lastAppliedParameterChange (-1)
     {
         ++insideLADSPACallback;
 
@@ -155,8 +155,6 @@ public:
 
     ~LADSPAPluginInstance()
     {
-        const ScopedLock sl (lock);
-
         jassert (insideLADSPACallback == 0);
 
         if (handle != nullptr && plugin != nullptr && plugin->cleanup != nullptr)
@@ -196,15 +194,22 @@ public:
         }
 
         parameterValues.calloc (parameters.size());
+        controlPortValues.calloc (parameters.size());
 
+        // The control ports stay bound to the same memory for the life of the instance. The
+        // audio ports are connected lazily by connectAudioPort(), so clear the record of them..
         for (int i = 0; i < parameters.size(); ++i)
-            plugin->connect_port (handle, parameters[i], &(parameterValues[i].scaled));
+            plugin->connect_port (handle, parameters[i], controlPortValues + i);
+
+        connectedPorts.insertMultiple (0, nullptr, (int) plugin->PortCount);
 
         setPlayConfigDetails (inputs.size(), outputs.size(),
                               getSampleRate() > 0 ? getSampleRate() : 44100.0f,
                               getBlockSize() > 0  ? getBlockSize() : 512);
 
+        prepareBuffers (getBlockSize());
         setCurrentProgram (0);
+        applyParameterChanges();
         setLatencySamples (0);
 
         // Some plugins crash if this doesn't happen:
@@ -267,7 +272,7 @@ public:
 
         if (initialised)
         {
-            tempBuffer.setSize (jmax (1, outputs.size()), samplesPerBlockExpected);
+            prepareBuffers (samplesPerBlockExpected);
 
             // dodgy hack to force some plugins to initialise the sample rate..
             if (getNumParameters() > 0)
@@ -277,6 +282,8 @@ public:
                 setParameter (0, old);
             }
 
+            applyParameterChanges();
+
             if (plugin->activate != nullptr)
                 plugin->activate (handle);
         }
@@ -286,8 +293,6 @@ public:
     {
         if (handle != nullptr && plugin->deactivate != nullptr)
             plugin->deactivate (handle);
-
-        tempBuffer.setSize (1, 1);
     }
 
     void processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
@@ -296,33 +301,13 @@ public:
 
         if (initialised && plugin != nullptr && handle != nullptr)
         {
-            for (int i = 0; i < inputs.size(); ++i)
-                plugin->connect_port (handle, inputs[i],
-                                      i < buffer.getNumChannels() ? buffer.getSampleData (i) : nullptr);
-
-            if (plugin->run != nullptr)
+            if (plugin->run != nullptr || plugin->run_adding != nullptr)
             {
-                for (int i = 0; i < outputs.size(); ++i)
-                    plugin->connect_port (handle, outputs.getUnchecked(i),
-                                          i < buffer.getNumChannels() ? buffer.getSampleData (i) : nullptr);
-
-                plugin->run (handle, numSamples);
-                return;
-            }
-
-            if (plugin->run_adding != nullptr)
-            {
-                tempBuffer.setSize (outputs.size(), numSamples);
-                tempBuffer.clear();
-
-                for (int i = 0; i < outputs.size(); ++i)
-                    plugin->connect_port (handle, outputs.getUnchecked(i), tempBuffer.getSampleData (i));
-
-                plugin->run_adding (handle, numSamples);
-
-                for (int i = 0; i < outputs.size(); ++i)
-                    if (i < buffer.getNumChannels())
-                        buffer.copyFrom (i, 0, tempBuffer, i, 0, numSamples);
+                for (int start = 0; start < numSamples; start += samplesPerRun)
+                {
+                    applyParameterChanges();
+                    processSubBlock (buffer, start, jmin (samplesPerRun, numSamples - start));
+                }
 
                 return;
             }
@@ -365,10 +350,7 @@ public:
     float getParameter (int index)
     {
         if (plugin != nullptr && isPositiveAndBelow (index, parameters.size()))
-        {
-            const ScopedLock sl (lock);
-            return parameterValues[index].unscaled;
-        }
+            return parameterValues[index].unscaled.get();
 
         return 0.0f;
     }
@@ -377,12 +359,13 @@ public:
     {
         if (plugin != nullptr && isPositiveAndBelow (index, parameters.size()))
         {
-            const ScopedLock sl (lock);
+            AtomicParameterValue& p = parameterValues[index];
 
-            ParameterValue& p = parameterValues[index];
-
-            if (p.unscaled != newValue)
-                p = ParameterValue (getNewParamScaled (plugin->PortRangeHints [parameters[index]], newValue), newValue);
+            if (p.unscaled.get() != newValue)
+            {
+                p.set (ParameterValue (getNewParamScaled (plugin->PortRangeHints [parameters[index]], newValue), newValue));
+                ++parameterChangeCount;
+            }
         }
     }
 
@@ -405,10 +388,12 @@ public:
 
             const LADSPA_PortRangeHint& hint = plugin->PortRangeHints [parameters [index]];
 
+            const float scaled = parameterValues[index].scaled.get();
+
             if (LADSPA_IS_HINT_INTEGER (hint.HintDescriptor))
-                return String ((int) parameterValues[index].scaled);
+                return String ((int) scaled);
 
-            return String (parameterValues[index].scaled, 4);
+            return String (scaled, 4);
         }
 
         return String::empty;
@@ -421,8 +406,12 @@ public:
     void setCurrentProgram (int newIndex)
     {
         if (plugin != nullptr)
+        {
             for (int i = 0; i < parameters.size(); ++i)
-                parameterValues[i] = getParamValue (plugin->PortRangeHints [parameters[i]]);
+                parameterValues[i].set (getParamValue (plugin->PortRangeHints [parameters[i]]));
+
+            ++parameterChangeCount;
+        }
     }
 
     const String getProgramName (int index)
@@ -484,12 +473,15 @@ public:
     const LADSPA_Descriptor* plugin;
 
 private:
+    enum { maxSamplesPerRun = 1024 };
+
     LADSPA_Handle handle;
     String name;
-    CriticalSection lock;
     bool initialised;
     AudioSampleBuffer tempBuffer;
+    int samplesPerRun;
     Array<int> inputs, outputs, parameters;
+    Array<float*> connectedPorts;
 
     struct ParameterValue
     {
@@ -499,7 +491,105 @@ private:
         float scaled, unscaled;
     };
 
-    HeapBlock<ParameterValue> parameterValues;
+    // Written by setParameter() on any thread, and copied into controlPortValues by the
+    // audio thread at the start of each run, so that the plugin never sees a torn update.
+    struct AtomicParameterValue
+    {
+        void set (const ParameterValue& v) noexcept     { scaled.set (v.scaled); unscaled.set (v.unscaled); }
+
+        Atomic<float> scaled, unscaled;
+    };
+
+    HeapBlock<AtomicParameterValue> parameterValues;
+    HeapBlock<LADSPA_Data> controlPortValues;
+    Atomic<int> parameterChangeCount;
+    int lastAppliedParameterChange;
+
+    //==============================================================================
+    void prepareBuffers (const int samplesPerBlockExpected)
+    {
+        // Blocks bigger than this get split up, so that parameter changes still take
+        // effect promptly, and so that the scratch buffer never needs to be resized
+        // on the audio thread..
+        samplesPerRun = jlimit (1, (int) maxSamplesPerRun, samplesPerBlockExpected);
+        tempBuffer.setSize (jmax (1, inputs.size() + outputs.size()), samplesPerRun);
+
+        // ..and as the scratch buffer may have moved, any ports using it must be reconnected.
+        for (int i = connectedPorts.size(); --i >= 0;)
+            connectedPorts.setUnchecked (i, nullptr);
+    }
+
+    void applyParameterChanges() noexcept
+    {
+        const int changeCount = parameterChangeCount.get();
+
+        if (changeCount != lastAppliedParameterChange)
+        {
+            lastAppliedParameterChange = changeCount;
+
+            for (int i = 0; i < parameters.size(); ++i)
+                controlPortValues[i] = parameterValues[i].scaled.get();
+        }
+    }
+
+    void connectAudioPort (const int port, float* const data) noexcept
+    {
+        // Only calls connect_port when the buffer actually moves, which for a graph that
+        // keeps using the same rendering buffers means it's only done once.
+        if (connectedPorts.getUnchecked (port) != data)
+        {
+            connectedPorts.setUnchecked (port, data);
+            plugin->connect_port (handle, (unsigned long) port, data);
+        }
+    }
+
+    void processSubBlock (AudioSampleBuffer& buffer, const int start, const int numSamples)
+    {
+        const int numChannels = buffer.getNumChannels();
+        // When run_adding() is used the outputs go to the scratch buffer, so the inputs
+        // can always be read directly from the host's buffer..
+        const bool inputsCanShareOutputs = plugin->run == nullptr
+                                            || ! LADSPA_IS_INPLACE_BROKEN (plugin->Properties);
+
+        for (int i = 0; i < inputs.size(); ++i)
+        {
+            float* data = tempBuffer.getSampleData (i);
+
+            if (i >= numChannels)
+                tempBuffer.clear (i, 0, numSamples);  // no input data, so give it silence
+            else if (inputsCanShareOutputs || i >= outputs.size())
+                data = buffer.getSampleData (i, start);
+            else
+                tempBuffer.copyFrom (i, 0, buffer, i, start, numSamples);
+
+            connectAudioPort (inputs.getUnchecked(i), data);
+        }
+
+        const int firstTempOutput = inputs.size();
+
+        if (plugin->run != nullptr)
+        {
+            for (int i = 0; i < outputs.size(); ++i)
+                connectAudioPort (outputs.getUnchecked(i),
+                                  i < numChannels ? buffer.getSampleData (i, start)
+                                                  : tempBuffer.getSampleData (firstTempOutput + i));
+
+            plugin->run (handle, (unsigned long) numSamples);
+        }
+        else
+        {
+            for (int i = 0; i < outputs.size(); ++i)
+            {
+                tempBuffer.clear (firstTempOutput + i, 0, numSamples);
+                connectAudioPort (outputs.getUnchecked(i), tempBuffer.getSampleData (firstTempOutput + i));
+            }
+
+            plugin->run_adding (handle, (unsigned long) numSamples);
+
+            for (int i = jmin (outputs.size(), numChannels); --i >= 0;)
+                buffer.copyFrom (i, start, tempBuffer, firstTempOutput + i, 0, numSamples);
+        }
+    }
 
     //==============================================================================
     static float scaledValue (float low, float high, float alpha, bool useLog) noexcept
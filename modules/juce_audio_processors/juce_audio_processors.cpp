@@ -85,6 +85,8 @@ static inline bool arrayContainsPlugin (const OwnedArray<PluginDescription>& lis
 #include "format_types/juce_VSTPluginFormat.cpp"
 #include "format_types/juce_AudioUnitPluginFormat.mm"
 #include "scanning/juce_KnownPluginList.cpp"
+#include "scanning/juce_KnownPluginListCache.cpp"
+#include "scanning/juce_ParallelPluginScanner.cpp"
 #include "scanning/juce_PluginDirectoryScanner.cpp"
 #include "scanning/juce_PluginListComponent.cpp"
 // END_AUTOINCLUDE
@@ -109,6 +109,12 @@ namespace juce
 #ifndef __JUCE_KNOWNPLUGINLIST_JUCEHEADER__
  #include "scanning/juce_KnownPluginList.h"
 #endif
+#ifndef __JUCE_KNOWNPLUGINLISTCACHE_JUCEHEADER__
+ #include "scanning/juce_KnownPluginListCache.h"
+#endif
+#ifndef __JUCE_PARALLELPLUGINSCANNER_JUCEHEADER__
+ #include "scanning/juce_ParallelPluginScanner.h"
+#endif
 #ifndef __JUCE_PLUGINDIRECTORYSCANNER_JUCEHEADER__
  #include "scanning/juce_PluginDirectoryScanner.h"
 #endif
@@ -33,13 +33,36 @@ namespace GraphRenderingOps
 class AudioGraphRenderingOp
 {
 public:
-    AudioGraphRenderingOp() {}
+    AudioGraphRenderingOp()  : timing (new Timing()) {}
     virtual ~AudioGraphRenderingOp()  {}
 
     virtual void perform (AudioSampleBuffer& sharedBufferChans,
                           const OwnedArray <MidiBuffer>& sharedMidiBuffers,
                           const int numSamples) = 0;
 
+    virtual String getDescription() const = 0;
+
+    void performAndMeasure (AudioSampleBuffer& sharedBufferChans,
+                            const OwnedArray <MidiBuffer>& sharedMidiBuffers,
+                            const int numSamples)
+    {
+        const int64 startTicks = Time::getHighResolutionTicks();
+        perform (sharedBufferChans, sharedMidiBuffers, numSamples);
+        timing->history.addMeasurement (Time::getHighResolutionTicks() - startTicks);
+    }
+
+    // This is ref-counted so that the statistics can be read without holding
+    // the callback lock, even if the op itself gets deleted in the meantime.
+    struct Timing  : public ReferenceCountedObject
+    {
+        String description;
+        TimingHistory history;
+
+        typedef ReferenceCountedObjectPtr<Timing> Ptr;
+    };
+
+    const Timing::Ptr timing;
+
     JUCE_LEAK_DETECTOR (AudioGraphRenderingOp)
 };
 
@@ -56,6 +79,8 @@ public:
         sharedBufferChans.clear (channelNum, 0, numSamples);
     }
 
+    String getDescription() const       { return "Clear channel " + String (channelNum); }
+
 private:
     const int channelNum;
 
@@ -76,6 +101,8 @@ public:
         sharedBufferChans.copyFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    String getDescription() const       { return "Copy channel " + String (srcChannelNum) + " to " + String (dstChannelNum); }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -96,6 +123,8 @@ public:
         sharedBufferChans.addFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    String getDescription() const       { return "Add channel " + String (srcChannelNum) + " to " + String (dstChannelNum); }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -115,6 +144,8 @@ public:
         sharedMidiBuffers.getUnchecked (bufferNum)->clear();
     }
 
+    String getDescription() const       { return "Clear midi buffer " + String (bufferNum); }
+
 private:
     const int bufferNum;
 
@@ -135,6 +166,8 @@ public:
         *sharedMidiBuffers.getUnchecked (dstBufferNum) = *sharedMidiBuffers.getUnchecked (srcBufferNum);
     }
 
+    String getDescription() const       { return "Copy midi buffer " + String (srcBufferNum) + " to " + String (dstBufferNum); }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -156,6 +189,8 @@ public:
             ->addEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), 0, numSamples, 0);
     }
 
+    String getDescription() const       { return "Add midi buffer " + String (srcBufferNum) + " to " + String (dstBufferNum); }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -188,6 +223,11 @@ public:
         }
     }
 
+    String getDescription() const
+    {
+        return "Delay channel " + String (channel) + " by " + String (bufferSize - 1) + " samples";
+    }
+
 private:
     HeapBlock<float> buffer;
     const int channel, bufferSize;
@@ -201,12 +241,14 @@ private:
 class ProcessBufferOp : public AudioGraphRenderingOp
 {
 public:
-    ProcessBufferOp (const AudioProcessorGraph::Node::Ptr& node_,
+    ProcessBufferOp (const AudioProcessorGraph& graph_,
+                     const AudioProcessorGraph::Node::Ptr& node_,
                      const Array <int>& audioChannelsToUse_,
                      const int totalChans_,
                      const int midiBufferToUse_)
         : node (node_),
           processor (node_->getProcessor()),
+          graph (graph_),
           audioChannelsToUse (audioChannelsToUse_),
           totalChans (jmax (1, totalChans_)),
           midiBufferToUse (midiBufferToUse_)
@@ -224,13 +266,28 @@ public:
 
         AudioSampleBuffer buffer (channels, totalChans, numSamples);
 
-        processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
+        if (graph.isNodeTimingEnabled())
+        {
+            const int64 startTicks = Time::getHighResolutionTicks();
+            processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
+            node->getProcessingTimeHistory().addMeasurement (Time::getHighResolutionTicks() - startTicks);
+        }
+        else
+        {
+            processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
+        }
+    }
+
+    String getDescription() const
+    {
+        return "Process node " + String (node->nodeId) + " (" + processor->getName() + ")";
     }
 
     const AudioProcessorGraph::Node::Ptr node;
     AudioProcessor* const processor;
 
 private:
+    const AudioProcessorGraph& graph;
     Array <int> audioChannelsToUse;
     HeapBlock <float*> channels;
     int totalChans;
@@ -611,7 +668,7 @@ private:
         if (numOuts == 0)
             totalLatency = maxLatency;
 
-        renderingOps.add (new ProcessBufferOp (node, audioChannelsToUse,
+        renderingOps.add (new ProcessBufferOp (graph, node, audioChannelsToUse,
                                                totalChans, midiBufferToUse));
     }
 
@@ -924,6 +981,7 @@ void AudioProcessorGraph::Node::setParentGraph (AudioProcessorGraph* const graph
 //==============================================================================
 AudioProcessorGraph::AudioProcessorGraph()
     : lastNodeId (0),
+      nodeTimingEnabled (false),
       renderingBuffers (1, 1),
       currentAudioOutputBuffer (1, 1)
 {
@@ -1166,6 +1224,41 @@ bool AudioProcessorGraph::removeIllegalConnections()
     return doneAnything;
 }
 
+//==============================================================================
+void AudioProcessorGraph::setNodeTimingEnabled (const bool shouldTimeNodes) noexcept
+{
+    nodeTimingEnabled = shouldTimeNodes;
+}
+
+Array<AudioProcessorGraph::RenderingOpStatistics> AudioProcessorGraph::getRenderingOpStatistics() const
+{
+    typedef GraphRenderingOps::AudioGraphRenderingOp::Timing OpTiming;
+    ReferenceCountedArray<OpTiming> timings;
+
+    {
+        const ScopedLock sl (getCallbackLock());
+
+        timings.ensureStorageAllocated (renderingOps.size());
+
+        for (int i = 0; i < renderingOps.size(); ++i)
+            timings.add (static_cast<GraphRenderingOps::AudioGraphRenderingOp*> (renderingOps.getUnchecked(i))->timing);
+    }
+
+    Array<RenderingOpStatistics> results;
+
+    for (int i = 0; i < timings.size(); ++i)
+    {
+        const OpTiming* const t = timings.getUnchecked(i);
+
+        RenderingOpStatistics s;
+        s.description = t->description;
+        s.timing = t->history.getStatistics();
+        results.add (s);
+    }
+
+    return results;
+}
+
 //==============================================================================
 static void deleteRenderOpArray (Array<void*>& ops)
 {
@@ -1240,6 +1333,14 @@ void AudioProcessorGraph::buildRenderingSequence()
         numMidiBuffersNeeded = calculator.getNumMidiBuffersNeeded();
     }
 
+    for (int i = 0; i < newRenderingOps.size(); ++i)
+    {
+        GraphRenderingOps::AudioGraphRenderingOp* const op
+            = static_cast<GraphRenderingOps::AudioGraphRenderingOp*> (newRenderingOps.getUnchecked(i));
+
+        op->timing->description = op->getDescription();
+    }
+
     {
         // swap over to the new rendering sequence..
         const ScopedLock sl (getCallbackLock());
@@ -1309,12 +1410,25 @@ void AudioProcessorGraph::processBlock (AudioSampleBuffer& buffer, MidiBuffer& m
     currentMidiInputBuffer = &midiMessages;
     currentMidiOutputBuffer.clear();
 
-    for (int i = 0; i < renderingOps.size(); ++i)
+    if (nodeTimingEnabled)
     {
-        GraphRenderingOps::AudioGraphRenderingOp* const op
-            = (GraphRenderingOps::AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
+        for (int i = 0; i < renderingOps.size(); ++i)
+        {
+            GraphRenderingOps::AudioGraphRenderingOp* const op
+                = (GraphRenderingOps::AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
 
-        op->perform (renderingBuffers, midiBuffers, numSamples);
+            op->performAndMeasure (renderingBuffers, midiBuffers, numSamples);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < renderingOps.size(); ++i)
+        {
+            GraphRenderingOps::AudioGraphRenderingOp* const op
+                = (GraphRenderingOps::AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
+
+            op->perform (renderingBuffers, midiBuffers, numSamples);
+        }
     }
 
     for (int i = 0; i < buffer.getNumChannels(); ++i)
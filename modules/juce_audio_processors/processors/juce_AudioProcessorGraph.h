@@ -83,6 +83,26 @@ public:
         */
         NamedValueSet properties;
 
+        //==============================================================================
+        /** Returns the total time, in seconds, that this node's processor has spent
+            inside its processBlock() method.
+
+            Time is only measured while the parent graph has node timing enabled.
+            @see AudioProcessorGraph::setNodeTimingEnabled, resetProcessingTime
+        */
+        double getTotalProcessingTime() const noexcept          { return processingTime.getTotalTime(); }
+
+        /** Resets the node's processing time measurements. */
+        void resetProcessingTime() noexcept                     { processingTime.reset(); }
+
+        /** Returns the history of times taken by this node's processBlock() calls.
+
+            The audio thread adds to this without locking, and its statistics can be read
+            from the message thread while the graph is running.
+            @see AudioProcessorGraph::setNodeTimingEnabled
+        */
+        TimingHistory& getProcessingTimeHistory() noexcept      { return processingTime; }
+
         //==============================================================================
         /** A convenient typedef for referring to a pointer to a node object. */
         typedef ReferenceCountedObjectPtr <Node> Ptr;
@@ -93,6 +113,7 @@ public:
 
         const ScopedPointer<AudioProcessor> processor;
         bool isPrepared;
+        TimingHistory processingTime;
 
         Node (uint32 nodeId, AudioProcessor*) noexcept;
 
@@ -256,6 +277,41 @@ public:
     */
     static const int midiChannelIndex;
 
+    //==============================================================================
+    /** Enables or disables measurement of the time that each node spends processing.
+
+        This is disabled by default. When it's turned on, each node's processBlock() call
+        is timed using the high-resolution counter, and the results can be read with
+        Node::getProcessingTimeHistory(). Each of the steps in the graph's rendering
+        sequence is timed too - see getRenderingOpStatistics().
+    */
+    void setNodeTimingEnabled (bool shouldTimeNodes) noexcept;
+
+    /** Returns true if per-node timing is enabled.
+        @see setNodeTimingEnabled
+    */
+    bool isNodeTimingEnabled() const noexcept                           { return nodeTimingEnabled; }
+
+    /** Describes the time taken by one of the steps in the graph's rendering sequence. */
+    struct RenderingOpStatistics
+    {
+        /** A description of what the step does, e.g. "Process node 3 (Reverb)". */
+        String description;
+
+        /** The times that the step has taken while node timing was enabled. */
+        TimingHistory::Statistics timing;
+    };
+
+    /** Returns timing statistics for each step in the graph's current rendering sequence,
+        in the order in which they're performed.
+
+        This doesn't block the audio thread for any longer than it takes to copy a list
+        of pointers, so it's safe to poll it from a timer while the graph is playing.
+        The timings are only measured while node timing is enabled.
+        @see setNodeTimingEnabled
+    */
+    Array<RenderingOpStatistics> getRenderingOpStatistics() const;
+
 
     //==============================================================================
     /** A special type of AudioProcessor that can live inside an AudioProcessorGraph
@@ -396,6 +452,7 @@ private:
     ReferenceCountedArray <Node> nodes;
     OwnedArray <Connection> connections;
     uint32 lastNodeId;
+    bool nodeTimingEnabled;
     AudioSampleBuffer renderingBuffers;
     OwnedArray <MidiBuffer> midiBuffers;
     Array<void*> renderingOps;
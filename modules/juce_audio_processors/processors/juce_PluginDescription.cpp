@@ -24,7 +24,8 @@
 */
 
 PluginDescription::PluginDescription()
-    : uid (0),
+    : lastFileSize (0),
+      uid (0),
       isInstrument (false),
       numInputChannels (0),
       numOutputChannels (0)
@@ -44,6 +45,7 @@ PluginDescription::PluginDescription (const PluginDescription& other)
       version (other.version),
       fileOrIdentifier (other.fileOrIdentifier),
       lastFileModTime (other.lastFileModTime),
+      lastFileSize (other.lastFileSize),
       uid (other.uid),
       isInstrument (other.isInstrument),
       numInputChannels (other.numInputChannels),
@@ -63,6 +65,7 @@ PluginDescription& PluginDescription::operator= (const PluginDescription& other)
     uid = other.uid;
     isInstrument = other.isInstrument;
     lastFileModTime = other.lastFileModTime;
+    lastFileSize = other.lastFileSize;
     numInputChannels = other.numInputChannels;
     numOutputChannels = other.numOutputChannels;
 
@@ -98,6 +101,10 @@ XmlElement* PluginDescription::createXml() const
     e->setAttribute ("uid", String::toHexString (uid));
     e->setAttribute ("isInstrument", isInstrument);
     e->setAttribute ("fileTime", String::toHexString (lastFileModTime.toMilliseconds()));
+
+    if (lastFileSize != 0)
+        e->setAttribute ("fileSize", String (lastFileSize));
+
     e->setAttribute ("numInputs", numInputChannels);
     e->setAttribute ("numOutputs", numOutputChannels);
 
@@ -118,6 +125,7 @@ bool PluginDescription::loadFromXml (const XmlElement& xml)
         uid                 = xml.getStringAttribute ("uid").getHexValue32();
         isInstrument        = xml.getBoolAttribute ("isInstrument", false);
         lastFileModTime     = Time (xml.getStringAttribute ("fileTime").getHexValue64());
+        lastFileSize        = xml.getStringAttribute ("fileSize").getLargeIntValue();
         numInputChannels    = xml.getIntAttribute ("numInputs");
         numOutputChannels   = xml.getIntAttribute ("numOutputs");
 
@@ -84,6 +84,11 @@ public:
     */
     Time lastFileModTime;
 
+    /** The size of the plugin file when it was last scanned, or 0 if this isn't known.
+        Along with lastFileModTime, this is used to decide whether a file needs rescanning.
+    */
+    int64 lastFileSize;
+
     /** A unique ID for the plugin.
 
         Note that this might not be unique between formats, e.g. a VST and some
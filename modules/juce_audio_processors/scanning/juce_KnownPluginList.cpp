@@ -89,11 +89,25 @@ namespace
         return Time();
     }
 
+    int64 getPluginFileSize (const String& fileOrIdentifier)
+    {
+        if (fileOrIdentifier.startsWithChar ('/') || fileOrIdentifier[1] == ':')
+            return File (fileOrIdentifier).getSize();
+
+        return 0;
+    }
+
     bool timesAreDifferent (const Time& t1, const Time& t2) noexcept
     {
         return t1 != t2 || t1 == Time();
     }
 
+    bool fileHasChanged (const PluginDescription& d)
+    {
+        return timesAreDifferent (d.lastFileModTime, getPluginFileModTime (d.fileOrIdentifier))
+                || (d.lastFileSize != 0 && d.lastFileSize != getPluginFileSize (d.fileOrIdentifier));
+    }
+
     enum { menuIdBase = 0x324503f4 };
 }
 
@@ -106,8 +120,7 @@ bool KnownPluginList::isListingUpToDate (const String& fileOrIdentifier) const
     {
         const PluginDescription* const d = types.getUnchecked(i);
 
-        if (d->fileOrIdentifier == fileOrIdentifier
-             && timesAreDifferent (d->lastFileModTime, getPluginFileModTime (fileOrIdentifier)))
+        if (d->fileOrIdentifier == fileOrIdentifier && fileHasChanged (*d))
         {
             return false;
         }
@@ -139,7 +152,7 @@ bool KnownPluginList::scanAndAddFile (const String& fileOrIdentifier,
 
             if (d->fileOrIdentifier == fileOrIdentifier && d->pluginFormatName == format.getName())
             {
-                if (timesAreDifferent (d->lastFileModTime, getPluginFileModTime (fileOrIdentifier)))
+                if (fileHasChanged (*d))
                     needsRescanning = true;
                 else
                     typesFound.add (new PluginDescription (*d));
@@ -173,6 +186,9 @@ bool KnownPluginList::scanAndAddFile (const String& fileOrIdentifier,
         PluginDescription* const desc = found.getUnchecked(i);
         jassert (desc != nullptr);
 
+        if (desc->lastFileSize == 0)
+            desc->lastFileSize = getPluginFileSize (fileOrIdentifier);
+
         addType (*desc);
         typesFound.add (new PluginDescription (*desc));
     }
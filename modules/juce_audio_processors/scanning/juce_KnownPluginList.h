@@ -203,6 +203,8 @@ private:
     ScopedPointer<CustomScanner> scanner;
     CriticalSection scanLock;
 
+    friend class KnownPluginListCache;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KnownPluginList)
 };
 
@@ -0,0 +1,747 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+namespace KnownPluginListCacheFormat
+{
+    /*  The layout of the data is:
+
+        header:     headerSize bytes, made of the little-endian uint32 fields below
+        types:      numTypes records of typeRecordSize bytes each
+        file index: fileIndexSize uint32 slots
+        id index:   idIndexSize uint32 slots
+        blacklist:  numBlacklisted uint32 string offsets
+        bl index:   blacklistIndexSize uint32 slots
+        strings:    null-terminated UTF-8 strings, referred to by their offset from
+                    the start of this block
+
+        Each index is an open-addressed hash table (with linear probing) whose slots
+        contain either 0 for an empty slot, or the index of the entry + 1.
+    */
+    enum
+    {
+        magicNumber             = 0x434c504a,   // "JPLC"
+        formatVersion           = 1,
+
+        headerSize              = 64,
+        typeRecordSize          = 64,
+
+        // header fields
+        hMagic                  = 0,
+        hVersion                = 4,
+        hNumTypes               = 8,
+        hNumBlacklisted         = 12,
+        hFileIndexSize          = 16,
+        hIdIndexSize            = 20,
+        hBlacklistIndexSize     = 24,
+        hTypesOffset            = 28,
+        hFileIndexOffset        = 32,
+        hIdIndexOffset          = 36,
+        hBlacklistOffset        = 40,
+        hBlacklistIndexOffset   = 44,
+        hStringsOffset          = 48,
+        hStringsSize            = 52,
+        hTotalSize              = 56,
+
+        // type record fields
+        tName                   = 0,
+        tDescriptiveName        = 4,
+        tFormatName             = 8,
+        tCategory               = 12,
+        tManufacturer           = 16,
+        tVersion                = 20,
+        tFileOrIdentifier       = 24,
+        tUid                    = 28,
+        tModTime                = 32,
+        tFileSize               = 40,
+        tNumInputs              = 48,
+        tNumOutputs             = 52,
+        tFlags                  = 56,
+        tFileHash               = 60,
+
+        flagIsInstrument        = 1
+    };
+
+    // This must give the same result on every platform and in every version, so it
+    // uses its own FNV-1a hash of the UTF-8 data rather than String::hashCode().
+    static uint32 hashString (const String& s) noexcept
+    {
+        uint32 h = 2166136261u;
+
+        for (const char* t = s.toUTF8(); *t != 0; ++t)
+            h = (h ^ (uint32) (uint8) *t) * 16777619u;
+
+        return h;
+    }
+
+    static uint32 getIndexSize (const int numItems) noexcept
+    {
+        return (uint32) nextPowerOfTwo (jmax (2, numItems * 2));
+    }
+
+    static bool isValidIndexSize (const uint32 size) noexcept
+    {
+        return size > 0 && isPowerOfTwo (size);
+    }
+
+    static void addToIndex (Array<uint32>& index, const uint32 hash, const int itemIndex)
+    {
+        const uint32 mask = (uint32) index.size() - 1;
+
+        for (uint32 slot = hash & mask;; slot = (slot + 1) & mask)
+        {
+            if (index.getUnchecked ((int) slot) == 0)
+            {
+                index.set ((int) slot, (uint32) itemIndex + 1);
+                break;
+            }
+        }
+    }
+
+    //==============================================================================
+    class StringTable
+    {
+    public:
+        StringTable() : offsets (1031) {}
+
+        uint32 add (const String& s)
+        {
+            if (offsets.contains (s))
+                return (uint32) offsets[s];
+
+            const uint32 offset = (uint32) data.getDataSize();
+            data.write (s.toUTF8(), s.getNumBytesAsUTF8() + 1);
+            offsets.set (s, (int) offset);
+            return offset;
+        }
+
+        MemoryOutputStream data;
+
+    private:
+        HashMap<String, int> offsets;
+    };
+
+    static Time getCurrentFileModTime (const String& fileOrIdentifier)
+    {
+        if (fileOrIdentifier.startsWithChar ('/') || fileOrIdentifier[1] == ':')
+            return File (fileOrIdentifier).getLastModificationTime();
+
+        return Time();
+    }
+
+    static int64 getCurrentFileSize (const String& fileOrIdentifier)
+    {
+        if (fileOrIdentifier.startsWithChar ('/') || fileOrIdentifier[1] == ':')
+            return File (fileOrIdentifier).getSize();
+
+        return 0;
+    }
+}
+
+//==============================================================================
+KnownPluginListCache::KnownPluginListCache (const File& cacheFile)
+    : data (nullptr), dataSize (0)
+{
+    if (cacheFile.existsAsFile())
+    {
+        mappedFile = new MemoryMappedFile (cacheFile, MemoryMappedFile::readOnly);
+        setData (mappedFile->getData(), mappedFile->getSize());
+
+        if (data == nullptr)
+            mappedFile = nullptr;
+    }
+}
+
+KnownPluginListCache::KnownPluginListCache (const void* const cacheData, const size_t cacheDataSize)
+    : data (nullptr), dataSize (0)
+{
+    setData (cacheData, cacheDataSize);
+}
+
+KnownPluginListCache::~KnownPluginListCache()
+{
+}
+
+void KnownPluginListCache::setData (const void* const newData, const size_t newSize)
+{
+    using namespace KnownPluginListCacheFormat;
+
+    data = static_cast <const char*> (newData);
+    dataSize = newSize;
+
+    if (data == nullptr || dataSize < headerSize
+         || readInt (hMagic) != magicNumber
+         || readInt (hVersion) != formatVersion
+         || readInt (hTotalSize) != dataSize)
+    {
+        data = nullptr;
+        dataSize = 0;
+        return;
+    }
+
+    // check that all the blocks are inside the data, so that the lookups don't need to..
+    const uint64 numTypes = readInt (hNumTypes);
+    const uint64 stringsOffset = readInt (hStringsOffset);
+    const uint64 stringsSize = readInt (hStringsSize);
+
+    const bool blockSizesAreOk
+        = readInt (hTypesOffset) + numTypes * typeRecordSize <= dataSize
+           && readInt (hFileIndexOffset) + readInt (hFileIndexSize) * (uint64) 4 <= dataSize
+           && readInt (hIdIndexOffset) + readInt (hIdIndexSize) * (uint64) 4 <= dataSize
+           && readInt (hBlacklistOffset) + readInt (hNumBlacklisted) * (uint64) 4 <= dataSize
+           && readInt (hBlacklistIndexOffset) + readInt (hBlacklistIndexSize) * (uint64) 4 <= dataSize
+           && stringsOffset + stringsSize <= dataSize
+           && stringsSize > 0 && data [stringsOffset + stringsSize - 1] == 0
+           && isValidIndexSize (readInt (hFileIndexSize))
+           && isValidIndexSize (readInt (hIdIndexSize))
+           && isValidIndexSize (readInt (hBlacklistIndexSize));
+
+    if (! blockSizesAreOk)
+    {
+        // corrupt cache data - the caller will need to rescan and rebuild it
+        data = nullptr;
+        dataSize = 0;
+    }
+}
+
+uint32 KnownPluginListCache::readInt (const size_t offset) const noexcept
+{
+    jassert (offset + 4 <= dataSize);
+    return ByteOrder::littleEndianInt (data + offset);
+}
+
+String KnownPluginListCache::readString (const uint32 stringOffset) const
+{
+    using namespace KnownPluginListCacheFormat;
+
+    if (stringOffset >= readInt (hStringsSize))
+    {
+        jassertfalse;
+        return String::empty;
+    }
+
+    return String::fromUTF8 (data + readInt (hStringsOffset) + stringOffset);
+}
+
+size_t KnownPluginListCache::getTypeOffset (const int index) const noexcept
+{
+    using namespace KnownPluginListCacheFormat;
+    return readInt (hTypesOffset) + (size_t) index * typeRecordSize;
+}
+
+String KnownPluginListCache::getFileOrIdentifier (const int index) const
+{
+    return readString (readInt (getTypeOffset (index) + KnownPluginListCacheFormat::tFileOrIdentifier));
+}
+
+void KnownPluginListCache::readType (const int index, PluginDescription& d) const
+{
+    using namespace KnownPluginListCacheFormat;
+    const size_t r = getTypeOffset (index);
+
+    d.name              = readString (readInt (r + tName));
+    d.descriptiveName   = readString (readInt (r + tDescriptiveName));
+    d.pluginFormatName  = readString (readInt (r + tFormatName));
+    d.category          = readString (readInt (r + tCategory));
+    d.manufacturerName  = readString (readInt (r + tManufacturer));
+    d.version           = readString (readInt (r + tVersion));
+    d.fileOrIdentifier  = readString (readInt (r + tFileOrIdentifier));
+    d.uid               = (int) readInt (r + tUid);
+    d.lastFileModTime   = Time ((int64) (readInt (r + tModTime) | (((uint64) readInt (r + tModTime + 4)) << 32)));
+    d.lastFileSize      = (int64) (readInt (r + tFileSize) | (((uint64) readInt (r + tFileSize + 4)) << 32));
+    d.numInputChannels  = (int) readInt (r + tNumInputs);
+    d.numOutputChannels = (int) readInt (r + tNumOutputs);
+    d.isInstrument      = (readInt (r + tFlags) & flagIsInstrument) != 0;
+}
+
+//==============================================================================
+int KnownPluginListCache::getNumTypes() const noexcept
+{
+    return isValid() ? (int) readInt (KnownPluginListCacheFormat::hNumTypes) : 0;
+}
+
+bool KnownPluginListCache::getType (const int index, PluginDescription& result) const
+{
+    if (! isPositiveAndBelow (index, getNumTypes()))
+        return false;
+
+    readType (index, result);
+    return true;
+}
+
+int KnownPluginListCache::getTypesForFile (const String& fileOrIdentifier,
+                                           OwnedArray <PluginDescription>& results) const
+{
+    using namespace KnownPluginListCacheFormat;
+
+    if (! isValid())
+        return 0;
+
+    const uint32 hash = hashString (fileOrIdentifier);
+    const uint32 mask = readInt (hFileIndexSize) - 1;
+    const size_t indexOffset = readInt (hFileIndexOffset);
+    const int numTypes = getNumTypes();
+    int numFound = 0;
+
+    for (uint32 slot = hash & mask, n = 0; n <= mask; slot = (slot + 1) & mask, ++n)
+    {
+        const int index = (int) readInt (indexOffset + slot * 4) - 1;
+
+        if (! isPositiveAndBelow (index, numTypes))
+            break;
+
+        if (readInt (getTypeOffset (index) + tFileHash) == hash
+             && getFileOrIdentifier (index) == fileOrIdentifier)
+        {
+            PluginDescription* const d = new PluginDescription();
+            readType (index, *d);
+            results.add (d);
+            ++numFound;
+        }
+    }
+
+    return numFound;
+}
+
+bool KnownPluginListCache::getTypeForIdentifierString (const String& identifierString,
+                                                       PluginDescription& result) const
+{
+    using namespace KnownPluginListCacheFormat;
+
+    if (! isValid())
+        return false;
+
+    const uint32 mask = readInt (hIdIndexSize) - 1;
+    const size_t indexOffset = readInt (hIdIndexOffset);
+    const int numTypes = getNumTypes();
+
+    for (uint32 slot = hashString (identifierString) & mask, n = 0; n <= mask; slot = (slot + 1) & mask, ++n)
+    {
+        const int index = (int) readInt (indexOffset + slot * 4) - 1;
+
+        if (! isPositiveAndBelow (index, numTypes))
+            return false;
+
+        readType (index, result);
+
+        if (result.createIdentifierString() == identifierString)
+            return true;
+    }
+
+    return false;
+}
+
+bool KnownPluginListCache::containsFile (const String& fileOrIdentifier) const
+{
+    OwnedArray <PluginDescription> types;
+    return getTypesForFile (fileOrIdentifier, types) > 0;
+}
+
+bool KnownPluginListCache::isListingUpToDate (const String& fileOrIdentifier) const
+{
+    using namespace KnownPluginListCacheFormat;
+
+    OwnedArray <PluginDescription> types;
+
+    if (getTypesForFile (fileOrIdentifier, types) == 0)
+        return false;
+
+    const Time modTime (getCurrentFileModTime (fileOrIdentifier));
+    const int64 fileSize = getCurrentFileSize (fileOrIdentifier);
+
+    for (int i = types.size(); --i >= 0;)
+    {
+        const PluginDescription& d = *types.getUnchecked(i);
+
+        if (d.lastFileModTime != modTime || d.lastFileModTime == Time()
+             || (d.lastFileSize != 0 && d.lastFileSize != fileSize))
+            return false;
+    }
+
+    return true;
+}
+
+bool KnownPluginListCache::isBlacklisted (const String& fileOrIdentifier) const
+{
+    using namespace KnownPluginListCacheFormat;
+
+    if (! isValid())
+        return false;
+
+    const uint32 mask = readInt (hBlacklistIndexSize) - 1;
+    const size_t indexOffset = readInt (hBlacklistIndexOffset);
+    const size_t blacklistOffset = readInt (hBlacklistOffset);
+    const int numBlacklisted = (int) readInt (hNumBlacklisted);
+
+    for (uint32 slot = hashString (fileOrIdentifier) & mask, n = 0; n <= mask; slot = (slot + 1) & mask, ++n)
+    {
+        const int index = (int) readInt (indexOffset + slot * 4) - 1;
+
+        if (! isPositiveAndBelow (index, numBlacklisted))
+            return false;
+
+        if (readString (readInt (blacklistOffset + (size_t) index * 4)) == fileOrIdentifier)
+            return true;
+    }
+
+    return false;
+}
+
+void KnownPluginListCache::loadInto (KnownPluginList& list) const
+{
+    using namespace KnownPluginListCacheFormat;
+
+    list.types.clear();
+    list.blacklist.clear();
+
+    if (isValid())
+    {
+        // The cache was written from a list that had no duplicates, so the types can
+        // go straight in, rather than each one being checked by addType()..
+        const int numTypes = getNumTypes();
+        list.types.ensureStorageAllocated (numTypes);
+
+        for (int i = 0; i < numTypes; ++i)
+        {
+            PluginDescription* const d = new PluginDescription();
+            readType (i, *d);
+            list.types.add (d);
+        }
+
+        const size_t blacklistOffset = readInt (hBlacklistOffset);
+        const int numBlacklisted = (int) readInt (hNumBlacklisted);
+
+        for (int i = 0; i < numBlacklisted; ++i)
+            list.blacklist.add (readString (readInt (blacklistOffset + (size_t) i * 4)));
+    }
+
+    list.sendChangeMessage();
+}
+
+//==============================================================================
+bool KnownPluginListCache::writeToStream (const KnownPluginList& list, OutputStream& out)
+{
+    using namespace KnownPluginListCacheFormat;
+
+    const int numTypes = list.getNumTypes();
+    const StringArray& blacklist = list.getBlacklistedFiles();
+
+    StringTable strings;
+    MemoryOutputStream types;
+    Array<uint32> fileIndex, idIndex, blacklistIndex, blacklistStrings;
+
+    fileIndex.insertMultiple (0, 0, (int) getIndexSize (numTypes));
+    idIndex.insertMultiple (0, 0, (int) getIndexSize (numTypes));
+    blacklistIndex.insertMultiple (0, 0, (int) getIndexSize (blacklist.size()));
+
+    for (int i = 0; i < numTypes; ++i)
+    {
+        const PluginDescription& d = *list.getType (i);
+        const uint32 fileHash = hashString (d.fileOrIdentifier);
+
+        types.writeInt ((int) strings.add (d.name));
+        types.writeInt ((int) strings.add (d.descriptiveName));
+        types.writeInt ((int) strings.add (d.pluginFormatName));
+        types.writeInt ((int) strings.add (d.category));
+        types.writeInt ((int) strings.add (d.manufacturerName));
+        types.writeInt ((int) strings.add (d.version));
+        types.writeInt ((int) strings.add (d.fileOrIdentifier));
+        types.writeInt (d.uid);
+        types.writeInt64 (d.lastFileModTime.toMilliseconds());
+        types.writeInt64 (d.lastFileSize);
+        types.writeInt (d.numInputChannels);
+        types.writeInt (d.numOutputChannels);
+        types.writeInt (d.isInstrument ? flagIsInstrument : 0);
+        types.writeInt ((int) fileHash);
+
+        addToIndex (fileIndex, fileHash, i);
+        addToIndex (idIndex, hashString (d.createIdentifierString()), i);
+    }
+
+    jassert (types.getDataSize() == (size_t) numTypes * typeRecordSize);
+
+    for (int i = 0; i < blacklist.size(); ++i)
+    {
+        blacklistStrings.add (strings.add (blacklist[i]));
+        addToIndex (blacklistIndex, hashString (blacklist[i]), i);
+    }
+
+    strings.add (String::empty); // makes sure the block isn't empty
+
+    const uint32 typesOffset          = headerSize;
+    const uint32 fileIndexOffset      = typesOffset + (uint32) types.getDataSize();
+    const uint32 idIndexOffset        = fileIndexOffset + (uint32) fileIndex.size() * 4;
+    const uint32 blacklistOffset      = idIndexOffset + (uint32) idIndex.size() * 4;
+    const uint32 blacklistIndexOffset = blacklistOffset + (uint32) blacklistStrings.size() * 4;
+    const uint32 stringsOffset        = blacklistIndexOffset + (uint32) blacklistIndex.size() * 4;
+    const uint32 stringsSize          = (uint32) strings.data.getDataSize();
+
+    const uint32 header[] = { magicNumber, formatVersion, (uint32) numTypes, (uint32) blacklist.size(),
+                              (uint32) fileIndex.size(), (uint32) idIndex.size(), (uint32) blacklistIndex.size(),
+                              typesOffset, fileIndexOffset, idIndexOffset, blacklistOffset, blacklistIndexOffset,
+                              stringsOffset, stringsSize, stringsOffset + stringsSize, 0 };
+
+    static_jassert (sizeof (header) == headerSize);
+
+    for (int i = 0; i < numElementsInArray (header); ++i)
+        out.writeInt ((int) header[i]);
+
+    out.write (types.getData(), types.getDataSize());
+
+    for (int i = 0; i < fileIndex.size(); ++i)          out.writeInt ((int) fileIndex.getUnchecked(i));
+    for (int i = 0; i < idIndex.size(); ++i)            out.writeInt ((int) idIndex.getUnchecked(i));
+    for (int i = 0; i < blacklistStrings.size(); ++i)   out.writeInt ((int) blacklistStrings.getUnchecked(i));
+    for (int i = 0; i < blacklistIndex.size(); ++i)     out.writeInt ((int) blacklistIndex.getUnchecked(i));
+
+    return out.write (strings.data.getData(), strings.data.getDataSize());
+}
+
+bool KnownPluginListCache::writeToFile (const KnownPluginList& list, const File& cacheFile)
+{
+    TemporaryFile temp (cacheFile);
+
+    {
+        ScopedPointer<FileOutputStream> out (temp.getFile().createOutputStream());
+
+        if (out == nullptr || ! writeToStream (list, *out))
+            return false;
+
+        out->flush();
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class KnownPluginListCacheTests  : public UnitTest
+{
+public:
+    KnownPluginListCacheTests() : UnitTest ("KnownPluginListCache") {}
+
+    static PluginDescription createType (const String& fileOrIdentifier, const int uid)
+    {
+        PluginDescription d;
+        d.name = "Plugin " + String (uid);
+        d.descriptiveName = "A test plugin";
+        d.pluginFormatName = "VST";
+        d.category = "Effect";
+        d.manufacturerName = "Test Manufacturer";
+        d.version = "1.0";
+        d.fileOrIdentifier = fileOrIdentifier;
+        d.uid = uid;
+        d.numInputChannels = 2;
+        d.numOutputChannels = uid % 3;
+        d.isInstrument = (uid & 1) != 0;
+
+        if (File::isAbsolutePath (fileOrIdentifier))
+        {
+            const File f (fileOrIdentifier);
+            d.lastFileModTime = f.getLastModificationTime();
+            d.lastFileSize = f.getSize();
+        }
+
+        return d;
+    }
+
+    static bool typesMatch (const PluginDescription& a, const PluginDescription& b)
+    {
+        const ScopedPointer<XmlElement> xa (a.createXml()), xb (b.createXml());
+        return xa->isEquivalentTo (xb, false);
+    }
+
+    static MemoryBlock createCacheData (const KnownPluginList& list)
+    {
+        MemoryOutputStream out;
+        KnownPluginListCache::writeToStream (list, out);
+        return out.getMemoryBlock();
+    }
+
+    static void writeFile (const File& f, const void* data, size_t size)
+    {
+        f.deleteFile();
+        f.appendData (data, size);
+    }
+
+    // A broken cache must look empty, so that a host which checks isValid() or
+    // isListingUpToDate() will rescan everything and write a new one.
+    void expectFallsBackToRescan (const File& cacheFile, const KnownPluginList& original, const String& pluginFile)
+    {
+        {
+            KnownPluginListCache cache (cacheFile);
+            expect (! cache.isValid());
+            expectEquals (cache.getNumTypes(), 0);
+            expect (! cache.containsFile (pluginFile));
+            expect (! cache.isListingUpToDate (pluginFile));
+
+            KnownPluginList list;
+            list.addType (createType ("/nonexistent/plugin.so", 99));
+            cache.loadInto (list);
+            expectEquals (list.getNumTypes(), 0);
+        }
+
+        expect (KnownPluginListCache::writeToFile (original, cacheFile));
+
+        KnownPluginListCache rebuilt (cacheFile);
+        expect (rebuilt.isValid());
+        expectEquals (rebuilt.getNumTypes(), original.getNumTypes());
+        expect (rebuilt.isListingUpToDate (pluginFile));
+    }
+
+    void runTest()
+    {
+        const File pluginFile (File::createTempFile (".so"));
+        pluginFile.replaceWithText ("not really a plugin");
+        const String pluginPath (pluginFile.getFullPathName());
+
+        KnownPluginList original;
+        original.addType (createType (pluginPath, 1));
+        original.addType (createType (pluginPath, 2));
+
+        for (int i = 0; i < 200; ++i)
+            original.addType (createType ("Identifier" + String (i), 100 + i));
+
+        original.addToBlacklist ("/plugins/crashed.so");
+        original.addToBlacklist ("/plugins/hung.so");
+
+        const File cacheFile (File::createTempFile (".cache"));
+
+        beginTest ("Round trip");
+        {
+            expect (KnownPluginListCache::writeToFile (original, cacheFile));
+
+            KnownPluginListCache cache (cacheFile);
+            expect (cache.isValid());
+            expectEquals (cache.getNumTypes(), original.getNumTypes());
+
+            for (int i = 0; i < original.getNumTypes(); ++i)
+            {
+                const PluginDescription& d = *original.getType (i);
+
+                PluginDescription found;
+                expect (cache.getType (i, found));
+                expect (typesMatch (found, d));
+
+                expect (cache.getTypeForIdentifierString (d.createIdentifierString(), found));
+                expect (typesMatch (found, d));
+            }
+
+            OwnedArray <PluginDescription> types;
+            expectEquals (cache.getTypesForFile (pluginPath, types), 2);
+            expectEquals (cache.getTypesForFile ("Identifier123", types), 1);
+            expectEquals (cache.getTypesForFile ("Identifier1234", types), 0);
+            expect (typesMatch (*types.getLast(), *original.getTypeForFile ("Identifier123")));
+
+            expect (cache.isBlacklisted ("/plugins/crashed.so"));
+            expect (cache.isBlacklisted ("/plugins/hung.so"));
+            expect (! cache.isBlacklisted ("/plugins/fine.so"));
+
+            expect (cache.isListingUpToDate (pluginPath));
+            expect (! cache.isListingUpToDate ("/plugins/fine.so"));
+
+            KnownPluginList loaded;
+            cache.loadInto (loaded);
+            expectEquals (loaded.getNumTypes(), original.getNumTypes());
+            expect (loaded.getBlacklistedFiles() == original.getBlacklistedFiles());
+
+            for (int i = 0; i < original.getNumTypes(); ++i)
+                expect (typesMatch (*loaded.getType (i), *original.getType (i)));
+
+            // changing the plugin file must make its listing out of date..
+            pluginFile.appendText ("changed");
+            expect (! cache.isListingUpToDate (pluginPath));
+            expect (! original.isListingUpToDate (pluginPath));
+        }
+
+        original.clear();
+        original.addType (createType (pluginPath, 1));
+        original.addType (createType ("Identifier", 2));
+
+        const MemoryBlock validData (createCacheData (original));
+
+        beginTest ("Truncated file");
+        {
+            for (size_t size = 0; size < validData.getSize(); size += jmax ((size_t) 1, validData.getSize() / 17))
+            {
+                writeFile (cacheFile, validData.getData(), size);
+                expectFallsBackToRescan (cacheFile, original, pluginPath);
+            }
+
+            writeFile (cacheFile, validData.getData(), validData.getSize() - 1);
+            expectFallsBackToRescan (cacheFile, original, pluginPath);
+        }
+
+        beginTest ("Corrupt header");
+        {
+            const int fieldsToCorrupt[] = { KnownPluginListCacheFormat::hMagic,
+                                            KnownPluginListCacheFormat::hNumTypes,
+                                            KnownPluginListCacheFormat::hFileIndexSize,
+                                            KnownPluginListCacheFormat::hTypesOffset,
+                                            KnownPluginListCacheFormat::hStringsOffset,
+                                            KnownPluginListCacheFormat::hStringsSize,
+                                            KnownPluginListCacheFormat::hTotalSize };
+
+            for (int i = 0; i < numElementsInArray (fieldsToCorrupt); ++i)
+            {
+                MemoryBlock data (validData);
+                data[fieldsToCorrupt[i] + 3] = (char) 0x7f;
+
+                writeFile (cacheFile, data.getData(), data.getSize());
+                expectFallsBackToRescan (cacheFile, original, pluginPath);
+            }
+
+            MemoryBlock garbage (validData.getSize());
+            Random r (1234);
+
+            for (size_t i = 0; i < garbage.getSize(); ++i)
+                garbage[(int) i] = (char) r.nextInt (256);
+
+            writeFile (cacheFile, garbage.getData(), garbage.getSize());
+            expectFallsBackToRescan (cacheFile, original, pluginPath);
+        }
+
+        beginTest ("Wrong version");
+        {
+            MemoryBlock data (validData);
+            data[KnownPluginListCacheFormat::hVersion] = (char) (KnownPluginListCacheFormat::formatVersion + 1);
+
+            writeFile (cacheFile, data.getData(), data.getSize());
+            expectFallsBackToRescan (cacheFile, original, pluginPath);
+        }
+
+        beginTest ("Missing file");
+        {
+            cacheFile.deleteFile();
+            expectFallsBackToRescan (cacheFile, original, pluginPath);
+        }
+
+        cacheFile.deleteFile();
+        pluginFile.deleteFile();
+    }
+};
+
+static KnownPluginListCacheTests knownPluginListCacheTests;
+
+#endif
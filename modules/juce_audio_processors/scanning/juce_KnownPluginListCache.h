@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_KNOWNPLUGINLISTCACHE_JUCEHEADER__
+#define __JUCE_KNOWNPLUGINLISTCACHE_JUCEHEADER__
+
+#include "juce_KnownPluginList.h"
+
+
+//==============================================================================
+/**
+    A compact binary snapshot of a KnownPluginList, which can be queried in-place.
+
+    Loading a list with thousands of plugins from XML means parsing the whole
+    document and building every PluginDescription, even if the host only needs
+    to check a handful of files. This class stores the same information in a
+    flat binary format with hash indexes on the plugin files and identifier
+    strings, so a cache file can be memory-mapped and searched directly, and
+    PluginDescription objects are only created for the entries that are asked for.
+
+    The XML format written by KnownPluginList::createXml() is still the one to use
+    for exchanging lists - this format is only meant as a fast local cache, and
+    its layout may change between versions (in which case isValid() will just
+    return false, and you should rebuild it).
+
+    @code
+    KnownPluginListCache cache (cacheFile);
+
+    if (cache.isValid() && cache.isListingUpToDate (pluginFile))
+        ...
+    @endcode
+
+    @see KnownPluginList
+*/
+class JUCE_API  KnownPluginListCache
+{
+public:
+    //==============================================================================
+    /** Memory-maps a cache file that was written by writeToFile().
+        If the file is missing or isn't a valid cache, isValid() will return false.
+    */
+    explicit KnownPluginListCache (const File& cacheFile);
+
+    /** Uses a block of cache data that was written by writeToStream().
+        The data isn't copied, so it must stay valid for the lifetime of this object.
+    */
+    KnownPluginListCache (const void* cacheData, size_t cacheDataSize);
+
+    /** Destructor. */
+    ~KnownPluginListCache();
+
+    //==============================================================================
+    /** Writes the contents of a list to a stream in the binary cache format. */
+    static bool writeToStream (const KnownPluginList& list, OutputStream& output);
+
+    /** Writes the contents of a list to a cache file.
+        The file is written to a temporary file first, and then swapped into place,
+        so a reader will never see a half-written cache.
+    */
+    static bool writeToFile (const KnownPluginList& list, const File& cacheFile);
+
+    //==============================================================================
+    /** Returns true if the data was a valid cache. */
+    bool isValid() const noexcept                   { return data != nullptr; }
+
+    /** Returns the number of plugin types in the cache. */
+    int getNumTypes() const noexcept;
+
+    /** Fills in a description with one of the cached types.
+        Returns false if the index is out of range.
+    */
+    bool getType (int index, PluginDescription& result) const;
+
+    /** Adds any types that come from the given file or identifier to an array.
+        Returns the number of types that were found.
+    */
+    int getTypesForFile (const String& fileOrIdentifier, OwnedArray <PluginDescription>& results) const;
+
+    /** Looks for a type whose PluginDescription::createIdentifierString() matches
+        the given string. Returns false if it isn't there.
+    */
+    bool getTypeForIdentifierString (const String& identifierString, PluginDescription& result) const;
+
+    /** Returns true if the cache contains any types for this file or identifier. */
+    bool containsFile (const String& fileOrIdentifier) const;
+
+    /** Returns true if the cache contains this file, and the file's modification
+        time and size haven't changed since it was scanned.
+
+        This behaves like KnownPluginList::isListingUpToDate(), but uses the hash index
+        rather than searching the whole list.
+    */
+    bool isListingUpToDate (const String& fileOrIdentifier) const;
+
+    /** Returns true if the given file or identifier is in the cached blacklist. */
+    bool isBlacklisted (const String& fileOrIdentifier) const;
+
+    //==============================================================================
+    /** Replaces the contents of a list with all the types and blacklisted files in
+        the cache.
+    */
+    void loadInto (KnownPluginList& list) const;
+
+private:
+    //==============================================================================
+    ScopedPointer<MemoryMappedFile> mappedFile;
+    const char* data;
+    size_t dataSize;
+
+    void setData (const void*, size_t);
+    uint32 readInt (size_t offset) const noexcept;
+    String readString (uint32 stringOffset) const;
+    size_t getTypeOffset (int index) const noexcept;
+    String getFileOrIdentifier (int index) const;
+    void readType (int index, PluginDescription&) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KnownPluginListCache)
+};
+
+
+#endif   // __JUCE_KNOWNPLUGINLISTCACHE_JUCEHEADER__
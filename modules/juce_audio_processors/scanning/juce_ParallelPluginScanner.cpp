@@ -0,0 +1,621 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+namespace ParallelPluginScannerHelpers
+{
+    static const char* const scanRequestFlag = "--juce-plugin-scan";
+    static const char* const resultsStartMarker = "<<JUCE_PLUGIN_SCAN_RESULTS>>";
+    static const char* const resultsEndMarker = "<<JUCE_PLUGIN_SCAN_RESULTS_END>>";
+
+    static bool isPluginFile (const String& fileOrIdentifier)
+    {
+        return File::isAbsolutePath (fileOrIdentifier) && File (fileOrIdentifier).exists();
+    }
+}
+
+//==============================================================================
+class ParallelPluginScanner::ScanJob  : public ThreadPoolJob
+{
+public:
+    ScanJob (ParallelPluginScanner& owner_, const String& fileOrIdentifier_)
+        : ThreadPoolJob ("Plugin scan"),
+          owner (owner_),
+          fileOrIdentifier (fileOrIdentifier_),
+          merged (false),
+          startTime (0),
+          outcome (notFinished),
+          timedOut (false),
+          hasLaunched (false)
+    {
+    }
+
+    enum Outcome
+    {
+        notFinished,
+        scanned,
+        crashed,
+        failedToLaunch
+    };
+
+    JobStatus runJob()
+    {
+        using namespace ParallelPluginScannerHelpers;
+
+        if (shouldExit())
+            return jobHasFinished;
+
+        const String output (runWorker());
+
+        // cancelled before the worker could be started - this job never ran..
+        if (! hasLaunched && shouldExit())
+            return jobHasFinished;
+
+        Outcome result = failedToLaunch;
+
+        if (hasLaunched)
+        {
+            const int start = output.indexOf (resultsStartMarker);
+            const int end = output.indexOf (start + 1, resultsEndMarker);
+
+            if (start >= 0 && end > start && ! timedOut)
+            {
+                parseResults (output.substring (start + (int) strlen (resultsStartMarker), end));
+                result = scanned;
+            }
+            else
+            {
+                result = crashed;
+            }
+        }
+
+        outcome.set ((int) result);
+        return jobHasFinished;
+    }
+
+    bool isRunningWorker() const
+    {
+        const ScopedLock sl (processLock);
+        return startTime != 0;
+    }
+
+    void killIfTimedOut (const int timeoutMs)
+    {
+        const ScopedLock sl (processLock);
+
+        // (the time has to be read inside the lock, or a worker that starts just
+        // after it could appear to have been running for ~49 days..)
+        if (startTime != 0 && Time::getMillisecondCounter() - startTime > (uint32) timeoutMs)
+            killWorker (true);
+    }
+
+    void killWorker (const bool isTimeout)
+    {
+        const ScopedLock sl (processLock);
+
+        if (startTime != 0)
+        {
+            timedOut = timedOut || isTimeout;
+            process.kill();
+        }
+    }
+
+    Outcome getOutcome() const noexcept     { return (Outcome) outcome.get(); }
+
+    ParallelPluginScanner& owner;
+    const String fileOrIdentifier;
+    OwnedArray <PluginDescription> typesFound;
+    bool merged;
+
+private:
+    ChildProcess process;
+    CriticalSection processLock;
+    uint32 startTime;
+    Atomic<int> outcome;
+    bool timedOut, hasLaunched;
+
+    String runWorker()
+    {
+        using namespace ParallelPluginScannerHelpers;
+
+        StringArray args;
+        args.add (owner.workerExecutable.getFullPathName());
+        args.add (scanRequestFlag);
+        args.add (owner.format.getName().replaceCharacter (' ', '_'));
+        args.add (MemoryBlock (fileOrIdentifier.toUTF8(), fileOrIdentifier.getNumBytesAsUTF8()).toBase64Encoding());
+
+        {
+            const ScopedLock sl (processLock);
+
+            // stopWorkers() kills the running workers while holding this lock, so
+            // this check stops a new one from being launched just after that..
+            if (shouldExit())
+                return String::empty;
+
+            // If the executable is missing, the child would fail silently, and
+            // every plugin would end up being blacklisted..
+            jassert (owner.workerExecutable.existsAsFile());
+
+            hasLaunched = owner.workerExecutable.existsAsFile() && process.start (args);
+
+            if (! hasLaunched)
+                return String::empty;
+
+            startTime = jmax ((uint32) 1, Time::getMillisecondCounter());
+        }
+
+        // This blocks until the worker closes its end of the pipe, which will
+        // happen when it exits, crashes or gets killed by the TimeoutWatcher..
+        const String output (process.readAllProcessOutput());
+
+        if (! process.waitForProcessToFinish (owner.timeoutMs))
+            killWorker (true);
+
+        const ScopedLock sl (processLock);
+        startTime = 0;
+        return output;
+    }
+
+    void parseResults (const String& xmlText)
+    {
+        XmlDocument doc (xmlText);
+        ScopedPointer<XmlElement> xml (doc.getDocumentElement());
+
+        if (xml != nullptr && xml->hasTagName ("KNOWNPLUGINS"))
+        {
+            forEachXmlChildElement (*xml, e)
+            {
+                ScopedPointer<PluginDescription> desc (new PluginDescription());
+
+                if (desc->loadFromXml (*e))
+                    typesFound.add (desc.release());
+            }
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ScanJob)
+};
+
+//==============================================================================
+/*  The workers block while reading their child's output, so this thread kills
+    any that overrun, whether or not scanAndMergeResults() is being called.
+*/
+class ParallelPluginScanner::TimeoutWatcher  : public Thread
+{
+public:
+    TimeoutWatcher (ParallelPluginScanner& owner_)
+        : Thread ("Plugin scan timeouts"), owner (owner_)
+    {
+    }
+
+    void run()
+    {
+        while (! threadShouldExit())
+        {
+            owner.killTimedOutWorkers();
+            wait (jlimit (1, 50, owner.timeoutMs / 4));
+        }
+    }
+
+private:
+    ParallelPluginScanner& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (TimeoutWatcher)
+};
+
+//==============================================================================
+ParallelPluginScanner::ParallelPluginScanner (KnownPluginList& listToAddTo,
+                                              AudioPluginFormat& formatToLookFor,
+                                              FileSearchPath directoriesToSearch,
+                                              const bool recursive,
+                                              const File& workerExecutable_,
+                                              const int numWorkerProcesses,
+                                              const bool onlyRescanChangedFiles)
+    : list (listToAddTo),
+      format (formatToLookFor),
+      workerExecutable (workerExecutable_),
+      pool (numWorkerProcesses > 0 ? numWorkerProcesses : jmax (1, SystemStats::getNumCpus())),
+      timeoutMs (30000),
+      numMerged (0),
+      started (false)
+{
+    directoriesToSearch.removeRedundantPaths();
+
+    const StringArray files (format.searchPathsForPlugins (directoriesToSearch, recursive));
+
+    for (int i = 0; i < files.size(); ++i)
+    {
+        const String& file = files[i];
+
+        if (file.isEmpty() || list.getBlacklistedFiles().contains (file))
+            continue;
+
+        if (onlyRescanChangedFiles && list.isListingUpToDate (file))
+            continue;
+
+        jobs.add (new ScanJob (*this, file));
+    }
+}
+
+ParallelPluginScanner::~ParallelPluginScanner()
+{
+    stopWorkers();
+}
+
+void ParallelPluginScanner::setTimeout (const int milliseconds) noexcept
+{
+    jassert (milliseconds > 0);
+    timeoutMs = milliseconds;
+}
+
+//==============================================================================
+void ParallelPluginScanner::startWorkers()
+{
+    started = true;
+
+    for (int i = 0; i < jobs.size(); ++i)
+        pool.addJob (jobs.getUnchecked(i), false);
+
+    timeoutWatcher = new TimeoutWatcher (*this);
+    timeoutWatcher->startThread();
+}
+
+void ParallelPluginScanner::killTimedOutWorkers()
+{
+    for (int i = 0; i < jobs.size(); ++i)
+        jobs.getUnchecked(i)->killIfTimedOut (timeoutMs);
+}
+
+bool ParallelPluginScanner::scanAndMergeResults (const int maxMillisecondsToWait)
+{
+    if (! started)
+        startWorkers();
+
+    const uint32 endTime = Time::getMillisecondCounter() + (uint32) jmax (0, maxMillisecondsToWait);
+
+    for (;;)
+    {
+        for (int i = 0; i < jobs.size(); ++i)
+        {
+            ScanJob& job = *jobs.getUnchecked(i);
+
+            if (! job.merged && job.getOutcome() != ScanJob::notFinished)
+                mergeResults (job);
+        }
+
+        if (numMerged >= jobs.size() || pool.getNumJobs() == 0)
+            return numMerged < jobs.size();
+
+        if (Time::getMillisecondCounter() >= endTime)
+            return true;
+
+        Thread::sleep (jmin (10, maxMillisecondsToWait));
+    }
+}
+
+void ParallelPluginScanner::mergeResults (ScanJob& job)
+{
+    job.merged = true;
+    ++numMerged;
+
+    switch (job.getOutcome())
+    {
+        case ScanJob::scanned:
+        {
+            const bool isFile = ParallelPluginScannerHelpers::isPluginFile (job.fileOrIdentifier);
+
+            for (int i = 0; i < job.typesFound.size(); ++i)
+            {
+                PluginDescription& desc = *job.typesFound.getUnchecked(i);
+
+                // stamp the details of the file as it was when we scanned it, so that
+                // an incremental rescan can tell whether it has changed since..
+                if (isFile)
+                {
+                    const File f (job.fileOrIdentifier);
+                    desc.lastFileModTime = f.getLastModificationTime();
+                    desc.lastFileSize = f.getSize();
+                }
+
+                list.addType (desc);
+            }
+
+            if (job.typesFound.size() == 0)
+                failedFiles.add (job.fileOrIdentifier);
+
+            break;
+        }
+
+        case ScanJob::crashed:
+            crashedFiles.add (job.fileOrIdentifier);
+            list.addToBlacklist (job.fileOrIdentifier);
+            break;
+
+        case ScanJob::failedToLaunch:
+            // couldn't start the worker process - check the executable that you gave it!
+            jassertfalse;
+            failedFiles.add (job.fileOrIdentifier);
+            break;
+
+        default:
+            jassertfalse;
+            break;
+    }
+
+    job.typesFound.clear();
+}
+
+void ParallelPluginScanner::stopWorkers()
+{
+    for (int i = 0; i < jobs.size(); ++i)
+        jobs.getUnchecked(i)->signalJobShouldExit();
+
+    for (int i = 0; i < jobs.size(); ++i)
+        jobs.getUnchecked(i)->killWorker (false);
+
+    pool.removeAllJobs (true, 10000);
+
+    if (timeoutWatcher != nullptr)
+    {
+        timeoutWatcher->stopThread (5000);
+        timeoutWatcher = nullptr;
+    }
+}
+
+void ParallelPluginScanner::cancel()
+{
+    stopWorkers();
+
+    for (int i = 0; i < jobs.size(); ++i)
+    {
+        ScanJob& job = *jobs.getUnchecked(i);
+
+        if (! job.merged && job.getOutcome() == ScanJob::scanned)
+            mergeResults (job);
+    }
+}
+
+float ParallelPluginScanner::getProgress() const noexcept
+{
+    return jobs.size() > 0 ? numMerged / (float) jobs.size() : 1.0f;
+}
+
+StringArray ParallelPluginScanner::getPluginsBeingScanned() const
+{
+    StringArray names;
+
+    for (int i = 0; i < jobs.size(); ++i)
+    {
+        const ScanJob& job = *jobs.getUnchecked(i);
+
+        if (job.isRunningWorker())
+            names.add (format.getNameOfPluginFromIdentifier (job.fileOrIdentifier));
+    }
+
+    return names;
+}
+
+//==============================================================================
+bool ParallelPluginScanner::performScanIfRequested (const String& commandLine,
+                                                    AudioPluginFormatManager& formatManager)
+{
+    using namespace ParallelPluginScannerHelpers;
+
+    StringArray tokens;
+    tokens.addTokens (commandLine, true);
+    tokens.removeEmptyStrings();
+
+    const int index = tokens.indexOf (scanRequestFlag);
+
+    if (index < 0 || index + 2 >= tokens.size())
+        return false;
+
+    const String formatName (tokens [index + 1].unquoted());
+
+    MemoryBlock idData;
+    idData.fromBase64Encoding (tokens [index + 2].unquoted());
+    const String fileOrIdentifier (String::fromUTF8 (static_cast <const char*> (idData.getData()), (int) idData.getSize()));
+
+    OwnedArray <PluginDescription> found;
+
+    for (int i = 0; i < formatManager.getNumFormats(); ++i)
+    {
+        AudioPluginFormat* const f = formatManager.getFormat (i);
+
+        if (f->getName().replaceCharacter (' ', '_') == formatName)
+        {
+            f->findAllTypesForFile (found, fileOrIdentifier);
+            break;
+        }
+    }
+
+    XmlElement results ("KNOWNPLUGINS");
+
+    for (int i = 0; i < found.size(); ++i)
+        results.addChildElement (found.getUnchecked(i)->createXml());
+
+    // The plugin may have printed its own junk to stdout, so the results are
+    // delimited by markers that the host looks for..
+    std::cout << "\n" << resultsStartMarker << "\n"
+              << results.createDocument (String::empty, true, false)
+              << "\n" << resultsEndMarker << std::endl;
+
+    return true;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS && (JUCE_LINUX || JUCE_MAC)
+
+class ParallelPluginScannerTests  : public UnitTest
+{
+public:
+    ParallelPluginScannerTests() : UnitTest ("ParallelPluginScanner") {}
+
+    class DummyFormat  : public AudioPluginFormat
+    {
+    public:
+        DummyFormat (int numPlugins_) : numPlugins (numPlugins_) {}
+
+        String getName() const                                              { return "Dummy Format"; }
+        void findAllTypesForFile (OwnedArray <PluginDescription>&, const String&) {}
+        AudioPluginInstance* createInstanceFromDescription (const PluginDescription&) { return nullptr; }
+        bool fileMightContainThisPluginType (const String&)                 { return true; }
+        String getNameOfPluginFromIdentifier (const String& id)             { return id; }
+        bool doesPluginStillExist (const PluginDescription&)                { return true; }
+        bool canScanForPlugins() const                                      { return true; }
+        FileSearchPath getDefaultLocationsToSearch()                        { return FileSearchPath(); }
+
+        StringArray searchPathsForPlugins (const FileSearchPath&, bool)
+        {
+            StringArray ids;
+
+            for (int i = 0; i < numPlugins; ++i)
+                ids.add ("DummyPlugin" + String (i));
+
+            return ids;
+        }
+
+    private:
+        const int numPlugins;
+    };
+
+    // A fake worker: a shell script standing in for the app's own executable.
+    class FakeWorker
+    {
+    public:
+        FakeWorker (const String& body)
+            : file (File::createTempFile (".sh"))
+        {
+            // (not replaceWithText(), which would write CRLFs)
+            const String script ("#!/bin/sh\n" + body + "\n");
+            file.replaceWithData (script.toRawUTF8(), script.getNumBytesAsUTF8());
+
+            ChildProcess chmod;
+            if (chmod.start ("chmod +x " + file.getFullPathName()))
+                chmod.readAllProcessOutput();
+        }
+
+        ~FakeWorker()       { file.deleteFile(); }
+
+        const File file;
+    };
+
+    bool scanUntilDone (ParallelPluginScanner& scanner, int maxMilliseconds)
+    {
+        const uint32 endTime = Time::getMillisecondCounter() + (uint32) maxMilliseconds;
+
+        while (scanner.scanAndMergeResults (50))
+            if (Time::getMillisecondCounter() > endTime)
+                return false;
+
+        return true;
+    }
+
+    void runTest()
+    {
+        beginTest ("Crashing workers");
+        {
+            FakeWorker worker ("kill -9 $$");
+            DummyFormat format (3);
+            KnownPluginList list;
+
+            ParallelPluginScanner scanner (list, format, FileSearchPath(), false, worker.file, 2);
+            expect (scanUntilDone (scanner, 20000));
+
+            expectEquals (scanner.getCrashedFiles().size(), 3);
+            expectEquals (list.getBlacklistedFiles().size(), 3);
+            expectEquals (list.getNumTypes(), 0);
+        }
+
+        beginTest ("Workers that find nothing");
+        {
+            String script;
+            script << "echo '" << ParallelPluginScannerHelpers::resultsStartMarker << "'\n"
+                   << "echo '<KNOWNPLUGINS/>'\n"
+                   << "echo '" << ParallelPluginScannerHelpers::resultsEndMarker << "'";
+
+            FakeWorker worker (script);
+            DummyFormat format (3);
+            KnownPluginList list;
+
+            ParallelPluginScanner scanner (list, format, FileSearchPath(), false, worker.file, 2);
+            expect (scanUntilDone (scanner, 20000));
+
+            expectEquals (scanner.getFailedFiles().size(), 3);
+            expectEquals (scanner.getCrashedFiles().size(), 0);
+            expectEquals (list.getBlacklistedFiles().size(), 0);
+        }
+
+        beginTest ("Hung workers time out");
+        {
+            // exec, so that killing the worker also closes the pipe
+            FakeWorker worker ("exec sleep 60");
+            DummyFormat format (2);
+            KnownPluginList list;
+
+            ParallelPluginScanner scanner (list, format, FileSearchPath(), false, worker.file, 2);
+            scanner.setTimeout (200);
+            scanner.scanAndMergeResults (0);
+
+            // the timeout mustn't depend on scanAndMergeResults() being called..
+            const uint32 endTime = Time::getMillisecondCounter() + 10000;
+
+            while (scanner.getPluginsBeingScanned().size() > 0 && Time::getMillisecondCounter() < endTime)
+                Thread::sleep (20);
+
+            expectEquals (scanner.getPluginsBeingScanned().size(), 0);
+
+            expect (scanUntilDone (scanner, 10000));
+            expectEquals (scanner.getCrashedFiles().size(), 2);
+            expectEquals (list.getBlacklistedFiles().size(), 2);
+        }
+
+        beginTest ("Stopping while workers are launching");
+        {
+            FakeWorker worker ("exec sleep 60");
+
+            for (int i = 0; i < 20; ++i)
+            {
+                DummyFormat format (16);
+                KnownPluginList list;
+                const uint32 startTime = Time::getMillisecondCounter();
+
+                {
+                    ParallelPluginScanner scanner (list, format, FileSearchPath(), false, worker.file, 4);
+                    scanner.scanAndMergeResults (i % 4);
+
+                    if ((i & 1) != 0)
+                        scanner.cancel();
+                }
+
+                expect (Time::getMillisecondCounter() - startTime < 5000);
+                expectEquals (list.getNumTypes(), 0);
+            }
+        }
+    }
+};
+
+static ParallelPluginScannerTests parallelPluginScannerTests;
+
+#endif
@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_PARALLELPLUGINSCANNER_JUCEHEADER__
+#define __JUCE_PARALLELPLUGINSCANNER_JUCEHEADER__
+
+#include "juce_KnownPluginList.h"
+#include "../format/juce_AudioPluginFormatManager.h"
+
+
+//==============================================================================
+/**
+    Scans a set of directories for plugins using a pool of child processes, and
+    adds the results to a KnownPluginList.
+
+    Unlike the PluginDirectoryScanner, no plugin code is ever loaded into the host
+    process. Each file is handed to a separate worker process, and several of these
+    run at the same time. The workers print their results to a pipe which the
+    scanner reads. If a worker crashes, or fails to finish within the timeout, its
+    plugin file is added to the list's blacklist and the scan carries on.
+
+    The worker executable is normally your own app, which must call
+    performScanIfRequested() with its command line when it starts up, e.g.
+
+    @code
+    void MyApp::initialise (const String& commandLine)
+    {
+        AudioPluginFormatManager formats;
+        formats.addDefaultFormats();
+
+        if (ParallelPluginScanner::performScanIfRequested (commandLine, formats))
+        {
+            quit();
+            return;
+        }
+
+        ...
+    }
+    @endcode
+
+    To run a scan, create one of these and call scanAndMergeResults() repeatedly
+    until it returns false. The KnownPluginList is only ever modified from inside
+    scanAndMergeResults(), so if you call that from the message thread (e.g. from
+    a timer) you don't need to do any locking around the list.
+
+    @see PluginDirectoryScanner, KnownPluginList
+*/
+class JUCE_API  ParallelPluginScanner
+{
+public:
+    //==============================================================================
+    /**
+        Creates a scanner.
+
+        @param listToAddResultsTo       this will get the new types added to it, and
+                                        any plugins that crash will be added to its
+                                        blacklist
+        @param formatToLookFor          this is the type of format that you want to look for
+        @param directoriesToSearch      the path to search
+        @param searchRecursively        true to search recursively
+        @param workerExecutable         the executable to launch for each plugin that needs
+                                        scanning - see performScanIfRequested()
+        @param numWorkerProcesses       the maximum number of workers to run at once, or 0
+                                        to use the number of CPUs
+        @param onlyRescanChangedFiles   if true, files which are already in the list and
+                                        whose modification time and size haven't changed
+                                        since they were last scanned will be skipped
+    */
+    ParallelPluginScanner (KnownPluginList& listToAddResultsTo,
+                           AudioPluginFormat& formatToLookFor,
+                           FileSearchPath directoriesToSearch,
+                           bool searchRecursively,
+                           const File& workerExecutable,
+                           int numWorkerProcesses = 0,
+                           bool onlyRescanChangedFiles = true);
+
+    /** Destructor.
+        If a scan is still running, any workers will be killed.
+    */
+    ~ParallelPluginScanner();
+
+    //==============================================================================
+    /** Sets the number of milliseconds that a worker is allowed to run before it's
+        assumed to have hung. The default is 30 seconds.
+    */
+    void setTimeout (int milliseconds) noexcept;
+
+    /** Returns the current timeout. @see setTimeout */
+    int getTimeout() const noexcept                                 { return timeoutMs; }
+
+    //==============================================================================
+    /** Lets the scan progress, and adds any new results to the list.
+
+        The first call will launch the workers. Each call will then wait for up to
+        the given number of milliseconds for some workers to finish, and merge all
+        the results that have arrived into the list. Workers that overrun the timeout
+        are killed by a background thread, so they don't depend on this being called.
+
+        Returns false when all the files have been scanned.
+    */
+    bool scanAndMergeResults (int maxMillisecondsToWait);
+
+    /** Stops the scan, killing any workers that are still running.
+        Results that have already arrived are still merged into the list.
+    */
+    void cancel();
+
+    /** Returns the estimated progress, between 0 and 1. */
+    float getProgress() const noexcept;
+
+    /** Returns the number of files that are going to be scanned.
+        In incremental mode, this doesn't include any files that were skipped.
+    */
+    int getNumFilesToScan() const noexcept                          { return jobs.size(); }
+
+    /** Returns the names of the plugins that are being scanned at the moment. */
+    StringArray getPluginsBeingScanned() const;
+
+    /** This returns a list of all the filenames of things that looked like being
+        a plugin file, but which failed to open for some reason.
+    */
+    const StringArray& getFailedFiles() const noexcept              { return failedFiles; }
+
+    /** Returns the files that crashed or timed out during this scan.
+        These will also have been added to the list's blacklist.
+    */
+    const StringArray& getCrashedFiles() const noexcept             { return crashedFiles; }
+
+    //==============================================================================
+    /** Call this at the start of your worker executable.
+
+        If the command line contains a request from a ParallelPluginScanner, this
+        will scan the plugin it names using the matching format from the manager,
+        print the results to stdout, and return true - in which case your app should
+        exit immediately. If the command line isn't a scan request, it returns false.
+    */
+    static bool performScanIfRequested (const String& commandLine,
+                                        AudioPluginFormatManager& formatManager);
+
+private:
+    //==============================================================================
+    class ScanJob;
+    class TimeoutWatcher;
+    friend class ScanJob;
+    friend class TimeoutWatcher;
+    friend class OwnedArray <ScanJob>;
+    friend class ScopedPointer <TimeoutWatcher>;
+
+    KnownPluginList& list;
+    AudioPluginFormat& format;
+    const File workerExecutable;
+    OwnedArray <ScanJob> jobs;
+    ThreadPool pool;
+    ScopedPointer <TimeoutWatcher> timeoutWatcher;
+    StringArray failedFiles, crashedFiles;
+    int timeoutMs, numMerged;
+    bool started;
+
+    void startWorkers();
+    void stopWorkers();
+    void killTimedOutWorkers();
+    void mergeResults (ScanJob&);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelPluginScanner)
+};
+
+
+#endif   // __JUCE_PARALLELPLUGINSCANNER_JUCEHEADER__
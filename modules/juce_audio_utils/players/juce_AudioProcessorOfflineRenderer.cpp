@@ -0,0 +1,373 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+AudioProcessorOfflineRenderer::AudioProcessorOfflineRenderer()
+    : blockSize (4096),
+      bpm (120.0),
+      timeSigNumerator (4),
+      timeSigDenominator (4),
+      startPosition (0),
+      currentPosition (0),
+      currentSampleRate (44100.0),
+      totalSamples (0),
+      shouldCancel (false),
+      owningJob (nullptr)
+{
+    stats.numSamplesRendered = 0;
+    stats.audioDuration = 0;
+    stats.renderTime = 0;
+}
+
+AudioProcessorOfflineRenderer::~AudioProcessorOfflineRenderer()
+{
+}
+
+//==============================================================================
+void AudioProcessorOfflineRenderer::setBlockSize (const int numSamplesPerBlock)
+{
+    jassert (numSamplesPerBlock > 0);
+    blockSize = jmax (1, numSamplesPerBlock);
+}
+
+void AudioProcessorOfflineRenderer::setTempo (const double beatsPerMinute,
+                                              const int numerator, const int denominator)
+{
+    jassert (beatsPerMinute > 0 && numerator > 0 && denominator > 0);
+
+    bpm = beatsPerMinute;
+    timeSigNumerator = numerator;
+    timeSigDenominator = denominator;
+}
+
+void AudioProcessorOfflineRenderer::setStartPosition (const int64 startSampleOnTimeline)
+{
+    startPosition = startSampleOnTimeline;
+}
+
+void AudioProcessorOfflineRenderer::cancel() noexcept
+{
+    shouldCancel = true;
+}
+
+double AudioProcessorOfflineRenderer::getProgress() const noexcept
+{
+    return totalSamples > 0 ? numSamplesDone.get() / (double) totalSamples : 0.0;
+}
+
+bool AudioProcessorOfflineRenderer::isCancelled() const noexcept
+{
+    return shouldCancel || (owningJob != nullptr && owningJob->shouldExit());
+}
+
+//==============================================================================
+bool AudioProcessorOfflineRenderer::getCurrentPosition (CurrentPositionInfo& info)
+{
+    const double quarterNotesPerBar = timeSigNumerator * 4.0 / timeSigDenominator;
+
+    info.resetToDefault();
+    info.bpm = bpm;
+    info.timeSigNumerator = timeSigNumerator;
+    info.timeSigDenominator = timeSigDenominator;
+    info.timeInSamples = currentPosition;
+    info.timeInSeconds = currentPosition / currentSampleRate;
+    info.ppqPosition = info.timeInSeconds * bpm / 60.0;
+    info.ppqPositionOfLastBarStart = std::floor (info.ppqPosition / quarterNotesPerBar) * quarterNotesPerBar;
+    info.frameRate = fpsUnknown;
+    info.isPlaying = true;
+    return true;
+}
+
+//==============================================================================
+Result AudioProcessorOfflineRenderer::render (AudioProcessor& processor,
+                                              AudioFormatWriter& writer,
+                                              const int64 numSamples,
+                                              AudioFormatReader* const inputSource,
+                                              const MidiMessageSequence* const midiInput)
+{
+    const int numOutputChans = (int) writer.getNumChannels();
+    const int numInputChans = inputSource != nullptr ? (int) inputSource->numChannels : 0;
+
+    currentSampleRate = writer.getSampleRate();
+    currentPosition = startPosition;
+    totalSamples = numSamples;
+    numSamplesDone = 0;
+    shouldCancel = false;
+
+    stats.numSamplesRendered = 0;
+    stats.audioDuration = 0;
+    stats.renderTime = 0;
+    stats.nodeTimings.clearQuick();
+
+    if (currentSampleRate <= 0)
+        return Result::fail ("The writer has no sample rate");
+
+    AudioProcessorGraph* const graph = dynamic_cast <AudioProcessorGraph*> (&processor);
+    const bool graphWasTimingNodes = graph != nullptr && graph->isNodeTimingEnabled();
+
+    processor.setPlayConfigDetails (numInputChans, numOutputChans, currentSampleRate, blockSize);
+    processor.setNonRealtime (true);
+    processor.setPlayHead (this);
+    processor.prepareToPlay (currentSampleRate, blockSize);
+
+    if (graph != nullptr)
+    {
+        for (int i = graph->getNumNodes(); --i >= 0;)
+            graph->getNode (i)->resetProcessingTime();
+
+        graph->setNodeTimingEnabled (true);
+    }
+
+    AudioSampleBuffer buffer (jmax (1, numInputChans, numOutputChans), blockSize);
+    MidiBuffer midi;
+    int nextMidiEvent = 0;
+    Result result (Result::ok());
+
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    while (numSamplesDone.get() < numSamples)
+    {
+        if (isCancelled())
+        {
+            result = Result::fail ("The render was cancelled");
+            break;
+        }
+
+        const int64 blockStart = numSamplesDone.get();
+        const int numThisTime = (int) jmin ((int64) blockSize, numSamples - blockStart);
+
+        buffer.setSize (buffer.getNumChannels(), numThisTime, false, false, true);
+        buffer.clear();
+
+        if (inputSource != nullptr)
+            inputSource->read (&buffer, 0, numThisTime, blockStart, true, true);
+
+        midi.clear();
+
+        if (midiInput != nullptr)
+        {
+            const int64 blockEnd = blockStart + numThisTime;
+
+            for (; nextMidiEvent < midiInput->getNumEvents(); ++nextMidiEvent)
+            {
+                const MidiMessage& m = midiInput->getEventPointer (nextMidiEvent)->message;
+                const int64 eventPos = (int64) (m.getTimeStamp() * currentSampleRate);
+
+                if (eventPos >= blockEnd)
+                    break;
+
+                midi.addEvent (m, (int) jmax ((int64) 0, eventPos - blockStart));
+            }
+        }
+
+        {
+            const ScopedLock sl (processor.getCallbackLock());
+            processor.processBlock (buffer, midi);
+        }
+
+        if (! writer.writeFromAudioSampleBuffer (buffer, 0, numThisTime))
+        {
+            result = Result::fail ("Failed to write to the output");
+            break;
+        }
+
+        currentPosition += numThisTime;
+        numSamplesDone += (int64) numThisTime;
+    }
+
+    stats.renderTime = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+    stats.numSamplesRendered = numSamplesDone.get();
+    stats.audioDuration = stats.numSamplesRendered / currentSampleRate;
+
+    if (graph != nullptr)
+    {
+        graph->setNodeTimingEnabled (graphWasTimingNodes);
+
+        for (int i = 0; i < graph->getNumNodes(); ++i)
+        {
+            const AudioProcessorGraph::Node* const node = graph->getNode (i);
+
+            NodeTiming timing;
+            timing.nodeId = node->nodeId;
+            timing.name = node->getProcessor()->getName();
+            timing.processingTime = node->getTotalProcessingTime();
+            stats.nodeTimings.add (timing);
+        }
+    }
+
+    processor.releaseResources();
+    processor.setPlayHead (nullptr);
+    processor.setNonRealtime (false);
+
+    return result;
+}
+
+//==============================================================================
+AudioProcessorOfflineRenderer::RenderJob::RenderJob (const String& jobName,
+                                                     AudioProcessor* const processorToRender,
+                                                     AudioFormatWriter* const writerToUse,
+                                                     const int64 numSamplesToRender)
+    : ThreadPoolJob (jobName),
+      processor (processorToRender),
+      writer (writerToUse),
+      numSamples (numSamplesToRender),
+      result (Result::ok())
+{
+    jassert (processor != nullptr && writer != nullptr);
+}
+
+AudioProcessorOfflineRenderer::RenderJob::~RenderJob()
+{
+}
+
+ThreadPoolJob::JobStatus AudioProcessorOfflineRenderer::RenderJob::runJob()
+{
+    if (processor != nullptr && writer != nullptr)
+    {
+        renderer.owningJob = this;
+        result = renderer.render (*processor, *writer, numSamples);
+        renderer.owningJob = nullptr;
+        writer = nullptr;
+    }
+
+    return jobHasFinished;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class AudioProcessorOfflineRendererTests  : public UnitTest
+{
+public:
+    AudioProcessorOfflineRendererTests() : UnitTest ("AudioProcessorOfflineRenderer") {}
+
+    class GainProcessor  : public AudioProcessor
+    {
+    public:
+        GainProcessor (const float gain_) : gain (gain_) {}
+
+        const String getName() const                                { return "Gain"; }
+        void prepareToPlay (double, int)                            {}
+        void releaseResources()                                     {}
+
+        void processBlock (AudioSampleBuffer& buffer, MidiBuffer&)
+        {
+            for (int i = 0; i < getNumOutputChannels(); ++i)
+                buffer.applyGain (i, 0, buffer.getNumSamples(), gain);
+        }
+
+        const String getInputChannelName (int) const                { return String::empty; }
+        const String getOutputChannelName (int) const               { return String::empty; }
+        bool isInputChannelStereoPair (int) const                   { return true; }
+        bool isOutputChannelStereoPair (int) const                  { return true; }
+        bool silenceInProducesSilenceOut() const                    { return true; }
+        double getTailLengthSeconds() const                         { return 0; }
+        bool acceptsMidi() const                                    { return false; }
+        bool producesMidi() const                                   { return false; }
+        AudioProcessorEditor* createEditor()                        { return nullptr; }
+        bool hasEditor() const                                      { return false; }
+        int getNumParameters()                                      { return 0; }
+        const String getParameterName (int)                         { return String::empty; }
+        float getParameter (int)                                    { return 0; }
+        const String getParameterText (int)                         { return String::empty; }
+        void setParameter (int, float)                              {}
+        int getNumPrograms()                                        { return 0; }
+        int getCurrentProgram()                                     { return 0; }
+        void setCurrentProgram (int)                                {}
+        const String getProgramName (int)                           { return String::empty; }
+        void changeProgramName (int, const String&)                 {}
+        void getStateInformation (MemoryBlock&)                     {}
+        void setStateInformation (const void*, int)                 {}
+
+    private:
+        const float gain;
+    };
+
+    static float getTestSample (const int channel, const int index)
+    {
+        return channel == 0 ? 0.8f * (float) std::sin (index * 0.01)
+                            : (index % 1000) / 1000.0f - 0.5f;
+    }
+
+    void runTest()
+    {
+        beginTest ("Fixed gain");
+
+        const int numSamples = 10000;
+        const double sampleRate = 44100.0;
+        WavAudioFormat wavFormat;
+        MemoryBlock inputData, outputData;
+
+        {
+            AudioSampleBuffer source (2, numSamples);
+
+            for (int chan = 0; chan < 2; ++chan)
+                for (int i = 0; i < numSamples; ++i)
+                    *source.getSampleData (chan, i) = getTestSample (chan, i);
+
+            ScopedPointer<AudioFormatWriter> writer (wavFormat.createWriterFor (new MemoryOutputStream (inputData, false),
+                                                                                sampleRate, 2, 24, StringPairArray(), 0));
+            expect (writer != nullptr && writer->writeFromAudioSampleBuffer (source, 0, numSamples));
+        }
+
+        {
+            ScopedPointer<AudioFormatReader> input (wavFormat.createReaderFor (new MemoryInputStream (inputData, false), true));
+            ScopedPointer<AudioFormatWriter> writer (wavFormat.createWriterFor (new MemoryOutputStream (outputData, false),
+                                                                                sampleRate, 2, 24, StringPairArray(), 0));
+            expect (input != nullptr && writer != nullptr);
+
+            GainProcessor processor (0.5f);
+            AudioProcessorOfflineRenderer renderer;
+            renderer.setBlockSize (4096);  // (so that the last block is a partial one)
+
+            const Result result (renderer.render (processor, *writer, numSamples, input));
+            expect (result.wasOk());
+            expectEquals ((int) renderer.getStatistics().numSamplesRendered, numSamples);
+            expect (renderer.getProgress() == 1.0);
+        }
+
+        ScopedPointer<AudioFormatReader> output (wavFormat.createReaderFor (new MemoryInputStream (outputData, false), true));
+        expect (output != nullptr);
+
+        if (output != nullptr)
+        {
+            expectEquals ((int) output->lengthInSamples, numSamples);
+
+            AudioSampleBuffer rendered (2, numSamples);
+            output->read (&rendered, 0, numSamples, 0, true, true);
+
+            float maxError = 0;
+
+            for (int chan = 0; chan < 2; ++chan)
+                for (int i = 0; i < numSamples; ++i)
+                    maxError = jmax (maxError, std::abs (*rendered.getSampleData (chan, i) - 0.5f * getTestSample (chan, i)));
+
+            expect (maxError < 1.0e-5f);
+        }
+    }
+};
+
+static AudioProcessorOfflineRendererTests audioProcessorOfflineRendererTests;
+
+#endif
@@ -0,0 +1,223 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_AUDIOPROCESSOROFFLINERENDERER_JUCEHEADER__
+#define __JUCE_AUDIOPROCESSOROFFLINERENDERER_JUCEHEADER__
+
+#include "../../juce_audio_processors/processors/juce_AudioProcessor.h"
+
+
+//==============================================================================
+/**
+    Renders the output of an AudioProcessor into an AudioFormatWriter, running
+    as fast as the CPU allows rather than in real time.
+
+    Where an AudioProcessorPlayer needs a live AudioIODevice to drive it, this
+    class pulls blocks through the processor itself, so it can be used to bounce
+    an AudioProcessorGraph (or any other processor) to a file. While rendering,
+    the processor is put into non-realtime mode and given a simulated AudioPlayHead
+    whose timeline advances with each block.
+
+    e.g. @code
+    AudioProcessorOfflineRenderer renderer;
+    renderer.setTempo (120.0, 4, 4);
+
+    const Result r (renderer.render (graph, *writer, (int64) (sampleRate * 60.0)));
+
+    DBG ("Rendered at " + String (renderer.getStatistics().getRealtimeFactor()) + "x realtime");
+    @endcode
+
+    To render several independent stems at the same time, create a RenderJob for
+    each one (each with its own processor instance) and add them to a ThreadPool.
+
+    @see AudioProcessorPlayer, AudioProcessorGraph
+*/
+class JUCE_API  AudioProcessorOfflineRenderer  : private AudioPlayHead
+{
+public:
+    //==============================================================================
+    /** Creates a renderer with a default block size of 4096 samples, and a
+        timeline running at 120bpm in 4/4.
+    */
+    AudioProcessorOfflineRenderer();
+
+    /** Destructor. */
+    ~AudioProcessorOfflineRenderer();
+
+    //==============================================================================
+    /** Sets the number of samples that will be passed to each processBlock() call.
+        Because there's no device latency to worry about, large blocks are usually
+        the most efficient choice.
+    */
+    void setBlockSize (int numSamplesPerBlock);
+
+    /** Returns the block size that will be used for rendering. */
+    int getBlockSize() const noexcept                       { return blockSize; }
+
+    /** Sets the tempo and time-signature that the simulated play head will report. */
+    void setTempo (double beatsPerMinute, int timeSigNumerator, int timeSigDenominator);
+
+    /** Sets the timeline position, in samples, that the play head will report
+        for the first rendered block.
+    */
+    void setStartPosition (int64 startSampleOnTimeline);
+
+    //==============================================================================
+    /** Renders a number of samples from a processor into a writer.
+
+        The processor is prepared using the writer's sample rate and number of channels,
+        then processed block-by-block on the calling thread until the requested length
+        has been written, after which its resources are released again.
+
+        @param processor        the processor to render. This isn't owned or deleted by the renderer,
+                                and mustn't be playing anywhere else while the render is running
+        @param writer           the destination for the rendered audio
+        @param numSamples       the total number of samples to render
+        @param inputSource      an optional reader whose audio is fed into the processor's inputs. This
+                                is read with AudioFormatReader::read (AudioSampleBuffer*...), so it
+                                supplies the first two inputs, and a mono source is fed to both
+        @param midiInput        an optional sequence of midi messages to send to the processor,
+                                whose timestamps are in seconds from the start of the render
+        @returns                a failure if the writer reports an error or the render is cancelled
+    */
+    Result render (AudioProcessor& processor,
+                   AudioFormatWriter& writer,
+                   int64 numSamples,
+                   AudioFormatReader* inputSource = nullptr,
+                   const MidiMessageSequence* midiInput = nullptr);
+
+    /** Asks a render that's running on another thread to stop as soon as possible. */
+    void cancel() noexcept;
+
+    /** Returns the proportion of the current render that has been completed, from 0 to 1.
+        This can safely be called from another thread while a render is running.
+    */
+    double getProgress() const noexcept;
+
+    //==============================================================================
+    /** Holds the timing of a single graph node during a render. */
+    struct NodeTiming
+    {
+        uint32 nodeId;          /**< The node's ID within its AudioProcessorGraph. */
+        String name;            /**< The name of the node's processor. */
+        double processingTime;  /**< The number of seconds spent inside the node's processBlock(). */
+    };
+
+    /** Describes the performance of the last render. */
+    struct Statistics
+    {
+        /** The number of samples that were written. */
+        int64 numSamplesRendered;
+
+        /** The duration of the rendered audio, in seconds. */
+        double audioDuration;
+
+        /** The wall-clock time that the render took, in seconds. */
+        double renderTime;
+
+        /** If the processor was an AudioProcessorGraph, this contains the time spent
+            in each of its nodes, in the order in which they appear in the graph.
+        */
+        Array<NodeTiming> nodeTimings;
+
+        /** Returns how many times faster than real time the render ran. */
+        double getRealtimeFactor() const noexcept       { return renderTime > 0 ? audioDuration / renderTime : 0.0; }
+    };
+
+    /** Returns the statistics gathered during the last call to render(). */
+    const Statistics& getStatistics() const noexcept        { return stats; }
+
+    //==============================================================================
+    /** A ThreadPoolJob that runs a render in the background - see its declaration below. */
+    class RenderJob;
+
+private:
+    //==============================================================================
+    int blockSize;
+    double bpm;
+    int timeSigNumerator, timeSigDenominator;
+    int64 startPosition, currentPosition;
+    double currentSampleRate;
+    int64 totalSamples;
+    Atomic<int64> numSamplesDone;
+    bool volatile shouldCancel;
+    ThreadPoolJob* owningJob;
+    Statistics stats;
+
+    bool isCancelled() const noexcept;
+    bool getCurrentPosition (CurrentPositionInfo&);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorOfflineRenderer)
+};
+
+//==============================================================================
+/**
+    A ThreadPoolJob that renders a processor to a writer, so that several renders
+    (e.g. the stems of a mix) can run in parallel.
+
+    Each job needs its own processor and writer - processors can't be shared between
+    jobs that run at the same time.
+*/
+class JUCE_API  AudioProcessorOfflineRenderer::RenderJob  : public ThreadPoolJob
+{
+public:
+    /** Creates a job that will render the given number of samples.
+        The job takes ownership of the processor and writer, and deletes them when
+        it's destroyed. The writer is deleted (and so flushed) before runJob() returns.
+    */
+    RenderJob (const String& jobName,
+               AudioProcessor* processorToRender,
+               AudioFormatWriter* writerToUse,
+               int64 numSamplesToRender);
+
+    /** Destructor. */
+    ~RenderJob();
+
+    /** Returns the renderer that this job uses, so that its settings can be changed
+        before the job is started, and its statistics read afterwards.
+    */
+    AudioProcessorOfflineRenderer& getRenderer() noexcept   { return renderer; }
+
+    /** Returns the processor that this job renders. */
+    AudioProcessor* getProcessor() const noexcept            { return processor; }
+
+    /** Returns the outcome of the render once the job has finished. */
+    const Result& getResult() const noexcept                 { return result; }
+
+    /** @internal */
+    JobStatus runJob();
+
+private:
+    AudioProcessorOfflineRenderer renderer;
+    ScopedPointer<AudioProcessor> processor;
+    ScopedPointer<AudioFormatWriter> writer;
+    const int64 numSamples;
+    Result result;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+};
+
+
+#endif   // __JUCE_AUDIOPROCESSOROFFLINERENDERER_JUCEHEADER__
@@ -134,6 +134,7 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
         }
         else
         {
+            const TimingHistory::ScopedMeasurement sm (processTiming);
             processor->processBlock (buffer, incomingMidi);
         }
     }
@@ -155,6 +156,7 @@ void AudioProcessorPlayer::audioDeviceAboutToStart (AudioIODevice* const device)
 
     messageCollector.reset (sampleRate);
     channels.calloc (jmax (numChansIn, numChansOut) + 2);
+    processTiming.reset();
 
     if (processor != nullptr)
     {
@@ -180,6 +182,11 @@ void AudioProcessorPlayer::audioDeviceStopped()
     tempBuffer.setSize (1, 1);
 }
 
+TimingHistory::Statistics AudioProcessorPlayer::getCpuUsageStatistics() const
+{
+    return processTiming.getStatistics().getAsProportionOf (sampleRate > 0 ? blockSize / sampleRate : 0.0);
+}
+
 void AudioProcessorPlayer::handleIncomingMidiMessage (MidiInput*, const MidiMessage& message)
 {
     messageCollector.addMessageToQueue (message);
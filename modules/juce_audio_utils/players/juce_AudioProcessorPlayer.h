@@ -69,6 +69,16 @@ public:
     */
     MidiMessageCollector& getMidiMessageCollector()                 { return messageCollector; }
 
+    //==============================================================================
+    /** Returns statistics about how long the processor's recent processBlock() calls took.
+
+        Each duration is given as a proportion of the length of the device's audio block,
+        so a value of 1.0 means that the processor used all of the time available to it.
+        This can be called from the message thread while audio is playing.
+        @see AudioDeviceManager::getCpuUsageStatistics
+    */
+    TimingHistory::Statistics getCpuUsageStatistics() const;
+
     //==============================================================================
     /** @internal */
     void audioDeviceIOCallback (const float** inputChannelData,
@@ -97,6 +107,7 @@ private:
 
     MidiBuffer incomingMidi;
     MidiMessageCollector messageCollector;
+    TimingHistory processTiming;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorPlayer)
 };
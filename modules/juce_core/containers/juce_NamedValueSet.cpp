@@ -46,8 +46,7 @@ NamedValueSet::NamedValue& NamedValueSet::NamedValue::operator= (const NamedValu
 
 #if JUCE_COMPILER_SUPPORTS_MOVE_SEMANTICS
 NamedValueSet::NamedValue::NamedValue (NamedValue&& other) noexcept
-    : nextListItem (static_cast <LinkedListPointer<NamedValue>&&> (other.nextListItem)),
-      name (static_cast <Identifier&&> (other.name)),
+    : name (static_cast <Identifier&&> (other.name)),
       value (static_cast <var&&> (other.value))
 {
 }
@@ -59,7 +58,6 @@ inline NamedValueSet::NamedValue::NamedValue (const Identifier& n, var&& v)
 
 NamedValueSet::NamedValue& NamedValueSet::NamedValue::operator= (NamedValue&& other) noexcept
 {
-    nextListItem = static_cast <LinkedListPointer<NamedValue>&&> (other.nextListItem);
     name = static_cast <Identifier&&> (other.name);
     value = static_cast <var&&> (other.value);
     return *this;
@@ -73,58 +71,58 @@ bool NamedValueSet::NamedValue::operator== (const NamedValueSet::NamedValue& oth
 
 //==============================================================================
 NamedValueSet::NamedValueSet() noexcept
+    : indexSize (0)
 {
 }
 
 NamedValueSet::NamedValueSet (const NamedValueSet& other)
+    : values (other.values), indexSize (0)
 {
-    values.addCopyOfList (other.values);
+    rebuildIndex();
 }
 
 NamedValueSet& NamedValueSet::operator= (const NamedValueSet& other)
 {
-    clear();
-    values.addCopyOfList (other.values);
+    values = other.values;
+    rebuildIndex();
     return *this;
 }
 
 #if JUCE_COMPILER_SUPPORTS_MOVE_SEMANTICS
 NamedValueSet::NamedValueSet (NamedValueSet&& other) noexcept
-    : values (static_cast <LinkedListPointer<NamedValue>&&> (other.values))
+    : indexSize (0)
 {
+    values.swapWithArray (other.values);
+    index.swapWith (other.index);
+    std::swap (indexSize, other.indexSize);
 }
 
 NamedValueSet& NamedValueSet::operator= (NamedValueSet&& other) noexcept
 {
-    other.values.swapWith (values);
+    values.swapWithArray (other.values);
+    index.swapWith (other.index);
+    std::swap (indexSize, other.indexSize);
     return *this;
 }
 #endif
 
 NamedValueSet::~NamedValueSet()
 {
-    clear();
 }
 
 void NamedValueSet::clear()
 {
-    values.deleteAll();
+    values.clear();
+    index.free();
+    indexSize = 0;
 }
 
 bool NamedValueSet::operator== (const NamedValueSet& other) const
 {
-    const NamedValue* i1 = values;
-    const NamedValue* i2 = other.values;
-
-    while (i1 != nullptr && i2 != nullptr)
-    {
-        if (! (*i1 == *i2))
+    for (int i = jmin (values.size(), other.values.size()); --i >= 0;)
+        if (! (values.getReference(i) == other.values.getReference(i)))
             return false;
 
-        i1 = i1->nextListItem;
-        i2 = i2->nextListItem;
-    }
-
     return true;
 }
 
@@ -138,13 +136,87 @@ int NamedValueSet::size() const noexcept
     return values.size();
 }
 
-const var& NamedValueSet::operator[] (const Identifier& name) const
+//==============================================================================
+namespace NamedValueSetHelpers
 {
-    for (NamedValue* i = values; i != nullptr; i = i->nextListItem)
-        if (i->name == name)
-            return i->value;
+    // Identifiers are pooled, so two that are equal always share the same pointer,
+    // and the pointer itself can be used as the hash.
+    inline uint32 hashIdentifier (const Identifier& name) noexcept
+    {
+        const uint64 p = (uint64) (pointer_sized_int) name.getCharPointer().getAddress();
+        return (uint32) ((p ^ (p >> 29)) * 0x9e3779b1u >> 7);
+    }
+}
 
-    return var::null;
+int NamedValueSet::indexOf (const Identifier& name) const noexcept
+{
+    if (indexSize == 0)
+    {
+        for (int i = 0; i < values.size(); ++i)
+            if (values.getReference(i).name == name)
+                return i;
+
+        return -1;
+    }
+
+    const int mask = indexSize - 1;
+
+    for (int slot = (int) NamedValueSetHelpers::hashIdentifier (name) & mask;; slot = (slot + 1) & mask)
+    {
+        const int i = index[slot] - 1;
+
+        if (i < 0 || values.getReference(i).name == name)
+            return i;
+    }
+}
+
+void NamedValueSet::addToIndex (const int position) noexcept
+{
+    const int mask = indexSize - 1;
+    int slot = (int) NamedValueSetHelpers::hashIdentifier (values.getReference (position).name) & mask;
+
+    while (index[slot] != 0)
+        slot = (slot + 1) & mask;
+
+    index[slot] = position + 1;
+}
+
+void NamedValueSet::rebuildIndex()
+{
+    if (values.size() < minSizeForIndex)
+    {
+        index.free();
+        indexSize = 0;
+        return;
+    }
+
+    // keep the table no more than half full..
+    indexSize = nextPowerOfTwo (values.size() * 2 + 1);
+    index.calloc ((size_t) indexSize);
+
+    for (int i = 0; i < values.size(); ++i)
+        addToIndex (i);
+}
+
+int NamedValueSet::add (const Identifier& name)
+{
+    const int position = values.size();
+    values.add (NamedValue (name, var::null));
+
+    if (indexSize == 0 ? values.size() >= minSizeForIndex
+                       : values.size() * 2 >= indexSize)
+        rebuildIndex();
+    else if (indexSize > 0)
+        addToIndex (position);
+
+    return position;
+}
+
+//==============================================================================
+const var& NamedValueSet::operator[] (const Identifier& name) const
+{
+    const int i = indexOf (name);
+    return i >= 0 ? values.getReference(i).value : var::null;
 }
 
 var NamedValueSet::getWithDefault (const Identifier& name, const var& defaultReturnValue) const
@@ -157,111 +229,87 @@ var NamedValueSet::getWithDefault (const Identifier& name, const var& defaultRet
 
 var* NamedValueSet::getVarPointer (const Identifier& name) const noexcept
 {
-    for (NamedValue* i = values; i != nullptr; i = i->nextListItem)
-        if (i->name == name)
-            return &(i->value);
-
-    return nullptr;
+    const int i = indexOf (name);
+    return i >= 0 ? &(values.getReference(i).value) : nullptr;
 }
 
 #if JUCE_COMPILER_SUPPORTS_MOVE_SEMANTICS
 bool NamedValueSet::set (const Identifier& name, var&& newValue)
 {
-    LinkedListPointer<NamedValue>* i = &values;
+    int i = indexOf (name);
 
-    while (i->get() != nullptr)
+    if (i >= 0)
     {
-        NamedValue* const v = i->get();
-
-        if (v->name == name)
-        {
-            if (v->value.equalsWithSameType (newValue))
-                return false;
+        var& v = values.getReference(i).value;
 
-            v->value = static_cast <var&&> (newValue);
-            return true;
-        }
+        if (v.equalsWithSameType (newValue))
+            return false;
 
-        i = &(v->nextListItem);
+        v = static_cast <var&&> (newValue);
+        return true;
     }
 
-    i->insertNext (new NamedValue (name, static_cast <var&&> (newValue)));
+    i = add (name);
+    values.getReference(i).value = static_cast <var&&> (newValue);
     return true;
 }
 #endif
 
 bool NamedValueSet::set (const Identifier& name, const var& newValue)
 {
-    LinkedListPointer<NamedValue>* i = &values;
+    int i = indexOf (name);
 
-    while (i->get() != nullptr)
+    if (i >= 0)
     {
-        NamedValue* const v = i->get();
-
-        if (v->name == name)
-        {
-            if (v->value.equalsWithSameType (newValue))
-                return false;
+        var& v = values.getReference(i).value;
 
-            v->value = newValue;
-            return true;
-        }
+        if (v.equalsWithSameType (newValue))
+            return false;
 
-        i = &(v->nextListItem);
+        v = newValue;
+        return true;
     }
 
-    i->insertNext (new NamedValue (name, newValue));
+    i = add (name);
+    values.getReference(i).value = newValue;
     return true;
 }
 
 bool NamedValueSet::contains (const Identifier& name) const
 {
-    return getVarPointer (name) != nullptr;
+    return indexOf (name) >= 0;
 }
 
 bool NamedValueSet::remove (const Identifier& name)
 {
-    LinkedListPointer<NamedValue>* i = &values;
+    const int i = indexOf (name);
 
-    for (;;)
-    {
-        NamedValue* const v = i->get();
-
-        if (v == nullptr)
-            break;
-
-        if (v->name == name)
-        {
-            delete i->removeNext();
-            return true;
-        }
+    if (i < 0)
+        return false;
 
-        i = &(v->nextListItem);
-    }
-
-    return false;
+    values.remove (i);
+    rebuildIndex();
+    return true;
 }
 
 const Identifier NamedValueSet::getName (const int index) const
 {
-    const NamedValue* const v = values[index];
-    jassert (v != nullptr);
-    return v->name;
+    jassert (isPositiveAndBelow (index, values.size()));
+    return values [index].name;
 }
 
 const var& NamedValueSet::getValueAt (const int index) const
 {
-    const NamedValue* const v = values[index];
-    jassert (v != nullptr);
-    return v->value;
+    jassert (isPositiveAndBelow (index, values.size()));
+    return isPositiveAndBelow (index, values.size()) ? values.getReference (index).value : var::null;
 }
 
 void NamedValueSet::setFromXmlAttributes (const XmlElement& xml)
 {
     clear();
-    LinkedListPointer<NamedValue>::Appender appender (values);
 
     const int numAtts = xml.getNumAttributes(); // xxx inefficient - should write an att iterator..
+    values.ensureStorageAllocated (numAtts);
 
     for (int i = 0; i < numAtts; ++i)
     {
@@ -274,19 +322,23 @@ void NamedValueSet::setFromXmlAttributes (const XmlElement& xml)
 
             if (mb.fromBase64Encoding (value))
             {
-                appender.append (new NamedValue (name.substring (7), var (mb)));
+                values.add (NamedValue (name.substring (7), var (mb)));
                 continue;
             }
         }
 
-        appender.append (new NamedValue (name, var (value)));
+        values.add (NamedValue (name, var (value)));
     }
+
+    rebuildIndex();
 }
 
 void NamedValueSet::copyToXmlAttributes (XmlElement& xml) const
 {
-    for (NamedValue* i = values; i != nullptr; i = i->nextListItem)
+    for (int j = 0; j < values.size(); ++j)
     {
+        const NamedValue* const i = &values.getReference (j);
+
         if (const MemoryBlock* mb = i->value.getBinaryData())
         {
             xml.setAttribute ("base64:" + i->name.toString(),
@@ -304,3 +356,83 @@ void NamedValueSet::copyToXmlAttributes (XmlElement& xml) const
         }
     }
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class NamedValueSetTests  : public UnitTest
+{
+public:
+    NamedValueSetTests() : UnitTest ("NamedValueSet") {}
+
+    void runTest()
+    {
+        beginTest ("Basics");
+
+        // large enough for the hash index to be used..
+        const int numItems = 100;
+        Array<Identifier> names;
+
+        for (int i = 0; i < numItems; ++i)
+            names.add (Identifier ("prop" + String (i)));
+
+        NamedValueSet set;
+
+        for (int i = 0; i < numItems; ++i)
+            expect (set.set (names[i], i));
+
+        expect (! set.set (names[10], 10));
+        expect (set.set (names[10], "ten"));
+        expectEquals (set.size(), numItems);
+        expect (set [names[10]] == var ("ten"));
+        expect (set [Identifier ("missing")].isVoid());
+        expect (set.getVarPointer (names[20]) != nullptr && *set.getVarPointer (names[20]) == var (20));
+
+        // items must stay in the order they were added..
+        for (int i = 0; i < numItems; ++i)
+            expect (set.getName (i) == names[i]);
+
+        expect (set.remove (names[0]));
+        expect (! set.remove (names[0]));
+        expect (! set.contains (names[0]));
+        expect (set.getName (0) == names[1]);
+
+        for (int i = 1; i < numItems; ++i)
+            expect (set.contains (names[i]));
+
+        NamedValueSet copy (set);
+        expect (copy == set);
+        expect (copy [names[99]] == var (99));
+
+        for (int i = numItems; --i > 2;)
+            copy.remove (names[i]);
+
+        expectEquals (copy.size(), 2);
+        expect (copy [names[1]] == var (1) && copy [names[2]] == var (2));
+
+        beginTest ("Wide sets");
+
+        const uint32 startTime = Time::getMillisecondCounter();
+        int64 total = 0;
+
+        for (int n = 0; n < 200; ++n)
+        {
+            NamedValueSet s;
+
+            for (int i = 0; i < numItems; ++i)
+                s.set (names[i], i);
+
+            for (int j = 0; j < 10; ++j)
+                for (int i = 0; i < numItems; ++i)
+                    total += (int) s [names[i]];
+        }
+
+        expectEquals (total, (int64) 200 * 10 * (numItems * (numItems - 1) / 2));
+        logMessage ("200 sets of " + String (numItems) + " properties: "
+                      + String (Time::getMillisecondCounter() - startTime) + "ms");
+    }
+};
+
+static NamedValueSetTests namedValueSetUnitTests;
+
+#endif
@@ -27,11 +27,8 @@
 #define __JUCE_NAMEDVALUESET_JUCEHEADER__
 
 #include "juce_Variant.h"
-#include "../containers/juce_LinkedListPointer.h"
+#include "../containers/juce_Array.h"
 class XmlElement;
-#ifndef DOXYGEN
- class JSONFormatter;
-#endif
 
 
 //==============================================================================
@@ -39,6 +36,11 @@ class XmlElement;
 
     This can be used as a basic structure to hold a set of var object, which can
     be retrieved by using their identifier.
+
+    The values are kept in a contiguous array in the order in which they were added.
+    Small sets are searched linearly, but once a set grows beyond a handful of items,
+    a hash index of the identifiers is built, so that lookups stay fast for objects
+    with large numbers of properties.
 */
 class JUCE_API  NamedValueSet
 {
@@ -120,6 +122,9 @@ public:
 
         Do not use this method unless you really need access to the internal var object
         for some reason - for normal reading and writing always prefer operator[]() and set().
+
+        Note that the pointer will become invalid as soon as any values are added to or
+        removed from the set.
     */
     var* getVarPointer (const Identifier& name) const noexcept;
 
@@ -148,7 +153,6 @@ private:
        #endif
         bool operator== (const NamedValue& other) const noexcept;
 
-        LinkedListPointer<NamedValue> nextListItem;
         Identifier name;
         var value;
 
@@ -156,10 +160,16 @@ private:
         JUCE_LEAK_DETECTOR (NamedValue)
     };
 
-    friend class LinkedListPointer<NamedValue>;
-    LinkedListPointer<NamedValue> values;
+    Array<NamedValue> values;
+    HeapBlock<int> index;   // an open-addressed hash table of (position in values + 1)
+    int indexSize;
+
+    enum { minSizeForIndex = 12 };
 
-    friend class JSONFormatter;
+    int indexOf (const Identifier&) const noexcept;
+    int add (const Identifier&);
+    void addToIndex (int position) noexcept;
+    void rebuildIndex();
 };
 
 
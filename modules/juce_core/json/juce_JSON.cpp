@@ -357,38 +357,45 @@ public:
         }
     }
 
-private:
     enum { indentSize = 2 };
 
-    static void writeEscapedChar (OutputStream& out, const unsigned short value)
-    {
-        out << "\\u" << String::toHexString ((int) value).paddedLeft ('0', 4);
-    }
-
     static void writeString (OutputStream& out, String::CharPointerType t)
     {
-        out << '"';
+        // The output is collected in a small local buffer, to avoid making a call to
+        // the stream for every character..
+        char buffer [256];
+        int num = 0;
+        buffer [num++] = '"';
 
         for (;;)
         {
+            if (num > numElementsInArray (buffer) - 16)
+            {
+                out.write (buffer, (size_t) num);
+                num = 0;
+            }
+
             const juce_wchar c (t.getAndAdvance());
 
             switch (c)
             {
-                case 0:  out << '"'; return;
-
-                case '\"':  out << "\\\""; break;
-                case '\\':  out << "\\\\"; break;
-                case '\b':  out << "\\b";  break;
-                case '\f':  out << "\\f";  break;
-                case '\t':  out << "\\t";  break;
-                case '\r':  out << "\\r";  break;
-                case '\n':  out << "\\n";  break;
+                case 0:
+                    buffer [num++] = '"';
+                    out.write (buffer, (size_t) num);
+                    return;
+
+                case '\"':  buffer [num++] = '\\'; buffer [num++] = '"';  break;
+                case '\\':  buffer [num++] = '\\'; buffer [num++] = '\\'; break;
+                case '\b':  buffer [num++] = '\\'; buffer [num++] = 'b';  break;
+                case '\f':  buffer [num++] = '\\'; buffer [num++] = 'f';  break;
+                case '\t':  buffer [num++] = '\\'; buffer [num++] = 't';  break;
+                case '\r':  buffer [num++] = '\\'; buffer [num++] = 'r';  break;
+                case '\n':  buffer [num++] = '\\'; buffer [num++] = 'n';  break;
 
                 default:
                     if (c >= 32 && c < 127)
                     {
-                        out << (char) c;
+                        buffer [num++] = (char) c;
                     }
                     else
                     {
@@ -399,11 +406,15 @@ private:
                             utf16.write (c);
 
                             for (int i = 0; i < 2; ++i)
-                                writeEscapedChar (out, (unsigned short) chars[i]);
+                            {
+                                writeEscapedChar (buffer + num, (unsigned short) chars[i]);
+                                num += 6;
+                            }
                         }
                         else
                         {
-                            writeEscapedChar (out, (unsigned short) c);
+                            writeEscapedChar (buffer + num, (unsigned short) c);
+                            num += 6;
                         }
                     }
 
@@ -457,23 +468,16 @@ private:
         if (! allOnOneLine)
             out << newLine;
 
-        LinkedListPointer<NamedValueSet::NamedValue>* i = &(props.values);
-
-        for (;;)
+        for (int i = 0; i < props.size(); ++i)
         {
-            NamedValueSet::NamedValue* const v = i->get();
-
-            if (v == nullptr)
-                break;
-
             if (! allOnOneLine)
                 writeSpaces (out, indentLevel + indentSize);
 
-            writeString (out, v->name);
+            writeString (out, props.getName (i));
             out << ": ";
-            write (out, v->value, indentLevel + indentSize, allOnOneLine);
+            write (out, props.getValueAt (i), indentLevel + indentSize, allOnOneLine);
 
-            if (v->nextListItem.get() != nullptr)
+            if (i < props.size() - 1)
             {
                 if (allOnOneLine)
                     out << ", ";
@@ -482,8 +486,6 @@ private:
             }
             else if (! allOnOneLine)
                 out << newLine;
-
-            i = &(v->nextListItem);
         }
 
         if (! allOnOneLine)
@@ -491,6 +493,19 @@ private:
 
         out << '}';
     }
+
+private:
+    // writes a 6-character "\\uXXXX" sequence
+    static void writeEscapedChar (char* const dest, const unsigned short value) noexcept
+    {
+        static const char hexDigits[] = "0123456789abcdef";
+
+        dest[0] = '\\';
+        dest[1] = 'u';
+
+        for (int i = 0; i < 4; ++i)
+            dest [2 + i] = hexDigits [(value >> (12 - 4 * i)) & 15];
+    }
 };
 
 //==============================================================================
@@ -506,12 +521,19 @@ var JSON::parse (const String& text)
 
 var JSON::parse (InputStream& input)
 {
-    return parse (input.readEntireStreamAsString());
+    // (reading via a JSONDocument avoids loading the whole stream into a string first)
+    JSONDocument doc;
+
+    if (doc.parse (input).failed())
+        return var::null;
+
+    return doc.getRoot().toVar();
 }
 
 var JSON::parse (const File& file)
 {
-    return parse (file.loadFileAsString());
+    FileInputStream in (file);
+    return parse (in);
 }
 
 Result JSON::parse (const String& text, var& result)
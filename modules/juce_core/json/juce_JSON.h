@@ -69,8 +69,8 @@ public:
     /** Attempts to parse some JSON-formatted text from a file, and returns the result
         as a var object.
 
-        Note that this is just a short-cut for reading the entire file into a string and
-        parsing the result.
+        The file is read with a JSONDocument, so it doesn't need to be loaded into a
+        string first.
 
         If the parsing fails, this simply returns var::null - if you need to find out more
         detail about the parse error, use the alternative parse() method which returns a Result.
@@ -80,8 +80,9 @@ public:
     /** Attempts to parse some JSON-formatted text from a stream, and returns the result
         as a var object.
 
-        Note that this is just a short-cut for reading the entire stream into a string and
-        parsing the result.
+        The stream is read with a JSONDocument, so it doesn't need to be loaded into a
+        string first. If you don't need the result as a var, using a JSONDocument
+        directly will be much faster.
 
         If the parsing fails, this simply returns var::null - if you need to find out more
         detail about the parse error, use the alternative parse() method which returns a Result.
@@ -100,7 +101,8 @@ public:
     /** Writes a JSON-formatted representation of the var object to the given stream.
         If allOnOneLine is true, the result will be compacted into a single line of text
         with no carriage-returns. If false, it will be laid-out in a more human-readable format.
-        @see toString
+        To write a large document without building it as a var first, use a JSONWriter.
+        @see toString, JSONWriter
     */
     static void writeToStream (OutputStream& output,
                                const var& objectToFormat,
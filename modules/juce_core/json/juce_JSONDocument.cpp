@@ -0,0 +1,842 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+struct JSONDocument::Item
+{
+    enum Type
+    {
+        nullType,
+        boolType,
+        intType,
+        doubleType,
+        stringType,
+        arrayType,
+        objectType
+    };
+
+    union
+    {
+        int64 intValue;
+        double doubleValue;
+        const char* text;
+        const Item* children;
+    };
+
+    const char* name;   // only used for the properties of an object
+    int size;           // the number of bytes in a string, or the number of items in an array or object
+    int type;
+};
+
+//==============================================================================
+class JSONDocument::Parser
+{
+public:
+    Parser (JSONDocument& doc, InputStream& in)
+        : document (doc), input (in), buffer ((size_t) bufferSize),
+          bufferStart (0), bufferEnd (0), bufferPosInStream (0), endOfInput (false),
+          numPropertyNames (0)
+    {
+    }
+
+    Result parse (const Item*& result)
+    {
+        const int firstChar = skipWhitespace();
+
+        if (firstChar < 0)
+        {
+            result = nullptr;
+            return Result::ok();
+        }
+
+        if (firstChar != '{' && firstChar != '[')
+            return createFail ("Expected '{' or '['");
+
+        for (;;)
+        {
+            Item item;
+            item.name = nullptr;
+            item.size = 0;
+            item.intValue = 0;
+
+            if (isInsideObject())
+            {
+                if (skipWhitespace() != '"')
+                    return createFail ("Expected object member declaration");
+
+                ++bufferStart;
+                Result r (readString (item.name, item.size, true));
+
+                if (r.failed())
+                    return r;
+
+                if (item.size == 0)
+                    return createFail ("Expected object member declaration");
+
+                if (skipWhitespace() != ':')
+                    return createFail ("Expected ':'");
+
+                ++bufferStart;
+            }
+
+            const int c = skipWhitespace();
+
+            if (c < 0)
+                return createFail ("Unexpected end-of-input");
+
+            ++bufferStart;
+
+            if (c == '{' || c == '[')
+            {
+                item.type = (c == '{') ? Item::objectType : Item::arrayType;
+                items.add (item);
+                openContainers.add (items.size() - 1);
+
+                if (skipWhitespace() != (c == '{' ? '}' : ']'))
+                    continue;
+
+                ++bufferStart;
+                closeContainer();
+            }
+            else
+            {
+                Result r (readSimpleValue (c, item));
+
+                if (r.failed())
+                    return r;
+
+                items.add (item);
+            }
+
+            // now skip any separators and closing brackets up to the next item..
+            for (;;)
+            {
+                if (openContainers.size() == 0)
+                {
+                    result = copyItems (items.getRawDataPointer(), 1);
+                    return Result::ok();
+                }
+
+                const int next = skipWhitespace();
+                ++bufferStart;
+
+                if (next == ',')
+                    break;
+
+                if (next != (isInsideObject() ? '}' : ']'))
+                {
+                    --bufferStart;
+                    return createFail (next < 0 ? "Unexpected end-of-input"
+                                                : (isInsideObject() ? "Expected ',' or '}'"
+                                                                    : "Expected ',' or ']'"));
+                }
+
+                closeContainer();
+            }
+        }
+    }
+
+private:
+    //==============================================================================
+    JSONDocument& document;
+    InputStream& input;
+    HeapBlock<char> buffer;
+    int bufferStart, bufferEnd;
+    int64 bufferPosInStream;
+    bool endOfInput;
+
+    Array<Item> items;
+    Array<int> openContainers;
+    Array<const char*> propertyNames;
+    int numPropertyNames;
+    MemoryOutputStream stringBuffer;
+
+    enum { bufferSize = 32768 };
+
+    bool isInsideObject() const noexcept
+    {
+        return openContainers.size() > 0
+                && items.getReference (openContainers.getLast()).type == Item::objectType;
+    }
+
+    // When a container is closed, its items are moved off the stack into a contiguous block
+    void closeContainer()
+    {
+        const int start = openContainers.getLast();
+        openContainers.removeLast();
+
+        const int numChildren = items.size() - start - 1;
+        Item& container = items.getReference (start);
+        container.children = copyItems (items.getRawDataPointer() + start + 1, numChildren);
+        container.size = numChildren;
+        items.removeRange (start + 1, numChildren);
+    }
+
+    const Item* copyItems (const Item* source, const int num)
+    {
+        if (num == 0)
+            return nullptr;
+
+        Item* const dest = reinterpret_cast <Item*> (document.allocate (sizeof (Item) * (size_t) num));
+        memcpy (dest, source, sizeof (Item) * (size_t) num);
+        return dest;
+    }
+
+    Result createFail (const char* const message) const
+    {
+        return Result::fail (String (message) + " at offset " + String (bufferPosInStream + bufferStart));
+    }
+
+    //==============================================================================
+    bool ensureAvailable (const int numBytes)
+    {
+        if (bufferEnd - bufferStart >= numBytes)
+            return true;
+
+        if (endOfInput)
+            return false;
+
+        const int remaining = bufferEnd - bufferStart;
+        memmove (buffer, buffer + bufferStart, (size_t) remaining);
+        bufferPosInStream += bufferStart;
+        bufferStart = 0;
+        bufferEnd = remaining;
+
+        while (bufferEnd < numBytes)
+        {
+            const int bytesRead = input.read (buffer + bufferEnd, (int) bufferSize - bufferEnd);
+
+            if (bytesRead <= 0)
+            {
+                endOfInput = true;
+                break;
+            }
+
+            bufferEnd += bytesRead;
+        }
+
+        return bufferEnd >= numBytes;
+    }
+
+    int peek (const int offset = 0)
+    {
+        return ensureAvailable (offset + 1) ? (int) (uint8) buffer [bufferStart + offset] : -1;
+    }
+
+    int skipWhitespace()
+    {
+        for (;;)
+        {
+            const int c = peek();
+
+            if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+                return c;
+
+            ++bufferStart;
+        }
+    }
+
+    //==============================================================================
+    Result readSimpleValue (const int firstChar, Item& item)
+    {
+        switch (firstChar)
+        {
+            case '"':
+                item.type = Item::stringType;
+                return readString (item.text, item.size, false);
+
+            case '-':
+                if (! CharacterFunctions::isDigit ((char) peek()))
+                    break;
+
+                return readNumber (item, true);
+
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                --bufferStart;
+                return readNumber (item, false);
+
+            case 't':
+                item.type = Item::boolType;
+                item.intValue = 1;
+                return readLiteral ("rue");
+
+            case 'f':
+                item.type = Item::boolType;
+                item.intValue = 0;
+                return readLiteral ("alse");
+
+            case 'n':
+                item.type = Item::nullType;
+                return readLiteral ("ull");
+
+            default:
+                break;
+        }
+
+        --bufferStart;
+        return createFail ("Syntax error");
+    }
+
+    Result readLiteral (const char* const rest)
+    {
+        const int len = (int) strlen (rest);
+
+        if (! (ensureAvailable (len) && memcmp (buffer + bufferStart, rest, (size_t) len) == 0))
+            return createFail ("Syntax error");
+
+        bufferStart += len;
+        return Result::ok();
+    }
+
+    Result readNumber (Item& item, const bool isNegative)
+    {
+        char text[64];
+        int len = 0;
+        bool isDouble = false;
+
+        for (;;)
+        {
+            const int c = peek();
+
+            if (c >= '0' && c <= '9')
+            {
+            }
+            else if (c == '.' || c == 'e' || c == 'E' || ((c == '-' || c == '+') && isDouble))
+            {
+                isDouble = true;
+            }
+            else
+            {
+                break;
+            }
+
+            if (len >= numElementsInArray (text) - 1)
+                return createFail ("Syntax error in number");
+
+            text[len++] = (char) c;
+            ++bufferStart;
+        }
+
+        text[len] = 0;
+
+        if (isDouble)
+        {
+            CharPointer_ASCII t (text);
+            const double value = CharacterFunctions::readDoubleValue (t);
+            item.type = Item::doubleType;
+            item.doubleValue = isNegative ? -value : value;
+        }
+        else
+        {
+            int64 value = 0;
+
+            for (int i = 0; i < len; ++i)
+                value = value * 10 + (text[i] - '0');
+
+            item.type = Item::intType;
+            item.intValue = isNegative ? -value : value;
+        }
+
+        return Result::ok();
+    }
+
+    // Reads the rest of a string after its opening quote, and copies it into the document
+    Result readString (const char*& result, int& numBytes, const bool isPropertyName)
+    {
+        stringBuffer.reset();
+
+        for (;;)
+        {
+            if (! ensureAvailable (1))
+                return createFail ("Unexpected end-of-input in string constant");
+
+            const char* const data = buffer + bufferStart;
+            const int num = bufferEnd - bufferStart;
+            int i = 0;
+
+            while (i < num && data[i] != '"' && data[i] != '\\')
+                ++i;
+
+            stringBuffer.write (data, (size_t) i);
+            bufferStart += i;
+
+            if (i < num)
+            {
+                ++bufferStart;
+
+                if (data[i] == '"')
+                    break;
+
+                Result r (readEscapeSequence());
+
+                if (r.failed())
+                    return r;
+            }
+        }
+
+        numBytes = (int) stringBuffer.getDataSize();
+        const char* const text = static_cast <const char*> (stringBuffer.getData());
+        result = isPropertyName ? getPooledPropertyName (text, numBytes)
+                                : copyString (text, numBytes);
+        return Result::ok();
+    }
+
+    const char* copyString (const char* const text, const int numBytes)
+    {
+        char* const dest = document.allocate ((size_t) numBytes + 1);
+        memcpy (dest, text, (size_t) numBytes);
+        dest [numBytes] = 0;
+        return dest;
+    }
+
+    static uint32 hashString (const char* text, int numBytes) noexcept
+    {
+        uint32 hash = 2166136261u;
+
+        while (--numBytes >= 0)
+            hash = (hash ^ (uint8) *text++) * 16777619u;
+
+        return hash;
+    }
+
+    // Property names tend to be repeated many times, so only one copy of each is kept
+    const char* getPooledPropertyName (const char* const text, const int numBytes)
+    {
+        if (numPropertyNames * 2 >= propertyNames.size())
+        {
+            Array<const char*> oldNames;
+            oldNames.swapWithArray (propertyNames);
+            propertyNames.insertMultiple (0, (const char*) nullptr, jmax (256, oldNames.size() * 2));
+
+            for (int i = 0; i < oldNames.size(); ++i)
+                if (const char* const name = oldNames.getUnchecked (i))
+                    propertyNames.getReference (findPropertyNameSlot (name, (int) strlen (name))) = name;
+        }
+
+        const int slot = findPropertyNameSlot (text, numBytes);
+        const char*& name = propertyNames.getReference (slot);
+
+        if (name == nullptr)
+        {
+            name = copyString (text, numBytes);
+            ++numPropertyNames;
+        }
+
+        return name;
+    }
+
+    int findPropertyNameSlot (const char* const text, const int numBytes) const noexcept
+    {
+        const int mask = propertyNames.size() - 1;
+
+        for (int slot = (int) (hashString (text, numBytes) & (uint32) mask);; slot = (slot + 1) & mask)
+        {
+            const char* const name = propertyNames.getUnchecked (slot);
+
+            if (name == nullptr || (strncmp (name, text, (size_t) numBytes) == 0 && name [numBytes] == 0))
+                return slot;
+        }
+    }
+
+    Result readEscapeSequence()
+    {
+        juce_wchar c = (juce_wchar) peek();
+        ++bufferStart;
+
+        switch (c)
+        {
+            case '"':
+            case '\\':
+            case '/':  break;
+
+            case 'b':  c = '\b'; break;
+            case 'f':  c = '\f'; break;
+            case 'n':  c = '\n'; break;
+            case 'r':  c = '\r'; break;
+            case 't':  c = '\t'; break;
+
+            case 'u':
+            {
+                Result r (readUnicodeEscape (c));
+
+                if (r.failed())
+                    return r;
+
+                // combine any surrogate pairs that were written by JSON::toString()
+                if (c >= 0xd800 && c <= 0xdbff && peek() == '\\' && peek (1) == 'u')
+                {
+                    bufferStart += 2;
+                    juce_wchar low = 0;
+                    Result r2 (readUnicodeEscape (low));
+
+                    if (r2.failed())
+                        return r2;
+
+                    if (low >= 0xdc00 && low <= 0xdfff)
+                    {
+                        c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    else
+                    {
+                        stringBuffer.appendUTF8Char (c);
+                        c = low;
+                    }
+                }
+
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        if (c == 0 || c == (juce_wchar) -1)
+            return createFail ("Unexpected end-of-input in string constant");
+
+        stringBuffer.appendUTF8Char (c);
+        return Result::ok();
+    }
+
+    Result readUnicodeEscape (juce_wchar& c)
+    {
+        c = 0;
+
+        for (int i = 4; --i >= 0;)
+        {
+            const int digitValue = CharacterFunctions::getHexDigitValue ((juce_wchar) peek());
+
+            if (digitValue < 0)
+                return createFail ("Syntax error in unicode escape sequence");
+
+            ++bufferStart;
+            c = (juce_wchar) ((c << 4) + digitValue);
+        }
+
+        return Result::ok();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Parser)
+};
+
+//==============================================================================
+JSONDocument::JSONDocument()
+    : nextFreeByte (nullptr), numFreeBytes (0), totalBytesUsed (0), root (nullptr)
+{
+}
+
+JSONDocument::~JSONDocument()
+{
+}
+
+void JSONDocument::clear()
+{
+    blocks.clear();
+    nextFreeByte = nullptr;
+    numFreeBytes = 0;
+    totalBytesUsed = 0;
+    root = nullptr;
+}
+
+char* JSONDocument::allocate (size_t numBytes)
+{
+    numBytes = (numBytes + 7) & ~(size_t) 7; // keep everything 8-byte aligned
+
+    if (numBytes > numFreeBytes)
+    {
+        const size_t blockSize = jmax ((size_t) 65536, numBytes);
+        MemoryBlock* const block = new MemoryBlock (blockSize);
+        blocks.add (block);
+
+        nextFreeByte = static_cast <char*> (block->getData());
+        numFreeBytes = blockSize;
+        totalBytesUsed += blockSize;
+    }
+
+    char* const result = nextFreeByte;
+    nextFreeByte += numBytes;
+    numFreeBytes -= numBytes;
+    return result;
+}
+
+Result JSONDocument::parse (InputStream& input)
+{
+    clear();
+
+    Parser parser (*this, input);
+    Result r (parser.parse (root));
+
+    if (r.failed())
+        clear();
+
+    return r;
+}
+
+Result JSONDocument::parse (const File& file)
+{
+    FileInputStream in (file);
+
+    if (in.failedToOpen())
+    {
+        clear();
+        return in.getStatus();
+    }
+
+    return parse (in);
+}
+
+Result JSONDocument::parse (const String& text)
+{
+    MemoryInputStream in (text.toRawUTF8(), text.getNumBytesAsUTF8(), false);
+    return parse (in);
+}
+
+JSONDocument::Node JSONDocument::getRoot() const noexcept
+{
+    return Node (root);
+}
+
+size_t JSONDocument::getMemoryUsed() const noexcept
+{
+    return totalBytesUsed;
+}
+
+//==============================================================================
+JSONDocument::Node::Node() noexcept  : item (nullptr) {}
+JSONDocument::Node::Node (const Item* i) noexcept  : item (i) {}
+
+bool JSONDocument::Node::isVoid() const noexcept    { return item == nullptr || item->type == Item::nullType; }
+bool JSONDocument::Node::isBool() const noexcept    { return item != nullptr && item->type == Item::boolType; }
+bool JSONDocument::Node::isInt() const noexcept     { return item != nullptr && item->type == Item::intType; }
+bool JSONDocument::Node::isDouble() const noexcept  { return item != nullptr && item->type == Item::doubleType; }
+bool JSONDocument::Node::isString() const noexcept  { return item != nullptr && item->type == Item::stringType; }
+bool JSONDocument::Node::isArray() const noexcept   { return item != nullptr && item->type == Item::arrayType; }
+bool JSONDocument::Node::isObject() const noexcept  { return item != nullptr && item->type == Item::objectType; }
+
+bool JSONDocument::Node::getBool() const noexcept
+{
+    if (item != nullptr)
+    {
+        switch (item->type)
+        {
+            case Item::boolType:
+            case Item::intType:     return item->intValue != 0;
+            case Item::doubleType:  return item->doubleValue != 0;
+            default:                break;
+        }
+    }
+
+    return false;
+}
+
+int64 JSONDocument::Node::getInt64() const noexcept
+{
+    if (item != nullptr)
+    {
+        switch (item->type)
+        {
+            case Item::boolType:
+            case Item::intType:     return item->intValue;
+            case Item::doubleType:  return (int64) item->doubleValue;
+            default:                break;
+        }
+    }
+
+    return 0;
+}
+
+double JSONDocument::Node::getDouble() const noexcept
+{
+    if (item != nullptr)
+    {
+        switch (item->type)
+        {
+            case Item::boolType:
+            case Item::intType:     return (double) item->intValue;
+            case Item::doubleType:  return item->doubleValue;
+            default:                break;
+        }
+    }
+
+    return 0;
+}
+
+const char* JSONDocument::Node::getRawUTF8() const noexcept
+{
+    return isString() ? item->text : "";
+}
+
+int JSONDocument::Node::getNumBytesAsUTF8() const noexcept
+{
+    return isString() ? item->size : 0;
+}
+
+String JSONDocument::Node::toString() const
+{
+    if (isString())
+        return String::fromUTF8 (item->text, item->size);
+
+    if (isArray() || isObject())
+        return String::empty;
+
+    return toVar().toString();
+}
+
+int JSONDocument::Node::size() const noexcept
+{
+    return (isArray() || isObject()) ? item->size : 0;
+}
+
+JSONDocument::Node JSONDocument::Node::operator[] (const int index) const noexcept
+{
+    return isPositiveAndBelow (index, size()) ? Node (item->children + index) : Node();
+}
+
+JSONDocument::Node JSONDocument::Node::operator[] (const char* const propertyName) const noexcept
+{
+    if (isObject())
+        for (int i = 0; i < item->size; ++i)
+            if (strcmp (item->children[i].name, propertyName) == 0)
+                return Node (item->children + i);
+
+    return Node();
+}
+
+const char* JSONDocument::Node::getName (const int index) const noexcept
+{
+    return (isObject() && isPositiveAndBelow (index, item->size)) ? item->children[index].name : "";
+}
+
+var JSONDocument::Node::toVar() const
+{
+    if (item == nullptr)
+        return var::null;
+
+    switch (item->type)
+    {
+        case Item::boolType:
+            return var (item->intValue != 0);
+
+        case Item::intType:
+        {
+            // use the same rule as JSON::parse() for choosing between int and int64
+            const int64 magnitude = item->intValue < 0 ? -item->intValue : item->intValue;
+
+            if ((magnitude >> 31) != 0)
+                return var (item->intValue);
+
+            return var ((int) item->intValue);
+        }
+
+        case Item::doubleType:
+            return var (item->doubleValue);
+
+        case Item::stringType:
+            return var (String::fromUTF8 (item->text, item->size));
+
+        case Item::arrayType:
+        {
+            var result ((Array<var>()));
+            Array<var>* const array = result.getArray();
+            array->ensureStorageAllocated (item->size);
+
+            for (int i = 0; i < item->size; ++i)
+                array->add (Node (item->children + i).toVar());
+
+            return result;
+        }
+
+        case Item::objectType:
+        {
+            DynamicObject* const object = new DynamicObject();
+            var result (object);
+
+            for (int i = 0; i < item->size; ++i)
+                object->setProperty (String (CharPointer_UTF8 (item->children[i].name)),
+                                     Node (item->children + i).toVar());
+
+            return result;
+        }
+
+        default:
+            break;
+    }
+
+    return var::null;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class JSONDocumentTests  : public UnitTest
+{
+public:
+    JSONDocumentTests() : UnitTest ("JSONDocument") {}
+
+    void runTest()
+    {
+        beginTest ("Basics");
+
+        JSONDocument doc;
+        expect (doc.parse ("{ \"a\": 1, \"b\": [ true, false, null, -2.5e1, \"x\\ny\\u00e9\" ], \"c\": { \"d\": 12345678901234 } }").wasOk());
+
+        const JSONDocument::Node root (doc.getRoot());
+        expect (root.isObject());
+        expectEquals (root.size(), 3);
+        expectEquals (String (root.getName (1)), String ("b"));
+        expect (root["a"].isInt() && root["a"].getInt64() == 1);
+        expect (root["missing"].isVoid());
+        expect (root["b"][0].getBool() && ! root["b"][1].getBool());
+        expect (root["b"][2].isVoid());
+        expect (root["b"][3].isDouble() && root["b"][3].getDouble() == -25.0);
+        expectEquals (root["b"][4].toString(), String (CharPointer_UTF8 ("x\ny\xc3\xa9")));
+        expect (root["b"][99].isVoid());
+        expect (root["c"]["d"].getInt64() == 12345678901234LL);
+
+        expect (doc.parse (String::empty).wasOk() && doc.getRoot().isVoid());
+        expect (doc.parse ("{ \"a\": }").failed());
+        expect (doc.parse ("[ 1, 2").failed());
+        expect (doc.parse ("123").failed());
+
+        beginTest ("Comparison with JSON::parse");
+
+        Random r;
+        r.setSeedRandomly();
+
+        for (int i = 100; --i >= 0;)
+        {
+            // (JSONTests lives in the same module, so its random var generator can be shared)
+            Array<var> wrapper;
+            wrapper.add (JSONTests::createRandomVar (r, 0));
+            const String asString (JSON::toString (wrapper, r.nextBool()));
+
+            expect (doc.parse (asString).wasOk());
+            expectEquals (JSON::toString (doc.getRoot().toVar()), JSON::toString (JSON::parse (asString)));
+        }
+    }
+};
+
+static JSONDocumentTests jsonDocumentTests;
+
+#endif
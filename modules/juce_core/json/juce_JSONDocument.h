@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_JSONDOCUMENT_JUCEHEADER__
+#define __JUCE_JSONDOCUMENT_JUCEHEADER__
+
+#include "juce_JSON.h"
+#include "../containers/juce_OwnedArray.h"
+#include "../memory/juce_MemoryBlock.h"
+
+
+//==============================================================================
+/**
+    A read-only, memory-efficient representation of a parsed JSON document.
+
+    JSON::parse() creates a tree of var and DynamicObject objects, which needs a
+    separate heap allocation for every value, string and property. A JSONDocument
+    instead reads its input directly from a stream, and packs all of its values and
+    strings into a few large blocks of memory, which makes it much faster and
+    lighter for big documents.
+
+    The values are accessed through JSONDocument::Node objects, which are just
+    lightweight handles into the document's memory, and any part of the tree can
+    be turned into a var when needed, with Node::toVar().
+
+    e.g.
+    @code
+    JSONDocument doc;
+    Result r (doc.parse (File ("presets.json")));
+
+    if (r.wasOk())
+    {
+        const JSONDocument::Node presets (doc.getRoot() ["presets"]);
+
+        for (int i = 0; i < presets.size(); ++i)
+            DBG (presets[i]["name"].toString());
+    }
+    @endcode
+
+    @see JSON, JSONWriter
+*/
+class JUCE_API  JSONDocument
+{
+private:
+    struct Item;
+
+public:
+    //==============================================================================
+    /** Creates an empty document. */
+    JSONDocument();
+
+    /** Destructor. */
+    ~JSONDocument();
+
+    //==============================================================================
+    /** Parses some JSON from a stream, replacing any previous contents of the document.
+
+        The stream is read in small chunks until the outer object or array has been
+        read. Like JSON::parse(), the outer item must be an object or an array, and an
+        empty stream produces a void root node.
+
+        @returns a Result which describes any parse errors
+    */
+    Result parse (InputStream& input);
+
+    /** Parses some JSON from a file, replacing any previous contents of the document.
+        @see parse (InputStream&)
+    */
+    Result parse (const File& file);
+
+    /** Parses some JSON-formatted text, replacing any previous contents of the document.
+        @see parse (InputStream&)
+    */
+    Result parse (const String& text);
+
+    /** Removes any previously-parsed content. */
+    void clear();
+
+    //==============================================================================
+    /**
+        A handle to one of the values in a JSONDocument.
+
+        Node objects are cheap to copy, but they point into the document's memory,
+        so they mustn't be used after the document has been deleted, cleared, or has
+        parsed something else.
+
+        Reading a value as the wrong type, or looking up an index or property which
+        doesn't exist, is harmless: it'll just return a default value or a void node.
+    */
+    class JUCE_API  Node
+    {
+    public:
+        /** Creates a void node. */
+        Node() noexcept;
+
+        //==============================================================================
+        /** Returns true if this is a null value, or a non-existent item. */
+        bool isVoid() const noexcept;
+        /** Returns true if this is a boolean value. */
+        bool isBool() const noexcept;
+        /** Returns true if this is a whole number. */
+        bool isInt() const noexcept;
+        /** Returns true if this is a number which has a fractional part or an exponent. */
+        bool isDouble() const noexcept;
+        /** Returns true if this is a string. */
+        bool isString() const noexcept;
+        /** Returns true if this is an array. */
+        bool isArray() const noexcept;
+        /** Returns true if this is an object. */
+        bool isObject() const noexcept;
+
+        //==============================================================================
+        /** Returns the value as a bool. Numbers are true if they're non-zero. */
+        bool getBool() const noexcept;
+
+        /** Returns the value as an integer, or 0 if it's not a number. */
+        int64 getInt64() const noexcept;
+
+        /** Returns the value as a double, or 0 if it's not a number. */
+        double getDouble() const noexcept;
+
+        /** Returns a string's text, or the value converted to a string in the same way
+            that a var would do it. Arrays and objects return an empty string.
+        */
+        String toString() const;
+
+        /** For a string, returns a pointer to its null-terminated UTF-8 text, without
+            making a copy of it. For any other type of value, this returns an empty string.
+        */
+        const char* getRawUTF8() const noexcept;
+
+        /** For a string, returns the number of bytes in its UTF-8 text, not including
+            the null terminator. For other types of value, this returns 0.
+        */
+        int getNumBytesAsUTF8() const noexcept;
+
+        //==============================================================================
+        /** Returns the number of items in an array, or the number of properties in an object. */
+        int size() const noexcept;
+
+        /** Returns one of the items in an array, or the value of one of the properties of an object. */
+        Node operator[] (int index) const noexcept;
+
+        /** Returns the value of one of an object's properties, or a void node if there's
+            no such property.
+        */
+        Node operator[] (const char* propertyName) const noexcept;
+
+        /** Returns the name of one of an object's properties, as a null-terminated UTF-8 string. */
+        const char* getName (int index) const noexcept;
+
+        //==============================================================================
+        /** Creates a var which holds a copy of this value.
+            Objects are converted to DynamicObjects, exactly as JSON::parse() would have
+            created them.
+        */
+        var toVar() const;
+
+    private:
+        friend class JSONDocument;
+        const Item* item;
+
+        explicit Node (const Item*) noexcept;
+    };
+
+    //==============================================================================
+    /** Returns the outer object or array of the document. */
+    Node getRoot() const noexcept;
+
+    /** Returns the number of bytes of memory that the document is using to store its values. */
+    size_t getMemoryUsed() const noexcept;
+
+private:
+    //==============================================================================
+    class Parser;
+    friend class Parser;
+    friend class Node;
+
+    OwnedArray<MemoryBlock> blocks;
+    char* nextFreeByte;
+    size_t numFreeBytes, totalBytesUsed;
+    const Item* root;
+
+    char* allocate (size_t numBytes);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JSONDocument)
+};
+
+
+#endif   // __JUCE_JSONDOCUMENT_JUCEHEADER__
@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+JSONWriter::JSONWriter (OutputStream& destStream, const bool allOnOneLine_)
+    : out (destStream),
+      allOnOneLine (allOnOneLine_),
+      nameWritten (false),
+      anythingWritten (false)
+{
+}
+
+JSONWriter::~JSONWriter()
+{
+    // If you hit this, you've not closed all the objects and arrays that you started!
+    jassert (! anythingWritten || levels.size() == 0);
+}
+
+bool JSONWriter::isComplete() const noexcept
+{
+    return anythingWritten && levels.size() == 0;
+}
+
+//==============================================================================
+void JSONWriter::writeSeparator (Level& level)
+{
+    if (level.numItems++ > 0)
+    {
+        if (allOnOneLine)
+            out << ", ";
+        else
+            out << ',' << newLine;
+    }
+
+    if (! allOnOneLine)
+        JSONFormatter::writeSpaces (out, levels.size() * JSONFormatter::indentSize);
+}
+
+void JSONWriter::startItem()
+{
+    if (levels.size() == 0)
+    {
+        // Only one outer item can be written!
+        jassert (! anythingWritten);
+        anythingWritten = true;
+        return;
+    }
+
+    Level& level = levels.getReference (levels.size() - 1);
+
+    if (level.isObject)
+    {
+        // Inside an object, you need to call writeName() before writing each value.
+        jassert (nameWritten);
+        nameWritten = false;
+        return;
+    }
+
+    writeSeparator (level);
+}
+
+void JSONWriter::startContainer (const bool isObject)
+{
+    startItem();
+
+    out << (isObject ? '{' : '[');
+
+    if (! allOnOneLine)
+        out << newLine;
+
+    const Level newLevel = { isObject, 0 };
+    levels.add (newLevel);
+}
+
+void JSONWriter::endContainer (const bool isObject)
+{
+    // This doesn't match the type of item that you started!
+    jassert (levels.size() > 0 && levels.getLast().isObject == isObject);
+
+    // A property name has been written without a value following it!
+    jassert (! nameWritten);
+
+    if (levels.size() == 0)
+        return;
+
+    const int numItems = levels.getLast().numItems;
+    levels.removeLast();
+
+    if (! allOnOneLine)
+    {
+        if (numItems > 0)
+            out << newLine;
+
+        JSONFormatter::writeSpaces (out, levels.size() * JSONFormatter::indentSize);
+    }
+
+    out << (isObject ? '}' : ']');
+}
+
+void JSONWriter::startObject()   { startContainer (true); }
+void JSONWriter::endObject()     { endContainer (true); }
+void JSONWriter::startArray()    { startContainer (false); }
+void JSONWriter::endArray()      { endContainer (false); }
+
+void JSONWriter::writeName (const String& propertyName)
+{
+    // Property names can only be written inside an object, and each one needs a value!
+    jassert (levels.size() > 0 && levels.getLast().isObject && ! nameWritten);
+
+    writeSeparator (levels.getReference (levels.size() - 1));
+    JSONFormatter::writeString (out, propertyName.getCharPointer());
+    out << ": ";
+    nameWritten = true;
+}
+
+void JSONWriter::writeValue (const var& value)
+{
+    startItem();
+    JSONFormatter::write (out, value, levels.size() * JSONFormatter::indentSize, allOnOneLine);
+}
+
+void JSONWriter::writeProperty (const String& propertyName, const var& value)
+{
+    writeName (propertyName);
+    writeValue (value);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class JSONWriterTests  : public UnitTest
+{
+public:
+    JSONWriterTests() : UnitTest ("JSONWriter") {}
+
+    // Writes a var item-by-item, so that the result can be compared with JSON::toString()
+    static void writeVar (JSONWriter& writer, const var& v)
+    {
+        if (const Array<var>* const array = v.getArray())
+        {
+            writer.startArray();
+
+            for (int i = 0; i < array->size(); ++i)
+                writeVar (writer, array->getReference(i));
+
+            writer.endArray();
+        }
+        else if (DynamicObject* const object = v.getDynamicObject())
+        {
+            writer.startObject();
+
+            NamedValueSet& props = object->getProperties();
+
+            for (int i = 0; i < props.size(); ++i)
+            {
+                writer.writeName (props.getName(i).toString());
+                writeVar (writer, props.getValueAt(i));
+            }
+
+            writer.endObject();
+        }
+        else
+        {
+            writer.writeValue (v);
+        }
+    }
+
+    void runTest()
+    {
+        beginTest ("JSONWriter");
+
+        Random r;
+        r.setSeedRandomly();
+
+        for (int i = 100; --i >= 0;)
+        {
+            const var v (JSONTests::createRandomVar (r, 0));
+            const bool oneLine = r.nextBool();
+
+            MemoryOutputStream mo;
+
+            {
+                JSONWriter writer (mo, oneLine);
+                writeVar (writer, v);
+                expect (writer.isComplete());
+            }
+
+            expectEquals (mo.toString(), JSON::toString (v, oneLine));
+        }
+    }
+};
+
+static JSONWriterTests jsonWriterTests;
+
+#endif
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_JSONWRITER_JUCEHEADER__
+#define __JUCE_JSONWRITER_JUCEHEADER__
+
+#include "juce_JSON.h"
+#include "../containers/juce_Array.h"
+
+
+//==============================================================================
+/**
+    Writes JSON-formatted text directly to a stream, one item at a time.
+
+    This lets you write a large JSON document without first having to build the
+    whole thing as a tree of var objects. The output is laid out in exactly the same
+    way as JSON::toString() would do it.
+
+    e.g.
+    @code
+    FileOutputStream out (file);
+    JSONWriter writer (out);
+
+    writer.startObject();
+    writer.writeProperty ("version", 2);
+    writer.writeName ("presets");
+    writer.startArray();
+
+    for (int i = 0; i < presets.size(); ++i)
+        writer.writeValue (presets.getReference(i).toVar());
+
+    writer.endArray();
+    writer.endObject();
+    @endcode
+
+    @see JSON, JSONDocument
+*/
+class JUCE_API  JSONWriter
+{
+public:
+    //==============================================================================
+    /** Creates a writer which sends its output to the given stream.
+        The stream must remain valid until the writer has been deleted.
+        @see JSON::toString
+    */
+    JSONWriter (OutputStream& destStream, bool allOnOneLine = false);
+
+    /** Destructor. */
+    ~JSONWriter();
+
+    //==============================================================================
+    /** Starts writing an object.
+        If the current item is an object, you must call writeName() before this.
+    */
+    void startObject();
+
+    /** Finishes the object that was begun with startObject(). */
+    void endObject();
+
+    /** Starts writing an array.
+        If the current item is an object, you must call writeName() before this.
+    */
+    void startArray();
+
+    /** Finishes the array that was begun with startArray(). */
+    void endArray();
+
+    /** Writes the name of the next property in the current object.
+        This must be followed by a call to writeValue(), startObject() or startArray().
+    */
+    void writeName (const String& propertyName);
+
+    /** Writes a value, which can be anything that JSON::toString() can convert, including
+        arrays or DynamicObjects.
+        If the current item is an object, you must call writeName() before this.
+    */
+    void writeValue (const var& value);
+
+    /** Writes a property of the current object. This is a shortcut for writeName() followed by writeValue(). */
+    void writeProperty (const String& propertyName, const var& value);
+
+    /** Returns true if the outer item has been finished. */
+    bool isComplete() const noexcept;
+
+private:
+    //==============================================================================
+    struct Level
+    {
+        bool isObject;
+        int numItems;
+    };
+
+    OutputStream& out;
+    Array<Level> levels;
+    bool allOnOneLine, nameWritten, anythingWritten;
+
+    void startItem();
+    void startContainer (bool isObject);
+    void endContainer (bool isObject);
+    void writeSeparator (Level&);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JSONWriter)
+};
+
+
+#endif   // __JUCE_JSONWRITER_JUCEHEADER__
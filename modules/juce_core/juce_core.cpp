@@ -118,6 +118,8 @@ namespace juce
 #include "files/juce_FileSearchPath.cpp"
 #include "files/juce_TemporaryFile.cpp"
 #include "json/juce_JSON.cpp"
+#include "json/juce_JSONDocument.cpp"
+#include "json/juce_JSONWriter.cpp"
 #include "logging/juce_FileLogger.cpp"
 #include "logging/juce_Logger.cpp"
 #include "maths/juce_BigInteger.cpp"
@@ -149,15 +151,18 @@ namespace juce
 #include "text/juce_TextDiff.cpp"
 #include "threads/juce_ChildProcess.cpp"
 #include "threads/juce_ReadWriteLock.cpp"
+#include "threads/juce_TaskScheduler.cpp"
 #include "threads/juce_Thread.cpp"
 #include "threads/juce_ThreadPool.cpp"
 #include "threads/juce_TimeSliceThread.cpp"
 #include "time/juce_PerformanceCounter.cpp"
 #include "time/juce_RelativeTime.cpp"
 #include "time/juce_Time.cpp"
+#include "time/juce_TimingHistory.cpp"
 #include "unit_tests/juce_UnitTest.cpp"
 #include "xml/juce_XmlDocument.cpp"
 #include "xml/juce_XmlElement.cpp"
+#include "xml/juce_XmlStreamParser.cpp"
 #include "zip/juce_GZIPDecompressorInputStream.cpp"
 #include "zip/juce_GZIPCompressorOutputStream.cpp"
 #include "zip/juce_ZipFile.cpp"
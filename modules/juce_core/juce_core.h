@@ -217,6 +217,12 @@ namespace juce
 #ifndef __JUCE_JSON_JUCEHEADER__
  #include "json/juce_JSON.h"
 #endif
+#ifndef __JUCE_JSONDOCUMENT_JUCEHEADER__
+ #include "json/juce_JSONDocument.h"
+#endif
+#ifndef __JUCE_JSONWRITER_JUCEHEADER__
+ #include "json/juce_JSONWriter.h"
+#endif
 #ifndef __JUCE_FILELOGGER_JUCEHEADER__
  #include "logging/juce_FileLogger.h"
 #endif
@@ -403,6 +409,9 @@ namespace juce
 #ifndef __JUCE_SPINLOCK_JUCEHEADER__
  #include "threads/juce_SpinLock.h"
 #endif
+#ifndef __JUCE_TASKSCHEDULER_JUCEHEADER__
+ #include "threads/juce_TaskScheduler.h"
+#endif
 #ifndef __JUCE_THREAD_JUCEHEADER__
  #include "threads/juce_Thread.h"
 #endif
@@ -427,6 +436,9 @@ namespace juce
 #ifndef __JUCE_TIME_JUCEHEADER__
  #include "time/juce_Time.h"
 #endif
+#ifndef __JUCE_TIMINGHISTORY_JUCEHEADER__
+ #include "time/juce_TimingHistory.h"
+#endif
 #ifndef __JUCE_UNITTEST_JUCEHEADER__
  #include "unit_tests/juce_UnitTest.h"
 #endif
@@ -436,6 +448,9 @@ namespace juce
 #ifndef __JUCE_XMLELEMENT_JUCEHEADER__
  #include "xml/juce_XmlElement.h"
 #endif
+#ifndef __JUCE_XMLSTREAMPARSER_JUCEHEADER__
+ #include "xml/juce_XmlStreamParser.h"
+#endif
 #ifndef __JUCE_GZIPCOMPRESSOROUTPUTSTREAM_JUCEHEADER__
  #include "zip/juce_GZIPCompressorOutputStream.h"
 #endif
@@ -26,7 +26,11 @@
 FileLogger::FileLogger (const File& file,
                         const String& welcomeMessage,
                         const int64 maxInitialFileSizeBytes)
-    : logFile (file)
+    : Thread ("FileLogger"),
+      logFile (file),
+      dequeuePosition (0),
+      numDroppedMessagesReported (0),
+      maxFileSize (-1)
 {
     if (maxInitialFileSizeBytes >= 0)
         trimFileSize (maxInitialFileSizeBytes);
@@ -34,6 +38,15 @@ FileLogger::FileLogger (const File& file,
     if (! file.exists())
         file.create();  // (to create the parent directories)
 
+    stream = new FileOutputStream (logFile);
+
+    for (int i = 0; i < queueSize; ++i)
+    {
+        QueuedMessage* const m = new QueuedMessage();
+        m->sequence.set (i);
+        queue.add (m);
+    }
+
     String welcome;
     welcome << newLine
             << "**********************************************************" << newLine
@@ -41,17 +54,147 @@ FileLogger::FileLogger (const File& file,
             << "Log started: " << Time::getCurrentTime().toString (true, true) << newLine;
 
     FileLogger::logMessage (welcome);
+
+    startThread();
 }
 
-FileLogger::~FileLogger() {}
+FileLogger::~FileLogger()
+{
+    stopThread (10000);
+    flush();
+}
 
 //==============================================================================
 void FileLogger::logMessage (const String& message)
 {
-    const ScopedLock sl (logLock);
-    DBG (message);
-    FileOutputStream out (logFile, 256);
-    out << message << newLine;
+    // This is a bounded multi-producer queue, where each slot's sequence number tells
+    // the producers and the writer thread whether the slot is free or full.
+    int position = enqueuePosition.value;
+
+    for (;;)
+    {
+        QueuedMessage& slot = *queue.getUnchecked (position & (queueSize - 1));
+        const int diff = (int) ((uint32) slot.sequence.value - (uint32) position);
+
+        if (diff == 0)
+        {
+            if (enqueuePosition.compareAndSetBool (position + 1, position))
+            {
+                slot.message = message;
+                slot.sequence.set (position + 1);
+
+                // only wake the writer if it has emptied the queue and gone to sleep..
+                if (writerIsWaiting.compareAndSetBool (0, 1))
+                    notify();
+
+                return;
+            }
+        }
+        else if (diff < 0)
+        {
+            ++numDroppedMessages;  // the queue is full
+            return;
+        }
+
+        position = enqueuePosition.value;
+    }
+}
+
+void FileLogger::setMaximumFileSize (const int64 maxFileSizeBytes) noexcept
+{
+    maxFileSize = maxFileSizeBytes;
+}
+
+int FileLogger::getNumDroppedMessages() const noexcept
+{
+    return numDroppedMessages.value;
+}
+
+void FileLogger::flush()
+{
+    const ScopedLock sl (writeLock);
+    writePendingMessages();
+}
+
+void FileLogger::run()
+{
+    while (! threadShouldExit())
+    {
+        {
+            const ScopedLock sl (writeLock);
+            writePendingMessages();
+        }
+
+        // The flag has to be set before checking the queue again: a message that
+        // arrives after the check will see it and call notify(), so can't be missed.
+        writerIsWaiting.set (1);
+        bool queueIsEmpty;
+
+        {
+            const ScopedLock sl (writeLock);
+            queueIsEmpty = ! hasPendingMessages();
+        }
+
+        if (queueIsEmpty && ! threadShouldExit())
+            wait (-1);
+
+        writerIsWaiting.set (0);
+    }
+}
+
+bool FileLogger::hasPendingMessages() const noexcept
+{
+    return queue.getUnchecked (dequeuePosition & (queueSize - 1))->sequence.value == dequeuePosition + 1;
+}
+
+void FileLogger::writePendingMessages()
+{
+    bool anythingWritten = false;
+
+    for (;;)
+    {
+        QueuedMessage& slot = *queue.getUnchecked (dequeuePosition & (queueSize - 1));
+
+        if (slot.sequence.value != dequeuePosition + 1)
+            break;
+
+        const String message (slot.message);
+        slot.message = String::empty;
+        slot.sequence.set (dequeuePosition + (int) queueSize);
+        ++dequeuePosition;
+
+        DBG (message);
+
+        if (stream != nullptr)
+            *stream << message << newLine;
+
+        anythingWritten = true;
+    }
+
+    const int numDropped = numDroppedMessages.value;
+
+    if (numDropped != numDroppedMessagesReported && stream != nullptr)
+    {
+        *stream << "[" << (numDropped - numDroppedMessagesReported)
+                << " log messages were dropped because the queue was full]" << newLine;
+
+        numDroppedMessagesReported = numDropped;
+        anythingWritten = true;
+    }
+
+    if (anythingWritten && stream != nullptr)
+    {
+        stream->flush();
+
+        const int64 maxSize = maxFileSize;
+
+        if (maxSize >= 0 && stream->getPosition() > maxSize)
+        {
+            stream = nullptr;
+            trimFileSize (maxSize / 2);
+            stream = new FileOutputStream (logFile);
+        }
+    }
 }
 
 void FileLogger::trimFileSize (int64 maxFileSizeBytes) const
@@ -129,3 +272,111 @@ FileLogger* FileLogger::createDateStampedLogger (const String& logFileSubDirecto
                                                    .getNonexistentSibling(),
                            welcomeMessage, 0);
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class FileLoggerTests  : public UnitTest
+{
+public:
+    FileLoggerTests() : UnitTest ("FileLogger") {}
+
+    class LoggingThread  : public Thread
+    {
+    public:
+        LoggingThread (FileLogger& l, int num) : Thread ("logging test"), logger (l), threadNum (num) {}
+
+        void run()
+        {
+            for (int i = 0; i < numMessagesPerThread; ++i)
+                logger.logMessage ("thread " + String (threadNum) + " message " + String (i));
+        }
+
+        enum { numMessagesPerThread = 5000 };
+
+    private:
+        FileLogger& logger;
+        const int threadNum;
+    };
+
+    void runTest()
+    {
+        beginTest ("Logging from multiple threads");
+
+        const File file (File::createTempFile ("log"));
+
+        {
+            FileLogger logger (file, "test", -1);
+            OwnedArray<LoggingThread> threads;
+
+            for (int i = 0; i < 4; ++i)
+                threads.add (new LoggingThread (logger, i));
+
+            for (int i = 0; i < threads.size(); ++i)
+                threads.getUnchecked(i)->startThread();
+
+            for (int i = 0; i < threads.size(); ++i)
+                threads.getUnchecked(i)->waitForThreadToExit (-1);
+
+            logger.flush();
+
+            StringArray lines;
+            lines.addLines (file.loadFileAsString());
+
+            int numMessagesFound = 0;
+
+            for (int i = 0; i < lines.size(); ++i)
+                if (lines[i].startsWith ("thread "))
+                    ++numMessagesFound;
+
+            // every message must either have been written or counted as dropped..
+            expectEquals (numMessagesFound + logger.getNumDroppedMessages(),
+                          4 * (int) LoggingThread::numMessagesPerThread);
+        }
+
+        beginTest ("Writing without a flush");
+
+        {
+            FileLogger logger (file, "test", 0);
+
+            for (int i = 0; i < 20; ++i)
+            {
+                // the writer is asleep by now, so each message has to wake it up..
+                const String message ("unflushed message " + String (i));
+                logger.logMessage (message);
+
+                const uint32 endTime = Time::getMillisecondCounter() + 5000;
+
+                while (! file.loadFileAsString().contains (message) && Time::getMillisecondCounter() < endTime)
+                    Thread::sleep (1);
+
+                expect (file.loadFileAsString().contains (message));
+            }
+        }
+
+        beginTest ("Size limit");
+
+        {
+            FileLogger logger (file, "test", 0);
+            logger.setMaximumFileSize (10000);
+
+            for (int i = 0; i < 2000; ++i)
+            {
+                logger.logMessage ("message " + String (i));
+
+                if ((i & 63) == 0)
+                    logger.flush();
+            }
+
+            logger.flush();
+            expect (file.getSize() <= 10000);
+            expect (file.loadFileAsString().trimEnd().endsWith ("message 1999"));
+        }
+
+        file.deleteFile();
+    }
+};
+
+static FileLoggerTests fileLoggerTests;
+
+#endif
@@ -29,15 +29,30 @@
 #include "juce_Logger.h"
 #include "../files/juce_File.h"
 #include "../memory/juce_ScopedPointer.h"
+#include "../containers/juce_OwnedArray.h"
+#include "../threads/juce_Thread.h"
+class FileOutputStream;
 
 
 //==============================================================================
 /**
     A simple implementation of a Logger that writes to a file.
 
+    The file is written by a background thread, so calling logMessage() never
+    touches the disk: the message is just put into a lock-free queue, and the
+    background thread writes any queued messages to the file in batches. This
+    makes it safe to log from threads that mustn't be held up by file i/o. (The
+    only system call a message can cost is the one that wakes the writer thread
+    when it has gone to sleep on an empty queue).
+
+    If messages are logged faster than they can be written, so that the queue
+    fills up, any further messages will be dropped (see getNumDroppedMessages()),
+    and a note of the number of dropped messages will be written to the log.
+
     @see Logger
 */
-class JUCE_API  FileLogger  : public Logger
+class JUCE_API  FileLogger  : public Logger,
+                              private Thread
 {
 public:
     //==============================================================================
@@ -54,8 +69,8 @@ public:
                                 file getting ridiculously large over time. The file will be truncated
                                 at a new-line boundary. If this value is less than zero, no size limit
                                 will be imposed; if it's zero, the file will always be deleted. Note that
-                                the size is only checked once when this object is created - any logging
-                                that is done later will be appended without any checking
+                                the size is only checked once when this object is created - to limit the
+                                size of the file while it's being written, use setMaximumFileSize()
     */
     FileLogger (const File& fileToWriteTo,
                 const String& welcomeMessage,
@@ -68,6 +83,23 @@ public:
     /** Returns the file that this logger is writing to. */
     const File& getLogFile() const noexcept               { return logFile; }
 
+    /** Sets a limit on the size of the file while it's being written.
+
+        When the file grows beyond this size, the background thread will discard the
+        oldest half of its contents. A value less than zero (the default) means that
+        there's no limit.
+    */
+    void setMaximumFileSize (int64 maxFileSizeBytes) noexcept;
+
+    /** Waits until all the messages that have been logged so far have been written to the file.
+        If the background thread isn't keeping up, this could block for a while, so it
+        shouldn't be called from a time-critical thread.
+    */
+    void flush();
+
+    /** Returns the number of messages that have been dropped because the queue was full. */
+    int getNumDroppedMessages() const noexcept;
+
     //==============================================================================
     /** Helper function to create a log file in the correct place for this platform.
 
@@ -124,9 +156,25 @@ public:
 
 private:
     //==============================================================================
-    File logFile;
-    CriticalSection logLock;
+    struct QueuedMessage
+    {
+        Atomic<int> sequence;
+        String message;
+    };
 
+    enum { queueSize = 4096 };  // (must be a power of two)
+
+    File logFile;
+    OwnedArray<QueuedMessage> queue;
+    Atomic<int> enqueuePosition, numDroppedMessages, writerIsWaiting;
+    int dequeuePosition, numDroppedMessagesReported;
+    int64 volatile maxFileSize;
+    ScopedPointer<FileOutputStream> stream;
+    CriticalSection writeLock;
+
+    void run();
+    void writePendingMessages();
+    bool hasPendingMessages() const noexcept;
     void trimFileSize (int64 maxFileSizeBytes) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FileLogger)
@@ -187,6 +187,8 @@
  #include <sys/sysinfo.h>
  #include <sys/file.h>
  #include <sys/prctl.h>
+ #include <sys/syscall.h>
+ #include <linux/futex.h>
  #include <signal.h>
  #include <stddef.h>
 
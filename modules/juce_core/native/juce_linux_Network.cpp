@@ -63,6 +63,114 @@ bool Process::openEmailWithAttachments (const String& /* targetEmailAddress */,
 }
 
 
+//==============================================================================
+/*  Holds on to the sockets of HTTP/1.1 connections that have finished their requests,
+    so that the next request to the same server can re-use one of them, rather than
+    having to open a new connection.
+*/
+class HTTPConnectionPool
+{
+public:
+    HTTPConnectionPool() {}
+
+    ~HTTPConnectionPool()
+    {
+        for (int i = connections.size(); --i >= 0;)
+            close (connections.getReference(i).socketHandle);
+
+        clearSingletonInstance();
+    }
+
+    juce_DeclareSingleton (HTTPConnectionPool, false)
+
+    /** Returns an idle socket that's connected to the given server, or -1 if there isn't one. */
+    int takeConnection (const String& serverName)
+    {
+        const ScopedLock sl (lock);
+        const uint32 now = Time::getMillisecondCounter();
+
+        for (int i = connections.size(); --i >= 0;)
+        {
+            const IdleConnection& c = connections.getReference (i);
+            const int socketHandle = c.socketHandle;
+
+            if (now - c.timeReleased > (uint32) maxIdleTimeMs)
+            {
+                connections.remove (i);
+                close (socketHandle);
+            }
+            else if (c.serverName == serverName)
+            {
+                connections.remove (i);
+
+                if (isStillOpen (socketHandle))
+                    return socketHandle;
+
+                close (socketHandle);
+            }
+        }
+
+        return -1;
+    }
+
+    /** Gives the pool a socket whose last response has been completely read. */
+    void releaseConnection (const String& serverName, const int socketHandle)
+    {
+        IdleConnection c;
+        c.serverName = serverName;
+        c.socketHandle = socketHandle;
+        c.timeReleased = Time::getMillisecondCounter();
+
+        const ScopedLock sl (lock);
+
+        if (connections.size() >= maxIdleConnections)
+        {
+            close (connections.getReference(0).socketHandle);
+            connections.remove (0);
+        }
+
+        connections.add (c);
+    }
+
+private:
+    struct IdleConnection
+    {
+        String serverName;
+        int socketHandle;
+        uint32 timeReleased;
+    };
+
+    enum { maxIdleConnections = 16, maxIdleTimeMs = 30000 };
+
+    CriticalSection lock;
+    Array<IdleConnection> connections;
+
+    // An idle connection shouldn't have anything to read: if it has, then the server
+    // has closed it, or has sent something that we weren't expecting.
+    static bool isStillOpen (const int socketHandle)
+    {
+        fd_set readbits;
+        FD_ZERO (&readbits);
+        FD_SET (socketHandle, &readbits);
+
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = 0;
+
+        return select (socketHandle + 1, &readbits, 0, 0, &tv) == 0;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (HTTPConnectionPool)
+};
+
+juce_ImplementSingleton (HTTPConnectionPool)
+
+// (called by URL::shutdownAsyncRequests())
+void juce_closeIdleHTTPConnections()
+{
+    HTTPConnectionPool::deleteInstance();
+}
+
 //==============================================================================
 class WebInputStream  : public InputStream
 {
@@ -72,7 +180,10 @@ public:
                     const String& headers_, int timeOutMs_, StringPairArray* responseHeaders)
       : socketHandle (-1), levelsOfRedirection (0),
         address (address_), headers (headers_), postData (postData_), position (0),
-        finished (false), isPost (isPost_), timeOutMs (timeOutMs_)
+        finished (false), isPost (isPost_), timeOutMs (timeOutMs_),
+        buffer ((size_t) bufferSize), bufferStart (0), bufferEnd (0),
+        contentLength (-1), bytesLeftInBody (-1), bytesLeftInChunk (0),
+        isChunked (false), keepAlive (false)
     {
         createConnection (progressCallback, progressCallbackContext);
 
@@ -95,37 +206,64 @@ public:
     }
 
     //==============================================================================
-    bool isError() const        { return socketHandle < 0; }
+    // (once the whole response has been read, the socket may have been handed back to
+    // the connection pool, so a closed socket isn't an error at that point - but if the
+    // connection is lost before then, the stream stays unfinished, and is an error)
+    bool isError() const        { return socketHandle < 0 && ! finished; }
     bool isExhausted()          { return finished; }
     int64 getPosition()         { return position; }
+    int64 getTotalLength()      { return contentLength; }
 
-    int64 getTotalLength()
-    {
-        //xxx to do
-        return -1;
-    }
-
-    int read (void* buffer, int bytesToRead)
+    int read (void* destBuffer, int bytesToRead)
     {
         if (finished || isError())
             return 0;
 
-        fd_set readbits;
-        FD_ZERO (&readbits);
-        FD_SET (socketHandle, &readbits);
+        char* const dest = static_cast <char*> (destBuffer);
+        int totalRead = 0;
 
-        struct timeval tv;
-        tv.tv_sec = jmax (1, timeOutMs / 1000);
-        tv.tv_usec = 0;
+        while (totalRead < bytesToRead && ! finished)
+        {
+            int numToRead = bytesToRead - totalRead;
 
-        if (select (socketHandle + 1, &readbits, 0, 0, &tv) <= 0)
-            return 0;   // (timeout)
+            if (isChunked)
+            {
+                if (bytesLeftInChunk == 0 && ! readChunkHeader())
+                    break;
+
+                numToRead = (int) jmin ((int64) numToRead, bytesLeftInChunk);
+            }
+            else if (bytesLeftInBody >= 0)
+            {
+                numToRead = (int) jmin ((int64) numToRead, bytesLeftInBody);
+            }
+
+            const int numRead = readBody (dest + totalRead, numToRead);
+
+            if (numRead < 0)
+                break;   // (timeout)
 
-        const int bytesRead = jmax (0, (int) recv (socketHandle, buffer, bytesToRead, MSG_WAITALL));
-        if (bytesRead == 0)
-            finished = true;
-        position += bytesRead;
-        return bytesRead;
+            if (numRead == 0)
+            {
+                // If the server didn't say how long the response was, this is how it ends,
+                // but otherwise, the response has been cut short
+                if (! (isChunked || bytesLeftInBody >= 0))
+                    finished = true;
+
+                closeSocket();
+                break;
+            }
+
+            totalRead += numRead;
+
+            if (isChunked)
+                bytesLeftInChunk -= numRead;
+            else if (bytesLeftInBody > 0 && (bytesLeftInBody -= numRead) == 0)
+                finishBody();
+        }
+
+        position += totalRead;
+        return totalRead;
     }
 
     bool setPosition (int64 wantedPos)
@@ -135,8 +273,6 @@ public:
 
         if (wantedPos != position)
         {
-            finished = false;
-
             if (wantedPos < position)
             {
                 closeSocket();
@@ -152,27 +288,55 @@ public:
 
     //==============================================================================
 private:
+    enum { bufferSize = 32768 };
+
     int socketHandle, levelsOfRedirection;
     StringArray headerLines;
-    String address, headers;
+    String address, headers, connectionKey;
     MemoryBlock postData;
     int64 position;
     bool finished;
     const bool isPost;
     const int timeOutMs;
 
+    // Data is received into this buffer, so that the headers can be parsed without
+    // reading one byte at a time
+    HeapBlock<char> buffer;
+    int bufferStart, bufferEnd;
+
+    int64 contentLength, bytesLeftInBody, bytesLeftInChunk;
+    bool isChunked, keepAlive;
+
     void closeSocket()
     {
         if (socketHandle >= 0)
             close (socketHandle);
 
         socketHandle = -1;
-        levelsOfRedirection = 0;
+        bufferStart = bufferEnd = 0;
+    }
+
+    // Called when the whole of the response has been read. If the server's happy to
+    // keep the connection open, it's handed to the pool for the next request to use.
+    void finishBody()
+    {
+        finished = true;
+
+        if (keepAlive && socketHandle >= 0 && bufferStart == bufferEnd)
+        {
+            HTTPConnectionPool::getInstance()->releaseConnection (connectionKey, socketHandle);
+            socketHandle = -1;
+        }
+        else
+        {
+            closeSocket();
+        }
     }
 
     void createConnection (URL::OpenStreamProgressCallback* progressCallback, void* progressCallbackContext)
     {
         closeSocket();
+        finished = false;
 
         uint32 timeOutTime = Time::getMillisecondCounter();
 
@@ -207,6 +371,66 @@ private:
             port = hostPort;
         }
 
+        connectionKey = serverName + ":" + String (port);
+        const MemoryBlock requestHeader (createRequestHeader (hostName, hostPort, proxyName, proxyPort,
+                                                              hostPath, address, headers, postData, isPost));
+        String responseHeader;
+
+        for (;;)
+        {
+            socketHandle = HTTPConnectionPool::getInstance()->takeConnection (connectionKey);
+            const bool isReusedConnection = (socketHandle >= 0);
+
+            if (! (isReusedConnection || openSocket (serverName, port)))
+                return;
+
+            if (sendHeader (socketHandle, requestHeader, timeOutTime, progressCallback, progressCallbackContext))
+                responseHeader = readResponseHeader (timeOutTime);
+
+            // The server may have closed a re-used connection since its last request,
+            // in which case this just tries again with another one. (A POST isn't sent
+            // again, because the server might have acted on it before the connection failed)
+            if (responseHeader.isNotEmpty() || ! isReusedConnection || isPost)
+                break;
+
+            closeSocket();
+        }
+
+        if (responseHeader.isNotEmpty())
+        {
+            headerLines.clear();
+            headerLines.addLines (responseHeader);
+
+            const int statusCode = responseHeader.fromFirstOccurrenceOf (" ", false, false)
+                                                 .substring (0, 3).getIntValue();
+
+            String location (findHeaderItem (headerLines, "Location:"));
+
+            if (statusCode >= 300 && statusCode < 400 && location.isNotEmpty())
+            {
+                if (! location.startsWithIgnoreCase ("http://"))
+                    location = "http://" + location;
+
+                if (++levelsOfRedirection <= 3)
+                {
+                    address = location;
+                    createConnection (progressCallback, progressCallbackContext);
+                    return;
+                }
+            }
+            else
+            {
+                levelsOfRedirection = 0;
+                startBody (statusCode, responseHeader);
+                return;
+            }
+        }
+
+        closeSocket();
+    }
+
+    bool openSocket (const String& hostName, const int port)
+    {
         struct addrinfo hints;
         zerostruct (hints);
 
@@ -215,21 +439,26 @@ private:
         hints.ai_flags = AI_NUMERICSERV;
 
         struct addrinfo* result = nullptr;
-        if (getaddrinfo (serverName.toUTF8(), String (port).toUTF8(), &hints, &result) != 0 || result == 0)
-            return;
+        if (getaddrinfo (hostName.toUTF8(), String (port).toUTF8(), &hints, &result) != 0 || result == 0)
+            return false;
 
         socketHandle = socket (result->ai_family, result->ai_socktype, 0);
 
         if (socketHandle == -1)
         {
             freeaddrinfo (result);
-            return;
+            return false;
         }
 
         int receiveBufferSize = 16384;
         setsockopt (socketHandle, SOL_SOCKET, SO_RCVBUF, (char*) &receiveBufferSize, sizeof (receiveBufferSize));
         setsockopt (socketHandle, SOL_SOCKET, SO_KEEPALIVE, 0, 0);
 
+        // (requests are sent in pieces, which mustn't be held back waiting for the replies
+        // to earlier packets on a connection that's being kept open)
+        int noDelay = 1;
+        setsockopt (socketHandle, IPPROTO_TCP, TCP_NODELAY, (char*) &noDelay, sizeof (noDelay));
+
       #if JUCE_MAC
         setsockopt (socketHandle, SOL_SOCKET, SO_NOSIGPIPE, 0, 0);
       #endif
@@ -238,95 +467,188 @@ private:
         {
             closeSocket();
             freeaddrinfo (result);
-            return;
+            return false;
         }
 
         freeaddrinfo (result);
+        return true;
+    }
 
-        {
-            const MemoryBlock requestHeader (createRequestHeader (hostName, hostPort, proxyName, proxyPort,
-                                                                  hostPath, address, headers, postData, isPost));
+    void startBody (const int statusCode, const String& responseHeader)
+    {
+        const String connection (findHeaderItem (headerLines, "Connection:"));
+        const String contentLengthString (findHeaderItem (headerLines, "Content-Length:"));
+
+        isChunked = findHeaderItem (headerLines, "Transfer-Encoding:").containsIgnoreCase ("chunked");
+        contentLength = -1;
+        bytesLeftInChunk = 0;
+
+        if (statusCode == 204 || statusCode == 304)
+            contentLength = 0;
+        else if (contentLengthString.isNotEmpty() && ! isChunked)
+            contentLength = contentLengthString.getLargeIntValue();
+
+        bytesLeftInBody = contentLength;
+
+        // The connection can only be re-used if the end of the response can be found
+        // without the server closing it
+        keepAlive = (isChunked || contentLength >= 0)
+                     && ! connection.containsIgnoreCase ("close")
+                     && ! headers.containsIgnoreCase ("Connection: close")
+                     && (responseHeader.startsWithIgnoreCase ("HTTP/1.1")
+                          || connection.containsIgnoreCase ("keep-alive"));
+
+        if (bytesLeftInBody == 0)
+            finishBody();
+    }
 
-            if (! sendHeader (socketHandle, requestHeader, timeOutTime, progressCallback, progressCallbackContext))
-            {
-                closeSocket();
-                return;
-            }
-        }
+    //==============================================================================
+    // Waits for some data to arrive, and reads as much of it as will fit.
+    // Returns the number of bytes read, 0 if the connection was closed, or -1 on a timeout.
+    int receive (char* dest, const int maxBytes, const int timeoutMs)
+    {
+        fd_set readbits;
+        FD_ZERO (&readbits);
+        FD_SET (socketHandle, &readbits);
 
-        String responseHeader (readResponse (socketHandle, timeOutTime));
+        struct timeval tv;
+        tv.tv_sec = jmax (1, timeoutMs / 1000);
+        tv.tv_usec = 0;
 
-        if (responseHeader.isNotEmpty())
+        if (select (socketHandle + 1, &readbits, 0, 0, &tv) <= 0)
+            return -1;
+
+        return jmax (0, (int) recv (socketHandle, dest, (size_t) maxBytes, 0));
+    }
+
+    bool fillBuffer (const int timeoutMs)
+    {
+        if (bufferStart > 0)
         {
-            headerLines.clear();
-            headerLines.addLines (responseHeader);
+            memmove (buffer, buffer + bufferStart, (size_t) (bufferEnd - bufferStart));
+            bufferEnd -= bufferStart;
+            bufferStart = 0;
+        }
 
-            const int statusCode = responseHeader.fromFirstOccurrenceOf (" ", false, false)
-                                                 .substring (0, 3).getIntValue();
+        if (bufferEnd >= (int) bufferSize)
+            return false;
 
-            //int contentLength = findHeaderItem (lines, "Content-Length:").getIntValue();
-            //bool isChunked = findHeaderItem (lines, "Transfer-Encoding:").equalsIgnoreCase ("chunked");
+        const int numRead = receive (buffer + bufferEnd, (int) bufferSize - bufferEnd, timeoutMs);
 
-            String location (findHeaderItem (headerLines, "Location:"));
+        if (numRead <= 0)
+            return false;
 
-            if (statusCode >= 300 && statusCode < 400 && location.isNotEmpty())
+        bufferEnd += numRead;
+        return true;
+    }
+
+    // Reads a line of the headers, without its line-feed
+    bool readLine (String& line, const int timeoutMs)
+    {
+        for (int i = bufferStart;; ++i)
+        {
+            if (i >= bufferEnd)
             {
-                if (! location.startsWithIgnoreCase ("http://"))
-                    location = "http://" + location;
+                i -= bufferStart;
 
-                if (++levelsOfRedirection <= 3)
-                {
-                    address = location;
-                    createConnection (progressCallback, progressCallbackContext);
-                    return;
-                }
+                if (! fillBuffer (timeoutMs))
+                    return false;
             }
-            else
+
+            if (buffer[i] == '\n')
             {
-                levelsOfRedirection = 0;
-                return;
+                line = String::fromUTF8 (buffer + bufferStart, i - bufferStart).trimEnd();
+                bufferStart = i + 1;
+                return true;
             }
         }
+    }
 
-        closeSocket();
+    int readBody (char* dest, const int maxBytes)
+    {
+        if (bufferStart == bufferEnd)
+        {
+            // (big reads can go straight into the caller's buffer)
+            if (maxBytes >= (int) bufferSize)
+                return receive (dest, maxBytes, timeOutMs);
+
+            const int numRead = receive (buffer, (int) bufferSize, timeOutMs);
+
+            if (numRead <= 0)
+                return numRead;
+
+            bufferStart = 0;
+            bufferEnd = numRead;
+        }
+
+        const int num = jmin (maxBytes, bufferEnd - bufferStart);
+        memcpy (dest, buffer + bufferStart, (size_t) num);
+        bufferStart += num;
+        return num;
     }
 
-    //==============================================================================
-    static String readResponse (const int socketHandle, const uint32 timeOutTime)
+    // Reads the size of the next chunk of a chunked response. When it gets to the
+    // last one, this finishes the response and returns false. If the connection fails,
+    // the socket's closed without finishing, so that the stream reports an error.
+    bool readChunkHeader()
     {
-        int bytesRead = 0, numConsecutiveLFs  = 0;
-        MemoryBlock buffer (1024, true);
+        String line;
 
-        while (numConsecutiveLFs < 2 && bytesRead < 32768
-                && Time::getMillisecondCounter() <= timeOutTime)
+        // (each chunk's data is followed by a CRLF, which gets skipped here)
+        if (! (readLine (line, timeOutMs) && (line.isNotEmpty() || readLine (line, timeOutMs))))
         {
-            fd_set readbits;
-            FD_ZERO (&readbits);
-            FD_SET (socketHandle, &readbits);
+            closeSocket();
+            return false;
+        }
+
+        bytesLeftInChunk = line.upToFirstOccurrenceOf (";", false, false).trim().getHexValue64();
 
-            struct timeval tv;
-            tv.tv_sec = jmax (1, (int) (timeOutTime - Time::getMillisecondCounter()) / 1000);
-            tv.tv_usec = 0;
+        if (bytesLeftInChunk > 0)
+            return true;
+
+        // skip any trailing headers
+        do
+        {
+            if (! readLine (line, timeOutMs))
+            {
+                closeSocket();
+                return false;
+            }
+        }
+        while (line.isNotEmpty());
 
-            if (select (socketHandle + 1, &readbits, 0, 0, &tv) <= 0)
-                return String::empty;  // (timeout)
+        finishBody();
+        return false;
+    }
 
-            buffer.ensureSize (bytesRead + 8, true);
-            char* const dest = (char*) buffer.getData() + bytesRead;
+    //==============================================================================
+    String readResponseHeader (const uint32 timeOutTime)
+    {
+        String header, line;
 
-            if (recv (socketHandle, dest, 1, 0) == -1)
+        for (;;)
+        {
+            if (Time::getMillisecondCounter() > timeOutTime
+                 || ! readLine (line, (int) (timeOutTime - Time::getMillisecondCounter())))
                 return String::empty;
 
-            const char lastByte = *dest;
-            ++bytesRead;
+            if (line.isEmpty())
+            {
+                // (an interim "100 Continue" response is skipped, and the real one read after it)
+                if (header.startsWithIgnoreCase ("HTTP/1.1 1"))
+                {
+                    header = String::empty;
+                    continue;
+                }
+
+                break;
+            }
 
-            if (lastByte == '\n')
-                ++numConsecutiveLFs;
-            else if (lastByte != '\r')
-                numConsecutiveLFs = 0;
-        }
+            if (header.length() > 32768)
+                return String::empty;
 
-        const String header (CharPointer_UTF8 ((const char*) buffer.getData()));
+            header << line << "\n";
+        }
 
         if (header.startsWithIgnoreCase ("HTTP/"))
             return header.trimEnd();
@@ -342,7 +664,7 @@ private:
 
     static void writeHost (MemoryOutputStream& dest, const bool isPost, const String& path, const String& host, const int port)
     {
-        dest << (isPost ? "POST " : "GET ") << path << " HTTP/1.0\r\nHost: " << host;
+        dest << (isPost ? "POST " : "GET ") << path << " HTTP/1.1\r\nHost: " << host;
 
         if (port > 0)
             dest << ':' << port;
@@ -364,13 +686,18 @@ private:
         writeValueIfNotPresent (header, userHeaders, "User-Agent:", "JUCE/" JUCE_STRINGIFY(JUCE_MAJOR_VERSION)
                                                                         "." JUCE_STRINGIFY(JUCE_MINOR_VERSION)
                                                                         "." JUCE_STRINGIFY(JUCE_BUILDNUMBER));
-        writeValueIfNotPresent (header, userHeaders, "Connection:", "Close");
 
         if (isPost)
             writeValueIfNotPresent (header, userHeaders, "Content-Length:", String ((int) postData.getSize()));
 
-        header << "\r\n" << userHeaders
-               << "\r\n" << postData;
+        // (the headers must end with exactly one blank line, or the server would see any
+        // extra ones as the start of the next request on this connection)
+        const String extraHeaders (userHeaders.trim());
+
+        if (extraHeaders.isNotEmpty())
+            header << "\r\n" << extraHeaders;
+
+        header << "\r\n\r\n" << postData;
 
         return header.getMemoryBlock();
     }
@@ -387,7 +714,8 @@ private:
 
             const int numToSend = jmin (1024, (int) (requestHeader.getSize() - totalHeaderSent));
 
-            if (send (socketHandle, static_cast <const char*> (requestHeader.getData()) + totalHeaderSent, numToSend, 0) != numToSend)
+            // (MSG_NOSIGNAL is used because a re-used connection may turn out to have been closed)
+            if (send (socketHandle, static_cast <const char*> (requestHeader.getData()) + totalHeaderSent, numToSend, MSG_NOSIGNAL) != numToSend)
                 return false;
 
             totalHeaderSent += numToSend;
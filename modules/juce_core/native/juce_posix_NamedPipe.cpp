@@ -23,6 +23,366 @@
   ==============================================================================
 */
 
+#if JUCE_LINUX
+//==============================================================================
+/*  A pair of single-reader, single-writer ring buffers in a block of POSIX shared
+    memory, one for each direction.
+
+    The read and write positions are free-running counters, so a ring is empty when
+    they're equal. Nothing needs a system call unless a reader finds its ring empty,
+    or a writer finds it full: they then sleep on a futex, and the other side only
+    wakes them if it can see that they're waiting.
+*/
+class SharedMemoryPipe
+{
+public:
+    /** Creates a new block of shared memory, returning nullptr if it fails. */
+    static SharedMemoryPipe* create (const String& pipeName)
+    {
+        const String name (getSharedMemoryName (pipeName));
+        const int handle = shm_open (name.toUTF8(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+        if (handle == -1)
+            return nullptr;
+
+        const size_t totalSize = getHeaderSize() + 2 * (size_t) defaultRingSize;
+        void* data = nullptr;
+
+        if (ftruncate (handle, (off_t) totalSize) == 0)
+        {
+            data = mmap (0, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+
+            if (data == MAP_FAILED)
+                data = nullptr;
+        }
+
+        ::close (handle);
+
+        if (data == nullptr)
+        {
+            shm_unlink (name.toUTF8());
+            return nullptr;
+        }
+
+        // (the new memory is all zeros, so only the non-zero fields need to be set)
+        Header* const header = static_cast <Header*> (data);
+        header->ringSize = defaultRingSize;
+        header->state[0].set (stateOpen);
+        __sync_synchronize();
+        header->magic = magicNumber;
+
+        return new SharedMemoryPipe (name, data, totalSize, defaultRingSize, true);
+    }
+
+    /** Deletes any existing block of shared memory that has this name. */
+    static void remove (const String& pipeName)
+    {
+        shm_unlink (getSharedMemoryName (pipeName).toUTF8());
+    }
+
+    /** Opens the block of shared memory that another process has created.
+
+        If there isn't one, this returns nullptr and sets segmentExists to false. If
+        there's one that can't be used (e.g. because another process is already
+        connected to it), it returns nullptr and sets segmentExists to true.
+    */
+    static SharedMemoryPipe* openExisting (const String& pipeName, bool& segmentExists)
+    {
+        const String name (getSharedMemoryName (pipeName));
+        const int handle = shm_open (name.toUTF8(), O_RDWR, 0);
+
+        segmentExists = (handle != -1);
+
+        if (handle == -1)
+            return nullptr;
+
+        struct stat info;
+        void* data = nullptr;
+        size_t totalSize = 0;
+
+        if (fstat (handle, &info) == 0 && info.st_size >= (off_t) getHeaderSize())
+        {
+            totalSize = (size_t) info.st_size;
+            data = mmap (0, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+
+            if (data == MAP_FAILED)
+                data = nullptr;
+        }
+
+        ::close (handle);
+
+        if (data != nullptr)
+        {
+            Header* const header = static_cast <Header*> (data);
+
+            // (the size is only read once, as the other process could change it later)
+            const uint32 size = header->ringSize;
+
+            if (header->magic == magicNumber
+                 && size > 0 && size <= (uint32) maxRingSize && isPowerOfTwo ((int) size)
+                 && totalSize == getHeaderSize() + 2 * (size_t) size
+                 && header->state[1].compareAndSetBool (stateOpen, stateNotOpen))
+                return new SharedMemoryPipe (name, data, totalSize, size, false);
+
+            munmap (data, totalSize);
+        }
+
+        return nullptr;
+    }
+
+    ~SharedMemoryPipe()
+    {
+        header->state [isCreator ? 0 : 1].set (stateClosed);
+        wakeAll();
+        munmap (header, totalSize);
+
+        if (isCreator)
+            shm_unlink (name.toUTF8());
+    }
+
+    //==============================================================================
+    int read (char* destBuffer, int maxBytesToRead, const uint32 timeoutEnd)
+    {
+        const ScopedLock sl (readLock);
+        Ring& ring = header->rings [isCreator ? 1 : 0];
+        const char* const buffer = getRingData (isCreator ? 1 : 0);
+        int bytesRead = 0;
+
+        while (bytesRead < maxBytesToRead)
+        {
+            const uint32 readPos = ring.readPosition.get();
+            const uint32 numAvailable = ring.writePosition.get() - readPos;
+
+            // the positions are in memory that the other process can write to, so if
+            // they don't make sense, it's treated as having gone away
+            if (numAvailable > ringSize)
+                return -1;
+
+            if (numAvailable > 0)
+            {
+                const int num = jmin ((int) numAvailable, maxBytesToRead - bytesRead);
+                copyFromRing (destBuffer + bytesRead, buffer, readPos, num);
+                ring.readPosition.set (readPos + (uint32) num);
+                bytesRead += num;
+
+                if (ring.numWritersWaiting.get() > 0)
+                    wake (ring.spaceSequence);
+
+                continue;
+            }
+
+            if (! waitFor (ring.dataSequence, ring.numReadersWaiting, ring.writePosition, readPos, timeoutEnd))
+                return -1;
+        }
+
+        return bytesRead;
+    }
+
+    int write (const char* sourceBuffer, int numBytesToWrite, const uint32 timeoutEnd)
+    {
+        const ScopedLock sl (writeLock);
+        Ring& ring = header->rings [isCreator ? 0 : 1];
+        char* const buffer = getRingData (isCreator ? 0 : 1);
+        int bytesWritten = 0;
+
+        while (bytesWritten < numBytesToWrite)
+        {
+            if (isPeerClosed())
+                return -1;
+
+            const uint32 writePos = ring.writePosition.get();
+            const uint32 fullPosition = ring.readPosition.get() + ringSize;
+            const uint32 numFree = fullPosition - writePos;
+
+            if (numFree > ringSize)
+                return -1;
+
+            if (numFree > 0)
+            {
+                const int num = jmin ((int) numFree, numBytesToWrite - bytesWritten);
+                copyToRing (buffer, writePos, sourceBuffer + bytesWritten, num);
+                ring.writePosition.set (writePos + (uint32) num);
+                bytesWritten += num;
+
+                if (ring.numReadersWaiting.get() > 0)
+                    wake (ring.dataSequence);
+
+                continue;
+            }
+
+            if (! waitFor (ring.spaceSequence, ring.numWritersWaiting, ring.readPosition, fullPosition - ringSize, timeoutEnd))
+                return (cancelled || isPeerClosed()) ? -1 : bytesWritten;
+        }
+
+        return bytesWritten;
+    }
+
+    /** Makes any reads or writes that are waiting return. */
+    void cancel()
+    {
+        cancelled = true;
+        wakeAll();
+    }
+
+private:
+    //==============================================================================
+    enum
+    {
+        magicNumber = 0x4a534d50,
+        defaultRingSize = 1024 * 1024,
+        maxRingSize = 64 * 1024 * 1024,
+        stateNotOpen = 0,
+        stateOpen = 1,
+        stateClosed = 2
+    };
+
+    struct Ring
+    {
+        // (the positions are kept in separate cache-lines, as each is only written by one side)
+        Atomic<uint32> writePosition;
+        char padding1 [60];
+        Atomic<uint32> readPosition;
+        char padding2 [60];
+
+        // These are the futex words: they're changed whenever a sleeping reader or
+        // writer needs to re-check the ring.
+        Atomic<int> dataSequence, spaceSequence;
+        Atomic<int> numReadersWaiting, numWritersWaiting;
+        char padding3 [48];
+    };
+
+    struct Header
+    {
+        uint32 magic, ringSize;
+        Atomic<int> state[2];   // [0] is the creator's state, [1] is the other end's
+        char padding [48];
+        Ring rings[2];          // rings[0] is written by the creator, rings[1] by the other end
+    };
+
+    const String name;
+    Header* const header;
+    const size_t totalSize;
+    const uint32 ringSize;
+    const bool isCreator;
+    volatile bool cancelled;
+    CriticalSection readLock, writeLock;
+
+    SharedMemoryPipe (const String& name_, void* data, const size_t totalSize_,
+                      const uint32 ringSize_, const bool isCreator_)
+        : name (name_), header (static_cast <Header*> (data)), totalSize (totalSize_),
+          ringSize (ringSize_), isCreator (isCreator_), cancelled (false)
+    {
+    }
+
+    static String getSharedMemoryName (const String& pipeName)
+    {
+        return "/juce_" + File::createLegalFileName (pipeName);
+    }
+
+    static size_t getHeaderSize() noexcept
+    {
+        return (sizeof (Header) + 63) & ~(size_t) 63;
+    }
+
+    char* getRingData (const int index) const noexcept
+    {
+        return addBytesToPointer (reinterpret_cast <char*> (header), getHeaderSize() + (size_t) index * ringSize);
+    }
+
+    bool isPeerClosed() const noexcept
+    {
+        return header->state [isCreator ? 1 : 0].get() == stateClosed;
+    }
+
+    void copyFromRing (char* dest, const char* buffer, const uint32 position, const int num) const noexcept
+    {
+        const int offset = (int) (position & (ringSize - 1));
+        const int num1 = jmin (num, (int) ringSize - offset);
+
+        memcpy (dest, buffer + offset, (size_t) num1);
+        memcpy (dest + num1, buffer, (size_t) (num - num1));
+    }
+
+    void copyToRing (char* buffer, const uint32 position, const char* source, const int num) const noexcept
+    {
+        const int offset = (int) (position & (ringSize - 1));
+        const int num1 = jmin (num, (int) ringSize - offset);
+
+        memcpy (buffer + offset, source, (size_t) num1);
+        memcpy (buffer, source + num1, (size_t) (num - num1));
+    }
+
+    /*  Sleeps until the other side changes the given position, or the timeout expires.
+        The waiting count is incremented before the position is re-checked, so either
+        the other side will see that we're waiting, or we'll see its new position.
+        (The position is checked before the other side's state, so that any data it
+        wrote before closing can still be read).
+    */
+    bool waitFor (Atomic<int>& sequence, Atomic<int>& numWaiting, const Atomic<uint32>& position,
+                  const uint32 oldPosition, const uint32 timeoutEnd)
+    {
+        ++numWaiting;
+        const int oldSequence = sequence.get();
+        bool ok = true;
+
+        if (position.get() == oldPosition)
+        {
+            if (cancelled || isPeerClosed())
+            {
+                ok = false;
+            }
+            else if (timeoutEnd == 0)
+            {
+                futex (sequence, FUTEX_WAIT, oldSequence, nullptr);
+            }
+            else
+            {
+                const int msLeft = (int) (timeoutEnd - Time::getMillisecondCounter());
+
+                if (msLeft <= 0)
+                {
+                    ok = false;
+                }
+                else
+                {
+                    struct timespec timeout;
+                    timeout.tv_sec = msLeft / 1000;
+                    timeout.tv_nsec = (msLeft % 1000) * 1000000;
+                    futex (sequence, FUTEX_WAIT, oldSequence, &timeout);
+                }
+            }
+        }
+
+        --numWaiting;
+        return ok;
+    }
+
+    static void wake (Atomic<int>& sequence) noexcept
+    {
+        ++sequence;
+        futex (sequence, FUTEX_WAKE, std::numeric_limits<int>::max(), nullptr);
+    }
+
+    void wakeAll() noexcept
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            wake (header->rings[i].dataSequence);
+            wake (header->rings[i].spaceSequence);
+        }
+    }
+
+    // (this isn't a private futex, because the other end is in a different process)
+    static void futex (Atomic<int>& word, const int op, const int value, const struct timespec* timeout) noexcept
+    {
+        syscall (SYS_futex, (int*) &word.value, op, value, timeout, nullptr, 0);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (SharedMemoryPipe)
+};
+#endif
+
+//==============================================================================
 class NamedPipe::Pimpl
 {
 public:
@@ -53,6 +413,11 @@ public:
     {
         const uint32 timeoutEnd = getTimeoutEnd (timeOutMilliseconds);
 
+       #if JUCE_LINUX
+        if (sharedMemory != nullptr)
+            return sharedMemory->read (destBuffer, maxBytesToRead, timeoutEnd);
+       #endif
+
         if (pipeIn == -1)
         {
             pipeIn = openPipe (createdPipe ? pipeInName : pipeOutName, O_RDWR | O_NONBLOCK, timeoutEnd);
@@ -91,6 +456,11 @@ public:
     {
         const uint32 timeoutEnd = getTimeoutEnd (timeOutMilliseconds);
 
+       #if JUCE_LINUX
+        if (sharedMemory != nullptr)
+            return sharedMemory->write (sourceBuffer, numBytesToWrite, timeoutEnd);
+       #endif
+
         if (pipeOut == -1)
         {
             pipeOut = openPipe (createdPipe ? pipeOutName : pipeInName, O_WRONLY, timeoutEnd);
@@ -128,6 +498,10 @@ public:
     const bool createdPipe;
     bool stopReadOperation;
 
+   #if JUCE_LINUX
+    ScopedPointer<SharedMemoryPipe> sharedMemory;
+   #endif
+
 private:
     static void signalHandler (int) {}
 
@@ -176,6 +550,11 @@ void NamedPipe::close()
     {
         pimpl->stopReadOperation = true;
 
+       #if JUCE_LINUX
+        if (pimpl->sharedMemory != nullptr)
+            pimpl->sharedMemory->cancel();
+       #endif
+
         char buffer[1] = { 0 };
         ssize_t done = ::write (pimpl->pipeIn, buffer, 1);
         (void) done;
@@ -185,7 +564,7 @@ void NamedPipe::close()
     }
 }
 
-bool NamedPipe::openInternal (const String& pipeName, const bool createPipe)
+bool NamedPipe::openInternal (const String& pipeName, const bool createPipe, const bool useSharedMemory)
 {
    #if JUCE_IOS
     pimpl = new Pimpl (File::getSpecialLocation (File::tempDirectory)
@@ -194,6 +573,35 @@ bool NamedPipe::openInternal (const String& pipeName, const bool createPipe)
     pimpl = new Pimpl ("/tmp/" + File::createLegalFileName (pipeName), createPipe);
    #endif
 
+   #if JUCE_LINUX
+    if (createPipe)
+    {
+        // (a stale block of shared memory with this name would make the other end try to
+        // use it instead of the fifos, so it's removed even if it isn't going to be used)
+        SharedMemoryPipe::remove (pipeName);
+
+        // if the shared memory can't be created, this falls back to using fifos
+        if (useSharedMemory)
+            pimpl->sharedMemory = SharedMemoryPipe::create (pipeName);
+    }
+    else
+    {
+        bool segmentExists = false;
+        pimpl->sharedMemory = SharedMemoryPipe::openExisting (pipeName, segmentExists);
+
+        if (segmentExists && pimpl->sharedMemory == nullptr)
+        {
+            pimpl = nullptr;
+            return false;
+        }
+    }
+
+    if (pimpl->sharedMemory != nullptr)
+        return true;
+   #else
+    (void) useSharedMemory;
+   #endif
+
     if (createPipe && ! pimpl->createFifos())
     {
         pimpl = nullptr;
@@ -203,6 +611,15 @@ bool NamedPipe::openInternal (const String& pipeName, const bool createPipe)
     return true;
 }
 
+bool NamedPipe::isUsingSharedMemory() const
+{
+   #if JUCE_LINUX
+    return pimpl != nullptr && pimpl->sharedMemory != nullptr;
+   #else
+    return false;
+   #endif
+}
+
 int NamedPipe::read (void* destBuffer, int maxBytesToRead, int timeOutMilliseconds)
 {
     ScopedReadLock sl (lock);
@@ -932,7 +932,7 @@ void NamedPipe::close()
     }
 }
 
-bool NamedPipe::openInternal (const String& pipeName, const bool createPipe)
+bool NamedPipe::openInternal (const String& pipeName, const bool createPipe, bool)
 {
     pimpl = new Pimpl (pipeName, createPipe);
 
@@ -945,6 +945,11 @@ bool NamedPipe::openInternal (const String& pipeName, const bool createPipe)
     return true;
 }
 
+bool NamedPipe::isUsingSharedMemory() const
+{
+    return false;
+}
+
 int NamedPipe::read (void* destBuffer, int maxBytesToRead, int timeOutMilliseconds)
 {
     ScopedReadLock sl (lock);
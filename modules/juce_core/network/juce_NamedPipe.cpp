@@ -38,7 +38,7 @@ bool NamedPipe::openExisting (const String& pipeName)
 
     ScopedWriteLock sl (lock);
     currentPipeName = pipeName;
-    return openInternal (pipeName, false);
+    return openInternal (pipeName, false, false);
 }
 
 bool NamedPipe::isOpen() const
@@ -46,13 +46,13 @@ bool NamedPipe::isOpen() const
     return pimpl != nullptr;
 }
 
-bool NamedPipe::createNewPipe (const String& pipeName)
+bool NamedPipe::createNewPipe (const String& pipeName, const bool useSharedMemory)
 {
     close();
 
     ScopedWriteLock sl (lock);
     currentPipeName = pipeName;
-    return openInternal (pipeName, true);
+    return openInternal (pipeName, true, useSharedMemory);
 }
 
 String NamedPipe::getName() const
@@ -61,3 +61,120 @@ String NamedPipe::getName() const
 }
 
 // other methods for this class are implemented in the platform-specific files
+
+//==============================================================================
+#if JUCE_UNIT_TESTS && JUCE_LINUX
+
+class NamedPipeTests  : public UnitTest
+{
+public:
+    NamedPipeTests() : UnitTest ("NamedPipe") {}
+
+    class WriterThread  : public Thread
+    {
+    public:
+        WriterThread (NamedPipe& pipe_, const MemoryBlock& data_)
+            : Thread ("pipe writer"), pipe (pipe_), data (data_), result (0)
+        {
+            startThread();
+        }
+
+        ~WriterThread()
+        {
+            stopThread (5000);
+        }
+
+        void run()
+        {
+            // (written in odd-sized blocks, so that they don't line up with the end of the ring)
+            const char* d = static_cast <const char*> (data.getData());
+
+            for (int pos = 0; pos < (int) data.getSize();)
+            {
+                const int num = jmin (12345, (int) data.getSize() - pos);
+
+                if (pipe.write (d + pos, num, 5000) != num)
+                    return;
+
+                pos += num;
+            }
+
+            result = (int) data.getSize();
+        }
+
+        NamedPipe& pipe;
+        const MemoryBlock data;
+        int result;
+    };
+
+    void runTest()
+    {
+        beginTest ("Shared memory");
+
+        const String name ("juce_test_pipe_" + String::toHexString (Random::getSystemRandom().nextInt()));
+        NamedPipe creator, other;
+        expect (creator.createNewPipe (name, true));
+        expect (other.openExisting (name));
+        expect (creator.isUsingSharedMemory());
+        expect (other.isUsingSharedMemory());
+
+        beginTest ("Round trip");
+
+        for (int direction = 0; direction < 2; ++direction)
+        {
+            NamedPipe& source = direction == 0 ? creator : other;
+            NamedPipe& dest   = direction == 0 ? other : creator;
+
+            MemoryBlock data (3 * 1024 * 1024 + 100);
+            Random r;
+
+            for (size_t i = 0; i < data.getSize(); ++i)
+                data[(int) i] = (char) r.nextInt (256);
+
+            WriterThread writer (source, data);
+            MemoryBlock received (data.getSize());
+            expectEquals (dest.read (received.getData(), (int) received.getSize(), 5000), (int) received.getSize());
+            writer.waitForThreadToExit (5000);
+            expectEquals (writer.result, (int) data.getSize());
+            expect (received == data);
+        }
+
+        beginTest ("Full ring");
+
+        {
+            // nothing's reading, so once the ring is full, the write times out
+            MemoryBlock data (2 * 1024 * 1024);
+            const int written = creator.write (data.getData(), (int) data.getSize(), 100);
+            expectEquals (written, 1024 * 1024);
+
+            MemoryBlock received ((size_t) written);
+            expectEquals (other.read (received.getData(), written, 1000), written);
+        }
+
+        beginTest ("Read timeout");
+
+        {
+            char buffer[16];
+            const uint32 start = Time::getMillisecondCounter();
+            expectEquals (other.read (buffer, sizeof (buffer), 100), -1);
+            expect (Time::getMillisecondCounter() - start >= 90);
+        }
+
+        beginTest ("Peer closing");
+
+        {
+            char buffer[16] = { 0 };
+            expectEquals (creator.write (buffer, 10, 1000), 10);
+            creator.close();
+
+            // (anything written before it closed can still be read)
+            expectEquals (other.read (buffer, 10, 1000), 10);
+            expectEquals (other.read (buffer, 10, 1000), -1);
+            expectEquals (other.write (buffer, 10, 1000), -1);
+        }
+    }
+};
+
+static NamedPipeTests namedPipeTests;
+
+#endif
@@ -48,14 +48,26 @@ public:
 
     //==============================================================================
     /** Tries to open a pipe that already exists.
+
+        If the pipe was created to use shared memory, this will connect to that, so
+        the pipe must have been created before this is called.
+
         Returns true if it succeeds.
     */
     bool openExisting (const String& pipeName);
 
     /** Tries to create a new pipe.
+
+        If useSharedMemory is true, then on platforms where it's supported (currently
+        only Linux), the data will be passed through a pair of ring buffers in a block
+        of shared memory, rather than through the kernel. This is much faster for large
+        amounts of data, but only one other pipe object can connect to it. If the
+        shared memory can't be created, a normal pipe will be used instead - you can
+        call isUsingSharedMemory() to find out which one you got.
+
         Returns true if it succeeds.
     */
-    bool createNewPipe (const String& pipeName);
+    bool createNewPipe (const String& pipeName, bool useSharedMemory = false);
 
     /** Closes the pipe, if it's open. */
     void close();
@@ -66,6 +78,11 @@ public:
     /** Returns the last name that was used to try to open this pipe. */
     String getName() const;
 
+    /** True if the pipe is open and is using shared memory rather than a system pipe.
+        @see createNewPipe
+    */
+    bool isUsingSharedMemory() const;
+
     //==============================================================================
     /** Reads data from the pipe.
 
@@ -93,7 +110,7 @@ private:
     String currentPipeName;
     ReadWriteLock lock;
 
-    bool openInternal (const String& pipeName, const bool createPipe);
+    bool openInternal (const String& pipeName, bool createPipe, bool useSharedMemory);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NamedPipe)
 };
@@ -367,6 +367,182 @@ XmlElement* URL::readEntireXmlStream (const bool usePostCommand) const
     return XmlDocument::parse (readEntireTextStream (usePostCommand));
 }
 
+//==============================================================================
+void URL::AsyncRequestListener::requestStarted (const URL&, const StringPairArray&) {}
+
+class URLAsyncRequestThread  : public Thread
+{
+public:
+    URLAsyncRequestThread()
+        : Thread ("JUCE URL requests"), currentListener (nullptr)
+    {
+    }
+
+    ~URLAsyncRequestThread()
+    {
+        stopThread (10000);
+        clearSingletonInstance();
+    }
+
+    juce_DeclareSingleton (URLAsyncRequestThread, false)
+
+    void addRequest (const URL& url, URL::AsyncRequestListener* const listener, const bool usePostCommand,
+                     const String& extraHeaders, const int timeOutMs)
+    {
+        {
+            const ScopedLock sl (lock);
+            requests.add (new Request (url, listener, usePostCommand, extraHeaders, timeOutMs));
+        }
+
+        startThread();
+        notify();
+    }
+
+    void cancelRequests (URL::AsyncRequestListener* const listener)
+    {
+        // (taking the callback lock means that this waits for a callback that's in progress)
+        const ScopedLock cl (callbackLock);
+        const ScopedLock sl (lock);
+
+        for (int i = requests.size(); --i >= 0;)
+            if (requests.getUnchecked(i)->listener == listener)
+                requests.remove (i);
+
+        if (currentListener == listener)
+            currentListener = nullptr;
+    }
+
+    void run()
+    {
+        HeapBlock<char> buffer ((size_t) bufferSize);
+
+        while (! threadShouldExit())
+        {
+            ScopedPointer<Request> r;
+
+            {
+                const ScopedLock sl (lock);
+
+                if (requests.size() > 0)
+                {
+                    r = requests.removeAndReturn (0);
+                    currentListener = r->listener;
+                }
+            }
+
+            if (r == nullptr)
+                wait (-1);
+            else
+                performRequest (*r, buffer);
+        }
+    }
+
+private:
+    struct Request
+    {
+        Request (const URL& url_, URL::AsyncRequestListener* const listener_, const bool usePostCommand_,
+                 const String& extraHeaders_, const int timeOutMs_)
+            : url (url_), listener (listener_), usePostCommand (usePostCommand_),
+              extraHeaders (extraHeaders_), timeOutMs (timeOutMs_)
+        {
+        }
+
+        const URL url;
+        URL::AsyncRequestListener* const listener;
+        const bool usePostCommand;
+        const String extraHeaders;
+        const int timeOutMs;
+
+        JUCE_DECLARE_NON_COPYABLE (Request)
+    };
+
+    enum { bufferSize = 16384 };
+
+    CriticalSection lock, callbackLock;
+    OwnedArray<Request> requests;
+    URL::AsyncRequestListener* currentListener;
+
+    bool isCancelled()
+    {
+        const ScopedLock sl (lock);
+        return currentListener == nullptr || threadShouldExit();
+    }
+
+    void performRequest (const Request& r, char* const buffer)
+    {
+        StringPairArray responseHeaders;
+        const ScopedPointer<InputStream> in (r.url.createInputStream (r.usePostCommand, nullptr, nullptr, r.extraHeaders,
+                                                                      r.timeOutMs, &responseHeaders));
+        bool succeeded = false;
+
+        if (in != nullptr)
+        {
+            {
+                const ScopedLock cl (callbackLock);
+
+                if (isCancelled())
+                    return;
+
+                r.listener->requestStarted (r.url, responseHeaders);
+            }
+
+            for (;;)
+            {
+                const int numRead = in->read (buffer, bufferSize);
+
+                if (numRead <= 0)
+                    break;
+
+                const ScopedLock cl (callbackLock);
+
+                if (isCancelled())
+                    return;
+
+                r.listener->dataReceived (r.url, buffer, numRead);
+            }
+
+            succeeded = in->isExhausted();
+        }
+
+        const ScopedLock cl (callbackLock);
+
+        if (! isCancelled())
+            r.listener->requestFinished (r.url, succeeded);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (URLAsyncRequestThread)
+};
+
+juce_ImplementSingleton (URLAsyncRequestThread)
+
+void URL::startAsyncRequest (AsyncRequestListener* const listener, const bool usePostCommand,
+                             const String& extraHeaders, const int timeOutMs) const
+{
+    jassert (listener != nullptr);
+
+    if (listener != nullptr)
+        URLAsyncRequestThread::getInstance()->addRequest (*this, listener, usePostCommand, extraHeaders, timeOutMs);
+}
+
+void URL::cancelAsyncRequests (AsyncRequestListener* const listener)
+{
+    if (URLAsyncRequestThread* const thread = URLAsyncRequestThread::getInstanceWithoutCreating())
+        thread->cancelRequests (listener);
+}
+
+#if JUCE_LINUX
+ void juce_closeIdleHTTPConnections();
+#endif
+
+void URL::shutdownAsyncRequests()
+{
+    URLAsyncRequestThread::deleteInstance();
+
+   #if JUCE_LINUX
+    juce_closeIdleHTTPConnections();
+   #endif
+}
+
 //==============================================================================
 URL URL::withParameter (const String& parameterName,
                         const String& parameterValue) const
@@ -468,3 +644,285 @@ bool URL::launchInDefaultBrowser() const
 
     return Process::openDocument (u, String::empty);
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS && JUCE_LINUX
+
+class URLTests  : public UnitTest
+{
+public:
+    URLTests() : UnitTest ("URL") {}
+
+    static String createBody (const String& path, const int size)
+    {
+        String s;
+
+        while (s.length() < size)
+            s << path << ':' << s.length() << ';';
+
+        return s.substring (0, size);
+    }
+
+    //==============================================================================
+    // A minimal HTTP/1.1 server, which keeps its connections open between requests.
+    class TestServer  : public Thread
+    {
+    public:
+        TestServer() : Thread ("URL test server"), port (0)
+        {
+            for (int i = 0; i < 20 && port == 0; ++i)
+            {
+                port = 30000 + Random::getSystemRandom().nextInt (20000);
+
+                if (! listener.createListener (port, "127.0.0.1"))
+                    port = 0;
+            }
+
+            startThread();
+        }
+
+        ~TestServer()
+        {
+            signalThreadShouldExit();
+            listener.close();
+            stopThread (5000);
+            connections.clear();
+        }
+
+        void run()
+        {
+            while (! threadShouldExit())
+            {
+                StreamingSocket* const s = listener.waitForNextConnection();
+
+                if (s == nullptr)
+                    break;
+
+                ++numConnections;
+                connections.add (new ConnectionThread (s));
+            }
+        }
+
+        int port;
+        Atomic<int> numConnections;
+
+    private:
+        class ConnectionThread  : public Thread
+        {
+        public:
+            ConnectionThread (StreamingSocket* s)  : Thread ("URL test connection"), socket (s)
+            {
+                startThread();
+            }
+
+            ~ConnectionThread()
+            {
+                socket->close();
+                stopThread (5000);
+            }
+
+            void run()
+            {
+                serve();
+                socket->close();
+            }
+
+        private:
+            ScopedPointer<StreamingSocket> socket;
+
+            void serve()
+            {
+                String request;
+
+                while (! threadShouldExit())
+                {
+                    if (! request.contains ("\r\n\r\n"))
+                    {
+                        char buffer [1024];
+
+                        if (socket->waitUntilReady (true, 100) == 0)
+                            continue;
+
+                        const int num = socket->read (buffer, sizeof (buffer), false);
+
+                        if (num <= 0)
+                            return;
+
+                        request += String::fromUTF8 (buffer, num);
+                        continue;
+                    }
+
+                    const String path (request.fromFirstOccurrenceOf (" ", false, false)
+                                              .upToFirstOccurrenceOf (" ", false, false));
+                    request = request.fromFirstOccurrenceOf ("\r\n\r\n", false, false);
+
+                    if (! respond (path))
+                        return;
+                }
+            }
+
+            bool send (const String& text)
+            {
+                const int size = (int) text.getNumBytesAsUTF8();
+                return socket->write (text.toRawUTF8(), size) == size;
+            }
+
+            // returns false if the connection should be closed
+            bool respond (const String& path)
+            {
+                const String body (createBody (path, 1000));
+
+                if (path == "/slow")
+                    Thread::sleep (300);
+
+                if (path.startsWith ("/chunked"))
+                {
+                    String response ("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+
+                    for (int i = 0; i < body.length(); i += 300)
+                    {
+                        const String piece (body.substring (i, i + 300));
+                        response << String::toHexString (piece.length()) << ";ext=1\r\n" << piece << "\r\n";
+
+                        if (path == "/chunked/truncated")
+                            return ! send (response);
+                    }
+
+                    return send (response + "0\r\nX-Trailer: yes\r\n\r\n");
+                }
+
+                const String header ("HTTP/1.1 200 OK\r\nContent-Length: 1000\r\n\r\n");
+
+                if (path == "/truncated")
+                    return ! send (header + body.substring (0, 500));
+
+                return send (header + body);
+            }
+        };
+
+        StreamingSocket listener;
+        OwnedArray<ConnectionThread> connections;
+    };
+
+    //==============================================================================
+    class Listener  : public URL::AsyncRequestListener
+    {
+    public:
+        Listener() : numFinished (0), numSucceeded (0), numCallbacks (0) {}
+
+        void requestStarted (const URL&, const StringPairArray&)    { ++numCallbacks; }
+
+        void dataReceived (const URL&, const void* data, int numBytes)
+        {
+            received.write (data, (size_t) numBytes);
+            ++numCallbacks;
+        }
+
+        void requestFinished (const URL&, bool succeeded)
+        {
+            ++numCallbacks;
+
+            if (succeeded)
+                ++numSucceeded;
+
+            if (++numFinished == numExpected)
+                finished.signal();
+        }
+
+        MemoryOutputStream received;
+        int numExpected, numFinished, numSucceeded;
+        Atomic<int> numCallbacks;
+        WaitableEvent finished;
+    };
+
+    //==============================================================================
+    void runTest()
+    {
+        beginTest ("Content-Length and chunked responses");
+
+        TestServer server;
+        expect (server.port != 0);
+        const String base ("http://127.0.0.1:" + String (server.port));
+
+        const char* const paths[] = { "/a", "/chunked/b", "/c", "/chunked/d" };
+
+        for (int i = 0; i < numElementsInArray (paths); ++i)
+            expectEquals (URL (base + paths[i]).readEntireTextStream(), createBody (paths[i], 1000));
+
+        beginTest ("Connection re-use");
+
+        expectEquals (server.numConnections.get(), 1);
+
+        beginTest ("Truncated responses");
+
+        for (int i = 0; i < 2; ++i)
+        {
+            const String path (i == 0 ? "/truncated" : "/chunked/truncated");
+            ScopedPointer<InputStream> in (URL (base + path).createInputStream (false));
+            expect (in != nullptr);
+
+            if (in != nullptr)
+            {
+                const String text (in->readEntireStreamAsString());
+                expect (text.length() < 1000 && createBody (path, 1000).startsWith (text));
+                expect (! in->isExhausted());
+            }
+
+            Listener listener;
+            listener.numExpected = 1;
+            URL (base + path).startAsyncRequest (&listener);
+            expect (listener.finished.wait (10000));
+            expectEquals (listener.numSucceeded, 0);
+        }
+
+        beginTest ("Async requests");
+
+        {
+            Listener listener;
+            listener.numExpected = numElementsInArray (paths);
+
+            for (int i = 0; i < numElementsInArray (paths); ++i)
+                URL (base + paths[i]).startAsyncRequest (&listener);
+
+            expect (listener.finished.wait (10000));
+            expectEquals (listener.numSucceeded, listener.numExpected);
+
+            String expected;
+
+            for (int i = 0; i < numElementsInArray (paths); ++i)
+                expected << createBody (paths[i], 1000);
+
+            expectEquals (listener.received.toString(), expected);
+        }
+
+        beginTest ("Cancelling async requests");
+
+        {
+            Listener listener;
+            listener.numExpected = 3;
+
+            for (int i = 0; i < listener.numExpected; ++i)
+                URL (base + "/slow").startAsyncRequest (&listener);
+
+            Thread::sleep (100);
+            URL::cancelAsyncRequests (&listener);
+            const int numCallbacks = listener.numCallbacks.get();
+
+            // (another request has to finish after this, to show that the cancelled ones have gone)
+            Listener other;
+            other.numExpected = 1;
+            URL (base + "/a").startAsyncRequest (&other);
+            expect (other.finished.wait (10000));
+            expectEquals (other.numSucceeded, 1);
+
+            expectEquals (listener.numCallbacks.get(), numCallbacks);
+            expectEquals (listener.numFinished, 0);
+        }
+
+        URL::shutdownAsyncRequests();
+    }
+};
+
+static URLTests urlTests;
+
+#endif
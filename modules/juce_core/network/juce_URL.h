@@ -258,6 +258,73 @@ public:
                                     StringPairArray* responseHeaders = nullptr) const;
 
 
+    //==============================================================================
+    /**
+        Receives the results of requests that were started with URL::startAsyncRequest().
+
+        All of these callbacks are made on a shared background thread, so a listener that
+        takes a long time to handle them will hold up any other requests that are waiting.
+
+        @see URL::startAsyncRequest
+    */
+    class JUCE_API  AsyncRequestListener
+    {
+    public:
+        /** Destructor. */
+        virtual ~AsyncRequestListener() {}
+
+        /** Called when the server has responded, before any of the data arrives.
+            If the request can't be made, this won't be called, and requestFinished()
+            will be called with succeeded = false.
+        */
+        virtual void requestStarted (const URL& url, const StringPairArray& responseHeaders);
+
+        /** Called with each block of data as it's read. */
+        virtual void dataReceived (const URL& url, const void* data, int numBytes) = 0;
+
+        /** Called when the request has finished, or has failed.
+            The succeeded flag is false if the request couldn't be made, or if the
+            connection was lost before the whole of the response had arrived.
+        */
+        virtual void requestFinished (const URL& url, bool succeeded) = 0;
+    };
+
+    /** Starts downloading this URL on a background thread, and returns immediately.
+
+        The data will be passed to the listener as it arrives. Requests are run one at a
+        time, in the order they were started, on a thread that's shared by all the async
+        requests, and on platforms where connections can be kept open between requests,
+        they'll re-use the same connection to a server. This makes it a cheap way to
+        fetch lots of small resources.
+
+        The listener must not be deleted until its requestFinished() method has been
+        called, or until it has been passed to cancelAsyncRequests().
+
+        @see cancelAsyncRequests, createInputStream
+    */
+    void startAsyncRequest (AsyncRequestListener* listener,
+                            bool usePostCommand = false,
+                            const String& extraHeaders = String::empty,
+                            int connectionTimeOutMs = 0) const;
+
+    /** Cancels any async requests that were started with this listener.
+
+        Requests that haven't started yet are discarded, and if one is in progress,
+        this waits for any callback that it's in the middle of making. After this
+        returns, the listener won't receive any more callbacks, and can be deleted.
+    */
+    static void cancelAsyncRequests (AsyncRequestListener* listener);
+
+    /** Stops the thread that runs async requests, and closes any connections that are
+        being kept open for re-use.
+
+        Any requests that are still waiting are discarded without their listeners being
+        called. This is called by shutdownJuce_GUI() when an app quits, but if you use
+        startAsyncRequest() without the rest of the library's app framework, you should
+        call it yourself before your program exits.
+    */
+    static void shutdownAsyncRequests();
+
     //==============================================================================
     /** Tries to download the entire contents of this URL into a binary data block.
 
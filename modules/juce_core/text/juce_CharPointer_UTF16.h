@@ -95,7 +95,7 @@ public:
     /** Moves this pointer along to the next character in the string. */
     CharPointer_UTF16& operator++() noexcept
     {
-        const juce_wchar n = *data++;
+        const uint32 n = (uint32) (uint16) *data++;
 
         if (n >= 0xd800 && n <= 0xdfff && ((uint32) (uint16) *data) >= 0xdc00)
             ++data;
@@ -106,7 +106,7 @@ public:
     /** Moves this pointer back to the previous character in the string. */
     CharPointer_UTF16& operator--() noexcept
     {
-        const juce_wchar n = *--data;
+        const uint32 n = (uint32) (uint16) *--data;
 
         if (n >= 0xdc00 && n <= 0xdfff)
             --data;
@@ -208,7 +208,7 @@ public:
 
         for (;;)
         {
-            const int n = *d++;
+            const uint32 n = (uint32) (uint16) *d++;
 
             if (n >= 0xd800 && n <= 0xdfff)
             {
@@ -260,10 +260,20 @@ public:
     static size_t getBytesRequiredFor (CharPointer text) noexcept
     {
         size_t count = 0;
-        juce_wchar n;
 
-        while ((n = text.getAndAdvance()) != 0)
+        for (;;)
+        {
+            const size_t numASCII = CharacterFunctions::findLengthOfASCIIPrefix (text.getAddress());
+            text = CharPointer (text.getAddress() + numASCII);
+            count += numASCII * sizeof (CharType);
+
+            const juce_wchar n = text.getAndAdvance();
+
+            if (n == 0)
+                break;
+
             count += getBytesRequiredFor (n);
+        }
 
         return count;
     }
@@ -240,6 +240,13 @@ public:
 
         for (;;)
         {
+            if (*d > 0)
+            {
+                const size_t numASCII = CharacterFunctions::findLengthOfASCIIPrefix (d);
+                d += numASCII;
+                count += numASCII;
+            }
+
             const uint32 n = (uint32) (uint8) *d++;
 
             if ((n & 0x80) != 0)
@@ -315,10 +322,20 @@ public:
     static size_t getBytesRequiredFor (CharPointer text) noexcept
     {
         size_t count = 0;
-        juce_wchar n;
 
-        while ((n = text.getAndAdvance()) != 0)
+        for (;;)
+        {
+            const size_t numASCII = CharacterFunctions::findLengthOfASCIIPrefix (text.getAddress());
+            text = CharPointer (text.getAddress() + numASCII);
+            count += numASCII;
+
+            const juce_wchar n = text.getAndAdvance();
+
+            if (n == 0)
+                break;
+
             count += getBytesRequiredFor (n);
+        }
 
         return count;
     }
@@ -371,13 +388,9 @@ public:
     /** Copies a source string to this pointer, advancing this pointer as it goes. */
     void writeAll (const CharPointer_UTF8& src) noexcept
     {
-        const CharType* s = src.data;
-
-        while ((*data = *s) != 0)
-        {
-            ++data;
-            ++s;
-        }
+        const size_t numBytes = strlen (src.data);
+        memmove (data, src.data, numBytes + 1);
+        data += numBytes;
     }
 
     /** Copies a source string to this pointer, advancing this pointer as it goes.
@@ -506,8 +519,18 @@ public:
     /** Returns true if this data contains a valid string in this encoding. */
     static bool isValidString (const CharType* dataToTest, int maxBytesToRead)
     {
-        while (--maxBytesToRead >= 0 && *dataToTest != 0)
+        for (;;)
         {
+            if (maxBytesToRead > 0)
+            {
+                const size_t numASCII = CharacterFunctions::findLengthOfASCIIPrefix (dataToTest, (size_t) maxBytesToRead);
+                dataToTest += numASCII;
+                maxBytesToRead -= (int) numASCII;
+            }
+
+            if (--maxBytesToRead < 0 || *dataToTest == 0)
+                break;
+
             const signed char byte = (signed char) *dataToTest++;
 
             if (byte < 0)
@@ -149,3 +149,136 @@ double CharacterFunctions::mulexp10 (const double value, int exponent) noexcept
 
     return negative ? (value / result) : (value * result);
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class CharacterFunctionsTests  : public UnitTest
+{
+public:
+    CharacterFunctionsTests() : UnitTest ("CharacterFunctions") {}
+
+    // Creates a string that's mostly made of runs of ASCII, with a few other characters mixed in
+    static void createRandomText (Random& r, Array<juce_wchar>& chars)
+    {
+        chars.clearQuick();
+        const int numChars = r.nextInt (200);
+
+        while (chars.size() < numChars)
+        {
+            switch (r.nextInt (8))
+            {
+                case 0:   chars.add ((juce_wchar) (0x80 + r.nextInt (0x780))); break;
+                case 1:   chars.add ((juce_wchar) (0x800 + r.nextInt (0xd000))); break;
+                case 2:   chars.add ((juce_wchar) (0x10000 + r.nextInt (0x10000))); break;
+
+                default:
+                    for (int n = r.nextInt (40); --n >= 0;)
+                        chars.add ((juce_wchar) (1 + r.nextInt (0x7f)));
+
+                    break;
+            }
+        }
+
+        chars.add (0);
+    }
+
+    static size_t findASCIIPrefixSlowly (const juce_wchar* chars, size_t maxChars, const juce_wchar charToStopAt)
+    {
+        size_t i = 0;
+
+        while (i < maxChars && chars[i] > 0 && chars[i] < 0x80 && chars[i] != charToStopAt)
+            ++i;
+
+        return i;
+    }
+
+    template <class CharPointer>
+    void testEncoding (Random& r, const Array<juce_wchar>& chars)
+    {
+        typedef typename CharPointer::CharType CharType;
+
+        // (the text is written at a random offset so that it's aligned in different ways)
+        const int bufferSize = chars.size() * 4 + 16;
+        HeapBlock<CharType> buffer ((size_t) bufferSize, true);
+        const int offset = r.nextInt (8);
+        CharPointer text (buffer + offset);
+        text.writeAll (CharPointer_UTF32 (chars.begin()));
+
+        expectEquals ((int) CharPointer (buffer + offset).length(), chars.size() - 1);
+        expectEquals ((int) CharPointer_UTF8::getBytesRequiredFor (CharPointer (buffer + offset)),
+                      (int) CharPointer_UTF8::getBytesRequiredFor (CharPointer_UTF32 (chars.begin())));
+        expectEquals ((int) CharPointer_UTF16::getBytesRequiredFor (CharPointer (buffer + offset)),
+                      (int) CharPointer_UTF16::getBytesRequiredFor (CharPointer_UTF32 (chars.begin())));
+
+        const CharType* const start = buffer + offset;
+        CharPointer p (buffer + offset);
+
+        for (int i = 0; i < chars.size() - 1; ++i)
+        {
+            const juce_wchar* const c = chars.begin() + i;
+            const int unitIndex = (int) (p.getAddress() - start);
+            const size_t maxChars = (size_t) jmin (r.nextInt (50), bufferSize - offset - unitIndex);
+            const juce_wchar charToFind = (juce_wchar) (1 + r.nextInt (0x7f));
+
+            // (because of the multi-unit characters, these are only equal up to the first non-ASCII one)
+            expectEquals ((int) CharacterFunctions::findLengthOfASCIIPrefix (start + unitIndex),
+                          (int) findASCIIPrefixSlowly (c, std::numeric_limits<size_t>::max(), 0));
+            expectEquals ((int) CharacterFunctions::findLengthOfASCIIPrefix (start + unitIndex, maxChars),
+                          (int) findASCIIPrefixSlowly (c, maxChars, 0));
+            expectEquals ((int) CharacterFunctions::findLengthOfASCIIPrefixNotContaining (start + unitIndex, charToFind),
+                          (int) findASCIIPrefixSlowly (c, std::numeric_limits<size_t>::max(), charToFind));
+
+            int expectedIndex = -1;
+
+            for (int j = 0; c[j] != 0; ++j)
+            {
+                if (c[j] == charToFind)
+                {
+                    expectedIndex = j;
+                    break;
+                }
+            }
+
+            expectEquals (CharacterFunctions::indexOfChar (p, charToFind), expectedIndex);
+            expect (p.getAndAdvance() == *c);
+        }
+    }
+
+    void runTest()
+    {
+        beginTest ("ASCII fast paths");
+
+        Random r;
+        r.setSeedRandomly();
+        Array<juce_wchar> chars;
+
+        for (int i = 0; i < 300; ++i)
+        {
+            createRandomText (r, chars);
+
+            testEncoding<CharPointer_UTF8>  (r, chars);
+            testEncoding<CharPointer_UTF16> (r, chars);
+            testEncoding<CharPointer_UTF32> (r, chars);
+
+            const String s (CharPointer_UTF32 (chars.begin()));
+            expectEquals (s.length(), chars.size() - 1);
+            expectEquals (String (s.toUTF16()), s);
+            expectEquals (String (s.toUTF32()), s);
+            expect (memcmp (s.toUTF32().getAddress(), chars.begin(), sizeof (juce_wchar) * (size_t) chars.size()) == 0);
+
+            // Checking every prefix of the UTF-8 data: it's only valid if it doesn't end part-way through a character
+            const char* const utf8 = s.toRawUTF8();
+            const int numBytes = (int) s.getNumBytesAsUTF8();
+            const int maxBytesToTest = r.nextInt (numBytes + 1);
+
+            expect (CharPointer_UTF8::isValidString (utf8, numBytes));
+            expect (CharPointer_UTF8::isValidString (utf8, maxBytesToTest)
+                     == (maxBytesToTest == numBytes || (utf8 [maxBytesToTest] & 0xc0) != 0x80));
+        }
+    }
+};
+
+static CharacterFunctionsTests characterFunctionsTests;
+
+#endif
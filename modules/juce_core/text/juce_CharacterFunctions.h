@@ -277,6 +277,45 @@ public:
         return isNeg ? -v : v;
     }
 
+    //==============================================================================
+    /** Returns the number of characters at the start of a null-terminated string which
+        are 7-bit ASCII, i.e. the index of the first one which is either a null or has a
+        value of 0x80 or more.
+
+        This works on the raw data of any of the CharPointer encodings (because an ASCII
+        character is always stored as a single unit in them), so it's used to speed up
+        operations on text that's mostly ASCII.
+    */
+    template <typename CharType>
+    static size_t findLengthOfASCIIPrefix (const CharType* text) noexcept
+    {
+        return scanASCIIPrefix (text, std::numeric_limits<size_t>::max(), 0);
+    }
+
+    /** Returns the number of 7-bit ASCII characters at the start of a string, stopping
+        at a null or after the given number of characters.
+        This never reads any data beyond the given number of characters, so can be used
+        on data which may not be null-terminated. Because the size of the data is known,
+        it checks a whole machine word of characters at a time.
+        @see findLengthOfASCIIPrefix
+    */
+    template <typename CharType>
+    static size_t findLengthOfASCIIPrefix (const CharType* text, size_t maxCharsToRead) noexcept
+    {
+        return scanASCIIPrefix (text, maxCharsToRead, 0);
+    }
+
+    /** Returns the number of 7-bit ASCII characters at the start of a null-terminated string
+        that come before the first occurrence of a given character, which must itself be a
+        (non-null) ASCII character.
+        @see findLengthOfASCIIPrefix
+    */
+    template <typename CharType>
+    static size_t findLengthOfASCIIPrefixNotContaining (const CharType* text, const juce_wchar asciiCharToStopAt) noexcept
+    {
+        return scanASCIIPrefix (text, std::numeric_limits<size_t>::max(), asciiCharToStopAt);
+    }
+
     //==============================================================================
     /** Counts the number of characters in a given string, stopping if the count exceeds
         a specified limit. */
@@ -310,6 +349,21 @@ public:
     {
         for (;;)
         {
+            // (runs of ASCII characters can be copied without decoding and re-encoding them)
+            const size_t numASCII = findLengthOfASCIIPrefix (src.getAddress());
+
+            if (numASCII > 0)
+            {
+                typename DestCharPointerType::CharType* const d = dest.getAddress();
+                typename SrcCharPointerType::CharType* const s = src.getAddress();
+
+                for (size_t i = 0; i < numASCII; ++i)
+                    d[i] = (typename DestCharPointerType::CharType) s[i];
+
+                dest = DestCharPointerType (d + numASCII);
+                src  = SrcCharPointerType (s + numASCII);
+            }
+
             const juce_wchar c = src.getAndAdvance();
 
             if (c == 0)
@@ -500,6 +554,24 @@ public:
     {
         int i = 0;
 
+        if (charToFind > 0 && charToFind < 0x80)
+        {
+            for (;;)
+            {
+                const size_t numToSkip = findLengthOfASCIIPrefixNotContaining (text.getAddress(), charToFind);
+                text = Type (text.getAddress() + numToSkip);
+                i += (int) numToSkip;
+
+                if (text.isEmpty())
+                    return -1;
+
+                if (text.getAndAdvance() == charToFind)
+                    return i;
+
+                ++i;
+            }
+        }
+
         while (! text.isEmpty())
         {
             if (text.getAndAdvance() == charToFind)
@@ -581,6 +653,60 @@ public:
 
 private:
     static double mulexp10 (const double value, int exponent) noexcept;
+
+    // If maxChars is std::numeric_limits<size_t>::max(), the text is null-terminated
+    template <typename CharType>
+    static size_t scanASCIIPrefix (const CharType* const text, size_t maxChars, const juce_wchar charToStopAt) noexcept
+    {
+        const size_t laneMask = sizeof (CharType) == 1 ? 0xff : (sizeof (CharType) == 2 ? 0xffff : 0xffffffff);
+        const CharType* t = text;
+
+        // Whole words can only be read when the length of the data is known, because reading
+        // past the terminator of a null-terminated string isn't allowed, even within a page.
+        if (maxChars != std::numeric_limits<size_t>::max())
+        {
+            // Each word is treated as a set of lanes, one per character. A word is skipped if none of
+            // its lanes is zero or has any bits above 0x7f, and none of them matches charToStopAt.
+            const size_t lowBits      = ~(size_t) 0 / laneMask;
+            const size_t highBits     = lowBits * ((laneMask >> 1) + 1);
+            const size_t nonASCIIBits = lowBits * (laneMask & ~(size_t) 0x7f);
+            const size_t stopPattern  = lowBits * (size_t) charToStopAt;
+            const size_t charsPerWord = sizeof (size_t) / sizeof (CharType);
+
+            while (maxChars >= charsPerWord)
+            {
+                size_t w;
+                memcpy (&w, t, sizeof (w));  // (the data may not be aligned, and mustn't be aliased)
+
+                if ((((w - lowBits) | w) & nonASCIIBits) != 0)
+                    break;
+
+                if (charToStopAt != 0)
+                {
+                    const size_t x = w ^ stopPattern;
+
+                    if (((x - lowBits) & ~x & highBits) != 0)
+                        break;
+                }
+
+                t += charsPerWord;
+                maxChars -= charsPerWord;
+            }
+        }
+
+        // (after the word loop, this finds the exact character within the word that stopped it)
+        for (; maxChars > 0; --maxChars)
+        {
+            const uint32 c = ((uint32) *t) & (uint32) laneMask;
+
+            if (c - 1 >= 0x7f || c == (uint32) charToStopAt)
+                break;
+
+            ++t;
+        }
+
+        return (size_t) (t - text);
+    }
 };
 
 
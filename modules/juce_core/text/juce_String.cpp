@@ -51,15 +51,11 @@ static inline CharPointer_wchar_t castToCharPointer_wchar_t (const void* t) noex
 class StringHolder
 {
 public:
-    StringHolder() noexcept
-        : refCount (0x3fffffff), allocatedNumBytes (sizeof (*text))
-    {
-        text[0] = 0;
-    }
-
     typedef String::CharPointerType CharPointerType;
     typedef String::CharPointerType::CharType CharType;
 
+    enum { localTextBytes = String::localTextBytes };
+
     //==============================================================================
     static CharPointerType createUninitialisedBytes (const size_t numBytes)
     {
@@ -69,28 +65,47 @@ public:
         return CharPointerType (s->text);
     }
 
-    template <class CharPointer>
-    static CharPointerType createFromCharPointer (const CharPointer& text)
+    // Sets up a string's storage (which mustn't already be holding any text) with space
+    // for the given number of bytes, and returns a pointer to it.
+    static CharPointerType allocate (String& dest, const size_t numBytes)
     {
-        if (text.getAddress() == nullptr || text.isEmpty())
-            return getEmpty();
+        if (numBytes <= localTextBytes)
+        {
+            setEmpty (dest.storage);
+            return getLocalText (dest.storage);
+        }
 
-        CharPointer t (text);
-        size_t bytesNeeded = sizeof (CharType);
+        const CharPointerType newText (createUninitialisedBytes (numBytes));
+        setHeapText (dest.storage, newText);
+        return newText;
+    }
 
-        while (! t.isEmpty())
-            bytesNeeded += CharPointerType::getBytesRequiredFor (t.getAndAdvance());
+    static inline void setEmpty (String::Storage& storage) noexcept
+    {
+        zerostruct (storage);
+    }
+
+    template <class CharPointer>
+    static void createFromCharPointer (String& dest, const CharPointer& text)
+    {
+        if (text.getAddress() == nullptr || text.isEmpty())
+        {
+            setEmpty (dest.storage);
+            return;
+        }
 
-        const CharPointerType dest (createUninitialisedBytes (bytesNeeded));
-        CharPointerType (dest).writeAll (text);
-        return dest;
+        const size_t bytesNeeded = sizeof (CharType) + CharPointerType::getBytesRequiredFor (text);
+        allocate (dest, bytesNeeded).writeAll (text);
     }
 
     template <class CharPointer>
-    static CharPointerType createFromCharPointer (const CharPointer& text, size_t maxChars)
+    static void createFromCharPointer (String& dest, const CharPointer& text, size_t maxChars)
     {
         if (text.getAddress() == nullptr || text.isEmpty() || maxChars == 0)
-            return getEmpty();
+        {
+            setEmpty (dest.storage);
+            return;
+        }
 
         CharPointer end (text);
         size_t numChars = 0;
@@ -102,16 +117,17 @@ public:
             ++numChars;
         }
 
-        const CharPointerType dest (createUninitialisedBytes (bytesNeeded));
-        CharPointerType (dest).writeWithCharLimit (text, (int) numChars + 1);
-        return dest;
+        allocate (dest, bytesNeeded).writeWithCharLimit (text, (int) numChars + 1);
     }
 
     template <class CharPointer>
-    static CharPointerType createFromCharPointer (const CharPointer& start, const CharPointer& end)
+    static void createFromCharPointer (String& dest, const CharPointer& start, const CharPointer& end)
     {
         if (start.getAddress() == nullptr || start.isEmpty())
-            return getEmpty();
+        {
+            setEmpty (dest.storage);
+            return;
+        }
 
         CharPointer e (start);
         int numChars = 0;
@@ -123,84 +139,78 @@ public:
             ++numChars;
         }
 
-        const CharPointerType dest (createUninitialisedBytes (bytesNeeded));
-        CharPointerType (dest).writeWithCharLimit (start, numChars + 1);
-        return dest;
+        allocate (dest, bytesNeeded).writeWithCharLimit (start, numChars + 1);
     }
 
-    static CharPointerType createFromCharPointer (const CharPointerType& start, const CharPointerType& end)
+    static void createFromCharPointer (String& dest, const CharPointerType& start, const CharPointerType& end)
     {
         if (start.getAddress() == nullptr || start.isEmpty())
-            return getEmpty();
+        {
+            setEmpty (dest.storage);
+            return;
+        }
 
         const size_t numBytes = (size_t) (end.getAddress() - start.getAddress());
-        const CharPointerType dest (createUninitialisedBytes (numBytes + 1));
-        memcpy (dest.getAddress(), start, numBytes);
-        dest.getAddress()[numBytes] = 0;
-        return dest;
-    }
-
-    static CharPointerType createFromFixedLength (const char* const src, const size_t numChars)
-    {
-        const CharPointerType dest (createUninitialisedBytes (numChars * sizeof (CharType) + sizeof (CharType)));
-        CharPointerType (dest).writeWithCharLimit (CharPointer_UTF8 (src), (int) (numChars + 1));
-        return dest;
+        const CharPointerType newText (allocate (dest, numBytes + 1));
+        memcpy (newText.getAddress(), start, numBytes);
+        newText.getAddress()[numBytes] = 0;
     }
 
-    static inline CharPointerType getEmpty() noexcept
+    static void createFromFixedLength (String& dest, const char* const src, const size_t numChars)
     {
-        return CharPointerType (empty.text);
+        allocate (dest, numChars * sizeof (CharType) + sizeof (CharType))
+            .writeWithCharLimit (CharPointer_UTF8 (src), (int) (numChars + 1));
     }
 
     //==============================================================================
-    static void retain (const CharPointerType& text) noexcept
+    static inline void retain (const String::Storage& storage) noexcept
     {
-        ++(bufferFromText (text)->refCount);
+        if (isHeapText (storage))
+            ++(bufferFromText (storage.heapText)->refCount);
     }
 
     static inline void release (StringHolder* const b) noexcept
     {
-        if (--(b->refCount) == -1 && b != &empty)
+        if (--(b->refCount) == -1)
             delete[] reinterpret_cast <char*> (b);
     }
 
-    static void release (const CharPointerType& text) noexcept
+    static inline void release (const String::Storage& storage) noexcept
     {
-        release (bufferFromText (text));
+        if (isHeapText (storage))
+            release (bufferFromText (storage.heapText));
     }
 
     //==============================================================================
-    static CharPointerType makeUnique (const CharPointerType& text)
+    static void makeUniqueWithByteSize (String& s, size_t numBytes)
     {
-        StringHolder* const b = bufferFromText (text);
-
-        if (b->refCount.get() <= 0)
-            return text;
-
-        CharPointerType newText (createUninitialisedBytes (b->allocatedNumBytes));
-        memcpy (newText.getAddress(), text.getAddress(), b->allocatedNumBytes);
-        release (b);
+        if (! isHeapText (s.storage))
+        {
+            if (numBytes > localTextBytes)
+            {
+                const CharPointerType newText (createUninitialisedBytes (numBytes));
+                memcpy (newText.getAddress(), s.storage.localText, localTextBytes);
+                setHeapText (s.storage, newText);
+            }
 
-        return newText;
-    }
+            return;
+        }
 
-    static CharPointerType makeUniqueWithByteSize (const CharPointerType& text, size_t numBytes)
-    {
-        StringHolder* const b = bufferFromText (text);
+        StringHolder* const b = bufferFromText (s.storage.heapText);
 
         if (b->refCount.get() <= 0 && b->allocatedNumBytes >= numBytes)
-            return text;
+            return;
 
-        CharPointerType newText (createUninitialisedBytes (jmax (b->allocatedNumBytes, numBytes)));
-        memcpy (newText.getAddress(), text.getAddress(), b->allocatedNumBytes);
+        const CharPointerType newText (createUninitialisedBytes (jmax (b->allocatedNumBytes, numBytes)));
+        memcpy (newText.getAddress(), s.storage.heapText, b->allocatedNumBytes);
         release (b);
-
-        return newText;
+        setHeapText (s.storage, newText);
     }
 
-    static size_t getAllocatedNumBytes (const CharPointerType& text) noexcept
+    static size_t getAllocatedNumBytes (const String& s) noexcept
     {
-        return bufferFromText (text)->allocatedNumBytes;
+        return isHeapText (s.storage) ? bufferFromText (s.storage.heapText)->allocatedNumBytes
+                                      : (size_t) localTextBytes;
     }
 
     //==============================================================================
@@ -208,13 +218,27 @@ public:
     size_t allocatedNumBytes;
     CharType text[1];
 
-    static StringHolder empty;
-
 private:
-    static inline StringHolder* bufferFromText (const CharPointerType& text) noexcept
+    static inline bool isHeapText (const String::Storage& storage) noexcept
+    {
+        return storage.localText [localTextBytes - 1] != 0;
+    }
+
+    static inline CharPointerType getLocalText (String::Storage& storage) noexcept
+    {
+        return CharPointerType (reinterpret_cast <CharType*> (storage.localText));
+    }
+
+    static inline void setHeapText (String::Storage& storage, const CharPointerType& text) noexcept
+    {
+        storage.heapText = text.getAddress();
+        storage.localText [localTextBytes - 1] = 1;
+    }
+
+    static inline StringHolder* bufferFromText (CharType* const text) noexcept
     {
         // (Can't use offsetof() here because of warnings about this not being a POD)
-        return reinterpret_cast <StringHolder*> (reinterpret_cast <char*> (text.getAddress())
+        return reinterpret_cast <StringHolder*> (reinterpret_cast <char*> (text)
                     - (reinterpret_cast <size_t> (reinterpret_cast <StringHolder*> (1)->text) - 1));
     }
 
@@ -230,56 +254,64 @@ private:
        #else
         #error "native wchar_t size is unknown"
        #endif
+
+        // The pointer to a heap buffer mustn't overlap the flag at the end of the local text
+        static_jassert (sizeof (CharType*) < localTextBytes);
     }
+
+    StringHolder();
+    JUCE_DECLARE_NON_COPYABLE (StringHolder)
 };
 
-StringHolder StringHolder::empty;
 const String String::empty;
 
 //==============================================================================
 void String::preallocateBytes (const size_t numBytesNeeded)
 {
-    text = StringHolder::makeUniqueWithByteSize (text, numBytesNeeded + sizeof (CharPointerType::CharType));
+    StringHolder::makeUniqueWithByteSize (*this, numBytesNeeded + sizeof (CharPointerType::CharType));
 }
 
 //==============================================================================
-String::String() noexcept  : text (StringHolder::getEmpty())
+String::String() noexcept
 {
+    StringHolder::setEmpty (storage);
 }
 
 String::~String() noexcept
 {
-    StringHolder::release (text);
+    StringHolder::release (storage);
 }
 
 String::String (const String& other) noexcept
-    : text (other.text)
+    : storage (other.storage)
 {
-    StringHolder::retain (text);
+    StringHolder::retain (storage);
 }
 
 void String::swapWith (String& other) noexcept
 {
-    std::swap (text, other.text);
+    std::swap (storage, other.storage);
 }
 
 String& String::operator= (const String& other) noexcept
 {
-    StringHolder::retain (other.text);
-    StringHolder::release (text.atomicSwap (other.text));
+    StringHolder::retain (other.storage);
+    const Storage oldStorage (storage);
+    storage = other.storage;
+    StringHolder::release (oldStorage);
     return *this;
 }
 
 #if JUCE_COMPILER_SUPPORTS_MOVE_SEMANTICS
 String::String (String&& other) noexcept
-    : text (other.text)
+    : storage (other.storage)
 {
-    other.text = StringHolder::getEmpty();
+    StringHolder::setEmpty (other.storage);
 }
 
 String& String::operator= (String&& other) noexcept
 {
-    std::swap (text, other.text);
+    std::swap (storage, other.storage);
     return *this;
 }
 #endif
@@ -287,14 +319,15 @@ String& String::operator= (String&& other) noexcept
 inline String::PreallocationBytes::PreallocationBytes (const size_t numBytes_) : numBytes (numBytes_) {}
 
 String::String (const PreallocationBytes& preallocationSize)
-    : text (StringHolder::createUninitialisedBytes (preallocationSize.numBytes + sizeof (CharPointerType::CharType)))
 {
+    StringHolder::allocate (*this, preallocationSize.numBytes + sizeof (CharPointerType::CharType));
 }
 
 //==============================================================================
 String::String (const char* const t)
-    : text (StringHolder::createFromCharPointer (CharPointer_ASCII (t)))
 {
+    StringHolder::createFromCharPointer (*this, CharPointer_ASCII (t));
+
     /*  If you get an assertion here, then you're trying to create a string from 8-bit data
         that contains values greater than 127. These can NOT be correctly converted to unicode
         because there's no way for the String class to know what encoding was used to
@@ -312,8 +345,9 @@ String::String (const char* const t)
 }
 
 String::String (const char* const t, const size_t maxChars)
-    : text (StringHolder::createFromCharPointer (CharPointer_ASCII (t), maxChars))
 {
+    StringHolder::createFromCharPointer (*this, CharPointer_ASCII (t), maxChars);
+
     /*  If you get an assertion here, then you're trying to create a string from 8-bit data
         that contains values greater than 127. These can NOT be correctly converted to unicode
         because there's no way for the String class to know what encoding was used to
@@ -330,27 +364,27 @@ String::String (const char* const t, const size_t maxChars)
     jassert (t == nullptr || CharPointer_ASCII::isValidString (t, (int) maxChars));
 }
 
-String::String (const wchar_t* const t)      : text (StringHolder::createFromCharPointer (castToCharPointer_wchar_t (t))) {}
-String::String (const CharPointer_UTF8&  t)  : text (StringHolder::createFromCharPointer (t)) {}
-String::String (const CharPointer_UTF16& t)  : text (StringHolder::createFromCharPointer (t)) {}
-String::String (const CharPointer_UTF32& t)  : text (StringHolder::createFromCharPointer (t)) {}
-String::String (const CharPointer_ASCII& t)  : text (StringHolder::createFromCharPointer (t)) {}
+String::String (const wchar_t* const t)      { StringHolder::createFromCharPointer (*this, castToCharPointer_wchar_t (t)); }
+String::String (const CharPointer_UTF8&  t)  { StringHolder::createFromCharPointer (*this, t); }
+String::String (const CharPointer_UTF16& t)  { StringHolder::createFromCharPointer (*this, t); }
+String::String (const CharPointer_UTF32& t)  { StringHolder::createFromCharPointer (*this, t); }
+String::String (const CharPointer_ASCII& t)  { StringHolder::createFromCharPointer (*this, t); }
 
-String::String (const CharPointer_UTF8&  t, const size_t maxChars)  : text (StringHolder::createFromCharPointer (t, maxChars)) {}
-String::String (const CharPointer_UTF16& t, const size_t maxChars)  : text (StringHolder::createFromCharPointer (t, maxChars)) {}
-String::String (const CharPointer_UTF32& t, const size_t maxChars)  : text (StringHolder::createFromCharPointer (t, maxChars)) {}
-String::String (const wchar_t* const t, size_t maxChars)            : text (StringHolder::createFromCharPointer (castToCharPointer_wchar_t (t), maxChars)) {}
+String::String (const CharPointer_UTF8&  t, const size_t maxChars)  { StringHolder::createFromCharPointer (*this, t, maxChars); }
+String::String (const CharPointer_UTF16& t, const size_t maxChars)  { StringHolder::createFromCharPointer (*this, t, maxChars); }
+String::String (const CharPointer_UTF32& t, const size_t maxChars)  { StringHolder::createFromCharPointer (*this, t, maxChars); }
+String::String (const wchar_t* const t, size_t maxChars)            { StringHolder::createFromCharPointer (*this, castToCharPointer_wchar_t (t), maxChars); }
 
-String::String (const CharPointer_UTF8&  start, const CharPointer_UTF8&  end) : text (StringHolder::createFromCharPointer (start, end)) {}
-String::String (const CharPointer_UTF16& start, const CharPointer_UTF16& end) : text (StringHolder::createFromCharPointer (start, end)) {}
-String::String (const CharPointer_UTF32& start, const CharPointer_UTF32& end) : text (StringHolder::createFromCharPointer (start, end)) {}
+String::String (const CharPointer_UTF8&  start, const CharPointer_UTF8&  end) { StringHolder::createFromCharPointer (*this, start, end); }
+String::String (const CharPointer_UTF16& start, const CharPointer_UTF16& end) { StringHolder::createFromCharPointer (*this, start, end); }
+String::String (const CharPointer_UTF32& start, const CharPointer_UTF32& end) { StringHolder::createFromCharPointer (*this, start, end); }
 
-String::String (const std::string& s) : text (StringHolder::createFromFixedLength (s.data(), s.size())) {}
+String::String (const std::string& s)   { StringHolder::createFromFixedLength (*this, s.data(), s.size()); }
 
 String String::charToString (const juce_wchar character)
 {
     String result (PreallocationBytes (CharPointerType::getBytesRequiredFor (character)));
-    CharPointerType t (result.text);
+    CharPointerType t (result.getCharPointer());
     t.write (character);
     t.writeNull();
     return result;
@@ -472,57 +506,57 @@ namespace NumberToStringConverters
     }
 
     template <typename IntegerType>
-    static String::CharPointerType createFromInteger (const IntegerType number)
+    static void createFromInteger (String& dest, const IntegerType number)
     {
         char buffer [32];
         char* const end = buffer + numElementsInArray (buffer);
         char* const start = numberToString (end, number);
 
-        return StringHolder::createFromFixedLength (start, (size_t) (end - start - 1));
+        StringHolder::createFromFixedLength (dest, start, (size_t) (end - start - 1));
     }
 
-    static String::CharPointerType createFromDouble (const double number, const int numberOfDecimalPlaces)
+    static void createFromDouble (String& dest, const double number, const int numberOfDecimalPlaces)
     {
         char buffer [48];
         size_t len;
         char* const start = doubleToString (buffer, numElementsInArray (buffer), (double) number, numberOfDecimalPlaces, len);
-        return StringHolder::createFromFixedLength (start, len);
+        StringHolder::createFromFixedLength (dest, start, len);
     }
 }
 
 //==============================================================================
-String::String (const int number)            : text (NumberToStringConverters::createFromInteger (number)) {}
-String::String (const unsigned int number)   : text (NumberToStringConverters::createFromInteger (number)) {}
-String::String (const short number)          : text (NumberToStringConverters::createFromInteger ((int) number)) {}
-String::String (const unsigned short number) : text (NumberToStringConverters::createFromInteger ((unsigned int) number)) {}
-String::String (const int64 number)          : text (NumberToStringConverters::createFromInteger (number)) {}
-String::String (const uint64 number)         : text (NumberToStringConverters::createFromInteger (number)) {}
-
-String::String (const float number)          : text (NumberToStringConverters::createFromDouble ((double) number, 0)) {}
-String::String (const double number)         : text (NumberToStringConverters::createFromDouble (number, 0)) {}
-String::String (const float number, const int numberOfDecimalPlaces)   : text (NumberToStringConverters::createFromDouble ((double) number, numberOfDecimalPlaces)) {}
-String::String (const double number, const int numberOfDecimalPlaces)  : text (NumberToStringConverters::createFromDouble (number, numberOfDecimalPlaces)) {}
+String::String (const int number)            { NumberToStringConverters::createFromInteger (*this, number); }
+String::String (const unsigned int number)   { NumberToStringConverters::createFromInteger (*this, number); }
+String::String (const short number)          { NumberToStringConverters::createFromInteger (*this, (int) number); }
+String::String (const unsigned short number) { NumberToStringConverters::createFromInteger (*this, (unsigned int) number); }
+String::String (const int64 number)          { NumberToStringConverters::createFromInteger (*this, number); }
+String::String (const uint64 number)         { NumberToStringConverters::createFromInteger (*this, number); }
+
+String::String (const float number)          { NumberToStringConverters::createFromDouble (*this, (double) number, 0); }
+String::String (const double number)         { NumberToStringConverters::createFromDouble (*this, number, 0); }
+String::String (const float number, const int numberOfDecimalPlaces)   { NumberToStringConverters::createFromDouble (*this, (double) number, numberOfDecimalPlaces); }
+String::String (const double number, const int numberOfDecimalPlaces)  { NumberToStringConverters::createFromDouble (*this, number, numberOfDecimalPlaces); }
 
 //==============================================================================
 int String::length() const noexcept
 {
-    return (int) text.length();
+    return (int) getCharPointer().length();
 }
 
 size_t String::getByteOffsetOfEnd() const noexcept
 {
-    return (size_t) (((char*) text.findTerminatingNull().getAddress()) - (char*) text.getAddress());
+    return (size_t) (((char*) getCharPointer().findTerminatingNull().getAddress()) - (char*) getCharPointer().getAddress());
 }
 
 juce_wchar String::operator[] (int index) const noexcept
 {
-    jassert (index == 0 || (index > 0 && index <= (int) text.lengthUpTo ((size_t) index + 1)));
-    return text [index];
+    jassert (index == 0 || (index > 0 && index <= (int) getCharPointer().lengthUpTo ((size_t) index + 1)));
+    return getCharPointer() [index];
 }
 
 int String::hashCode() const noexcept
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
     int result = 0;
 
     while (! t.isEmpty())
@@ -533,7 +567,7 @@ int String::hashCode() const noexcept
 
 int64 String::hashCode64() const noexcept
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
     int64 result = 0;
 
     while (! t.isEmpty())
@@ -562,35 +596,35 @@ JUCE_API bool JUCE_CALLTYPE operator<= (const String& s1, const String& s2) noex
 
 bool String::equalsIgnoreCase (const wchar_t* const t) const noexcept
 {
-    return t != nullptr ? text.compareIgnoreCase (castToCharPointer_wchar_t (t)) == 0
+    return t != nullptr ? getCharPointer().compareIgnoreCase (castToCharPointer_wchar_t (t)) == 0
                         : isEmpty();
 }
 
 bool String::equalsIgnoreCase (const char* const t) const noexcept
 {
-    return t != nullptr ? text.compareIgnoreCase (CharPointer_UTF8 (t)) == 0
+    return t != nullptr ? getCharPointer().compareIgnoreCase (CharPointer_UTF8 (t)) == 0
                         : isEmpty();
 }
 
 bool String::equalsIgnoreCase (const String& other) const noexcept
 {
-    return text == other.text
-            || text.compareIgnoreCase (other.text) == 0;
+    return getCharPointer() == other.getCharPointer()
+            || getCharPointer().compareIgnoreCase (other.getCharPointer()) == 0;
 }
 
-int String::compare (const String& other) const noexcept           { return (text == other.text) ? 0 : text.compare (other.text); }
-int String::compare (const char* const other) const noexcept       { return text.compare (CharPointer_UTF8 (other)); }
-int String::compare (const wchar_t* const other) const noexcept    { return text.compare (castToCharPointer_wchar_t (other)); }
-int String::compareIgnoreCase (const String& other) const noexcept { return (text == other.text) ? 0 : text.compareIgnoreCase (other.text); }
+int String::compare (const String& other) const noexcept           { return (getCharPointer() == other.getCharPointer()) ? 0 : getCharPointer().compare (other.getCharPointer()); }
+int String::compare (const char* const other) const noexcept       { return getCharPointer().compare (CharPointer_UTF8 (other)); }
+int String::compare (const wchar_t* const other) const noexcept    { return getCharPointer().compare (castToCharPointer_wchar_t (other)); }
+int String::compareIgnoreCase (const String& other) const noexcept { return (getCharPointer() == other.getCharPointer()) ? 0 : getCharPointer().compareIgnoreCase (other.getCharPointer()); }
 
 int String::compareLexicographically (const String& other) const noexcept
 {
-    CharPointerType s1 (text);
+    CharPointerType s1 (getCharPointer());
 
     while (! (s1.isEmpty() || s1.isLetterOrDigit()))
         ++s1;
 
-    CharPointerType s2 (other.text);
+    CharPointerType s2 (other.getCharPointer());
 
     while (! (s2.isEmpty() || s2.isLetterOrDigit()))
         ++s2;
@@ -601,7 +635,16 @@ int String::compareLexicographically (const String& other) const noexcept
 //==============================================================================
 void String::append (const String& textToAppend, size_t maxCharsToTake)
 {
-    appendCharPointer (textToAppend.text, maxCharsToTake);
+    if (&textToAppend == this)
+    {
+        // (a copy is needed here, because the text may be moved when this string grows)
+        const String copy (textToAppend);
+        appendCharPointer (copy.getCharPointer(), maxCharsToTake);
+    }
+    else
+    {
+        appendCharPointer (textToAppend.getCharPointer(), maxCharsToTake);
+    }
 }
 
 String& String::operator+= (const wchar_t* const t)
@@ -636,7 +679,13 @@ String& String::operator+= (const String& other)
     if (isEmpty())
         return operator= (other);
 
-    appendCharPointer (other.text);
+    if (&other == this)
+    {
+        const String copy (other);
+        return operator+= (copy);
+    }
+
+    appendCharPointer (other.getCharPointer());
     return *this;
 }
 
@@ -675,9 +724,9 @@ String& String::operator+= (const int number)
         const size_t newBytesNeeded = sizeof (CharPointerType::CharType) + byteOffsetOfNull
                                         + sizeof (CharPointerType::CharType) * (size_t) numExtraChars;
 
-        text = StringHolder::makeUniqueWithByteSize (text, newBytesNeeded);
+        StringHolder::makeUniqueWithByteSize (*this, newBytesNeeded);
 
-        CharPointerType newEnd (addBytesToPointer (text.getAddress(), (int) byteOffsetOfNull));
+        CharPointerType newEnd (addBytesToPointer (getCharPointer().getAddress(), (int) byteOffsetOfNull));
         newEnd.writeWithCharLimit (CharPointer_ASCII (start), numExtraChars);
     }
 
@@ -755,12 +804,12 @@ JUCE_API String& JUCE_CALLTYPE operator<< (String& string1, const NewLine&)
 //==============================================================================
 int String::indexOfChar (const juce_wchar character) const noexcept
 {
-    return text.indexOf (character);
+    return getCharPointer().indexOf (character);
 }
 
 int String::indexOfChar (const int startIndex, const juce_wchar character) const noexcept
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     for (int i = 0; ! t.isEmpty(); ++i)
     {
@@ -780,7 +829,7 @@ int String::indexOfChar (const int startIndex, const juce_wchar character) const
 
 int String::lastIndexOfChar (const juce_wchar character) const noexcept
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
     int last = -1;
 
     for (int i = 0; ! t.isEmpty(); ++i)
@@ -792,13 +841,13 @@ int String::lastIndexOfChar (const juce_wchar character) const noexcept
 
 int String::indexOfAnyOf (const String& charactersToLookFor, const int startIndex, const bool ignoreCase) const noexcept
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     for (int i = 0; ! t.isEmpty(); ++i)
     {
         if (i >= startIndex)
         {
-            if (charactersToLookFor.text.indexOf (t.getAndAdvance(), ignoreCase) >= 0)
+            if (charactersToLookFor.getCharPointer().indexOf (t.getAndAdvance(), ignoreCase) >= 0)
                 return i;
         }
         else
@@ -812,12 +861,12 @@ int String::indexOfAnyOf (const String& charactersToLookFor, const int startInde
 
 int String::indexOf (const String& other) const noexcept
 {
-    return other.isEmpty() ? 0 : text.indexOf (other.text);
+    return other.isEmpty() ? 0 : getCharPointer().indexOf (other.getCharPointer());
 }
 
 int String::indexOfIgnoreCase (const String& other) const noexcept
 {
-    return other.isEmpty() ? 0 : CharacterFunctions::indexOfIgnoreCase (text, other.text);
+    return other.isEmpty() ? 0 : CharacterFunctions::indexOfIgnoreCase (getCharPointer(), other.getCharPointer());
 }
 
 int String::indexOf (const int startIndex, const String& other) const noexcept
@@ -825,7 +874,7 @@ int String::indexOf (const int startIndex, const String& other) const noexcept
     if (other.isEmpty())
         return -1;
 
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     for (int i = startIndex; --i >= 0;)
     {
@@ -835,7 +884,7 @@ int String::indexOf (const int startIndex, const String& other) const noexcept
         ++t;
     }
 
-    int found = t.indexOf (other.text);
+    int found = t.indexOf (other.getCharPointer());
     if (found >= 0)
         found += startIndex;
     return found;
@@ -846,7 +895,7 @@ int String::indexOfIgnoreCase (const int startIndex, const String& other) const
     if (other.isEmpty())
         return -1;
 
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     for (int i = startIndex; --i >= 0;)
     {
@@ -856,7 +905,7 @@ int String::indexOfIgnoreCase (const int startIndex, const String& other) const
         ++t;
     }
 
-    int found = CharacterFunctions::indexOfIgnoreCase (t, other.text);
+    int found = CharacterFunctions::indexOfIgnoreCase (t, other.getCharPointer());
     if (found >= 0)
         found += startIndex;
     return found;
@@ -871,11 +920,11 @@ int String::lastIndexOf (const String& other) const noexcept
 
         if (i >= 0)
         {
-            CharPointerType n (text + i);
+            CharPointerType n (getCharPointer() + i);
 
             while (i >= 0)
             {
-                if (n.compareUpTo (other.text, len) == 0)
+                if (n.compareUpTo (other.getCharPointer(), len) == 0)
                     return i;
 
                 --n;
@@ -896,11 +945,11 @@ int String::lastIndexOfIgnoreCase (const String& other) const noexcept
 
         if (i >= 0)
         {
-            CharPointerType n (text + i);
+            CharPointerType n (getCharPointer() + i);
 
             while (i >= 0)
             {
-                if (n.compareIgnoreCaseUpTo (other.text, len) == 0)
+                if (n.compareIgnoreCaseUpTo (other.getCharPointer(), len) == 0)
                     return i;
 
                 --n;
@@ -914,11 +963,11 @@ int String::lastIndexOfIgnoreCase (const String& other) const noexcept
 
 int String::lastIndexOfAnyOf (const String& charactersToLookFor, const bool ignoreCase) const noexcept
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
     int last = -1;
 
     for (int i = 0; ! t.isEmpty(); ++i)
-        if (charactersToLookFor.text.indexOf (t.getAndAdvance(), ignoreCase) >= 0)
+        if (charactersToLookFor.getCharPointer().indexOf (t.getAndAdvance(), ignoreCase) >= 0)
             last = i;
 
     return last;
@@ -931,7 +980,7 @@ bool String::contains (const String& other) const noexcept
 
 bool String::containsChar (const juce_wchar character) const noexcept
 {
-    return text.indexOf (character) >= 0;
+    return getCharPointer().indexOf (character) >= 0;
 }
 
 bool String::containsIgnoreCase (const String& t) const noexcept
@@ -943,13 +992,13 @@ int String::indexOfWholeWord (const String& word) const noexcept
 {
     if (word.isNotEmpty())
     {
-        CharPointerType t (text);
+        CharPointerType t (getCharPointer());
         const int wordLen = word.length();
         const int end = (int) t.length() - wordLen;
 
         for (int i = 0; i <= end; ++i)
         {
-            if (t.compareUpTo (word.text, wordLen) == 0
+            if (t.compareUpTo (word.getCharPointer(), wordLen) == 0
                   && (i == 0 || ! (t - 1).isLetterOrDigit())
                   && ! (t + wordLen).isLetterOrDigit())
                 return i;
@@ -965,13 +1014,13 @@ int String::indexOfWholeWordIgnoreCase (const String& word) const noexcept
 {
     if (word.isNotEmpty())
     {
-        CharPointerType t (text);
+        CharPointerType t (getCharPointer());
         const int wordLen = word.length();
         const int end = (int) t.length() - wordLen;
 
         for (int i = 0; i <= end; ++i)
         {
-            if (t.compareIgnoreCaseUpTo (word.text, wordLen) == 0
+            if (t.compareIgnoreCaseUpTo (word.getCharPointer(), wordLen) == 0
                   && (i == 0 || ! (t - 1).isLetterOrDigit())
                   && ! (t + wordLen).isLetterOrDigit())
                 return i;
@@ -1032,7 +1081,7 @@ struct WildCardMatcher
 
 bool String::matchesWildcard (const String& wildcard, const bool ignoreCase) const noexcept
 {
-    return WildCardMatcher<CharPointerType>::matches (wildcard.text, text, ignoreCase);
+    return WildCardMatcher<CharPointerType>::matches (wildcard.getCharPointer(), getCharPointer(), ignoreCase);
 }
 
 //==============================================================================
@@ -1042,10 +1091,10 @@ String String::repeatedString (const String& stringToRepeat, int numberOfTimesTo
         return empty;
 
     String result (PreallocationBytes (stringToRepeat.getByteOffsetOfEnd() * (size_t) numberOfTimesToRepeat));
-    CharPointerType n (result.text);
+    CharPointerType n (result.getCharPointer());
 
     while (--numberOfTimesToRepeat >= 0)
-        n.writeAll (stringToRepeat.text);
+        n.writeAll (stringToRepeat.getCharPointer());
 
     return result;
 }
@@ -1055,7 +1104,7 @@ String String::paddedLeft (const juce_wchar padCharacter, int minimumLength) con
     jassert (padCharacter != 0);
 
     int extraChars = minimumLength;
-    CharPointerType end (text);
+    CharPointerType end (getCharPointer());
 
     while (! end.isEmpty())
     {
@@ -1066,14 +1115,14 @@ String String::paddedLeft (const juce_wchar padCharacter, int minimumLength) con
     if (extraChars <= 0 || padCharacter == 0)
         return *this;
 
-    const size_t currentByteSize = (size_t) (((char*) end.getAddress()) - (char*) text.getAddress());
+    const size_t currentByteSize = (size_t) (((char*) end.getAddress()) - (char*) getCharPointer().getAddress());
     String result (PreallocationBytes (currentByteSize + (size_t) extraChars * CharPointerType::getBytesRequiredFor (padCharacter)));
-    CharPointerType n (result.text);
+    CharPointerType n (result.getCharPointer());
 
     while (--extraChars >= 0)
         n.write (padCharacter);
 
-    n.writeAll (text);
+    n.writeAll (getCharPointer());
     return result;
 }
 
@@ -1082,7 +1131,7 @@ String String::paddedRight (const juce_wchar padCharacter, int minimumLength) co
     jassert (padCharacter != 0);
 
     int extraChars = minimumLength;
-    CharPointerType end (text);
+    CharPointerType end (getCharPointer());
 
     while (! end.isEmpty())
     {
@@ -1093,11 +1142,11 @@ String String::paddedRight (const juce_wchar padCharacter, int minimumLength) co
     if (extraChars <= 0 || padCharacter == 0)
         return *this;
 
-    const size_t currentByteSize = (size_t) (((char*) end.getAddress()) - (char*) text.getAddress());
+    const size_t currentByteSize = (size_t) (((char*) end.getAddress()) - (char*) getCharPointer().getAddress());
     String result (PreallocationBytes (currentByteSize + (size_t) extraChars * CharPointerType::getBytesRequiredFor (padCharacter)));
-    CharPointerType n (result.text);
+    CharPointerType n (result.getCharPointer());
 
-    n.writeAll (text);
+    n.writeAll (getCharPointer());
 
     while (--extraChars >= 0)
         n.write (padCharacter);
@@ -1124,7 +1173,7 @@ String String::replaceSection (int index, int numCharsToReplace, const String& s
     }
 
     int i = 0;
-    CharPointerType insertPoint (text);
+    CharPointerType insertPoint (getCharPointer());
 
     while (i < index)
     {
@@ -1148,10 +1197,10 @@ String String::replaceSection (int index, int numCharsToReplace, const String& s
         ++i;
     }
 
-    if (insertPoint == text && startOfRemainder.isEmpty())
+    if (insertPoint == getCharPointer() && startOfRemainder.isEmpty())
         return stringToInsert;
 
-    const size_t initialBytes = (size_t) (((char*) insertPoint.getAddress()) - (char*) text.getAddress());
+    const size_t initialBytes = (size_t) (((char*) insertPoint.getAddress()) - (char*) getCharPointer().getAddress());
     const size_t newStringBytes = stringToInsert.getByteOffsetOfEnd();
     const size_t remainderBytes = (size_t) (((char*) startOfRemainder.findTerminatingNull().getAddress()) - (char*) startOfRemainder.getAddress());
 
@@ -1161,10 +1210,10 @@ String String::replaceSection (int index, int numCharsToReplace, const String& s
 
     String result (PreallocationBytes ((size_t) newTotalBytes));
 
-    char* dest = (char*) result.text.getAddress();
-    memcpy (dest, text.getAddress(), initialBytes);
+    char* dest = (char*) result.getCharPointer().getAddress();
+    memcpy (dest, getCharPointer().getAddress(), initialBytes);
     dest += initialBytes;
-    memcpy (dest, stringToInsert.text.getAddress(), newStringBytes);
+    memcpy (dest, stringToInsert.getCharPointer().getAddress(), newStringBytes);
     dest += newStringBytes;
     memcpy (dest, startOfRemainder.getAddress(), remainderBytes);
     dest += remainderBytes;
@@ -1201,8 +1250,9 @@ public:
         dest = result.getCharPointer();
     }
 
-    StringCreationHelper (const String::CharPointerType& source_)
-        : source (source_), dest (nullptr), allocatedBytes (StringHolder::getAllocatedNumBytes (source)), bytesWritten (0)
+    StringCreationHelper (const String& sourceString)
+        : source (sourceString.getCharPointer()), dest (nullptr),
+          allocatedBytes (StringHolder::getAllocatedNumBytes (sourceString)), bytesWritten (0)
     {
         result.preallocateBytes (allocatedBytes);
         dest = result.getCharPointer();
@@ -1236,7 +1286,7 @@ String String::replaceCharacter (const juce_wchar charToReplace, const juce_wcha
     if (! containsChar (charToReplace))
         return *this;
 
-    StringCreationHelper builder (text);
+    StringCreationHelper builder (*this);
 
     for (;;)
     {
@@ -1256,7 +1306,7 @@ String String::replaceCharacter (const juce_wchar charToReplace, const juce_wcha
 
 String String::replaceCharacters (const String& charactersToReplace, const String& charactersToInsertInstead) const
 {
-    StringCreationHelper builder (text);
+    StringCreationHelper builder (*this);
 
     for (;;)
     {
@@ -1278,38 +1328,38 @@ String String::replaceCharacters (const String& charactersToReplace, const Strin
 //==============================================================================
 bool String::startsWith (const String& other) const noexcept
 {
-    return text.compareUpTo (other.text, other.length()) == 0;
+    return getCharPointer().compareUpTo (other.getCharPointer(), other.length()) == 0;
 }
 
 bool String::startsWithIgnoreCase (const String& other) const noexcept
 {
-    return text.compareIgnoreCaseUpTo (other.text, other.length()) == 0;
+    return getCharPointer().compareIgnoreCaseUpTo (other.getCharPointer(), other.length()) == 0;
 }
 
 bool String::startsWithChar (const juce_wchar character) const noexcept
 {
     jassert (character != 0); // strings can't contain a null character!
 
-    return *text == character;
+    return *getCharPointer() == character;
 }
 
 bool String::endsWithChar (const juce_wchar character) const noexcept
 {
     jassert (character != 0); // strings can't contain a null character!
 
-    if (text.isEmpty())
+    if (getCharPointer().isEmpty())
         return false;
 
-    CharPointerType t (text.findTerminatingNull());
+    CharPointerType t (getCharPointer().findTerminatingNull());
     return *--t == character;
 }
 
 bool String::endsWith (const String& other) const noexcept
 {
-    CharPointerType end (text.findTerminatingNull());
-    CharPointerType otherEnd (other.text.findTerminatingNull());
+    CharPointerType end (getCharPointer().findTerminatingNull());
+    CharPointerType otherEnd (other.getCharPointer().findTerminatingNull());
 
-    while (end > text && otherEnd > other.text)
+    while (end > getCharPointer() && otherEnd > other.getCharPointer())
     {
         --end;
         --otherEnd;
@@ -1318,15 +1368,15 @@ bool String::endsWith (const String& other) const noexcept
             return false;
     }
 
-    return otherEnd == other.text;
+    return otherEnd == other.getCharPointer();
 }
 
 bool String::endsWithIgnoreCase (const String& other) const noexcept
 {
-    CharPointerType end (text.findTerminatingNull());
-    CharPointerType otherEnd (other.text.findTerminatingNull());
+    CharPointerType end (getCharPointer().findTerminatingNull());
+    CharPointerType otherEnd (other.getCharPointer().findTerminatingNull());
 
-    while (end > text && otherEnd > other.text)
+    while (end > getCharPointer() && otherEnd > other.getCharPointer())
     {
         --end;
         --otherEnd;
@@ -1335,13 +1385,13 @@ bool String::endsWithIgnoreCase (const String& other) const noexcept
             return false;
     }
 
-    return otherEnd == other.text;
+    return otherEnd == other.getCharPointer();
 }
 
 //==============================================================================
 String String::toUpperCase() const
 {
-    StringCreationHelper builder (text);
+    StringCreationHelper builder (*this);
 
     for (;;)
     {
@@ -1358,7 +1408,7 @@ String String::toUpperCase() const
 
 String String::toLowerCase() const
 {
-    StringCreationHelper builder (text);
+    StringCreationHelper builder (*this);
 
     for (;;)
     {
@@ -1376,7 +1426,7 @@ String String::toLowerCase() const
 //==============================================================================
 juce_wchar String::getLastCharacter() const noexcept
 {
-    return isEmpty() ? juce_wchar() : text [length() - 1];
+    return isEmpty() ? juce_wchar() : getCharPointer() [length() - 1];
 }
 
 String String::substring (int start, const int end) const
@@ -1388,7 +1438,7 @@ String String::substring (int start, const int end) const
         return empty;
 
     int i = 0;
-    CharPointerType t1 (text);
+    CharPointerType t1 (getCharPointer());
 
     while (i < start)
     {
@@ -1422,7 +1472,7 @@ String String::substring (int start) const
     if (start <= 0)
         return *this;
 
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     while (--start >= 0)
     {
@@ -1437,12 +1487,12 @@ String String::substring (int start) const
 
 String String::dropLastCharacters (const int numberToDrop) const
 {
-    return String (text, (size_t) jmax (0, length() - numberToDrop));
+    return String (getCharPointer(), (size_t) jmax (0, length() - numberToDrop));
 }
 
 String String::getLastCharacters (const int numCharacters) const
 {
-    return String (text + jmax (0, length() - jmax (0, numCharacters)));
+    return String (getCharPointer() + jmax (0, length() - jmax (0, numCharacters)));
 }
 
 String String::fromFirstOccurrenceOf (const String& sub,
@@ -1508,8 +1558,8 @@ String String::unquoted() const
     if (len == 0)
         return empty;
 
-    const juce_wchar lastChar = text [len - 1];
-    const int dropAtStart = (*text == '"' || *text == '\'') ? 1 : 0;
+    const juce_wchar lastChar = getCharPointer() [len - 1];
+    const int dropAtStart = (*getCharPointer() == '"' || *getCharPointer() == '\'') ? 1 : 0;
     const int dropAtEnd = (lastChar == '"' || lastChar == '\'') ? 1 : 0;
 
     return substring (dropAtStart, len - dropAtEnd);
@@ -1550,7 +1600,7 @@ String String::trim() const
 {
     if (isNotEmpty())
     {
-        CharPointerType start (text.findEndOfWhitespace());
+        CharPointerType start (getCharPointer().findEndOfWhitespace());
 
         const CharPointerType end (start.findTerminatingNull());
         CharPointerType trimmedEnd (findTrimmedEnd (start, end));
@@ -1558,7 +1608,7 @@ String String::trim() const
         if (trimmedEnd <= start)
             return empty;
 
-        if (text < start || trimmedEnd < end)
+        if (getCharPointer() < start || trimmedEnd < end)
             return String (start, trimmedEnd);
     }
 
@@ -1569,9 +1619,9 @@ String String::trimStart() const
 {
     if (isNotEmpty())
     {
-        const CharPointerType t (text.findEndOfWhitespace());
+        const CharPointerType t (getCharPointer().findEndOfWhitespace());
 
-        if (t != text)
+        if (t != getCharPointer())
             return String (t);
     }
 
@@ -1582,11 +1632,11 @@ String String::trimEnd() const
 {
     if (isNotEmpty())
     {
-        const CharPointerType end (text.findTerminatingNull());
-        CharPointerType trimmedEnd (findTrimmedEnd (text, end));
+        const CharPointerType end (getCharPointer().findTerminatingNull());
+        CharPointerType trimmedEnd (findTrimmedEnd (getCharPointer(), end));
 
         if (trimmedEnd < end)
-            return String (text, trimmedEnd);
+            return String (getCharPointer(), trimmedEnd);
     }
 
     return *this;
@@ -1594,22 +1644,22 @@ String String::trimEnd() const
 
 String String::trimCharactersAtStart (const String& charactersToTrim) const
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     while (charactersToTrim.containsChar (*t))
         ++t;
 
-    return t == text ? *this : String (t);
+    return t == getCharPointer() ? *this : String (t);
 }
 
 String String::trimCharactersAtEnd (const String& charactersToTrim) const
 {
     if (isNotEmpty())
     {
-        const CharPointerType end (text.findTerminatingNull());
+        const CharPointerType end (getCharPointer().findTerminatingNull());
         CharPointerType trimmedEnd (end);
 
-        while (trimmedEnd > text)
+        while (trimmedEnd > getCharPointer())
         {
             if (! charactersToTrim.containsChar (*--trimmedEnd))
             {
@@ -1619,7 +1669,7 @@ String String::trimCharactersAtEnd (const String& charactersToTrim) const
         }
 
         if (trimmedEnd < end)
-            return String (text, trimmedEnd);
+            return String (getCharPointer(), trimmedEnd);
     }
 
     return *this;
@@ -1631,7 +1681,7 @@ String String::retainCharacters (const String& charactersToRetain) const
     if (isEmpty())
         return empty;
 
-    StringCreationHelper builder (text);
+    StringCreationHelper builder (*this);
 
     for (;;)
     {
@@ -1653,7 +1703,7 @@ String String::removeCharacters (const String& charactersToRemove) const
     if (isEmpty())
         return empty;
 
-    StringCreationHelper builder (text);
+    StringCreationHelper builder (*this);
 
     for (;;)
     {
@@ -1671,12 +1721,12 @@ String String::removeCharacters (const String& charactersToRemove) const
 
 String String::initialSectionContainingOnly (const String& permittedCharacters) const
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     while (! t.isEmpty())
     {
         if (! permittedCharacters.containsChar (*t))
-            return String (text, t);
+            return String (getCharPointer(), t);
 
         ++t;
     }
@@ -1686,12 +1736,12 @@ String String::initialSectionContainingOnly (const String& permittedCharacters)
 
 String String::initialSectionNotContaining (const String& charactersToStopAt) const
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     while (! t.isEmpty())
     {
         if (charactersToStopAt.containsChar (*t))
-            return String (text, t);
+            return String (getCharPointer(), t);
 
         ++t;
     }
@@ -1701,7 +1751,7 @@ String String::initialSectionNotContaining (const String& charactersToStopAt) co
 
 bool String::containsOnly (const String& chars) const noexcept
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     while (! t.isEmpty())
         if (! chars.containsChar (t.getAndAdvance()))
@@ -1712,7 +1762,7 @@ bool String::containsOnly (const String& chars) const noexcept
 
 bool String::containsAnyOf (const String& chars) const noexcept
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     while (! t.isEmpty())
         if (chars.containsChar (t.getAndAdvance()))
@@ -1723,7 +1773,7 @@ bool String::containsAnyOf (const String& chars) const noexcept
 
 bool String::containsNonWhitespaceChars() const noexcept
 {
-    CharPointerType t (text);
+    CharPointerType t (getCharPointer());
 
     while (! t.isEmpty())
     {
@@ -1774,16 +1824,16 @@ String String::formatted (const String pf, ... )
 //==============================================================================
 int String::getIntValue() const noexcept
 {
-    return text.getIntValue32();
+    return getCharPointer().getIntValue32();
 }
 
 int String::getTrailingIntValue() const noexcept
 {
     int n = 0;
     int mult = 1;
-    CharPointerType t (text.findTerminatingNull());
+    CharPointerType t (getCharPointer().findTerminatingNull());
 
-    while (--t >= text)
+    while (--t >= getCharPointer())
     {
         if (! t.isDigit())
         {
@@ -1802,7 +1852,7 @@ int String::getTrailingIntValue() const noexcept
 
 int64 String::getLargeIntValue() const noexcept
 {
-    return text.getIntValue64();
+    return getCharPointer().getIntValue64();
 }
 
 float String::getFloatValue() const noexcept
@@ -1812,7 +1862,7 @@ float String::getFloatValue() const noexcept
 
 double String::getDoubleValue() const noexcept
 {
-    return text.getDoubleValue();
+    return getCharPointer().getDoubleValue();
 }
 
 static const char hexDigits[] = "0123456789abcdef";
@@ -1880,7 +1930,7 @@ String String::toHexString (const void* const d, const int size, const int group
     String s (PreallocationBytes (sizeof (CharPointerType::CharType) * (size_t) numChars));
 
     const unsigned char* data = static_cast <const unsigned char*> (d);
-    CharPointerType dest (s.text);
+    CharPointerType dest (s.getCharPointer());
 
     for (int i = 0; i < size; ++i)
     {
@@ -1896,8 +1946,8 @@ String String::toHexString (const void* const d, const int size, const int group
     return s;
 }
 
-int   String::getHexValue32() const noexcept    { return HexConverter<int>  ::stringToHex (text); }
-int64 String::getHexValue64() const noexcept    { return HexConverter<int64>::stringToHex (text); }
+int   String::getHexValue32() const noexcept    { return HexConverter<int>  ::stringToHex (getCharPointer()); }
+int64 String::getHexValue64() const noexcept    { return HexConverter<int64>::stringToHex (getCharPointer()); }
 
 //==============================================================================
 String String::createStringFromData (const void* const data_, const int size)
@@ -1967,7 +2017,10 @@ struct StringEncodingConverter
         const size_t extraBytesNeeded = CharPointerType_Dest::getBytesRequiredFor (text);
         const size_t endOffset = (text.sizeInBytes() + 3) & ~3u; // the new string must be word-aligned or many Windows
                                                                 // functions will fail to read it correctly!
-        source.preallocateBytes (endOffset + extraBytesNeeded);
+
+        // (The converted text is always put on the heap, because writing it after the end of a
+        // short string that's stored inside the String object would corrupt its storage)
+        source.preallocateBytes (jmax (endOffset + extraBytesNeeded, (size_t) StringHolder::localTextBytes));
         text = source.getCharPointer();
 
         void* const newSpace = addBytesToPointer (text.getAddress(), (int) endOffset);
@@ -2037,23 +2090,23 @@ struct StringCopier
 
 size_t String::copyToUTF8 (CharPointer_UTF8::CharType* const buffer, size_t maxBufferSizeBytes) const noexcept
 {
-    return StringCopier <CharPointerType, CharPointer_UTF8>::copyToBuffer (text, buffer, maxBufferSizeBytes);
+    return StringCopier <CharPointerType, CharPointer_UTF8>::copyToBuffer (getCharPointer(), buffer, maxBufferSizeBytes);
 }
 
 size_t String::copyToUTF16 (CharPointer_UTF16::CharType* const buffer, size_t maxBufferSizeBytes) const noexcept
 {
-    return StringCopier <CharPointerType, CharPointer_UTF16>::copyToBuffer (text, buffer, maxBufferSizeBytes);
+    return StringCopier <CharPointerType, CharPointer_UTF16>::copyToBuffer (getCharPointer(), buffer, maxBufferSizeBytes);
 }
 
 size_t String::copyToUTF32 (CharPointer_UTF32::CharType* const buffer, size_t maxBufferSizeBytes) const noexcept
 {
-    return StringCopier <CharPointerType, CharPointer_UTF32>::copyToBuffer (text, buffer, maxBufferSizeBytes);
+    return StringCopier <CharPointerType, CharPointer_UTF32>::copyToBuffer (getCharPointer(), buffer, maxBufferSizeBytes);
 }
 
 //==============================================================================
 size_t String::getNumBytesAsUTF8() const noexcept
 {
-    return CharPointer_UTF8::getBytesRequiredFor (text);
+    return CharPointer_UTF8::getBytesRequiredFor (getCharPointer());
 }
 
 String String::fromUTF8 (const char* const buffer, int bufferSizeBytes)
@@ -2371,6 +2424,59 @@ public:
             TestUTFConversion <CharPointer_UTF16>::test (*this);
         }
 
+        {
+            beginTest ("Short and long strings");
+
+            String s, expected;
+
+            for (int i = 0; i < 40; ++i)
+            {
+                const String before (s);
+                s += (juce_wchar) ('a' + i % 26);
+                expected = String::repeatedString ("x", i + 1);
+
+                expectEquals (s.length(), i + 1);
+                expectEquals (before.length(), i);
+                expect (s.startsWith (before));
+                expectEquals (s.replaceCharacters ("abcdefghijklmnopqrstuvwxyz", "xxxxxxxxxxxxxxxxxxxxxxxxxx"), expected);
+                expectEquals (String (s.toUTF16()), s);
+                expectEquals (String (s.toUTF32()), s);
+            }
+
+            String longString ("a string which is too long to be stored locally");
+            String copy (longString);
+            expect (copy.getCharPointer().getAddress() == longString.getCharPointer().getAddress());
+            copy += "!";
+            expect (copy.getCharPointer().getAddress() != longString.getCharPointer().getAddress());
+            expect (! longString.endsWithChar ('!'));
+
+            String shortString ("short");
+            shortString.swapWith (longString);
+            expectEquals (shortString, String ("a string which is too long to be stored locally"));
+            expectEquals (longString, String ("short"));
+            longString = shortString;
+            shortString = "tiny";
+            expectEquals (longString, copy.dropLastCharacters (1));
+
+            String selfAppend ("abcdefgh");
+            selfAppend += selfAppend;
+            selfAppend.append (selfAppend, 3);
+            expectEquals (selfAppend, String ("abcdefghabcdefghabc"));
+
+            String multiByte (CharPointer_UTF8 ("\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac"));
+            expectEquals (multiByte.length(), 5);
+            multiByte += multiByte;
+            expectEquals (multiByte.length(), 10);
+
+            StringArray array;
+            for (int i = 0; i < 100; ++i)
+                array.add (String (99 - i).paddedLeft ('0', 2));
+
+            array.sort (false);
+            expectEquals (array[0], String ("00"));
+            expectEquals (array[99], String ("99"));
+        }
+
         {
             beginTest ("StringArray");
 
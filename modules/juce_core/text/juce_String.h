@@ -53,9 +53,9 @@ class OutputStream;
 /**
     The JUCE String class!
 
-    Using a reference-counted internal representation, these strings are fast
-    and efficient, and there are methods to do just about any operation you'll ever
-    dream of.
+    Short strings are stored directly inside the String object, and longer ones use a
+    reference-counted internal representation, so these strings are fast and efficient,
+    and there are methods to do just about any operation you'll ever dream of.
 
     @see StringArray, StringPairArray
 */
@@ -260,7 +260,7 @@ public:
                 const size_t byteOffsetOfNull = getByteOffsetOfEnd();
 
                 preallocateBytes (byteOffsetOfNull + extraBytesNeeded);
-                CharPointerType (addBytesToPointer (text.getAddress(), (int) byteOffsetOfNull)).writeWithCharLimit (textToAppend, (int) (numChars + 1));
+                CharPointerType (addBytesToPointer (getCharPointer().getAddress(), (int) byteOffsetOfNull)).writeWithCharLimit (textToAppend, (int) (numChars + 1));
             }
         }
     }
@@ -281,7 +281,7 @@ public:
                 const size_t byteOffsetOfNull = getByteOffsetOfEnd();
 
                 preallocateBytes (byteOffsetOfNull + extraBytesNeeded);
-                CharPointerType (addBytesToPointer (text.getAddress(), (int) byteOffsetOfNull)).writeAll (textToAppend);
+                CharPointerType (addBytesToPointer (getCharPointer().getAddress(), (int) byteOffsetOfNull)).writeAll (textToAppend);
             }
         }
     }
@@ -293,13 +293,13 @@ public:
         Note that there's also an isNotEmpty() method to help write readable code.
         @see containsNonWhitespaceChars()
     */
-    inline bool isEmpty() const noexcept                    { return text[0] == 0; }
+    inline bool isEmpty() const noexcept                    { return getCharPointer().isEmpty(); }
 
     /** Returns true if the string contains at least one character.
         Note that there's also an isEmpty() method to help write readable code.
         @see containsNonWhitespaceChars()
     */
-    inline bool isNotEmpty() const noexcept                 { return text[0] != 0; }
+    inline bool isNotEmpty() const noexcept                 { return ! getCharPointer().isEmpty(); }
 
     /** Case-insensitive comparison with another string. */
     bool equalsIgnoreCase (const String& other) const noexcept;
@@ -1036,14 +1036,35 @@ public:
         Because it returns a reference to the string's internal data, the pointer
         that is returned must not be stored anywhere, as it can be deleted whenever the
         string changes.
+
+        Short strings are kept inside the String object itself, so the pointer also
+        becomes invalid when that particular String object is deleted, or moved by an
+        Array or StringArray that reallocates its storage, even if other copies of it
+        still exist. In particular, a pointer taken from a temporary String is only
+        valid until the end of the statement:
+
+        @code
+        const char* p = getName().toRawUTF8();  // dangling as soon as the temporary has gone!
+        doSomething (p);
+
+        const String name (getName());          // OK: keep the String alive for as long
+        doSomething (name.toRawUTF8());         // as the pointer is needed
+        @endcode
+
+        The same applies to the pointers returned by toUTF8(), toRawUTF8(), toUTF16(),
+        toUTF32() and toWideCharPointer().
     */
-    inline const CharPointerType& getCharPointer() const noexcept    { return text; }
+    inline CharPointerType getCharPointer() const noexcept
+    {
+        return CharPointerType (isUsingLocalText() ? reinterpret_cast <const CharPointerType::CharType*> (storage.localText)
+                                                   : storage.heapText);
+    }
 
     /** Returns a pointer to a UTF-8 version of this string.
 
         Because it returns a reference to the string's internal data, the pointer
         that is returned must not be stored anywhere, as it can be deleted whenever the
-        string changes.
+        string changes, or when this String object is deleted - see getCharPointer().
 
         To find out how many bytes you need to store this string as UTF-8, you can call
         CharPointer_UTF8::getBytesRequiredFor (myString.getCharPointer())
@@ -1056,7 +1077,7 @@ public:
 
         Because it returns a reference to the string's internal data, the pointer
         that is returned must not be stored anywhere, as it can be deleted whenever the
-        string changes.
+        string changes, or when this String object is deleted - see getCharPointer().
 
         To find out how many bytes you need to store this string as UTF-8, you can call
         CharPointer_UTF8::getBytesRequiredFor (myString.getCharPointer())
@@ -1069,7 +1090,7 @@ public:
 
         Because it returns a reference to the string's internal data, the pointer
         that is returned must not be stored anywhere, as it can be deleted whenever the
-        string changes.
+        string changes, or when this String object is deleted - see getCharPointer().
 
         To find out how many bytes you need to store this string as UTF-16, you can call
         CharPointer_UTF16::getBytesRequiredFor (myString.getCharPointer())
@@ -1082,7 +1103,7 @@ public:
 
         Because it returns a reference to the string's internal data, the pointer
         that is returned must not be stored anywhere, as it can be deleted whenever the
-        string changes.
+        string changes, or when this String object is deleted - see getCharPointer().
 
         @see getCharPointer, toUTF8, toUTF16
     */
@@ -1092,7 +1113,7 @@ public:
 
         Because it returns a reference to the string's internal data, the pointer
         that is returned must not be stored anywhere, as it can be deleted whenever the
-        string changes.
+        string changes, or when this String object is deleted - see getCharPointer().
 
         Bear in mind that the wchar_t type is different on different platforms, so on
         Windows, this will be equivalent to calling toUTF16(), on unix it'll be the same
@@ -1209,7 +1230,23 @@ public:
 
 private:
     //==============================================================================
-    CharPointerType text;
+    /*  Strings that fit into localTextBytes (including their terminator) are stored
+        inside the object. Otherwise, heapText points to a shared, reference-counted
+        buffer, and the last byte of localText is set to a non-zero value to show this.
+    */
+    enum { localTextBytes = 16 };
+
+    union Storage
+    {
+        CharPointerType::CharType* heapText;
+        char localText [localTextBytes];
+    };
+
+    Storage storage;
+
+    friend class StringHolder;
+
+    inline bool isUsingLocalText() const noexcept   { return storage.localText [localTextBytes - 1] == 0; }
 
     //==============================================================================
     struct PreallocationBytes
@@ -23,65 +23,218 @@
   ==============================================================================
 */
 
-StringPool::StringPool() noexcept   {}
-StringPool::~StringPool()           {}
+//==============================================================================
+/*  Each shard is an open-addressed hash table of pointers to entries, with the entries
+    themselves allocated from an arena that is only freed when the pool is deleted.
 
-namespace StringPoolHelpers
+    Entries never move or change once they've been added, and a new entry is completely
+    written before the pointer to it is published, so readers can search a table without
+    taking the lock. When a table needs to grow, a new one is built and published, but the
+    old one is kept alive until the pool is deleted, because a reader may still be looking
+    at it. A reader that fails to find a string (possibly because it was searching an
+    out-of-date table) falls back to searching again under the lock before adding it.
+*/
+class StringPool::Shard
 {
-    template <class StringType>
-    String::CharPointerType getPooledStringFromArray (Array<String>& strings,
-                                                      StringType newString,
-                                                      const CriticalSection& lock)
+public:
+    Shard()
+        : table (nullptr), numEntries (0), arenaPosition (nullptr), arenaSpaceLeft (0)
+    {
+        table = createTable (64);
+    }
+
+    struct Entry
     {
-        const ScopedLock sl (lock);
-        int start = 0;
-        int end = strings.size();
+        uint32 hash;
 
-        for (;;)
+        String::CharPointerType getText() noexcept
         {
-            if (start >= end)
-            {
-                jassert (start <= end);
-                strings.insert (start, newString);
-                return strings.getReference (start).getCharPointer();
-            }
-            else
-            {
-                const String& startString = strings.getReference (start);
+            return String::CharPointerType (reinterpret_cast <String::CharPointerType::CharType*> (this + 1));
+        }
+    };
 
-                if (startString == newString)
-                    return startString.getCharPointer();
+    template <class CharPointer>
+    Entry* find (const uint32 hash, const CharPointer text) const noexcept
+    {
+        const Table* const t = table;
+        const int mask = t->size - 1;
 
-                const int halfway = (start + end) >> 1;
+        for (int i = (int) (hash >> 4) & mask;; i = (i + 1) & mask)
+        {
+            Entry* const e = t->getSlot (i);
 
-                if (halfway == start)
-                {
-                    if (startString.compare (newString) < 0)
-                        ++start;
+            if (e == nullptr)
+                return nullptr;
 
-                    strings.insert (start, newString);
-                    return strings.getReference (start).getCharPointer();
-                }
+            if (e->hash == hash && e->getText().compare (text) == 0)
+                return e;
+        }
+    }
 
-                const int comp = strings.getReference (halfway).compare (newString);
+    template <class CharPointer>
+    Entry* add (const uint32 hash, const CharPointer text)
+    {
+        // must be called with the lock held!
+        const size_t textBytes = String::CharPointerType::getBytesRequiredFor (text)
+                                   + sizeof (String::CharPointerType::CharType);
 
-                if (comp == 0)
-                    return strings.getReference (halfway).getCharPointer();
-                else if (comp < 0)
-                    start = halfway;
-                else
-                    end = halfway;
-            }
+        Entry* const e = static_cast <Entry*> (allocate (sizeof (Entry) + textBytes));
+        e->hash = hash;
+        e->getText().writeAll (text);
+
+        if ((numEntries + 1) * 2 > table->size)
+            growTable();
+
+        entries.add (e);
+        ++numEntries;
+        insert (*table, e, true);
+        return e;
+    }
+
+    CriticalSection lock;
+    Array<Entry*> entries;
+
+private:
+    struct Table
+    {
+        // the slots are read without a lock, so must always be accessed through a volatile pointer
+        Entry* getSlot (const int i) const noexcept             { Entry* const volatile* s = slots; return s[i]; }
+        void setSlot (const int i, Entry* const e) noexcept     { Entry* volatile* s = slots; s[i] = e; }
+
+        int size;
+        HeapBlock<Entry*> slots;
+    };
+
+    Table* volatile table;
+    OwnedArray<Table> tables;
+    int numEntries;
+
+    struct ArenaBlock
+    {
+        ArenaBlock (const size_t size) : data (size) {}
+        HeapBlock<char> data;
+    };
+
+    OwnedArray<ArenaBlock> arenaBlocks;
+    char* arenaPosition;
+    size_t arenaSpaceLeft;
+
+    enum { arenaBlockSize = 8192 };
+
+    Table* createTable (const int size)
+    {
+        Table* const t = new Table();
+        t->size = size;
+        t->slots.calloc ((size_t) size);
+        tables.add (t);
+        return t;
+    }
+
+    static void insert (Table& t, Entry* const e, const bool needsBarrier) noexcept
+    {
+        const int mask = t.size - 1;
+        int i = (int) (e->hash >> 4) & mask;
+
+        while (t.getSlot (i) != nullptr)
+            i = (i + 1) & mask;
+
+        // make sure the entry's contents are visible to other threads before the pointer is..
+        if (needsBarrier)
+            Atomic<int>::memoryBarrier();
+
+        t.setSlot (i, e);
+    }
+
+    void growTable()
+    {
+        Table* const newTable = createTable (table->size * 2);
+
+        for (int i = 0; i < entries.size(); ++i)
+            insert (*newTable, entries.getUnchecked(i), false);
+
+        Atomic<int>::memoryBarrier();
+        table = newTable;
+    }
+
+    void* allocate (size_t numBytes)
+    {
+        numBytes = (numBytes + 7) & ~(size_t) 7;
+
+        if (numBytes > arenaSpaceLeft)
+        {
+            const size_t blockSize = jmax ((size_t) arenaBlockSize, numBytes);
+            ArenaBlock* const block = new ArenaBlock (blockSize);
+            arenaBlocks.add (block);
+            arenaPosition = block->data;
+            arenaSpaceLeft = blockSize;
         }
+
+        void* const result = arenaPosition;
+        arenaPosition += numBytes;
+        arenaSpaceLeft -= numBytes;
+        return result;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Shard)
+};
+
+//==============================================================================
+StringPool::StringPool()
+{
+    for (int i = 0; i < numShards; ++i)
+        shards.add (new Shard());
+}
+
+StringPool::~StringPool() {}
+
+namespace StringPoolHelpers
+{
+    // The hash must be the same for a given string whatever encoding it's passed in,
+    // so it works on the unicode characters rather than the raw data.
+    template <class CharPointer>
+    uint32 calculateHash (CharPointer text) noexcept
+    {
+        uint32 hash = 0;
+
+        while (! text.isEmpty())
+            hash = hash * 31 + (uint32) text.getAndAdvance();
+
+        // the low bits pick the shard, and the rest pick the slot, so mix them up a bit..
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6b;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35;
+        hash ^= hash >> 16;
+        return hash;
     }
 }
 
+template <class CharPointer>
+String::CharPointerType StringPool::getPooledStringFor (const CharPointer text)
+{
+    const uint32 hash = StringPoolHelpers::calculateHash (text);
+    Shard& shard = *shards.getUnchecked ((int) (hash & (numShards - 1)));
+
+    Shard::Entry* e = shard.find (hash, text);
+
+    if (e == nullptr)
+    {
+        const ScopedLock sl (shard.lock);
+        e = shard.find (hash, text);
+
+        if (e == nullptr)
+            e = shard.add (hash, text);
+    }
+
+    return e->getText();
+}
+
 String::CharPointerType StringPool::getPooledString (const String& s)
 {
     if (s.isEmpty())
         return String::empty.getCharPointer();
 
-    return StringPoolHelpers::getPooledStringFromArray (strings, s, lock);
+    return getPooledStringFor (s.getCharPointer());
 }
 
 String::CharPointerType StringPool::getPooledString (const char* const s)
@@ -89,7 +242,7 @@ String::CharPointerType StringPool::getPooledString (const char* const s)
     if (s == nullptr || *s == 0)
         return String::empty.getCharPointer();
 
-    return StringPoolHelpers::getPooledStringFromArray (strings, s, lock);
+    return getPooledStringFor (CharPointer_UTF8 (s));
 }
 
 String::CharPointerType StringPool::getPooledString (const wchar_t* const s)
@@ -97,15 +250,140 @@ String::CharPointerType StringPool::getPooledString (const wchar_t* const s)
     if (s == nullptr || *s == 0)
         return String::empty.getCharPointer();
 
-    return StringPoolHelpers::getPooledStringFromArray (strings, s, lock);
+    return getPooledStringFor (CharPointer_wchar_t (s));
 }
 
 int StringPool::size() const noexcept
 {
-    return strings.size();
+    int total = 0;
+
+    for (int i = 0; i < numShards; ++i)
+    {
+        const Shard& shard = *shards.getUnchecked(i);
+        const ScopedLock sl (shard.lock);
+        total += shard.entries.size();
+    }
+
+    return total;
 }
 
-String::CharPointerType StringPool::operator[] (const int index) const noexcept
+String::CharPointerType StringPool::operator[] (int index) const noexcept
 {
-    return strings [index].getCharPointer();
+    if (index >= 0)
+    {
+        for (int i = 0; i < numShards; ++i)
+        {
+            Shard& shard = *shards.getUnchecked(i);
+            const ScopedLock sl (shard.lock);
+
+            if (index < shard.entries.size())
+                return shard.entries.getUnchecked (index)->getText();
+
+            index -= shard.entries.size();
+        }
+    }
+
+    return String::empty.getCharPointer();
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class StringPoolTests  : public UnitTest
+{
+public:
+    StringPoolTests() : UnitTest ("StringPool") {}
+
+    void runTest()
+    {
+        beginTest ("Basics");
+
+        StringPool pool;
+        expect (pool.getPooledString ("") == String::empty.getCharPointer());
+        expect (pool.getPooledString (String::empty) == String::empty.getCharPointer());
+
+        const String::CharPointerType abc (pool.getPooledString ("abc"));
+        expect (String (abc) == "abc");
+        expect (pool.getPooledString (String ("ab") + "c") == abc);
+        expect (pool.getPooledString (L"abc") == abc);
+        expect (pool.getPooledString ("abd") != abc);
+
+        const String unicode (CharPointer_UTF8 ("\xe2\x88\x9a\xc3\xa9x"));
+        expect (String (pool.getPooledString (unicode)) == unicode);
+        expect (pool.getPooledString (unicode.toWideCharPointer()) == pool.getPooledString (unicode));
+
+        // enough strings to make the tables grow a few times..
+        Array<String::CharPointerType> pooled;
+
+        for (int i = 0; i < 5000; ++i)
+            pooled.add (pool.getPooledString ("item" + String (i)));
+
+        for (int i = 0; i < 5000; ++i)
+            expect (pool.getPooledString ("item" + String (i)) == pooled.getUnchecked(i));
+
+        expectEquals (pool.size(), 5000 + 3);
+
+        int numFound = 0;
+        for (int i = 0; i < pool.size(); ++i)
+            if (pooled.contains (pool[i]))
+                ++numFound;
+
+        expectEquals (numFound, 5000);
+
+        beginTest ("Concurrent access");
+
+        StringPool sharedPool;
+        OwnedArray<PoolThread> threads;
+
+        for (int i = 0; i < 8; ++i)
+            threads.add (new PoolThread (sharedPool, i));
+
+        const uint32 startTime = Time::getMillisecondCounter();
+
+        for (int i = 0; i < threads.size(); ++i)
+            threads.getUnchecked(i)->startThread();
+
+        for (int i = 0; i < threads.size(); ++i)
+            threads.getUnchecked(i)->waitForThreadToExit (-1);
+
+        logMessage ("8 threads, " + String (8 * PoolThread::numLookups) + " lookups: "
+                      + String (Time::getMillisecondCounter() - startTime) + "ms");
+
+        expectEquals (sharedPool.size(), (int) PoolThread::numNames);
+
+        // every thread must have been given exactly the same pointers..
+        for (int i = 1; i < threads.size(); ++i)
+            expect (threads.getUnchecked(i)->results == threads.getUnchecked(0)->results);
+    }
+
+private:
+    struct PoolThread  : public Thread
+    {
+        PoolThread (StringPool& p, int seed_) : Thread ("StringPool test"), pool (p), seed (seed_) {}
+
+        enum { numNames = 2000, numLookups = 200000 };
+
+        void run()
+        {
+            StringArray names;
+            for (int i = 0; i < numNames; ++i)
+                names.add ("property" + String (i));
+
+            results.insertMultiple (0, String::CharPointerType (nullptr), numNames);
+
+            for (int i = 0; i < numLookups; ++i)
+            {
+                const int index = ((i + seed * 137) * 7919) % numNames;
+                results.set (index, pool.getPooledString (names[index]));
+            }
+        }
+
+        StringPool& pool;
+        const int seed;
+        Array<String::CharPointerType> results;
+    };
+};
+
+static StringPoolTests stringPoolUnitTests;
+
+#endif
@@ -27,7 +27,7 @@
 #define __JUCE_STRINGPOOL_JUCEHEADER__
 
 #include "juce_String.h"
-#include "../containers/juce_Array.h"
+#include "../containers/juce_OwnedArray.h"
 
 
 //==============================================================================
@@ -40,13 +40,18 @@
     is returned every time a matching string is asked for. This means that it's trivial to
     compare two pooled strings for equality, as you can simply compare their pointers. It
     also cuts down on storage if you're using many copies of the same string.
+
+    The pool is safe to use from multiple threads. It's split into a number of independently
+    locked hash tables, and looking up a string that's already in the pool doesn't need to
+    take any locks at all, so threads that are mostly re-using the same strings (e.g. when
+    creating Identifiers for ValueTree properties) won't block each other.
 */
 class JUCE_API  StringPool
 {
 public:
     //==============================================================================
     /** Creates an empty pool. */
-    StringPool() noexcept;
+    StringPool();
 
     /** Destructor */
     ~StringPool();
@@ -80,12 +85,22 @@ public:
     /** Returns the number of strings in the pool. */
     int size() const noexcept;
 
-    /** Returns one of the strings in the pool, by index. */
+    /** Returns one of the strings in the pool, by index.
+        The strings aren't kept in any particular order.
+    */
     String::CharPointerType operator[] (int index) const noexcept;
 
 private:
-    Array <String> strings;
-    CriticalSection lock;
+    //==============================================================================
+    class Shard;
+    enum { numShards = 16 };
+
+    OwnedArray <Shard> shards;
+
+    template <class CharPointer>
+    String::CharPointerType getPooledStringFor (CharPointer);
+
+    JUCE_DECLARE_NON_COPYABLE (StringPool)
 };
 
 
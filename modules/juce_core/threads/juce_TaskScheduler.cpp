@@ -0,0 +1,705 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+namespace TaskStates
+{
+    enum
+    {
+        notScheduled = 0,
+        waitingForDependencies,
+        queued,
+        running,
+        finished
+    };
+}
+
+//==============================================================================
+TaskScheduler::Task::Task()
+    : scheduler (nullptr),
+      finishedEvent (true)
+{
+}
+
+TaskScheduler::Task::~Task()
+{
+    // A task mustn't be deleted while it's waiting to run!
+    jassert (state.value == TaskStates::notScheduled || state.value == TaskStates::finished);
+}
+
+bool TaskScheduler::Task::isFinished() const noexcept
+{
+    return state.value == TaskStates::finished;
+}
+
+bool TaskScheduler::Task::waitUntilFinished (const int timeOutMilliseconds) const
+{
+    if (isFinished())
+        return true;
+
+    if (scheduler == nullptr)
+        return false;
+
+    const uint32 startTime = Time::getMillisecondCounter();
+    const int workerIndex = scheduler->getCurrentWorkerIndex();
+
+    for (;;)
+    {
+        // Rather than just blocking, help to get through whatever's in the queues..
+        while (! isFinished())
+            if (! scheduler->runNextTask (workerIndex))
+                break;
+
+        if (isFinished())
+            return true;
+
+        int timeLeft = -1;
+
+        if (timeOutMilliseconds >= 0)
+        {
+            const int elapsed = (int) (Time::getMillisecondCounter() - startTime);
+
+            if (elapsed >= timeOutMilliseconds)
+                return false;
+
+            timeLeft = timeOutMilliseconds - elapsed;
+        }
+
+        ++numWaiters;
+
+        if (! isFinished())
+            finishedEvent.wait (timeLeft);
+
+        --numWaiters;
+    }
+}
+
+//==============================================================================
+/*  A double-ended queue of tasks. The worker that owns the queue takes the newest
+    tasks from its back, and other threads steal the oldest ones from its front.
+*/
+class TaskScheduler::WorkQueue
+{
+public:
+    WorkQueue()
+        : items ((size_t) initialSize), head (0), tail (0), mask (initialSize - 1)
+    {
+    }
+
+    void push (Task* const task)
+    {
+        const SpinLock::ScopedLockType sl (lock);
+
+        if (tail - head > mask)
+            grow();
+
+        items [tail++ & mask] = task;
+    }
+
+    Task* popNewest() noexcept
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        return head != tail ? items [--tail & mask] : nullptr;
+    }
+
+    Task* stealOldest() noexcept
+    {
+        // If another thread is busy with this queue, don't hang around - the
+        // caller can try one of the other queues instead.
+        if (! lock.tryEnter())
+            return nullptr;
+
+        Task* const task = head != tail ? items [head++ & mask] : nullptr;
+        lock.exit();
+        return task;
+    }
+
+    int size() const noexcept
+    {
+        const SpinLock::ScopedLockType sl (lock);
+        return (int) (tail - head);
+    }
+
+private:
+    enum { initialSize = 64 };
+
+    SpinLock lock;
+    HeapBlock<Task*> items;
+    uint32 head, tail, mask;
+
+    void grow()
+    {
+        const uint32 newMask = mask * 2 + 1;
+        HeapBlock<Task*> newItems ((size_t) newMask + 1);
+
+        for (uint32 i = head; i != tail; ++i)
+            newItems [i & newMask] = items [i & mask];
+
+        items.swapWith (newItems);
+        mask = newMask;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (WorkQueue)
+};
+
+//==============================================================================
+class TaskScheduler::Worker  : public Thread
+{
+public:
+    Worker (TaskScheduler& owner_, const int index_)
+        : Thread ("Task Scheduler"),
+          owner (owner_),
+          index (index_)
+    {
+    }
+
+    void run()
+    {
+        while (! threadShouldExit())
+        {
+            if (owner.runNextTask (index))
+                continue;
+
+            // Announce that we're going to sleep before checking the queues for the last
+            // time, so that anything added after this point will be sure to wake us up.
+            isSleeping = 1;
+            ++owner.numSleepingWorkers;
+
+            if (owner.getNumQueuedTasks() == 0 && ! threadShouldExit())
+                wait (-1);
+
+            stopSleeping();
+        }
+    }
+
+    // Returns true if the thread was asleep and the caller is responsible for waking it.
+    bool stopSleeping() noexcept
+    {
+        if (! isSleeping.compareAndSetBool (0, 1))
+            return false;
+
+        --owner.numSleepingWorkers;
+        return true;
+    }
+
+private:
+    TaskScheduler& owner;
+    const int index;
+    Atomic<int> isSleeping;
+
+    JUCE_DECLARE_NON_COPYABLE (Worker)
+};
+
+//==============================================================================
+class TaskScheduler::ParallelForTask  : public Task
+{
+public:
+    struct SharedRange
+    {
+        SharedRange (RangeFunctionCallerBase& function_, const int start_, const int end_, const int grainSize_) noexcept
+            : function (function_), start (start_), end (end_), grainSize (grainSize_),
+              numChunks ((end_ - start_ - 1) / grainSize_ + 1)
+        {
+        }
+
+        // Each thread keeps grabbing the next chunk until they've all been taken.
+        void processChunks()
+        {
+            for (;;)
+            {
+                const int chunk = ++nextChunk - 1;
+
+                if (chunk >= numChunks)
+                    break;
+
+                const int chunkStart = start + chunk * grainSize;
+
+                function.call (chunkStart, jmin (end, chunkStart + grainSize));
+            }
+        }
+
+        RangeFunctionCallerBase& function;
+        const int start, end, grainSize, numChunks;
+        Atomic<int> nextChunk;
+
+        JUCE_DECLARE_NON_COPYABLE (SharedRange)
+    };
+
+    ParallelForTask (SharedRange& range_) noexcept  : range (range_) {}
+
+    void run()      { range.processChunks(); }
+
+private:
+    SharedRange& range;
+
+    JUCE_DECLARE_NON_COPYABLE (ParallelForTask)
+};
+
+//==============================================================================
+TaskScheduler::TaskScheduler (const int numberOfThreads)
+{
+    const int numThreads = numberOfThreads > 0 ? numberOfThreads
+                                               : SystemStats::getNumCpus();
+
+    // One queue per worker, plus one for tasks that are added by other threads.
+    for (int i = 0; i <= numThreads; ++i)
+        queues.add (new WorkQueue());
+
+    for (int i = 0; i < numThreads; ++i)
+        workers.add (new Worker (*this, i));
+
+    for (int i = 0; i < numThreads; ++i)
+        workers.getUnchecked(i)->startThread();
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    for (int i = workers.size(); --i >= 0;)
+        workers.getUnchecked(i)->signalThreadShouldExit();
+
+    for (int i = workers.size(); --i >= 0;)
+        workers.getUnchecked(i)->stopThread (-1);
+
+    // Discard anything that's left, including any tasks that get released by doing so..
+    for (int i = 0; i < queues.size();)
+    {
+        if (Task* const task = queues.getUnchecked(i)->popNewest())
+        {
+            if (task->state.compareAndSetBool (TaskStates::running, TaskStates::queued))
+                finishTask (task);
+
+            task->decReferenceCount();
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+//==============================================================================
+void TaskScheduler::addTask (Task* const task)
+{
+    addDependencies (task, nullptr, 0);
+}
+
+void TaskScheduler::addTask (Task* const task, Task* const taskToWaitFor)
+{
+    addDependencies (task, &taskToWaitFor, 1);
+}
+
+void TaskScheduler::addTask (Task* const task, const Array<Task*>& tasksToWaitFor)
+{
+    addDependencies (task, tasksToWaitFor.begin(), tasksToWaitFor.size());
+}
+
+void TaskScheduler::addDependencies (Task* const task, Task* const* const dependencies, const int numDependencies)
+{
+    jassert (task != nullptr);
+
+    // A task can only be added once!
+    jassert (task->scheduler == nullptr && task->state.value == TaskStates::notScheduled);
+
+    if (task == nullptr || task->scheduler != nullptr)
+        return;
+
+    // Make sure the task can't be deleted by another thread while we're still using it.
+    const Task::Ptr taskHolder (task);
+
+    task->scheduler = this;
+    task->state = TaskStates::waitingForDependencies;
+
+    // (this extra count stops the task being started before all its dependencies are registered)
+    task->numDependenciesLeft = 1;
+
+    for (int i = 0; i < numDependencies; ++i)
+    {
+        Task* const dependency = dependencies[i];
+
+        if (dependency != nullptr && dependency != task)
+        {
+            const SpinLock::ScopedLockType sl (dependency->dependentsLock);
+
+            if (! dependency->isFinished())
+            {
+                ++(task->numDependenciesLeft);
+                task->incReferenceCount();
+                dependency->dependents.add (task);
+            }
+        }
+    }
+
+    scheduleIfReady (task);
+}
+
+void TaskScheduler::scheduleIfReady (Task* const task)
+{
+    if (--(task->numDependenciesLeft) == 0)
+        enqueue (task);
+}
+
+void TaskScheduler::enqueue (Task* const task)
+{
+    task->state = TaskStates::queued;
+    task->incReferenceCount();
+
+    const int workerIndex = getCurrentWorkerIndex();
+    queues.getUnchecked (workerIndex >= 0 ? workerIndex : workers.size())->push (task);
+
+    Atomic<int>::memoryBarrier();
+
+    if (numSleepingWorkers.value > 0)
+        wakeSleepingWorker();
+}
+
+void TaskScheduler::wakeSleepingWorker()
+{
+    for (int i = 0; i < workers.size(); ++i)
+    {
+        Worker* const w = workers.getUnchecked(i);
+
+        if (w->stopSleeping())
+        {
+            w->notify();
+            break;
+        }
+    }
+}
+
+int TaskScheduler::getCurrentWorkerIndex() noexcept
+{
+    const Thread::ThreadID thisThread = Thread::getCurrentThreadId();
+
+    for (int i = workers.size(); --i >= 0;)
+        if (workers.getUnchecked(i)->getThreadId() == thisThread)
+            return i;
+
+    return -1;
+}
+
+//==============================================================================
+bool TaskScheduler::runNextTask (const int workerIndex)
+{
+    Task* task = workerIndex >= 0 ? queues.getUnchecked (workerIndex)->popNewest()
+                                  : nullptr;
+
+    if (task == nullptr)
+    {
+        const int numQueues = queues.size();
+
+        for (int i = 1; i <= numQueues && task == nullptr; ++i)
+            task = queues.getUnchecked ((workerIndex + i + numQueues) % numQueues)->stealOldest();
+
+        if (task == nullptr)
+            return false;
+    }
+
+    runTask (task);
+    return true;
+}
+
+void TaskScheduler::runTask (Task* const task)
+{
+    // (the task may have been cancelled while it was in the queue)
+    if (task->state.compareAndSetBool (TaskStates::running, TaskStates::queued))
+    {
+        JUCE_TRY
+        {
+            task->run();
+        }
+        JUCE_CATCH_ALL_ASSERT
+
+        finishTask (task);
+    }
+
+    task->decReferenceCount();
+}
+
+void TaskScheduler::finishTask (Task* const task)
+{
+    Array<Task*> dependents;
+
+    {
+        const SpinLock::ScopedLockType sl (task->dependentsLock);
+        task->state = TaskStates::finished;
+        dependents.swapWithArray (task->dependents);
+    }
+
+    Atomic<int>::memoryBarrier();
+
+    if (task->numWaiters.value > 0)
+        task->finishedEvent.signal();
+
+    for (int i = 0; i < dependents.size(); ++i)
+    {
+        Task* const dependent = dependents.getUnchecked(i);
+        dependent->scheduler->scheduleIfReady (dependent);
+        dependent->decReferenceCount();
+    }
+}
+
+//==============================================================================
+void TaskScheduler::runParallelFor (const int start, const int end, int grainSize,
+                                    RangeFunctionCallerBase& function)
+{
+    if (end <= start)
+        return;
+
+    const int numItems = end - start;
+
+    if (grainSize <= 0)
+        grainSize = jmax (1, numItems / (4 * (workers.size() + 1)));
+
+    const int numChunks = (numItems - 1) / grainSize + 1;
+
+    if (numChunks <= 1)
+    {
+        function.call (start, end);
+        return;
+    }
+
+    ParallelForTask::SharedRange range (function, start, end, grainSize);
+    const int numHelpers = jmin (workers.size(), numChunks - 1);
+    Array<Task::Ptr> helpers;
+
+    for (int i = 0; i < numHelpers; ++i)
+    {
+        Task* const helper = new ParallelForTask (range);
+        helpers.add (helper);
+        addTask (helper);
+    }
+
+    range.processChunks();
+
+    // All the chunks have now been taken, so any helpers that haven't started can be
+    // cancelled, and we just need to wait for the others to finish their last chunk.
+    for (int i = 0; i < numHelpers; ++i)
+    {
+        Task* const helper = helpers.getReference(i);
+
+        if (helper->state.compareAndSetBool (TaskStates::running, TaskStates::queued))
+            finishTask (helper);
+        else
+            helper->waitUntilFinished();
+    }
+}
+
+//==============================================================================
+int TaskScheduler::getNumQueuedTasks() const noexcept
+{
+    int num = 0;
+
+    for (int i = queues.size(); --i >= 0;)
+        num += queues.getUnchecked(i)->size();
+
+    return num;
+}
+
+bool TaskScheduler::setThreadPriorities (const int newPriority)
+{
+    bool ok = true;
+
+    for (int i = workers.size(); --i >= 0;)
+        if (! workers.getUnchecked(i)->setPriority (newPriority))
+            ok = false;
+
+    return ok;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class TaskSchedulerTests  : public UnitTest
+{
+public:
+    TaskSchedulerTests() : UnitTest ("TaskScheduler") {}
+
+    struct CountingTask  : public TaskScheduler::Task
+    {
+        CountingTask (Atomic<int>& counter_) : counter (counter_) {}
+        void run()      { ++counter; }
+
+        Atomic<int>& counter;
+    };
+
+    struct OrderCheckingTask  : public TaskScheduler::Task
+    {
+        OrderCheckingTask (Atomic<int>& counter_, int expected_, bool& ok_)
+            : counter (counter_), expected (expected_), ok (ok_) {}
+
+        void run()
+        {
+            Thread::yield();
+
+            if (counter.value != expected)
+                ok = false;
+
+            ++counter;
+        }
+
+        Atomic<int>& counter;
+        const int expected;
+        bool& ok;
+    };
+
+    // Recursively splits itself into two sub-tasks, and waits for them
+    struct FibonacciTask  : public TaskScheduler::TaskWithResult<int>
+    {
+        FibonacciTask (TaskScheduler& s, int n_) : scheduler (s), n (n_) {}
+
+        int compute()
+        {
+            if (n < 2)
+                return n;
+
+            TaskScheduler::Task::Ptr a (new FibonacciTask (scheduler, n - 1));
+            TaskScheduler::Task::Ptr b (new FibonacciTask (scheduler, n - 2));
+            scheduler.addTask (a);
+            scheduler.addTask (b);
+
+            return static_cast<FibonacciTask*> (a.getObject())->getResult()
+                    + static_cast<FibonacciTask*> (b.getObject())->getResult();
+        }
+
+        TaskScheduler& scheduler;
+        const int n;
+    };
+
+    struct RangeMarker
+    {
+        RangeMarker (Array<int>& hits_) : hits (hits_) {}
+
+        void operator() (int start, int end) const
+        {
+            for (int i = start; i < end; ++i)
+                ++(hits.getReference (i));
+        }
+
+        Array<int>& hits;
+    };
+
+    void runTest()
+    {
+        beginTest ("Tasks");
+
+        {
+            TaskScheduler scheduler (3);
+            Atomic<int> counter;
+            Array<TaskScheduler::Task::Ptr> tasks;
+
+            for (int i = 0; i < 10000; ++i)
+            {
+                tasks.add (new CountingTask (counter));
+                scheduler.addTask (tasks.getLast());
+            }
+
+            for (int i = 0; i < tasks.size(); ++i)
+                expect (tasks.getReference(i)->waitUntilFinished (10000));
+
+            expectEquals (counter.value, 10000);
+            expectEquals (scheduler.getNumQueuedTasks(), 0);
+
+            // tasks which are added without keeping a pointer to them should get deleted
+            for (int i = 0; i < 1000; ++i)
+                scheduler.addTask (new CountingTask (counter));
+
+            TaskScheduler::Task::Ptr last (new CountingTask (counter));
+            scheduler.addTask (last, tasks.getLast());
+            expect (last->waitUntilFinished (10000));
+        }
+
+        beginTest ("Dependencies");
+
+        {
+            TaskScheduler scheduler (4);
+            Atomic<int> counter;
+            bool ok = true;
+            Array<TaskScheduler::Task::Ptr> tasks;
+
+            // Each task waits for the previous one, but they're added in reverse order
+            for (int i = 0; i < 100; ++i)
+                tasks.add (new OrderCheckingTask (counter, i, ok));
+
+            for (int i = tasks.size(); --i > 0;)
+                scheduler.addTask (tasks.getReference(i), tasks.getReference (i - 1));
+
+            expect (! tasks.getLast()->waitUntilFinished (50));
+            expectEquals (counter.value, 0);
+
+            scheduler.addTask (tasks.getFirst());
+            expect (tasks.getLast()->waitUntilFinished (10000));
+            expectEquals (counter.value, 100);
+            expect (ok);
+
+            Array<TaskScheduler::Task*> all;
+            for (int i = 0; i < tasks.size(); ++i)
+                all.add (tasks.getReference(i));
+
+            TaskScheduler::Task::Ptr afterAll (new OrderCheckingTask (counter, 100, ok));
+            scheduler.addTask (afterAll, all);
+            afterAll->waitUntilFinished();
+            expect (ok);
+        }
+
+        beginTest ("Results");
+
+        {
+            TaskScheduler scheduler (2);
+            FibonacciTask::Ptr fib (new FibonacciTask (scheduler, 16));
+            scheduler.addTask (fib);
+            expectEquals (static_cast<FibonacciTask*> (fib.getObject())->getResult(), 987);
+        }
+
+        beginTest ("parallelFor");
+
+        {
+            TaskScheduler scheduler (3);
+            Random r;
+
+            for (int i = 0; i < 50; ++i)
+            {
+                const int start = r.nextInt (100);
+                const int end = start + r.nextInt (5000);
+                Array<int> hits;
+                hits.insertMultiple (0, 0, end + 10);
+
+                RangeMarker marker (hits);
+                scheduler.parallelFor (start, end, marker, r.nextInt (200) - 10);
+
+                bool allCorrect = true;
+
+                for (int j = 0; j < hits.size(); ++j)
+                    if (hits[j] != ((j >= start && j < end) ? 1 : 0))
+                        allCorrect = false;
+
+                expect (allCorrect);
+            }
+        }
+    }
+};
+
+static TaskSchedulerTests taskSchedulerTests;
+
+#endif
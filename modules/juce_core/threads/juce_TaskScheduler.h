@@ -0,0 +1,325 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_TASKSCHEDULER_JUCEHEADER__
+#define __JUCE_TASKSCHEDULER_JUCEHEADER__
+
+#include "juce_Thread.h"
+#include "juce_SpinLock.h"
+#include "../containers/juce_Array.h"
+#include "../containers/juce_OwnedArray.h"
+#include "../memory/juce_ReferenceCountedObject.h"
+
+
+//==============================================================================
+/**
+    Runs large numbers of small tasks on a set of worker threads.
+
+    A ThreadPool is designed for a modest number of long-running jobs, which it keeps
+    in a single shared list. A TaskScheduler is intended for work that has been split
+    into lots of small pieces, e.g. the tiles of an image or the blocks of a file
+    that's being decoded: each of its threads has its own queue of tasks, and when a
+    thread runs out of work, it steals tasks from the other threads' queues.
+
+    Tasks can be made to wait for other tasks to finish before they start, so that
+    you can build up a graph of work, and any thread can wait for a task to finish
+    (while it waits, it'll help by running other tasks).
+
+    e.g.
+    @code
+    struct ThumbnailTask  : public TaskScheduler::Task
+    {
+        ThumbnailTask (const File& f) : file (f) {}
+        void run()     { image = createThumbnail (file); }
+
+        File file;
+        Image image;
+    };
+
+    TaskScheduler scheduler;
+    Array<TaskScheduler::Task::Ptr> tasks;
+
+    for (int i = 0; i < files.size(); ++i)
+    {
+        TaskScheduler::Task::Ptr t (new ThumbnailTask (files[i]));
+        scheduler.addTask (t);
+        tasks.add (t);
+    }
+
+    for (int i = 0; i < tasks.size(); ++i)
+        tasks.getReference(i)->waitUntilFinished();
+    @endcode
+
+    @see ThreadPool, TaskScheduler::Task, TaskScheduler::parallelFor
+*/
+class JUCE_API  TaskScheduler
+{
+public:
+    //==============================================================================
+    /** Creates a scheduler with a given number of worker threads.
+        If the number of threads is less than 1, the number of CPUs will be used.
+    */
+    explicit TaskScheduler (int numberOfThreads = 0);
+
+    /** Destructor.
+        This will wait for any tasks that are currently running to finish, and will
+        then stop the threads. Any tasks that haven't been started will be discarded
+        without being run, and will be marked as finished.
+    */
+    ~TaskScheduler();
+
+    //==============================================================================
+    /**
+        A piece of work that can be run by a TaskScheduler.
+
+        Tasks are reference-counted, and the scheduler keeps a reference to each task
+        until it has been run, so you can create one with new, add it to a scheduler,
+        and then either forget about it or keep a Task::Ptr to it so that you can wait
+        for it to finish.
+
+        A task can only be added to a scheduler once.
+
+        @see TaskScheduler::addTask, TaskScheduler::TaskWithResult
+    */
+    class JUCE_API  Task  : public ReferenceCountedObject
+    {
+    public:
+        /** Creates a task. */
+        Task();
+
+        /** Destructor. */
+        virtual ~Task();
+
+        /** Performs the task's work.
+            This will be called once, on one of the scheduler's threads, or on a thread
+            which is waiting for a task to finish. It can add other tasks to the scheduler,
+            and can wait for them to finish.
+        */
+        virtual void run() = 0;
+
+        /** Returns true if the task has been run, or has been discarded by its scheduler. */
+        bool isFinished() const noexcept;
+
+        /** Waits until the task has finished.
+
+            While it's waiting, the calling thread will run any other tasks that are
+            queued in the scheduler, so this can safely be called from inside another
+            task's run() method.
+
+            @param timeOutMilliseconds  the maximum time to wait, or -1 to wait forever
+            @returns true if the task finished, or false if it timed-out
+        */
+        bool waitUntilFinished (int timeOutMilliseconds = -1) const;
+
+        /** A pointer to a Task. */
+        typedef ReferenceCountedObjectPtr<Task> Ptr;
+
+    private:
+        //==============================================================================
+        friend class TaskScheduler;
+        TaskScheduler* scheduler;
+        Atomic<int> state, numDependenciesLeft;
+        mutable Atomic<int> numWaiters;
+        SpinLock dependentsLock;
+        Array<Task*> dependents;
+        WaitableEvent finishedEvent;
+
+        JUCE_DECLARE_NON_COPYABLE (Task)
+    };
+
+    //==============================================================================
+    /**
+        A Task which produces a value, which other threads can wait for.
+
+        Subclasses implement the compute() method, which is called on one of the
+        scheduler's threads, and other threads can call getResult(), which will wait
+        until the value is ready.
+
+        @code
+        struct SumTask  : public TaskScheduler::TaskWithResult<double>
+        {
+            SumTask (const float* d, int n) : data (d), num (n) {}
+
+            double compute()
+            {
+                double total = 0;
+                for (int i = 0; i < num; ++i)
+                    total += data[i];
+
+                return total;
+            }
+
+            const float* data;
+            int num;
+        };
+        @endcode
+    */
+    template <typename ResultType>
+    class TaskWithResult  : public Task
+    {
+    public:
+        /** Creates a task. */
+        TaskWithResult()    : result() {}
+
+        /** Must be implemented to calculate the result. */
+        virtual ResultType compute() = 0;
+
+        /** Waits for the task to finish and returns its result.
+            If the task hasn't been added to a scheduler, this will simply return a
+            default-constructed value.
+        */
+        const ResultType& getResult() const
+        {
+            waitUntilFinished();
+            return result;
+        }
+
+        /** @internal */
+        void run()          { result = compute(); }
+
+    private:
+        ResultType result;
+
+        JUCE_DECLARE_NON_COPYABLE (TaskWithResult)
+    };
+
+    //==============================================================================
+    /** Adds a task to the scheduler, to be run as soon as a thread is free.
+
+        If this is called by a task that's running on one of the scheduler's threads,
+        the new task is added to that thread's own queue.
+    */
+    void addTask (Task* task);
+
+    /** Adds a task which will not be started until another task has finished.
+        The task that must finish first can be one that hasn't yet been added to the
+        scheduler, or has already finished.
+    */
+    void addTask (Task* task, Task* taskToWaitFor);
+
+    /** Adds a task which will not be started until all of the tasks in the given list
+        have finished.
+        @see addTask (Task*, Task*)
+    */
+    void addTask (Task* task, const Array<Task*>& tasksToWaitFor);
+
+    //==============================================================================
+    /**
+        Calls a function for every chunk of a range of integers, using all the scheduler's
+        threads, and returns when all of the chunks have been done.
+
+        The function is called as rangeFunction (chunkStart, chunkEnd), where chunkStart
+        is inclusive and chunkEnd is exclusive. It'll be called concurrently from several
+        threads, including the caller's own thread, so it must be thread-safe.
+
+        The range is divided into chunks of grainSize items (except for the last one,
+        which may be shorter). If grainSize is less than 1, a size will be picked that
+        gives a few chunks per thread.
+
+        e.g.
+        @code
+        struct Scaler
+        {
+            Scaler (float* d, float g) : data (d), gain (g) {}
+
+            void operator() (int start, int end) const
+            {
+                for (int i = start; i < end; ++i)
+                    data[i] *= gain;
+            }
+
+            float* data;
+            float gain;
+        };
+
+        Scaler scaler (samples, 0.5f);
+        scheduler.parallelFor (0, numSamples, scaler, 4096);
+        @endcode
+    */
+    template <typename RangeFunctionType>
+    void parallelFor (int rangeStart, int rangeEnd, RangeFunctionType& rangeFunction, int grainSize = 0)
+    {
+        RangeFunctionCaller<RangeFunctionType> caller (rangeFunction);
+        runParallelFor (rangeStart, rangeEnd, grainSize, caller);
+    }
+
+    //==============================================================================
+    /** Returns the number of worker threads. */
+    int getNumThreads() const noexcept                  { return workers.size(); }
+
+    /** Returns the number of tasks that are queued but haven't yet been started.
+        Tasks which are waiting for other tasks to finish aren't included.
+    */
+    int getNumQueuedTasks() const noexcept;
+
+    /** Changes the priority of all the worker threads.
+        @see Thread::setPriority
+    */
+    bool setThreadPriorities (int newPriority);
+
+private:
+    //==============================================================================
+    class WorkQueue;
+    class Worker;
+    class ParallelForTask;
+    friend class Task;
+    friend class WorkQueue;
+    friend class Worker;
+    friend class ParallelForTask;
+
+    struct RangeFunctionCallerBase
+    {
+        virtual ~RangeFunctionCallerBase() {}
+        virtual void call (int start, int end) = 0;
+    };
+
+    template <typename RangeFunctionType>
+    struct RangeFunctionCaller  : public RangeFunctionCallerBase
+    {
+        RangeFunctionCaller (RangeFunctionType& f) noexcept : function (f) {}
+        void call (int start, int end)      { function (start, end); }
+
+        RangeFunctionType& function;
+    };
+
+    OwnedArray<WorkQueue> queues;
+    OwnedArray<Worker> workers;
+    Atomic<int> numSleepingWorkers;
+
+    int getCurrentWorkerIndex() noexcept;
+    void enqueue (Task*);
+    void scheduleIfReady (Task*);
+    void addDependencies (Task*, Task* const*, int numDependencies);
+    bool runNextTask (int workerIndex);
+    void runTask (Task*);
+    void finishTask (Task*);
+    void wakeSleepingWorker();
+    void runParallelFor (int start, int end, int grainSize, RangeFunctionCallerBase&);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TaskScheduler)
+};
+
+
+#endif   // __JUCE_TASKSCHEDULER_JUCEHEADER__
@@ -23,15 +23,57 @@
   ==============================================================================
 */
 
-TimeSliceThread::TimeSliceThread (const String& name)
+TimeSliceClient::TimeSliceClient() noexcept
+    : owner (nullptr),
+      callingLock (nullptr),
+      callingThread (nullptr),
+      nextCallTime (0),
+      queueOrder (0),
+      queueIndex (-1),
+      callAgainSoon (false)
+{
+    zerostruct (statistics);
+}
+
+//==============================================================================
+class TimeSliceThread::HelperThread  : public Thread
+{
+public:
+    HelperThread (TimeSliceThread& owner_)
+        : Thread (owner_.getThreadName()),
+          owner (owner_)
+    {
+    }
+
+    void run()
+    {
+        owner.serviceClients (*this, callbackLock);
+    }
+
+private:
+    TimeSliceThread& owner;
+    CriticalSection callbackLock;
+
+    JUCE_DECLARE_NON_COPYABLE (HelperThread)
+};
+
+//==============================================================================
+TimeSliceThread::TimeSliceThread (const String& name, const int numberOfThreads)
     : Thread (name),
-      clientBeingCalled (nullptr)
+      nextQueueOrder (0),
+      lateCallTolerance (10.0)
 {
+    for (int i = 1; i < numberOfThreads; ++i)
+        helperThreads.add (new HelperThread (*this));
 }
 
 TimeSliceThread::~TimeSliceThread()
 {
     stopThread (2000);
+
+    // (these will normally have been stopped by run(), unless the main thread was killed)
+    for (int i = helperThreads.size(); --i >= 0;)
+        helperThreads.getUnchecked(i)->stopThread (2000);
 }
 
 //==============================================================================
@@ -40,9 +82,18 @@ void TimeSliceThread::addTimeSliceClient (TimeSliceClient* const client, int mil
     if (client != nullptr)
     {
         const ScopedLock sl (listLock);
-        client->nextCallTime = Time::getCurrentTime() + RelativeTime::milliseconds (millisecondsBeforeStarting);
-        clients.addIfNotAlreadyThere (client);
-        notify();
+
+        // A client can't be added to more than one thread at a time!
+        jassert (client->owner == nullptr || client->owner == this);
+
+        if (client->owner == nullptr)
+        {
+            client->owner = this;
+            clients.add (client);
+        }
+
+        setNextCallTime (client, Time::getMillisecondCounterHiRes() + millisecondsBeforeStarting);
+        notifyAllThreads();
     }
 }
 
@@ -50,31 +101,36 @@ void TimeSliceThread::removeTimeSliceClient (TimeSliceClient* const client)
 {
     const ScopedLock sl1 (listLock);
 
-    // if there's a chance we're in the middle of calling this client, we need to
-    // also lock the outer lock..
-    if (clientBeingCalled == client)
-    {
-        const ScopedUnlock ul (listLock); // unlock first to get the order right..
+    if (client == nullptr || client->owner != this)
+        return;
 
-        const ScopedLock sl2 (callbackLock);
-        const ScopedLock sl3 (listLock);
-
-        clients.removeFirstMatchingValue (client);
-    }
-    else
+    // if we're in the middle of calling this client on another thread, we need to
+    // wait for that thread's callback to finish..
+    while (client->callingLock != nullptr
+            && client->callingThread != Thread::getCurrentThreadId())
     {
-        clients.removeFirstMatchingValue (client);
+        const CriticalSection& callbackLockInUse = *client->callingLock;
+
+        const ScopedUnlock ul (listLock); // unlock first to get the order right..
+        const ScopedLock sl2 (callbackLockInUse);
     }
+
+    if (client->owner == this)
+        removeClient (client);
 }
 
 void TimeSliceThread::moveToFrontOfQueue (TimeSliceClient* client)
 {
     const ScopedLock sl (listLock);
 
-    if (clients.contains (client))
+    if (client != nullptr && client->owner == this)
     {
-        client->nextCallTime = Time::getCurrentTime();
-        notify();
+        if (client->callingLock != nullptr)
+            client->callAgainSoon = true;
+        else
+            setNextCallTime (client, Time::getMillisecondCounterHiRes());
+
+        notifyAllThreads();
     }
 }
 
@@ -90,79 +146,353 @@ TimeSliceClient* TimeSliceThread::getClient (const int i) const
 }
 
 //==============================================================================
-TimeSliceClient* TimeSliceThread::getNextClient (int index) const
+TimeSliceClient::Statistics TimeSliceThread::getClientStatistics (TimeSliceClient* const client) const
 {
-    Time soonest;
-    TimeSliceClient* client = nullptr;
+    const ScopedLock sl (listLock);
+
+    if (client != nullptr && client->owner == this)
+        return client->statistics;
+
+    TimeSliceClient::Statistics s;
+    zerostruct (s);
+    return s;
+}
+
+void TimeSliceThread::resetClientStatistics()
+{
+    const ScopedLock sl (listLock);
 
     for (int i = clients.size(); --i >= 0;)
+        zerostruct (clients.getUnchecked(i)->statistics);
+}
+
+void TimeSliceThread::setLateCallTolerance (const int milliseconds)
+{
+    const ScopedLock sl (listLock);
+    lateCallTolerance = jmax (0, milliseconds);
+}
+
+//==============================================================================
+void TimeSliceThread::notifyAllThreads()
+{
+    notify();
+
+    for (int i = helperThreads.size(); --i >= 0;)
+        helperThreads.getUnchecked(i)->notify();
+}
+
+void TimeSliceThread::removeClient (TimeSliceClient* const client)
+{
+    if (client->queueIndex >= 0)
+        removeFromQueue (client);
+
+    clients.removeFirstMatchingValue (client);
+    client->owner = nullptr;
+}
+
+void TimeSliceThread::setNextCallTime (TimeSliceClient* const client, const double time)
+{
+    if (client->queueIndex >= 0)
+        removeFromQueue (client);
+
+    client->nextCallTime = time;
+    client->queueOrder = nextQueueOrder++;
+
+    // (if the client is being called, it'll be put back in the queue when the call returns)
+    if (client->callingLock == nullptr)
+        addToQueue (client);
+}
+
+//==============================================================================
+// The queue is a binary heap, ordered by the time at which each client is due,
+// and then by the order in which they were scheduled.
+bool TimeSliceThread::isDueBefore (const TimeSliceClient* const a, const TimeSliceClient* const b) noexcept
+{
+    return a->nextCallTime < b->nextCallTime
+            || (a->nextCallTime == b->nextCallTime && (int) (a->queueOrder - b->queueOrder) < 0);
+}
+
+void TimeSliceThread::addToQueue (TimeSliceClient* const client)
+{
+    client->queueIndex = queue.size();
+    queue.add (client);
+    moveUp (client->queueIndex);
+}
+
+void TimeSliceThread::removeFromQueue (TimeSliceClient* const client)
+{
+    const int index = client->queueIndex;
+    jassert (queue [index] == client);
+
+    TimeSliceClient* const last = queue.getLast();
+    queue.removeLast();
+    client->queueIndex = -1;
+
+    if (last != client)
     {
-        TimeSliceClient* const c = clients.getUnchecked ((i + index) % clients.size());
+        queue.set (index, last);
+        last->queueIndex = index;
+        moveUp (index);
+        moveDown (last->queueIndex);
+    }
+}
 
-        if (client == nullptr || c->nextCallTime < soonest)
-        {
-            client = c;
-            soonest = c->nextCallTime;
-        }
+void TimeSliceThread::moveUp (int index)
+{
+    TimeSliceClient** const q = queue.getRawDataPointer();
+    TimeSliceClient* const client = q[index];
+
+    while (index > 0)
+    {
+        const int parent = (index - 1) / 2;
+
+        if (! isDueBefore (client, q[parent]))
+            break;
+
+        q[index] = q[parent];
+        q[index]->queueIndex = index;
+        index = parent;
     }
 
-    return client;
+    q[index] = client;
+    client->queueIndex = index;
 }
 
-void TimeSliceThread::run()
+void TimeSliceThread::moveDown (int index)
 {
-    int index = 0;
+    TimeSliceClient** const q = queue.getRawDataPointer();
+    TimeSliceClient* const client = q[index];
+    const int num = queue.size();
 
-    while (! threadShouldExit())
+    for (;;)
+    {
+        int child = index * 2 + 1;
+
+        if (child >= num)
+            break;
+
+        if (child + 1 < num && isDueBefore (q [child + 1], q [child]))
+            ++child;
+
+        if (! isDueBefore (q [child], client))
+            break;
+
+        q[index] = q[child];
+        q[index]->queueIndex = index;
+        index = child;
+    }
+
+    q[index] = client;
+    client->queueIndex = index;
+}
+
+//==============================================================================
+void TimeSliceThread::serviceClients (Thread& thread, const CriticalSection& callbackLockToUse)
+{
+    while (! thread.threadShouldExit())
     {
         int timeToWait = 500;
 
         {
-            Time nextClientTime;
+            const ScopedLock sl (callbackLockToUse);
+            TimeSliceClient* client = nullptr;
 
             {
                 const ScopedLock sl2 (listLock);
 
-                index = clients.size() > 0 ? ((index + 1) % clients.size()) : 0;
-
-                if (TimeSliceClient* const firstClient = getNextClient (index))
-                    nextClientTime = firstClient->nextCallTime;
+                if (queue.size() > 0)
+                {
+                    TimeSliceClient* const firstClient = queue.getUnchecked (0);
+                    const double now = Time::getMillisecondCounterHiRes();
+
+                    if (firstClient->nextCallTime <= now)
+                    {
+                        client = firstClient;
+                        removeFromQueue (client);
+                        client->callingLock = &callbackLockToUse;
+                        client->callingThread = Thread::getCurrentThreadId();
+                    }
+                    else
+                    {
+                        timeToWait = (int) jmin (500.0, std::ceil (firstClient->nextCallTime - now));
+                    }
+                }
             }
 
-            const Time now (Time::getCurrentTime());
-
-            if (nextClientTime > now)
-            {
-                timeToWait = (int) jmin ((int64) 500, (nextClientTime - now).inMilliseconds());
-            }
-            else
+            if (client != nullptr)
             {
-                timeToWait = index == 0 ? 1 : 0;
+                timeToWait = 0;
 
-                const ScopedLock sl (callbackLock);
+                const double startTime = Time::getMillisecondCounterHiRes();
+                const int msUntilNextCall = client->useTimeSlice();
+                const double endTime = Time::getMillisecondCounterHiRes();
 
-                {
-                    const ScopedLock sl2 (listLock);
-                    clientBeingCalled = getNextClient (index);
-                }
+                const ScopedLock sl2 (listLock);
 
-                if (clientBeingCalled != nullptr)
+                client->callingLock = nullptr;
+                client->callingThread = nullptr;
+
+                // (the client may have removed itself during its callback)
+                if (client->owner == this)
                 {
-                    const int msUntilNextCall = clientBeingCalled->useTimeSlice();
+                    TimeSliceClient::Statistics& stats = client->statistics;
+                    const double lateness = startTime - client->nextCallTime;
+                    const double callTime = endTime - startTime;
+
+                    ++stats.numCalls;
 
-                    const ScopedLock sl2 (listLock);
+                    if (lateness > lateCallTolerance)
+                        ++stats.numLateCalls;
+
+                    stats.maxLatenessMs = jmax (stats.maxLatenessMs, lateness);
+                    stats.totalCallTimeMs += callTime;
+                    stats.maxCallTimeMs = jmax (stats.maxCallTimeMs, callTime);
 
                     if (msUntilNextCall >= 0)
-                        clientBeingCalled->nextCallTime += RelativeTime::milliseconds (msUntilNextCall);
+                    {
+                        // If the client has fallen behind, it goes to the back of the
+                        // queue of clients that are due, rather than trying to catch up.
+                        const double nextTime = client->callAgainSoon ? endTime
+                                                                      : jmax (endTime, client->nextCallTime + msUntilNextCall);
+                        client->callAgainSoon = false;
+                        setNextCallTime (client, nextTime);
+                    }
                     else
-                        clients.removeFirstMatchingValue (clientBeingCalled);
-
-                    clientBeingCalled = nullptr;
+                    {
+                        removeClient (client);
+                    }
                 }
             }
         }
 
         if (timeToWait > 0)
-            wait (timeToWait);
+            thread.wait (timeToWait);
     }
 }
+
+void TimeSliceThread::run()
+{
+    for (int i = 0; i < helperThreads.size(); ++i)
+        helperThreads.getUnchecked(i)->startThread();
+
+    serviceClients (*this, callbackLock);
+
+    for (int i = helperThreads.size(); --i >= 0;)
+        helperThreads.getUnchecked(i)->signalThreadShouldExit();
+
+    for (int i = helperThreads.size(); --i >= 0;)
+        helperThreads.getUnchecked(i)->stopThread (-1);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class TimeSliceThreadTests  : public UnitTest
+{
+public:
+    TimeSliceThreadTests() : UnitTest ("TimeSliceThread") {}
+
+    struct TestClient  : public TimeSliceClient
+    {
+        TestClient (int interval_, int numCallsBeforeStopping_ = -1)
+            : interval (interval_), numCallsBeforeStopping (numCallsBeforeStopping_), overlapped (false)
+        {
+        }
+
+        int useTimeSlice()
+        {
+            if (++isBeingCalled != 1)
+                overlapped = true;
+
+            Thread::yield();
+            --isBeingCalled;
+
+            return ++numCalls == numCallsBeforeStopping ? -1 : interval;
+        }
+
+        const int interval, numCallsBeforeStopping;
+        Atomic<int> numCalls, isBeingCalled;
+        bool overlapped;
+    };
+
+    void runTest()
+    {
+        beginTest ("Scheduling");
+
+        {
+            TimeSliceThread thread ("test", 3);
+            OwnedArray<TestClient> clients;
+
+            for (int i = 0; i < 100; ++i)
+            {
+                clients.add (new TestClient (i < 20 ? 0 : 20));
+                thread.addTimeSliceClient (clients.getLast());
+            }
+
+            TestClient stopper (0, 5), sleeper (100000), removed (0);
+            thread.addTimeSliceClient (&stopper);
+            thread.addTimeSliceClient (&sleeper, 100000);
+            thread.addTimeSliceClient (&removed);
+            expectEquals (thread.getNumClients(), 103);
+
+            const uint32 startTime = Time::getMillisecondCounter();
+            thread.startThread();
+            Thread::sleep (200);
+
+            thread.removeTimeSliceClient (&removed);
+            const int numCallsBeforeRemoval = removed.numCalls.value;
+            thread.moveToFrontOfQueue (&sleeper);
+            Thread::sleep (100);
+
+            thread.stopThread (5000);
+            const int elapsed = (int) (Time::getMillisecondCounter() - startTime);
+
+            for (int i = 0; i < clients.size(); ++i)
+            {
+                TestClient& c = *clients.getUnchecked(i);
+                expect (! c.overlapped);
+                expect (c.numCalls.value > 1);
+
+                if (i >= 20)
+                    expect (c.numCalls.value <= elapsed / 20 + 2);
+            }
+
+            expectEquals (removed.numCalls.value, numCallsBeforeRemoval);
+            expectEquals (stopper.numCalls.value, 5);
+            expectEquals (sleeper.numCalls.value, 1);
+            expectEquals (thread.getNumClients(), 101);
+
+            for (int i = 0; i < clients.size(); ++i)
+                thread.removeTimeSliceClient (clients.getUnchecked(i));
+
+            thread.removeTimeSliceClient (&sleeper);
+            expectEquals (thread.getNumClients(), 0);
+        }
+
+        beginTest ("Statistics");
+
+        {
+            TimeSliceThread thread ("test");
+            TestClient client (5);
+            thread.addTimeSliceClient (&client);
+            thread.startThread();
+            Thread::sleep (100);
+            thread.stopThread (5000);
+
+            const TimeSliceClient::Statistics stats (thread.getClientStatistics (&client));
+            expect (stats.numCalls > 1);
+            expectEquals (stats.numCalls, (int64) client.numCalls.value);
+            expect (stats.maxCallTimeMs >= 0 && stats.totalCallTimeMs >= 0);
+
+            thread.resetClientStatistics();
+            expectEquals (thread.getClientStatistics (&client).numCalls, (int64) 0);
+
+            thread.removeTimeSliceClient (&client);
+            expectEquals (thread.getClientStatistics (&client).numCalls, (int64) 0);
+        }
+    }
+};
+
+static TimeSliceThreadTests timeSliceThreadTests;
+
+#endif
@@ -28,6 +28,7 @@
 
 #include "juce_Thread.h"
 #include "../containers/juce_Array.h"
+#include "../containers/juce_OwnedArray.h"
 #include "../time/juce_Time.h"
 class TimeSliceThread;
 
@@ -67,10 +68,45 @@ public:
     */
     virtual int useTimeSlice() = 0;
 
+    //==============================================================================
+    /** Some timing statistics about the calls that a TimeSliceThread has made to a client.
+        @see TimeSliceThread::getClientStatistics
+    */
+    struct Statistics
+    {
+        /** The number of times that useTimeSlice() has been called. */
+        int64 numCalls;
+
+        /** The number of calls which started later than the time that the client asked
+            for by more than the thread's tolerance.
+            @see TimeSliceThread::setLateCallTolerance
+        */
+        int64 numLateCalls;
+
+        /** The largest delay between the time a call was due and when it started, in milliseconds. */
+        double maxLatenessMs;
+
+        /** The total time spent inside useTimeSlice(), in milliseconds. */
+        double totalCallTimeMs;
+
+        /** The longest time that a single call to useTimeSlice() has taken, in milliseconds. */
+        double maxCallTimeMs;
+    };
+
+protected:
+    /** Creates a client. */
+    TimeSliceClient() noexcept;
 
 private:
     friend class TimeSliceThread;
-    Time nextCallTime;
+    TimeSliceThread* owner;
+    const CriticalSection* callingLock;
+    Thread::ThreadID callingThread;
+    double nextCallTime;
+    uint32 queueOrder;
+    int queueIndex;
+    bool callAgainSoon;
+    Statistics statistics;
 };
 
 
@@ -79,6 +115,12 @@ private:
     A thread that keeps a list of clients, and calls each one in turn, giving them
     all a chance to run some sort of short task.
 
+    The clients are kept in a queue which is sorted by the time at which each one is
+    next due to be called, so a thread can handle large numbers of clients without
+    having to keep checking the ones that aren't ready. If the clients need more time
+    than one thread can give them, the thread can be given some extra helper threads,
+    which will share the work.
+
     @see TimeSliceClient, Thread
 */
 class JUCE_API  TimeSliceThread   : public Thread
@@ -90,8 +132,12 @@ public:
 
         When first created, the thread is not running. Use the startThread()
         method to start it.
+
+        If numberOfThreads is more than 1, the extra threads are started and stopped
+        along with this one, and they'll all share the job of calling the clients. A
+        client will never be called by more than one thread at a time.
     */
-    explicit TimeSliceThread (const String& threadName);
+    explicit TimeSliceThread (const String& threadName, int numberOfThreads = 1);
 
     /** Destructor.
 
@@ -129,6 +175,20 @@ public:
     /** Returns one of the registered clients. */
     TimeSliceClient* getClient (int index) const;
 
+    //==============================================================================
+    /** Returns the timing statistics for one of this thread's clients.
+        If the client hasn't been added to this thread, this returns all zeros.
+    */
+    TimeSliceClient::Statistics getClientStatistics (TimeSliceClient* client) const;
+
+    /** Resets the timing statistics for all the clients. */
+    void resetClientStatistics();
+
+    /** Sets how many milliseconds after its due time a call can start before it's
+        counted as being late in the client's statistics. The default is 10ms.
+    */
+    void setLateCallTolerance (int milliseconds);
+
     //==============================================================================
    #ifndef DOXYGEN
     void run();
@@ -136,11 +196,24 @@ public:
 
     //==============================================================================
 private:
-    CriticalSection callbackLock, listLock;
-    Array <TimeSliceClient*> clients;
-    TimeSliceClient* clientBeingCalled;
+    class HelperThread;
+    friend class HelperThread;
 
-    TimeSliceClient* getNextClient (int index) const;
+    CriticalSection callbackLock, listLock;
+    Array <TimeSliceClient*> clients, queue;
+    OwnedArray<HelperThread> helperThreads;
+    uint32 nextQueueOrder;
+    double lateCallTolerance;
+
+    void serviceClients (Thread&, const CriticalSection&);
+    void notifyAllThreads();
+    void removeClient (TimeSliceClient*);
+    void setNextCallTime (TimeSliceClient*, double time);
+    void addToQueue (TimeSliceClient*);
+    void removeFromQueue (TimeSliceClient*);
+    void moveUp (int index);
+    void moveDown (int index);
+    static bool isDueBefore (const TimeSliceClient*, const TimeSliceClient*) noexcept;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimeSliceThread)
 };
@@ -0,0 +1,188 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+TimingHistory::TimingHistory (const int numMeasurementsToKeep)
+    : capacity (jmax (1, numMeasurementsToKeep))
+{
+    measurements.calloc ((size_t) capacity);
+}
+
+TimingHistory::~TimingHistory()
+{
+}
+
+//==============================================================================
+void TimingHistory::addMeasurement (const int64 numTicks) noexcept
+{
+    const int64 index = numAdded.get();
+
+    measurements [(int) (index % capacity)] = numTicks;
+    totalTicks += numTicks;
+    numAdded = index + 1;
+}
+
+void TimingHistory::reset() noexcept
+{
+    // The writing thread never sees this - readers just ignore everything
+    // that was added before the point at which we were reset.
+    resetTicks = totalTicks.get();
+    resetCount = numAdded.get();
+}
+
+int64 TimingHistory::getNumMeasurements() const noexcept
+{
+    return numAdded.get() - resetCount.get();
+}
+
+double TimingHistory::getTotalTime() const noexcept
+{
+    return Time::highResolutionTicksToSeconds (totalTicks.get() - resetTicks.get());
+}
+
+//==============================================================================
+TimingHistory::Statistics TimingHistory::getStatistics() const
+{
+    Statistics s;
+    zerostruct (s);
+
+    const int64 countBefore = numAdded.get();
+    const int64 firstIndex = jmax (countBefore - capacity, resetCount.get());
+
+    s.numMeasurements = countBefore - resetCount.get();
+    s.totalTime = getTotalTime();
+
+    if (countBefore <= firstIndex)
+        return s;
+
+    HeapBlock<int64> window ((size_t) (countBefore - firstIndex));
+
+    for (int64 i = firstIndex; i < countBefore; ++i)
+        window [(int) (i - firstIndex)] = measurements [(int) (i % capacity)];
+
+    // Any slots that the writer has reached while we were copying may have been
+    // overwritten, so only trust the ones that are still older than its position.
+    const int64 firstValid = jmax (firstIndex, numAdded.get() - capacity);
+    const int numValid = (int) (countBefore - firstValid);
+
+    if (numValid <= 0)
+        return s;
+
+    int64* const values = window + (firstValid - firstIndex);
+    DefaultElementComparator<int64> comparator;
+    sortArray (comparator, values, 0, numValid - 1, false);
+
+    int64 sum = 0;
+    for (int i = 0; i < numValid; ++i)
+        sum += values[i];
+
+    s.numInWindow = numValid;
+    s.minimum = Time::highResolutionTicksToSeconds (values[0]);
+    s.maximum = Time::highResolutionTicksToSeconds (values [numValid - 1]);
+    s.average = Time::highResolutionTicksToSeconds (sum) / numValid;
+    s.percentile50 = Time::highResolutionTicksToSeconds (values [roundToInt (0.50 * (numValid - 1))]);
+    s.percentile90 = Time::highResolutionTicksToSeconds (values [roundToInt (0.90 * (numValid - 1))]);
+    s.percentile99 = Time::highResolutionTicksToSeconds (values [roundToInt (0.99 * (numValid - 1))]);
+
+    return s;
+}
+
+TimingHistory::Statistics TimingHistory::Statistics::getAsProportionOf (const double periodInSeconds) const noexcept
+{
+    Statistics s (*this);
+
+    if (periodInSeconds > 0)
+    {
+        const double scale = 1.0 / periodInSeconds;
+
+        s.totalTime *= scale;
+        s.minimum *= scale;
+        s.average *= scale;
+        s.maximum *= scale;
+        s.percentile50 *= scale;
+        s.percentile90 *= scale;
+        s.percentile99 *= scale;
+    }
+
+    return s;
+}
+
+//==============================================================================
+TimingHistory::ScopedMeasurement::ScopedMeasurement (TimingHistory& history_) noexcept
+    : history (history_), startTicks (Time::getHighResolutionTicks())
+{
+}
+
+TimingHistory::ScopedMeasurement::~ScopedMeasurement() noexcept
+{
+    history.addMeasurement (Time::getHighResolutionTicks() - startTicks);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class TimingHistoryTests  : public UnitTest
+{
+public:
+    TimingHistoryTests() : UnitTest ("TimingHistory") {}
+
+    void runTest()
+    {
+        const double tick = Time::highResolutionTicksToSeconds (1);
+
+        beginTest ("Statistics");
+
+        TimingHistory history (100);
+        expectEquals (history.getStatistics().numInWindow, 0);
+
+        for (int i = 1; i <= 250; ++i)
+            history.addMeasurement (i);
+
+        TimingHistory::Statistics s (history.getStatistics());
+        expectEquals (s.numMeasurements, (int64) 250);
+        expectEquals (s.numInWindow, 100);
+        expect (std::abs (s.minimum - 151 * tick) < tick * 0.01);
+        expect (std::abs (s.maximum - 250 * tick) < tick * 0.01);
+        expect (std::abs (s.average - 200.5 * tick) < tick * 0.01);
+        expect (std::abs (s.percentile90 - 240 * tick) < tick * 0.01);
+        expect (std::abs (s.totalTime - 31375 * tick) < tick * 0.01);
+
+        beginTest ("Reset");
+
+        history.reset();
+        expectEquals (history.getStatistics().numInWindow, 0);
+        expectEquals (history.getNumMeasurements(), (int64) 0);
+
+        history.addMeasurement (10);
+        history.addMeasurement (20);
+        s = history.getStatistics();
+        expectEquals (s.numInWindow, 2);
+        expect (std::abs (s.maximum - 20 * tick) < tick * 0.01);
+        expect (std::abs (history.getTotalTime() - 30 * tick) < tick * 0.01);
+    }
+};
+
+static TimingHistoryTests timingHistoryTests;
+
+#endif
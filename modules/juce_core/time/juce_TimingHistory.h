@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_TIMINGHISTORY_JUCEHEADER__
+#define __JUCE_TIMINGHISTORY_JUCEHEADER__
+
+#include "../memory/juce_Atomic.h"
+#include "../memory/juce_HeapBlock.h"
+
+
+//==============================================================================
+/**
+    Keeps a rolling history of the durations of some repeated task, so that they
+    can be summarised without disturbing the thread that's being measured.
+
+    A single thread (e.g. an audio callback) adds measurements with addMeasurement()
+    or a ScopedMeasurement. This never blocks or allocates, so it's safe to use in
+    realtime code. Any other thread - typically the message thread - can then call
+    getStatistics() to find the min, average, max and percentiles of the most recent
+    measurements.
+
+    e.g. @code
+    void processBlock (AudioSampleBuffer& buffer, MidiBuffer& midi)
+    {
+        const TimingHistory::ScopedMeasurement sm (processTiming);
+        ...
+    }
+
+    // ..and later, on the message thread:
+    const TimingHistory::Statistics stats (processTiming.getStatistics());
+    @endcode
+
+    @see PerformanceCounter
+*/
+class JUCE_API  TimingHistory
+{
+public:
+    //==============================================================================
+    /** Creates a history which keeps the given number of recent measurements. */
+    explicit TimingHistory (int numMeasurementsToKeep = 256);
+
+    /** Destructor. */
+    ~TimingHistory();
+
+    //==============================================================================
+    /** Adds a measurement, in high-resolution ticks.
+
+        Only one thread may add measurements at a time, but other threads can read
+        the statistics while this is happening.
+        @see Time::getHighResolutionTicks
+    */
+    void addMeasurement (int64 numTicks) noexcept;
+
+    /** Discards all the measurements made so far.
+        This doesn't interfere with the thread that is adding measurements, so it can
+        be called at any time from the thread that reads the statistics.
+    */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** A summary of the measurements in a TimingHistory.
+        All of the times are in seconds.
+    */
+    struct JUCE_API  Statistics
+    {
+        /** The number of measurements added since the history was created or reset. */
+        int64 numMeasurements;
+
+        /** The sum of all the measurements since the history was created or reset. */
+        double totalTime;
+
+        /** The number of recent measurements that the other values are taken from. */
+        int numInWindow;
+
+        double minimum;         /**< The shortest recent measurement. */
+        double average;         /**< The mean of the recent measurements. */
+        double maximum;         /**< The longest recent measurement. */
+        double percentile50;    /**< The median of the recent measurements. */
+        double percentile90;    /**< The 90th percentile of the recent measurements. */
+        double percentile99;    /**< The 99th percentile of the recent measurements. */
+
+        /** Returns a copy of these statistics with each duration divided by the given period.
+
+            This is handy for turning the time taken by a callback into a proportion of the
+            time that was available, e.g. the length of an audio block.
+        */
+        Statistics getAsProportionOf (double periodInSeconds) const noexcept;
+    };
+
+    /** Returns a summary of the most recent measurements.
+        This can be called from any thread other than the one that's adding measurements,
+        but not from more than one thread at a time.
+    */
+    Statistics getStatistics() const;
+
+    /** Returns the number of measurements added since the history was created or reset. */
+    int64 getNumMeasurements() const noexcept;
+
+    /** Returns the sum of all the measurements since the history was created or reset, in seconds. */
+    double getTotalTime() const noexcept;
+
+    //==============================================================================
+    /**
+        Measures the time between its construction and destruction, and adds it to a
+        TimingHistory.
+    */
+    class JUCE_API  ScopedMeasurement
+    {
+    public:
+        /** Starts timing. */
+        explicit ScopedMeasurement (TimingHistory& history) noexcept;
+
+        /** Stops timing, and adds the measurement to the history. */
+        ~ScopedMeasurement() noexcept;
+
+    private:
+        TimingHistory& history;
+        const int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedMeasurement)
+    };
+
+private:
+    //==============================================================================
+    HeapBlock<int64> measurements;
+    const int capacity;
+    Atomic<int64> numAdded, totalTicks, resetCount, resetTicks;
+
+    JUCE_DECLARE_NON_COPYABLE (TimingHistory)
+};
+
+
+#endif   // __JUCE_TIMINGHISTORY_JUCEHEADER__
@@ -63,6 +63,75 @@ void XmlDocument::setEmptyTextElementsIgnored (const bool shouldBeIgnored) noexc
     ignoreEmptyTextElements = shouldBeIgnored;
 }
 
+namespace XmlEntityHelpers
+{
+    /* Returns the character that one of the predefined entities or a numeric character
+       reference stands for, given the text between its '&' and ';', or 0 if it's neither.
+       This is shared by XmlDocument and XmlStreamParser.
+    */
+    template <typename CharPointerType>
+    static juce_wchar getCharacterForEntity (CharPointerType name, const CharPointerType end) noexcept
+    {
+        const int length = (int) (end.getAddress() - name.getAddress());
+
+        if (length > 1 && *name == '#')
+        {
+            uint32 charCode = 0;
+            const juce_wchar c = *++name;
+
+            if (c == 'x' || c == 'X')
+            {
+                if (length > 10)
+                    return 0;
+
+                while ((++name).getAddress() < end.getAddress())
+                {
+                    const int hexValue = CharacterFunctions::getHexDigitValue (*name);
+
+                    if (hexValue < 0)
+                        return 0;
+
+                    charCode = (charCode << 4) | (uint32) hexValue;
+                }
+            }
+            else
+            {
+                if (length > 11)
+                    return 0;
+
+                for (; name.getAddress() < end.getAddress(); ++name)
+                {
+                    const juce_wchar digit = *name;
+
+                    if (digit < '0' || digit > '9')
+                        return 0;
+
+                    charCode = charCode * 10 + (uint32) (digit - '0');
+                }
+            }
+
+            return (juce_wchar) charCode;
+        }
+
+        if (length == 2)
+        {
+            if (name.compareIgnoreCaseUpTo (CharPointer_ASCII ("lt"), 2) == 0)    return '<';
+            if (name.compareIgnoreCaseUpTo (CharPointer_ASCII ("gt"), 2) == 0)    return '>';
+        }
+        else if (length == 3)
+        {
+            if (name.compareIgnoreCaseUpTo (CharPointer_ASCII ("amp"), 3) == 0)   return '&';
+        }
+        else if (length == 4)
+        {
+            if (name.compareIgnoreCaseUpTo (CharPointer_ASCII ("quot"), 4) == 0)  return '"';
+            if (name.compareIgnoreCaseUpTo (CharPointer_ASCII ("apos"), 4) == 0)  return '\'';
+        }
+
+        return 0;
+    }
+}
+
 namespace XmlIdentifierChars
 {
     static bool isIdentifierCharSlow (const juce_wchar c) noexcept
@@ -714,22 +783,14 @@ void XmlDocument::readEntity (String& result)
 
 String XmlDocument::expandEntity (const String& ent)
 {
-    if (ent.equalsIgnoreCase ("amp"))   return String::charToString ('&');
-    if (ent.equalsIgnoreCase ("quot"))  return String::charToString ('"');
-    if (ent.equalsIgnoreCase ("apos"))  return String::charToString ('\'');
-    if (ent.equalsIgnoreCase ("lt"))    return String::charToString ('<');
-    if (ent.equalsIgnoreCase ("gt"))    return String::charToString ('>');
+    const String::CharPointerType name (ent.getCharPointer());
+    const juce_wchar c = XmlEntityHelpers::getCharacterForEntity (name, name.findTerminatingNull());
+
+    if (c != 0)
+        return String::charToString (c);
 
     if (ent[0] == '#')
     {
-        const juce_wchar char1 = ent[1];
-
-        if (char1 == 'x' || char1 == 'X')
-            return String::charToString (static_cast <juce_wchar> (ent.substring (2).getHexValue32()));
-
-        if (char1 >= '0' && char1 <= '9')
-            return String::charToString (static_cast <juce_wchar> (ent.substring (1).getIntValue()));
-
         setLastError ("illegal escape sequence", false);
         return String::charToString ('&');
     }
@@ -161,6 +161,8 @@ private:
     bool needToLoadDTD, ignoreEmptyTextElements;
     ScopedPointer <InputSource> inputSource;
 
+    friend class XmlStreamParser;
+
     void setLastError (const String& desc, bool carryOn);
     void skipHeader();
     void skipNextWhiteSpace();
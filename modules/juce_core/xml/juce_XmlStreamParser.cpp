@@ -0,0 +1,826 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+String XmlStreamParser::Attributes::getValue (const String& attributeName, const String& defaultReturnValue) const
+{
+    for (int i = 0; i < names.size(); ++i)
+        if (names.getReference(i) == attributeName)
+            return values.getReference(i);
+
+    return defaultReturnValue;
+}
+
+bool XmlStreamParser::Attributes::contains (const String& attributeName) const noexcept
+{
+    for (int i = 0; i < names.size(); ++i)
+        if (names.getReference(i) == attributeName)
+            return true;
+
+    return false;
+}
+
+//==============================================================================
+XmlStreamParser::XmlStreamParser (Listener& listener_)
+    : listener (listener_),
+      input (nullptr),
+      buffer ((size_t) bufferSize),
+      bufferStart (0),
+      bufferEnd (0),
+      endOfInput (true),
+      shouldStop (false),
+      errorOccurred (false),
+      ignoreEmptyTextElements (true),
+      userSuppliedInputSource (false),
+      entityResolver (String::empty)
+{
+}
+
+XmlStreamParser::~XmlStreamParser()
+{
+}
+
+void XmlStreamParser::setInputSource (InputSource* const newSource) noexcept
+{
+    entityResolver.setInputSource (newSource);
+    userSuppliedInputSource = (newSource != nullptr);
+}
+
+void XmlStreamParser::setEmptyTextElementsIgnored (const bool shouldBeIgnored) noexcept
+{
+    ignoreEmptyTextElements = shouldBeIgnored;
+}
+
+void XmlStreamParser::stop() noexcept
+{
+    shouldStop = true;
+}
+
+const String& XmlStreamParser::getLastParseError() const noexcept
+{
+    return lastError;
+}
+
+int XmlStreamParser::getCurrentDepth() const noexcept
+{
+    return openElements.size();
+}
+
+void XmlStreamParser::setLastError (const String& desc, const bool carryOn)
+{
+    lastError = desc;
+
+    if (! carryOn)
+        errorOccurred = true;
+}
+
+//==============================================================================
+bool XmlStreamParser::parse (const File& file)
+{
+    if (! userSuppliedInputSource)
+        entityResolver.setInputSource (new FileInputSource (file));
+
+    FileInputStream in (file);
+    return parse (in);
+}
+
+bool XmlStreamParser::parse (const String& xmlText)
+{
+    MemoryInputStream in (xmlText.toRawUTF8(), xmlText.getNumBytesAsUTF8(), false);
+    return parse (in);
+}
+
+bool XmlStreamParser::parse (InputStream& in)
+{
+    input = &in;
+    bufferStart = bufferEnd = 0;
+    endOfInput = false;
+    shouldStop = false;
+    errorOccurred = false;
+    lastError = String::empty;
+    openElements.clear();
+
+    entityResolver.dtdText = String::empty;
+    entityResolver.tokenisedDTD.clear();
+    entityResolver.needToLoadDTD = true;
+    entityResolver.errorOccurred = false;
+
+    const bool ok = parseDocument();
+    input = nullptr;
+
+    return ok && ! errorOccurred;
+}
+
+bool XmlStreamParser::parseDocument()
+{
+    if (matches ("\xef\xbb\xbf")) // skip a UTF-8 byte-order mark
+        bufferStart += 3;
+
+    skipComments();
+
+    if (matches ("<!DOCTYPE"))
+    {
+        bufferStart += 9;
+
+        if (! readDocType())
+        {
+            setLastError ("not enough input", false);
+            return false;
+        }
+
+        skipComments();
+    }
+
+    // like XmlDocument, ignore any junk before the first tag..
+    if (! skipUntil ("<"))
+    {
+        setLastError ("not enough input", false);
+        return false;
+    }
+
+    if (! readStartTag())
+        return false;
+
+    while (openElements.size() > 0 && ! shouldStop)
+    {
+        const int c = peek();
+
+        if (c < 0)
+        {
+            setLastError ("unmatched tags", false);
+            return false;
+        }
+
+        if (c == '<')
+        {
+            const int c1 = peek (1);
+
+            if (c1 == '/')
+            {
+                bufferStart += 2;
+
+                if (! readEndTag())
+                    return false;
+            }
+            else if (matches ("<![CDATA["))
+            {
+                bufferStart += 9;
+
+                if (! readCData())
+                    return false;
+            }
+            else if (c1 == '!' || c1 == '?')
+            {
+                // comments, processing instructions and other declarations are skipped
+                const bool ok = matches ("<!--") ? skipUntil ("-->")
+                                                 : (c1 == '?' ? skipUntil ("?>") : skipUntil (">"));
+
+                if (! ok)
+                {
+                    setLastError ("unmatched tags", false);
+                    return false;
+                }
+            }
+            else
+            {
+                ++bufferStart;
+
+                if (! readStartTag())
+                    return false;
+            }
+        }
+        else
+        {
+            if (! readText())
+                return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+bool XmlStreamParser::ensureAvailable (const int numBytes)
+{
+    jassert (numBytes <= (int) bufferSize);
+
+    if (bufferEnd - bufferStart >= numBytes)
+        return true;
+
+    if (endOfInput)
+        return false;
+
+    const int remaining = bufferEnd - bufferStart;
+    memmove (buffer, buffer + bufferStart, (size_t) remaining);
+    bufferStart = 0;
+    bufferEnd = remaining;
+
+    while (bufferEnd < numBytes)
+    {
+        const int bytesRead = input->read (buffer + bufferEnd, (int) bufferSize - bufferEnd);
+
+        if (bytesRead <= 0)
+        {
+            endOfInput = true;
+            break;
+        }
+
+        bufferEnd += bytesRead;
+    }
+
+    return bufferEnd >= numBytes;
+}
+
+int XmlStreamParser::peek (const int offset)
+{
+    return ensureAvailable (offset + 1) ? (int) (uint8) buffer [bufferStart + offset] : -1;
+}
+
+bool XmlStreamParser::matches (const char* const text)
+{
+    const int len = (int) strlen (text);
+    return ensureAvailable (len) && memcmp (buffer + bufferStart, text, (size_t) len) == 0;
+}
+
+String XmlStreamParser::getTokenAsString() const
+{
+    return String::fromUTF8 (static_cast <const char*> (token.getData()), (int) token.getDataSize());
+}
+
+void XmlStreamParser::skipWhiteSpace()
+{
+    for (;;)
+    {
+        const int c = peek();
+
+        if (c <= 0 || c > ' ')
+            break;
+
+        ++bufferStart;
+    }
+}
+
+bool XmlStreamParser::skipUntil (const char* const terminator)
+{
+    const int len = (int) strlen (terminator);
+
+    while (ensureAvailable (len))
+    {
+        const char* const data = buffer + bufferStart;
+        const int numToCheck = bufferEnd - bufferStart - (len - 1);
+
+        for (int i = 0; i < numToCheck; ++i)
+        {
+            if (data[i] == terminator[0] && memcmp (data + i, terminator, (size_t) len) == 0)
+            {
+                bufferStart += i + len;
+                return true;
+            }
+        }
+
+        // keep any bytes that could be the start of a partial match..
+        bufferStart += numToCheck;
+    }
+
+    bufferStart = bufferEnd;
+    return false;
+}
+
+void XmlStreamParser::skipComments()
+{
+    for (;;)
+    {
+        skipWhiteSpace();
+
+        if (matches ("<!--"))
+        {
+            if (! skipUntil ("-->"))
+                return;
+        }
+        else if (matches ("<?"))
+        {
+            if (! skipUntil ("?>"))
+                return;
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+bool XmlStreamParser::readDocType()
+{
+    token.reset();
+
+    for (int depth = 1;;)
+    {
+        const int c = peek();
+
+        if (c < 0)
+            return false;
+
+        ++bufferStart;
+
+        if (c == '<')
+        {
+            ++depth;
+        }
+        else if (c == '>')
+        {
+            if (--depth == 0)
+                break;
+        }
+
+        token.writeByte ((char) c);
+    }
+
+    entityResolver.dtdText = getTokenAsString().trim();
+    return true;
+}
+
+bool XmlStreamParser::readName (String& result)
+{
+    token.reset();
+
+    while (ensureAvailable (1))
+    {
+        const char* const data = buffer + bufferStart;
+        const int num = bufferEnd - bufferStart;
+        int i = 0;
+
+        // non-ascii characters are all accepted as part of a name
+        while (i < num && ((uint8) data[i] >= 0x80 || XmlIdentifierChars::isIdentifierChar ((juce_wchar) data[i])))
+            ++i;
+
+        token.write (data, (size_t) i);
+        bufferStart += i;
+
+        if (i < num)
+            break;
+    }
+
+    if (token.getDataSize() == 0)
+        return false;
+
+    result = getTokenAsString();
+    return true;
+}
+
+bool XmlStreamParser::readStartTag()
+{
+    skipWhiteSpace(); // (XmlDocument allows a gap after the '<')
+
+    String tagName;
+
+    if (! readName (tagName))
+    {
+        setLastError ("tag name missing", false);
+        return false;
+    }
+
+    attributes.names.clearQuick();
+    attributes.values.clearQuick();
+
+    for (;;)
+    {
+        skipWhiteSpace();
+
+        const int c = peek();
+
+        // empty tag..
+        if (c == '/' && peek (1) == '>')
+        {
+            bufferStart += 2;
+            openElements.add (tagName);
+            listener.elementStarted (tagName, attributes);
+            openElements.remove (openElements.size() - 1);
+            listener.elementFinished (tagName);
+            return true;
+        }
+
+        if (c == '>')
+        {
+            ++bufferStart;
+            openElements.add (tagName);
+            listener.elementStarted (tagName, attributes);
+            return true;
+        }
+
+        // get an attribute..
+        String attributeName;
+
+        if (c > 0 && readName (attributeName))
+        {
+            skipWhiteSpace();
+
+            if (peek() == '=')
+            {
+                ++bufferStart;
+                skipWhiteSpace();
+
+                const int quote = peek();
+
+                if (quote == '"' || quote == '\'')
+                {
+                    String value;
+
+                    if (! readQuotedString (value))
+                        return false;
+
+                    attributes.names.add (attributeName);
+                    attributes.values.add (value);
+                    continue;
+                }
+            }
+        }
+
+        const int badChar = peek();
+
+        if (badChar < 0)
+            setLastError ("unmatched tags", false);
+        else
+            setLastError ("illegal character found in " + tagName + ": '" + String::charToString ((juce_wchar) badChar) + "'", false);
+
+        return false;
+    }
+}
+
+bool XmlStreamParser::readEndTag()
+{
+    if (! skipUntil (">"))
+    {
+        setLastError ("unmatched tags", false);
+        return false;
+    }
+
+    // (like XmlDocument, this doesn't check that the tag name matches)
+    const String tagName (openElements [openElements.size() - 1]);
+    openElements.remove (openElements.size() - 1);
+    listener.elementFinished (tagName);
+    return true;
+}
+
+bool XmlStreamParser::readText()
+{
+    token.reset();
+    bool containsNonWhitespace = false;
+
+    for (;;)
+    {
+        if (! ensureAvailable (1))
+        {
+            setLastError ("unmatched tags", false);
+            return false;
+        }
+
+        const char* const data = buffer + bufferStart;
+        const int num = bufferEnd - bufferStart;
+        int i = 0;
+
+        for (; i < num; ++i)
+        {
+            const char c = data[i];
+
+            if (c == '<' || c == '&')
+                break;
+
+            if ((uint8) c > ' ')
+                containsNonWhitespace = true;
+        }
+
+        token.write (data, (size_t) i);
+        bufferStart += i;
+
+        if (i < num)
+        {
+            if (data[i] == '<')
+                break;
+
+            readEntity();
+            containsNonWhitespace = true;
+
+            if (errorOccurred)
+                return false;
+        }
+    }
+
+    if (containsNonWhitespace || ! ignoreEmptyTextElements)
+        listener.textFound (getTokenAsString());
+
+    return true;
+}
+
+bool XmlStreamParser::readCData()
+{
+    token.reset();
+
+    for (;;)
+    {
+        if (! ensureAvailable (3))
+        {
+            setLastError ("unterminated CDATA section", false);
+            return false;
+        }
+
+        const char* const data = buffer + bufferStart;
+        const int numToCheck = bufferEnd - bufferStart - 2;
+        int i = 0;
+
+        while (i < numToCheck && ! (data[i] == ']' && data[i + 1] == ']' && data[i + 2] == '>'))
+            ++i;
+
+        token.write (data, (size_t) i);
+        bufferStart += i;
+
+        if (i < numToCheck)
+        {
+            bufferStart += 3;
+            break;
+        }
+    }
+
+    listener.textFound (getTokenAsString());
+    return true;
+}
+
+bool XmlStreamParser::readQuotedString (String& result)
+{
+    const char quote = (char) peek();
+    ++bufferStart;
+    token.reset();
+
+    for (;;)
+    {
+        if (! ensureAvailable (1))
+        {
+            setLastError ("unmatched quotes", false);
+            return false;
+        }
+
+        const char* const data = buffer + bufferStart;
+        const int num = bufferEnd - bufferStart;
+        int i = 0;
+
+        while (i < num && data[i] != quote && data[i] != '&')
+            ++i;
+
+        token.write (data, (size_t) i);
+        bufferStart += i;
+
+        if (i < num)
+        {
+            if (data[i] == quote)
+            {
+                ++bufferStart;
+                break;
+            }
+
+            readEntity();
+
+            if (errorOccurred)
+                return false;
+        }
+    }
+
+    result = getTokenAsString();
+    return true;
+}
+
+void XmlStreamParser::readEntity()
+{
+    // skip over the ampersand
+    ++bufferStart;
+
+    int length = 0;
+
+    for (;; ++length)
+    {
+        const int c = peek (length);
+
+        if (c == ';')
+            break;
+
+        if (c <= ' ' || c == '<' || c == '&' || length >= (int) maxEntityNameLength)
+        {
+            setLastError ("illegal escape sequence", true);
+            token.writeByte ('&');
+            return;
+        }
+    }
+
+    const CharPointer_UTF8 name (buffer + bufferStart);
+    const juce_wchar c = XmlEntityHelpers::getCharacterForEntity (name, name + length);
+
+    if (c != 0)
+    {
+        char utf8[8];
+        CharPointer_UTF8 dest (utf8);
+        dest.write (c);
+        token.write (utf8, (size_t) (dest.getAddress() - utf8));
+    }
+    else
+    {
+        const String entityName (String::fromUTF8 (buffer + bufferStart, length));
+
+        if (entityName[0] == '#')
+        {
+            setLastError ("illegal escape sequence", true);
+            token.writeByte ('&');
+            return;
+        }
+
+        const String expanded (entityResolver.expandExternalEntity (entityName));
+
+        if (entityResolver.lastError.isNotEmpty())
+        {
+            setLastError (entityResolver.lastError, ! entityResolver.errorOccurred);
+            entityResolver.lastError = String::empty;
+        }
+
+        token.write (expanded.toRawUTF8(), expanded.getNumBytesAsUTF8());
+    }
+
+    bufferStart += length + 1;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class XmlStreamParserTests  : public UnitTest
+{
+public:
+    XmlStreamParserTests() : UnitTest ("XmlStreamParser") {}
+
+    // Rebuilds an XmlElement tree from the parser's events, so it can be compared with XmlDocument's
+    struct TreeBuilder  : public XmlStreamParser::Listener
+    {
+        void elementStarted (const String& tagName, const XmlStreamParser::Attributes& atts)
+        {
+            XmlElement* const e = new XmlElement (tagName);
+
+            for (int i = 0; i < atts.size(); ++i)
+                e->setAttribute (atts.getName (i), atts.getValue (i));
+
+            if (stack.size() > 0)
+                stack.getLast()->addChildElement (e);
+            else
+                root = e;
+
+            stack.add (e);
+        }
+
+        void elementFinished (const String& tagName)
+        {
+            jassert (stack.getLast()->hasTagName (tagName));
+            stack.removeLast();
+        }
+
+        void textFound (const String& text)
+        {
+            stack.getLast()->addTextElement (text);
+        }
+
+        ScopedPointer<XmlElement> root;
+        Array<XmlElement*> stack;
+    };
+
+    // An input stream that only returns a few bytes at a time, to exercise the buffer boundaries
+    struct TrickleInputStream  : public MemoryInputStream
+    {
+        TrickleInputStream (const String& text)
+            : MemoryInputStream (text.toRawUTF8(), text.getNumBytesAsUTF8(), true), counter (0)
+        {
+        }
+
+        int read (void* dest, int numBytes)
+        {
+            return MemoryInputStream::read (dest, jmin (numBytes, 1 + (counter++ % 7)));
+        }
+
+        int counter;
+    };
+
+    static String createRandomText (Random& r)
+    {
+        static const char* const chunks[] = { "abc", " ", "&amp;", "&lt;", "\xc2\xa3", "&#x20AC;", "&#65;", "\"", "xyz" };
+
+        String s;
+
+        for (int i = r.nextInt (20); --i >= 0;)
+            s << String::fromUTF8 (chunks [r.nextInt (numElementsInArray (chunks))]);
+
+        return s;
+    }
+
+    static void createRandomElement (Random& r, String& out, const int depth)
+    {
+        const String tag ("tag" + String (r.nextInt (5)));
+        out << "<" << tag;
+
+        for (int i = r.nextInt (4); --i >= 0;)
+            out << " att" << i << "=\"" << createRandomText (r).replace ("\"", "&quot;") << "\"";
+
+        if (depth > 5 || r.nextInt (5) == 0)
+        {
+            out << "/>";
+            return;
+        }
+
+        out << ">";
+
+        for (int i = r.nextInt (6); --i >= 0;)
+        {
+            switch (r.nextInt (4))
+            {
+                case 0:     out << createRandomText (r).replace ("\"", "x") << " "; break;
+                case 1:     out << "<![CDATA[a <b> & ]] c]]>"; break;
+                case 2:     out << "<!-- a comment -->"; createRandomElement (r, out, depth + 1); break;
+                default:    createRandomElement (r, out, depth + 1); break;
+            }
+        }
+
+        out << "</" << tag << ">";
+    }
+
+    void runTest()
+    {
+        beginTest ("Basics");
+
+        {
+            TreeBuilder builder;
+            XmlStreamParser parser (builder);
+
+            expect (parser.parse (String ("<?xml version=\"1.0\"?>\n<!-- comment -->\n"
+                                          "<A x=\"1 &amp; 2\" y='&#x41;&#66;'>hello &lt;there&gt;<B/><![CDATA[<raw>]]></A>")));
+            expect (builder.root != nullptr && builder.root->hasTagName ("A"));
+            expectEquals (builder.root->getStringAttribute ("x"), String ("1 & 2"));
+            expectEquals (builder.root->getStringAttribute ("y"), String ("AB"));
+            expectEquals (builder.root->getNumChildElements(), 3);
+            expectEquals (builder.root->getChildElement (0)->getText(), String ("hello <there>"));
+            expect (builder.root->getChildElement (1)->hasTagName ("B"));
+            expectEquals (builder.root->getChildElement (2)->getText(), String ("<raw>"));
+        }
+
+        {
+            TreeBuilder builder;
+            XmlStreamParser parser (builder);
+            expect (! parser.parse (String ("<A><B></B>")));
+            expectEquals (parser.getLastParseError(), String ("unmatched tags"));
+            expect (! parser.parse (String::empty));
+            expect (! parser.parse (String ("<A x=\"unterminated></A>")));
+        }
+
+        {
+            TreeBuilder builder;
+            XmlStreamParser parser (builder);
+            expect (parser.parse (String ("<!DOCTYPE A [ <!ENTITY foo \"bar\"> ]><A>&foo;</A>")));
+            expectEquals (builder.root->getAllSubText(), String ("bar"));
+        }
+
+        beginTest ("Comparison with XmlDocument");
+
+        Random r;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            String doc;
+            createRandomElement (r, doc, 0);
+
+            ScopedPointer<XmlElement> expected (XmlDocument::parse (doc));
+            expect (expected != nullptr);
+
+            TreeBuilder builder;
+            XmlStreamParser parser (builder);
+            TrickleInputStream in (doc);
+
+            expect (parser.parse (in));
+            expect (builder.root != nullptr && builder.root->isEquivalentTo (expected, false));
+        }
+    }
+};
+
+static XmlStreamParserTests xmlStreamParserTests;
+
+#endif
@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_XMLSTREAMPARSER_JUCEHEADER__
+#define __JUCE_XMLSTREAMPARSER_JUCEHEADER__
+
+#include "juce_XmlDocument.h"
+#include "../streams/juce_MemoryOutputStream.h"
+class InputStream;
+
+
+//==============================================================================
+/**
+    An event-driven XML parser which reads from a stream.
+
+    Unlike XmlDocument, this doesn't need the whole document to be loaded into memory,
+    and doesn't build a tree of XmlElement objects. Instead, it reads its input in
+    small chunks and calls a Listener as each element, end tag and block of text is
+    found, so the memory it needs depends only on the size of the largest tag or
+    block of text, not the size of the document.
+
+    The input is expected to be UTF-8 encoded. Entities are expanded in the same way
+    that XmlDocument does it, including any that are declared in the document's DTD,
+    but an entity which expands to some XML markup will be treated as plain text.
+
+    e.g.
+    @code
+    struct PresetCounter  : public XmlStreamParser::Listener
+    {
+        PresetCounter() : numPresets (0) {}
+
+        void elementStarted (const String& tagName, const XmlStreamParser::Attributes&)
+        {
+            if (tagName == "PRESET")
+                ++numPresets;
+        }
+
+        void elementFinished (const String&)    {}
+        void textFound (const String&)          {}
+
+        int numPresets;
+    };
+
+    PresetCounter counter;
+    XmlStreamParser parser (counter);
+
+    if (! parser.parse (File ("presets.xml")))
+        DBG (parser.getLastParseError());
+    @endcode
+
+    @see XmlDocument
+*/
+class JUCE_API  XmlStreamParser
+{
+public:
+    //==============================================================================
+    /** Holds the attributes of the element that is being passed to a Listener.
+
+        The object is only valid during the Listener::elementStarted() callback, so
+        if you need to keep any of its values, you should copy them.
+    */
+    class JUCE_API  Attributes
+    {
+    public:
+        /** Returns the number of attributes. */
+        int size() const noexcept                                       { return names.size(); }
+
+        /** Returns the name of one of the attributes. */
+        const String& getName (int index) const noexcept                { return names.getReference (index); }
+
+        /** Returns the value of one of the attributes. */
+        const String& getValue (int index) const noexcept               { return values.getReference (index); }
+
+        /** Returns the value of the attribute with the given name, or a default value
+            if there's no such attribute.
+        */
+        String getValue (const String& attributeName,
+                         const String& defaultReturnValue = String::empty) const;
+
+        /** Returns true if the element has an attribute with this name. */
+        bool contains (const String& attributeName) const noexcept;
+
+    private:
+        friend class XmlStreamParser;
+        Array<String> names, values;
+    };
+
+    //==============================================================================
+    /** Receives the events that an XmlStreamParser generates.
+
+        The callbacks are made synchronously by the thread that calls XmlStreamParser::parse().
+    */
+    class JUCE_API  Listener
+    {
+    public:
+        /** Destructor. */
+        virtual ~Listener() {}
+
+        /** Called when an opening tag has been read. */
+        virtual void elementStarted (const String& tagName, const Attributes& attributes) = 0;
+
+        /** Called when an element's closing tag has been read.
+            For an empty tag such as <FOO/>, this is called straight after elementStarted().
+        */
+        virtual void elementFinished (const String& tagName) = 0;
+
+        /** Called with the text content between tags, or the content of a CDATA section.
+
+            A block of text which is interrupted by a comment or a sub-element will
+            be delivered as more than one callback.
+        */
+        virtual void textFound (const String& text) = 0;
+    };
+
+    //==============================================================================
+    /** Creates a parser which will send its events to the given listener. */
+    XmlStreamParser (Listener& listener);
+
+    /** Destructor. */
+    ~XmlStreamParser();
+
+    //==============================================================================
+    /** Parses a document from a stream.
+
+        This reads the stream until the document's outer element has been closed, making
+        the appropriate callbacks to the listener as it goes.
+
+        @returns true if the document was parsed successfully, or false if there was an
+                 error, in which case getLastParseError() will describe the problem. If
+                 stop() was called during the parse, it will return true.
+    */
+    bool parse (InputStream& input);
+
+    /** Parses a document from a file.
+        Any external entities that the document refers to will be looked for relative
+        to this file, unless you've supplied an InputSource with setInputSource().
+        @see parse (InputStream&)
+    */
+    bool parse (const File& file);
+
+    /** Parses a document which is held in a string.
+        @see parse (InputStream&)
+    */
+    bool parse (const String& xmlText);
+
+    /** Can be called by a listener callback to stop the parse that is in progress. */
+    void stop() noexcept;
+
+    /** Returns the error from the last time parse() was called.
+
+        Like XmlDocument, some problems such as unknown entities are reported here but
+        are not treated as fatal.
+
+        @returns the error, or an empty string if there was no error.
+    */
+    const String& getLastParseError() const noexcept;
+
+    /** Returns the number of elements that are currently open.
+        When called from inside Listener::elementStarted(), this includes the new element.
+    */
+    int getCurrentDepth() const noexcept;
+
+    //==============================================================================
+    /** Sets an input source object to use for finding external entities.
+        The object that is passed-in will be deleted automatically when no longer needed.
+        @see XmlDocument::setInputSource
+    */
+    void setInputSource (InputSource* newSource) noexcept;
+
+    /** Sets a flag to change the treatment of whitespace-only text.
+        If this is true (the default state), then blocks of text that contain only whitespace
+        will not be passed to the listener.
+        @see XmlDocument::setEmptyTextElementsIgnored
+    */
+    void setEmptyTextElementsIgnored (bool shouldBeIgnored) noexcept;
+
+private:
+    //==============================================================================
+    Listener& listener;
+    InputStream* input;
+    HeapBlock<char> buffer;
+    int bufferStart, bufferEnd;
+    bool endOfInput, shouldStop, errorOccurred, ignoreEmptyTextElements, userSuppliedInputSource;
+
+    MemoryOutputStream token;
+    StringArray openElements;
+    Attributes attributes;
+    String lastError;
+    XmlDocument entityResolver;
+
+    enum { bufferSize = 32768, maxEntityNameLength = 256 };
+
+    bool ensureAvailable (int numBytes);
+    int peek (int offset = 0);
+    bool matches (const char* text);
+    void setLastError (const String& desc, bool carryOn);
+    bool parseDocument();
+    void skipWhiteSpace();
+    bool skipUntil (const char* terminator);
+    void skipComments();
+    bool readDocType();
+    bool readName (String& result);
+    bool readStartTag();
+    bool readEndTag();
+    bool readText();
+    bool readCData();
+    bool readQuotedString (String& result);
+    void readEntity();
+    String getTokenAsString() const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (XmlStreamParser)
+};
+
+
+#endif   // __JUCE_XMLSTREAMPARSER_JUCEHEADER__
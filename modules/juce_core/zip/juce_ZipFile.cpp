@@ -118,34 +118,42 @@ public:
           headerSize (0),
           inputStream (zf.inputStream)
     {
-        if (zf.inputSource != nullptr)
+        if (zf.mappedFile != nullptr)
         {
-            inputStream = streamToDelete = file.inputSource->createInputStream();
+            // When the archive is memory-mapped, each stream can read it directly without locking
+            inputStream = streamToDelete = new MemoryInputStream (zf.mappedFile->getData(),
+                                                                  zf.mappedFile->getSize(), false);
         }
-        else
+        else if (zf.inputSource != nullptr)
         {
-           #if JUCE_DEBUG
-            zf.streamCounter.numOpenStreams++;
-           #endif
+            inputStream = streamToDelete = file.inputSource->createInputStream();
         }
 
-        char buffer [30];
+        if (inputStream == nullptr)
+            return;
 
-        if (inputStream != nullptr
-             && inputStream->setPosition (zei.streamOffset)
-             && inputStream->read (buffer, 30) == 30
-             && ByteOrder::littleEndianInt (buffer) == 0x04034b50)
+       #if JUCE_DEBUG
+        if (isUsingSharedData())
+            ++zf.streamCounter.numOpenStreams;
+       #endif
+
+        if (inputStream == zf.inputStream)
         {
-            headerSize = 30 + ByteOrder::littleEndianShort (buffer + 26)
-                            + ByteOrder::littleEndianShort (buffer + 28);
+            // (the shared stream may be in use by other ZipInputStreams on other threads)
+            const ScopedLock sl (zf.lock);
+            readLocalHeader();
+        }
+        else
+        {
+            readLocalHeader();
         }
     }
 
     ~ZipInputStream()
     {
        #if JUCE_DEBUG
-        if (inputStream != nullptr && inputStream == file.inputStream)
-            file.streamCounter.numOpenStreams--;
+        if (inputStream != nullptr && isUsingSharedData())
+            --file.streamCounter.numOpenStreams;
        #endif
     }
 
@@ -206,6 +214,27 @@ private:
     InputStream* inputStream;
     ScopedPointer<InputStream> streamToDelete;
 
+    void readLocalHeader()
+    {
+        char buffer [30];
+
+        if (inputStream->setPosition (zipEntryHolder.streamOffset)
+             && inputStream->read (buffer, 30) == 30
+             && ByteOrder::littleEndianInt (buffer) == 0x04034b50)
+        {
+            headerSize = 30 + ByteOrder::littleEndianShort (buffer + 26)
+                            + ByteOrder::littleEndianShort (buffer + 28);
+        }
+    }
+
+   #if JUCE_DEBUG
+    // true if this stream reads data that belongs to the ZipFile, so mustn't outlive it
+    bool isUsingSharedData() const noexcept
+    {
+        return inputStream == file.inputStream || file.mappedFile != nullptr;
+    }
+   #endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ZipInputStream)
 };
 
@@ -228,8 +257,12 @@ ZipFile::ZipFile (InputStream& stream)
 
 ZipFile::ZipFile (const File& file)
     : inputStream (nullptr),
-      inputSource (new FileInputSource (file))
+      inputSource (new FileInputSource (file)),
+      mappedFile (new MemoryMappedFile (file, MemoryMappedFile::readOnly))
 {
+    if (mappedFile->getData() == nullptr)
+        mappedFile = nullptr;
+
     init();
 }
 
@@ -251,9 +284,9 @@ ZipFile::OpenStreamCounter::~OpenStreamCounter()
     /* If you hit this assertion, it means you've created a stream to read one of the items in the
        zipfile, but you've forgotten to delete that stream object before deleting the file..
        Streams can't be kept open after the file is deleted because they need to share the input
-       stream that is managed by the ZipFile object.
+       stream or the memory-mapped file that is managed by the ZipFile object.
     */
-    jassert (numOpenStreams == 0);
+    jassert (numOpenStreams.get() == 0);
 }
 #endif
 
@@ -327,7 +360,12 @@ void ZipFile::init()
     ScopedPointer <InputStream> toDelete;
     InputStream* in = inputStream;
 
-    if (inputSource != nullptr)
+    if (mappedFile != nullptr)
+    {
+        in = new MemoryInputStream (mappedFile->getData(), mappedFile->getSize(), false);
+        toDelete = in;
+    }
+    else if (inputSource != nullptr)
     {
         in = inputSource->createInputStream();
         toDelete = in;
@@ -385,19 +423,97 @@ Result ZipFile::uncompressTo (const File& targetDirectory,
     return Result::ok();
 }
 
+//==============================================================================
+namespace
+{
+    File getZipEntryTargetFile (const String& entryName, const File& targetDirectory)
+    {
+       #if JUCE_WINDOWS
+        return targetDirectory.getChildFile (entryName);
+       #else
+        return targetDirectory.getChildFile (entryName.replaceCharacter ('\\', '/'));
+       #endif
+    }
+
+    struct ZipEntryUncompressor
+    {
+        ZipEntryUncompressor (ZipFile& zip_, const File& targetDirectory_, const bool shouldOverwriteFiles_)
+            : zip (zip_), targetDirectory (targetDirectory_), shouldOverwriteFiles (shouldOverwriteFiles_),
+              firstFailedIndex (std::numeric_limits<int>::max()), firstFailure (Result::ok())
+        {
+        }
+
+        void operator() (const int start, const int end)
+        {
+            for (int i = start; i < end; ++i)
+            {
+                const Result result (zip.uncompressEntry (i, targetDirectory, shouldOverwriteFiles));
+
+                if (result.failed())
+                {
+                    const ScopedLock sl (lock);
+
+                    if (i < firstFailedIndex)
+                    {
+                        firstFailedIndex = i;
+                        firstFailure = result;
+                    }
+                }
+            }
+        }
+
+        ZipFile& zip;
+        const File targetDirectory;
+        const bool shouldOverwriteFiles;
+        CriticalSection lock;
+        int firstFailedIndex;
+        Result firstFailure;
+
+        JUCE_DECLARE_NON_COPYABLE (ZipEntryUncompressor)
+    };
+}
+
+Result ZipFile::uncompressTo (const File& targetDirectory,
+                              const bool shouldOverwriteFiles,
+                              TaskScheduler& scheduler)
+{
+    // All the folders are created before starting, so that the threads never race each other
+    // to create the same one..
+    File lastFolder;
+
+    for (int i = 0; i < entries.size(); ++i)
+    {
+        const String& entryName = entries.getUnchecked (i)->entry.filename;
+        const File targetFile (getZipEntryTargetFile (entryName, targetDirectory));
+
+        const File folder (entryName.endsWithChar ('/') || entryName.endsWithChar ('\\')
+                            ? targetFile : targetFile.getParentDirectory());
+
+        if (folder != lastFolder)
+        {
+            Result result (folder.createDirectory());
+            if (result.failed())
+                return result;
+
+            lastFolder = folder;
+        }
+    }
+
+    // The entries can be very different sizes, so they're handed out one at a time
+    ZipEntryUncompressor uncompressor (*this, targetDirectory, shouldOverwriteFiles);
+    scheduler.parallelFor (0, entries.size(), uncompressor, 1);
+
+    return uncompressor.firstFailure;
+}
+
 Result ZipFile::uncompressEntry (const int index,
                                  const File& targetDirectory,
                                  bool shouldOverwriteFiles)
 {
     const ZipEntryHolder* zei = entries.getUnchecked (index);
 
-   #if JUCE_WINDOWS
-    const String entryPath (zei->entry.filename);
-   #else
-    const String entryPath (zei->entry.filename.replaceCharacter ('\\', '/'));
-   #endif
-
-    const File targetFile (targetDirectory.getChildFile (entryPath));
+    const String& entryPath = zei->entry.filename;
+    const File targetFile (getZipEntryTargetFile (entryPath, targetDirectory));
 
     if (entryPath.endsWithChar ('/') || entryPath.endsWithChar ('\\'))
         return targetFile.createDirectory(); // (entry is a directory, not a file)
@@ -447,28 +563,47 @@ public:
           storedPathname (storedPath.isEmpty() ? f.getFileName() : storedPath),
           compressionLevel (compression),
           compressedSize (0),
-          headerStart (0)
+          headerStart (0),
+          uncompressedSize (0),
+          checksum (0)
     {
     }
 
     bool writeData (OutputStream& target, const int64 overallStartPosition)
     {
-        MemoryOutputStream compressedData;
+        return compressData() && writeCompressedData (target, overallStartPosition);
+    }
+
+    /** Reads and compresses the file into a memory buffer, ready for writeCompressedData().
+        This doesn't touch anything that other items use, so several items can do it at once.
+    */
+    bool compressData()
+    {
+        fileTime = file.getLastModificationTime();
 
-        if (compressionLevel > 0)
-        {
-            GZIPCompressorOutputStream compressor (&compressedData, compressionLevel, false,
-                                                   GZIPCompressorOutputStream::windowBitsRaw);
-            if (! writeSource (compressor))
-                return false;
-        }
-        else
         {
-            if (! writeSource (compressedData))
-                return false;
+            MemoryOutputStream out (compressedData, false);
+
+            if (compressionLevel > 0)
+            {
+                GZIPCompressorOutputStream compressor (&out, compressionLevel, false,
+                                                       GZIPCompressorOutputStream::windowBitsRaw);
+                if (! writeSource (compressor))
+                    return false;
+            }
+            else
+            {
+                if (! writeSource (out))
+                    return false;
+            }
         }
 
-        compressedSize = (int) compressedData.getDataSize();
+        compressedSize = (int) compressedData.getSize();
+        return true;
+    }
+
+    bool writeCompressedData (OutputStream& target, const int64 overallStartPosition)
+    {
         headerStart = (int) (target.getPosition() - overallStartPosition);
 
         target.writeInt (0x04034b50);
@@ -476,9 +611,15 @@ public:
         target << storedPathname
                << compressedData;
 
+        clearCompressedData();
         return true;
     }
 
+    void clearCompressedData()
+    {
+        compressedData.setSize (0);
+    }
+
     bool writeDirectoryEntry (OutputStream& target)
     {
         target.writeInt (0x02014b50);
@@ -498,11 +639,14 @@ private:
     const File file;
     String storedPathname;
     int compressionLevel, compressedSize, headerStart;
+    int64 uncompressedSize;
     unsigned long checksum;
+    Time fileTime;
+    MemoryBlock compressedData;
 
     void writeTimeAndDate (OutputStream& target) const
     {
-        const Time t (file.getLastModificationTime());
+        const Time& t = fileTime;
         target.writeShort ((short) (t.getSeconds() + (t.getMinutes() << 5) + (t.getHours() << 11)));
         target.writeShort ((short) (t.getDayOfMonth() + ((t.getMonth() + 1) << 5) + ((t.getYear() - 1980) << 9)));
     }
@@ -510,6 +654,7 @@ private:
     bool writeSource (OutputStream& target)
     {
         checksum = 0;
+        uncompressedSize = 0;
         FileInputStream input (file);
 
         if (input.failedToOpen())
@@ -526,6 +671,7 @@ private:
                 return false;
 
             checksum = juce_crc32 (checksum, buffer, (unsigned int) bytesRead);
+            uncompressedSize += bytesRead;
             target.write (buffer, (size_t) bytesRead);
         }
 
@@ -540,7 +686,7 @@ private:
         writeTimeAndDate (target);
         target.writeInt ((int) checksum);
         target.writeInt (compressedSize);
-        target.writeInt ((int) file.getSize());
+        target.writeInt ((int) uncompressedSize);
         target.writeShort ((short) storedPathname.toUTF8().sizeInBytes() - 1);
         target.writeShort (0); // extra field length
     }
@@ -548,6 +694,20 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Item)
 };
 
+//=============================================================================
+class ZipFile::Builder::CompressionTask  : public TaskScheduler::TaskWithResult<bool>
+{
+public:
+    CompressionTask (Item& item_) noexcept  : item (item_) {}
+
+    bool compute()      { return item.compressData(); }
+
+private:
+    Item& item;
+
+    JUCE_DECLARE_NON_COPYABLE (CompressionTask)
+};
+
 //=============================================================================
 ZipFile::Builder::Builder() {}
 ZipFile::Builder::~Builder() {}
@@ -558,16 +718,66 @@ void ZipFile::Builder::addFile (const File& fileToAdd, const int compressionLeve
 }
 
 bool ZipFile::Builder::writeToStream (OutputStream& target, double* const progress) const
+{
+    return writeToStreamInternal (target, progress, nullptr);
+}
+
+bool ZipFile::Builder::writeToStream (OutputStream& target, double* const progress, TaskScheduler& scheduler) const
+{
+    return writeToStreamInternal (target, progress, &scheduler);
+}
+
+bool ZipFile::Builder::writeToStreamInternal (OutputStream& target, double* const progress,
+                                              TaskScheduler* const scheduler) const
 {
     const int64 fileStart = target.getPosition();
 
-    for (int i = 0; i < items.size(); ++i)
+    // With a scheduler, its threads compress the items that come after the one that's being
+    // written, and this thread waits for each of them in turn (helping out while it waits).
+    // The look-ahead is limited so that only a few compressed buffers are held at once.
+    ReferenceCountedArray<CompressionTask> tasks;
+    const int maxItemsAhead = scheduler != nullptr ? 4 * (scheduler->getNumThreads() + 1) : 0;
+    bool ok = true;
+
+    for (int i = 0; i < items.size() && ok; ++i)
     {
         if (progress != nullptr)
             *progress = (i + 0.5) / items.size();
 
-        if (! items.getUnchecked (i)->writeData (target, fileStart))
-            return false;
+        Item* const item = items.getUnchecked (i);
+
+        if (scheduler != nullptr)
+        {
+            while (tasks.size() < jmin (items.size(), i + maxItemsAhead))
+            {
+                CompressionTask* const task = new CompressionTask (*items.getUnchecked (tasks.size()));
+                tasks.add (task);
+                scheduler->addTask (task);
+            }
+
+            ok = tasks.getObjectPointerUnchecked (i)->getResult()
+                  && item->writeCompressedData (target, fileStart);
+
+            tasks.set (i, nullptr);
+        }
+        else
+        {
+            ok = item->writeData (target, fileStart);
+        }
+    }
+
+    if (! ok)
+    {
+        // Any tasks that are still going have to finish before their buffers can be freed
+        for (int i = 0; i < items.size(); ++i)
+        {
+            if (CompressionTask* const task = tasks[i])
+                task->waitUntilFinished();
+
+            items.getUnchecked (i)->clearCompressedData();
+        }
+
+        return false;
     }
 
     const int64 directoryStart = target.getPosition();
@@ -592,3 +802,99 @@ bool ZipFile::Builder::writeToStream (OutputStream& target, double* const progre
 
     return true;
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class ZipFileTests  : public UnitTest
+{
+public:
+    ZipFileTests()   : UnitTest ("ZipFile") {}
+
+    static MemoryBlock createRandomData (Random& rng)
+    {
+        MemoryBlock data ((size_t) rng.nextInt (20000) + 1);
+
+        // (a small alphabet, so that some of it compresses)
+        const int range = rng.nextBool() ? 4 : 256;
+
+        for (int i = (int) data.getSize(); --i >= 0;)
+            data[i] = (char) rng.nextInt (range);
+
+        return data;
+    }
+
+    static bool filesMatch (const File& a, const File& b)
+    {
+        MemoryBlock dataA, dataB;
+        return a.loadFileAsData (dataA) && b.loadFileAsData (dataB) && dataA == dataB;
+    }
+
+    void runTest()
+    {
+        beginTest ("Builder and uncompressTo");
+
+        Random rng;
+        TaskScheduler scheduler (3);
+
+        const File tempFolder (File::getSpecialLocation (File::tempDirectory)
+                                 .getNonexistentChildFile ("ZipFileTests", String::empty, false));
+        const File sourceFolder (tempFolder.getChildFile ("source"));
+
+        ZipFile::Builder builder;
+        StringArray names;
+
+        for (int i = 0; i < 40; ++i)
+        {
+            const String name ("folder" + String (i % 3) + "/file" + String (i));
+            const File f (sourceFolder.getChildFile (name));
+            f.getParentDirectory().createDirectory();
+            const MemoryBlock data (createRandomData (rng));
+            expect (f.replaceWithData (data.getData(), data.getSize()));
+
+            builder.addFile (f, rng.nextInt (10), name);
+            names.add (name);
+        }
+
+        MemoryOutputStream serialZip, parallelZip;
+        expect (builder.writeToStream (serialZip, nullptr));
+        expect (builder.writeToStream (parallelZip, nullptr, scheduler));
+        expect (serialZip.getMemoryBlock() == parallelZip.getMemoryBlock());
+
+        const File zipFile (tempFolder.getChildFile ("test.zip"));
+        expect (zipFile.replaceWithData (parallelZip.getData(), parallelZip.getDataSize()));
+
+        {
+            ZipFile zip (zipFile);
+            expectEquals (zip.getNumEntries(), names.size());
+
+            const File serialFolder (tempFolder.getChildFile ("serial"));
+            const File parallelFolder (tempFolder.getChildFile ("parallel"));
+            expect (zip.uncompressTo (serialFolder).wasOk());
+            expect (zip.uncompressTo (parallelFolder, true, scheduler).wasOk());
+
+            for (int i = 0; i < names.size(); ++i)
+            {
+                const File original (sourceFolder.getChildFile (names[i]));
+                expect (filesMatch (original, serialFolder.getChildFile (names[i])));
+                expect (filesMatch (original, parallelFolder.getChildFile (names[i])));
+            }
+        }
+
+        {
+            MemoryInputStream in (parallelZip.getData(), parallelZip.getDataSize(), false);
+            ZipFile zip (in);
+            const File streamFolder (tempFolder.getChildFile ("stream"));
+            expect (zip.uncompressTo (streamFolder, true, scheduler).wasOk());
+
+            for (int i = 0; i < names.size(); ++i)
+                expect (filesMatch (sourceFolder.getChildFile (names[i]), streamFolder.getChildFile (names[i])));
+        }
+
+        expect (tempFolder.deleteRecursively());
+    }
+};
+
+static ZipFileTests zipFileTests;
+
+#endif
@@ -27,8 +27,10 @@
 #define __JUCE_ZIPFILE_JUCEHEADER__
 
 #include "../files/juce_File.h"
+#include "../files/juce_MemoryMappedFile.h"
 #include "../streams/juce_InputSource.h"
 #include "../threads/juce_CriticalSection.h"
+#include "../threads/juce_TaskScheduler.h"
 #include "../containers/juce_OwnedArray.h"
 
 
@@ -42,7 +44,11 @@
 class JUCE_API  ZipFile
 {
 public:
-    /** Creates a ZipFile based for a file. */
+    /** Creates a ZipFile based for a file.
+
+        If possible, the file will be memory-mapped, so that the streams for its entries
+        can read it directly, without having to open the file again or share a stream.
+    */
     explicit ZipFile (const File& file);
 
     //==============================================================================
@@ -156,6 +162,25 @@ public:
     Result uncompressTo (const File& targetDirectory,
                          bool shouldOverwriteFiles = true);
 
+    /** Uncompresses all of the files in the zip file, using the threads of a TaskScheduler
+        to decompress several entries at the same time.
+
+        This creates all the folders that are needed first, and then writes the files in
+        parallel, so it's a lot quicker than the single-threaded version for an archive that
+        contains lots of files. It returns when all the entries have been done.
+
+        If more than one entry fails, the result will describe the one that comes first
+        in the zip file.
+
+        @param targetDirectory      the root folder to uncompress to
+        @param shouldOverwriteFiles whether to overwrite existing files with similarly-named ones
+        @param scheduler            the scheduler whose threads should be used
+        @returns success if the file is successfully unzipped
+    */
+    Result uncompressTo (const File& targetDirectory,
+                         bool shouldOverwriteFiles,
+                         TaskScheduler& scheduler);
+
     /** Uncompresses one of the entries from the zip file.
 
         This will expand the entry and write it in a target directory. The entry's path is used to
@@ -204,12 +229,29 @@ public:
         */
         bool writeToStream (OutputStream& target, double* progress) const;
 
+        /** Generates the zip file, using the threads of a TaskScheduler to compress several
+            files at the same time.
+
+            Each file is compressed into a temporary memory buffer by one of the scheduler's
+            threads, and the calling thread writes the buffers to the stream in the order in
+            which the files were added, so the output is identical to that of the
+            single-threaded version. Only a few files ahead of the one being written are
+            compressed at any one time, so the amount of memory used stays bounded.
+
+            If the progress parameter is non-null, it will be updated with an approximate
+            progress status between 0 and 1.0
+        */
+        bool writeToStream (OutputStream& target, double* progress, TaskScheduler& scheduler) const;
+
         //==============================================================================
     private:
         class Item;
+        class CompressionTask;
         friend class OwnedArray<Item>;
         OwnedArray<Item> items;
 
+        bool writeToStreamInternal (OutputStream&, double*, TaskScheduler*) const;
+
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Builder)
     };
 
@@ -225,6 +267,7 @@ private:
     InputStream* inputStream;
     ScopedPointer <InputStream> streamToDelete;
     ScopedPointer <InputSource> inputSource;
+    ScopedPointer <MemoryMappedFile> mappedFile;
 
    #if JUCE_DEBUG
     struct OpenStreamCounter
@@ -232,7 +275,7 @@ private:
         OpenStreamCounter() : numOpenStreams (0) {}
         ~OpenStreamCounter();
 
-        int numOpenStreams;
+        Atomic<int> numOpenStreams;
     };
 
     OpenStreamCounter streamCounter;
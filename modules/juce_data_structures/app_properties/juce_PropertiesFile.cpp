@@ -27,6 +27,10 @@ namespace PropertyFileConstants
 {
     static const int magicNumber            = (int) ByteOrder::littleEndianInt ("PROP");
     static const int magicNumberCompressed  = (int) ByteOrder::littleEndianInt ("CPRP");
+    static const int magicNumberLog         = (int) ByteOrder::littleEndianInt ("LPRP");
+
+    static const char setValueRecord        = 1;
+    static const char removeValueRecord     = 2;
 
     static const char* const fileTag        = "PROPERTIES";
     static const char* const valueTag       = "VALUE";
@@ -40,6 +44,7 @@ PropertiesFile::Options::Options()
       ignoreCaseOfKeyNames (false),
       millisecondsBeforeSaving (3000),
       storageFormat (PropertiesFile::storeAsXML),
+      saveInBackground (false),
       processLock (nullptr)
 {
 }
@@ -102,11 +107,96 @@ File PropertiesFile::Options::getDefaultFile() const
 }
 
 
+//==============================================================================
+class PropertiesFile::SaveThread  : public Thread
+{
+public:
+    SaveThread (PropertiesFile& owner_)
+        : Thread ("PropertiesFile saver"),
+          owner (owner_), hasPendingValues (false)
+    {
+        startThread();
+    }
+
+    ~SaveThread()
+    {
+        stopThread (-1);
+        writePendingValues();
+    }
+
+    void saveValues (const StringPairArray& values)
+    {
+        {
+            const ScopedLock sl (pendingLock);
+            pendingValues = values;
+            hasPendingValues = true;
+        }
+
+        notify();
+    }
+
+    void cancelPendingSave()
+    {
+        const ScopedLock sl (pendingLock);
+        pendingValues.clear();
+        hasPendingValues = false;
+    }
+
+    void run()
+    {
+        while (! threadShouldExit())
+        {
+            wait (-1);
+            writePendingValues();
+        }
+    }
+
+private:
+    PropertiesFile& owner;
+    CriticalSection pendingLock;
+    StringPairArray pendingValues;
+    bool hasPendingValues;
+
+    void writePendingValues()
+    {
+        bool ok;
+
+        {
+            const ScopedLock wl (owner.writeLock);
+            StringPairArray values;
+
+            {
+                const ScopedLock sl (pendingLock);
+
+                if (! hasPendingValues)
+                    return;
+
+                values = pendingValues;
+                pendingValues.clear();
+                hasPendingValues = false;
+            }
+
+            ok = owner.writeValues (values);
+        }
+
+        // if it failed, the file's flagged as needing to be saved again, so that
+        // the next save will have another go
+        if (! ok)
+        {
+            const ScopedLock sl (owner.getLock());
+            owner.needsWriting = true;
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (SaveThread)
+};
+
 //==============================================================================
 PropertiesFile::PropertiesFile (const File& f, const Options& o)
     : PropertySet (o.ignoreCaseOfKeyNames),
       file (f), options (o),
-      loadedOk (false), needsWriting (false)
+      loadedOk (false), needsWriting (false),
+      logCompactedSize (0), logAppendedSize (0), logNeedsCompacting (true)
 {
     reload();
 }
@@ -114,18 +204,23 @@ PropertiesFile::PropertiesFile (const File& f, const Options& o)
 PropertiesFile::PropertiesFile (const Options& o)
     : PropertySet (o.ignoreCaseOfKeyNames),
       file (o.getDefaultFile()), options (o),
-      loadedOk (false), needsWriting (false)
+      loadedOk (false), needsWriting (false),
+      logCompactedSize (0), logAppendedSize (0), logNeedsCompacting (true)
 {
     reload();
 }
 
 bool PropertiesFile::reload()
 {
+    const ScopedLock sl (getLock());
+    const ScopedLock wl (writeLock);
+
     ProcessScopedLock pl (createProcessLock());
 
     if (pl != nullptr && ! pl->isLocked())
         return false; // locking failure..
 
+    logNeedsCompacting = true;
     loadedOk = (! file.exists()) || loadAsBinary() || loadAsXml();
     return loadedOk;
 }
@@ -133,6 +228,7 @@ bool PropertiesFile::reload()
 PropertiesFile::~PropertiesFile()
 {
     saveIfNeeded();
+    saveThread = nullptr;
 }
 
 InterProcessLock::ScopedLockType* PropertiesFile::createProcessLock() const
@@ -164,15 +260,52 @@ bool PropertiesFile::save()
 
     stopTimer();
 
+    // the current values are about to be written, so any older ones that are
+    // waiting to be saved in the background can be skipped
+    if (saveThread != nullptr)
+        saveThread->cancelPendingSave();
+
+    const ScopedLock wl (writeLock);
+
+    if (writeValues (getAllProperties()))
+    {
+        needsWriting = false;
+        return true;
+    }
+
+    return false;
+}
+
+void PropertiesFile::startBackgroundSave()
+{
+    const ScopedLock sl (getLock());
+
+    stopTimer();
+
+    if (needsWriting)
+    {
+        if (saveThread == nullptr)
+            saveThread = new SaveThread (*this);
+
+        saveThread->saveValues (getAllProperties());
+        needsWriting = false;
+    }
+}
+
+bool PropertiesFile::writeValues (const StringPairArray& values)
+{
     if (file == File::nonexistent
          || file.isDirectory()
          || ! file.getParentDirectory().createDirectory())
         return false;
 
     if (options.storageFormat == storeAsXML)
-        return saveAsXml();
+        return saveAsXml (values);
 
-    return saveAsBinary();
+    if (options.storageFormat == storeAsAppendLog)
+        return saveAsLog (values);
+
+    return saveAsBinary (values);
 }
 
 bool PropertiesFile::loadAsXml()
@@ -213,21 +346,21 @@ bool PropertiesFile::loadAsXml()
     return false;
 }
 
-bool PropertiesFile::saveAsXml()
+bool PropertiesFile::saveAsXml (const StringPairArray& values)
 {
     XmlElement doc (PropertyFileConstants::fileTag);
 
-    for (int i = 0; i < getAllProperties().size(); ++i)
+    for (int i = 0; i < values.size(); ++i)
     {
         XmlElement* const e = doc.createNewChildElement (PropertyFileConstants::valueTag);
-        e->setAttribute (PropertyFileConstants::nameAttribute, getAllProperties().getAllKeys() [i]);
+        e->setAttribute (PropertyFileConstants::nameAttribute, values.getAllKeys() [i]);
 
         // if the value seems to contain xml, store it as such..
-        if (XmlElement* const childElement = XmlDocument::parse (getAllProperties().getAllValues() [i]))
+        if (XmlElement* const childElement = XmlDocument::parse (values.getAllValues() [i]))
             e->addChildElement (childElement);
         else
             e->setAttribute (PropertyFileConstants::valueAttribute,
-                             getAllProperties().getAllValues() [i]);
+                             values.getAllValues() [i]);
     }
 
     ProcessScopedLock pl (createProcessLock());
@@ -235,13 +368,7 @@ bool PropertiesFile::saveAsXml()
     if (pl != nullptr && ! pl->isLocked())
         return false; // locking failure..
 
-    if (doc.writeToFile (file, String::empty))
-    {
-        needsWriting = false;
-        return true;
-    }
-
-    return false;
+    return doc.writeToFile (file, String::empty);
 }
 
 bool PropertiesFile::loadAsBinary()
@@ -262,6 +389,10 @@ bool PropertiesFile::loadAsBinary()
         {
             return loadAsBinary (fileStream);
         }
+        else if (magicNumber == PropertyFileConstants::magicNumberLog)
+        {
+            return loadAsLog (fileStream);
+        }
     }
 
     return false;
@@ -270,7 +401,44 @@ bool PropertiesFile::loadAsBinary()
 bool PropertiesFile::loadAsBinary (InputStream& input)
 {
     BufferedInputStream in (input, 2048);
+    readValues (in);
+    return true;
+}
+
+bool PropertiesFile::loadAsLog (InputStream& input)
+{
+    BufferedInputStream in (input, 8192);
+    readValues (in);
+
+    while (in.getNumBytesRemaining() >= 4)
+    {
+        const int size = in.readInt();
+
+        // if the last set of changes wasn't completely written, it gets ignored
+        if (size <= 0 || in.getNumBytesRemaining() < size)
+            break;
+
+        MemoryBlock changes;
+        in.readIntoMemoryBlock (changes, size);
+        MemoryInputStream changeStream (changes, false);
+
+        while (! changeStream.isExhausted())
+        {
+            const char type = changeStream.readByte();
+            const String key (changeStream.readString());
+
+            if (type == PropertyFileConstants::setValueRecord)
+                getAllProperties().set (key, changeStream.readString());
+            else
+                getAllProperties().remove (key);
+        }
+    }
+
+    return true;
+}
 
+void PropertiesFile::readValues (InputStream& in)
+{
     int numValues = in.readInt();
 
     while (--numValues >= 0 && ! in.isExhausted())
@@ -282,11 +450,9 @@ bool PropertiesFile::loadAsBinary (InputStream& input)
         if (key.isNotEmpty())
             getAllProperties().set (key, value);
     }
-
-    return true;
 }
 
-bool PropertiesFile::saveAsBinary()
+bool PropertiesFile::saveAsBinary (const StringPairArray& values)
 {
     ProcessScopedLock pl (createProcessLock());
 
@@ -313,31 +479,164 @@ bool PropertiesFile::saveAsBinary()
             out->writeInt (PropertyFileConstants::magicNumber);
         }
 
-        const int numProperties = getAllProperties().size();
+        const int numProperties = values.size();
 
         out->writeInt (numProperties);
 
         for (int i = 0; i < numProperties; ++i)
         {
-            out->writeString (getAllProperties().getAllKeys() [i]);
-            out->writeString (getAllProperties().getAllValues() [i]);
+            out->writeString (values.getAllKeys() [i]);
+            out->writeString (values.getAllValues() [i]);
         }
 
         out = nullptr;
 
-        if (tempFile.overwriteTargetFileWithTemporary())
+        return tempFile.overwriteTargetFileWithTemporary();
+    }
+
+    return false;
+}
+
+bool PropertiesFile::saveAsLog (const StringPairArray& values)
+{
+    // (if the file's been changed by something else, it needs to be rewritten)
+    if (logNeedsCompacting
+         || logAppendedSize > jmax (logCompactedSize, (int64) 16384)
+         || file.getSize() != logCompactedSize + logAppendedSize)
+        return compactLog (values);
+
+    const StringArray& keys = values.getAllKeys();
+    const StringArray& vals = values.getAllValues();
+    const StringArray& oldKeys = loggedValues.getAllKeys();
+    const StringArray& oldVals = loggedValues.getAllValues();
+    MemoryOutputStream changes;
+
+    // Keys are normally in the same order as last time, so the arrays can be compared
+    // item by item until they stop matching..
+    int numMatching = 0;
+
+    for (const int num = jmin (keys.size(), oldKeys.size()); numMatching < num; ++numMatching)
+    {
+        const int i = numMatching;
+
+        if (keys[i] != oldKeys[i])
+            break;
+
+        if (vals[i] != oldVals[i])
         {
-            needsWriting = false;
-            return true;
+            changes.writeByte (PropertyFileConstants::setValueRecord);
+            changes.writeString (keys[i]);
+            changes.writeString (vals[i]);
         }
     }
 
-    return false;
+    // ..and any that are left over have to be looked up.
+    if (numMatching < keys.size() || numMatching < oldKeys.size())
+    {
+        HashMap<String, int> oldIndexes;
+
+        for (int i = numMatching; i < oldKeys.size(); ++i)
+            oldIndexes.set (oldKeys[i], i);
+
+        for (int i = numMatching; i < keys.size(); ++i)
+        {
+            const int oldIndex = oldIndexes.contains (keys[i]) ? oldIndexes [keys[i]] : -1;
+
+            if (oldIndex < 0 || vals[i] != oldVals [oldIndex])
+            {
+                changes.writeByte (PropertyFileConstants::setValueRecord);
+                changes.writeString (keys[i]);
+                changes.writeString (vals[i]);
+            }
+
+            oldIndexes.remove (keys[i]);
+        }
+
+        for (HashMap<String, int>::Iterator i (oldIndexes); i.next();)
+        {
+            changes.writeByte (PropertyFileConstants::removeValueRecord);
+            changes.writeString (i.getKey());
+        }
+    }
+
+    loggedValues = values;
+
+    if (changes.getDataSize() == 0)
+        return true;
+
+    // until the changes have been appended, the logged values don't match the file
+    logNeedsCompacting = true;
+
+    ProcessScopedLock pl (createProcessLock());
+
+    if (pl != nullptr && ! pl->isLocked())
+        return false; // locking failure..
+
+    FileOutputStream out (file);
+
+    if (out.failedToOpen())
+        return false;
+
+    out.writeInt ((int) changes.getDataSize());
+    out << changes;
+    out.flush();
+
+    if (out.getStatus().failed())
+        return false;
+
+    logAppendedSize += 4 + (int64) changes.getDataSize();
+    logNeedsCompacting = false;
+    return true;
+}
+
+bool PropertiesFile::compactLog (const StringPairArray& values)
+{
+    ProcessScopedLock pl (createProcessLock());
+
+    if (pl != nullptr && ! pl->isLocked())
+        return false; // locking failure..
+
+    TemporaryFile tempFile (file);
+
+    {
+        FileOutputStream out (tempFile.getFile());
+
+        if (out.failedToOpen())
+            return false;
+
+        const int numProperties = values.size();
+
+        out.writeInt (PropertyFileConstants::magicNumberLog);
+        out.writeInt (numProperties);
+
+        for (int i = 0; i < numProperties; ++i)
+        {
+            out.writeString (values.getAllKeys() [i]);
+            out.writeString (values.getAllValues() [i]);
+        }
+
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    if (! tempFile.overwriteTargetFileWithTemporary())
+        return false;
+
+    loggedValues = values;
+    logCompactedSize = file.getSize();
+    logAppendedSize = 0;
+    logNeedsCompacting = false;
+    return true;
 }
 
 void PropertiesFile::timerCallback()
 {
-    saveIfNeeded();
+    if (options.saveInBackground)
+        startBackgroundSave();
+    else
+        saveIfNeeded();
 }
 
 void PropertiesFile::propertyChanged()
@@ -349,5 +648,96 @@ void PropertiesFile::propertyChanged()
     if (options.millisecondsBeforeSaving > 0)
         startTimer (options.millisecondsBeforeSaving);
     else if (options.millisecondsBeforeSaving == 0)
-        saveIfNeeded();
+        timerCallback();
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class PropertiesFileTests  : public UnitTest
+{
+public:
+    PropertiesFileTests() : UnitTest ("PropertiesFile") {}
+
+    static PropertiesFile::Options createOptions (const bool saveInBackground)
+    {
+        PropertiesFile::Options options;
+        options.storageFormat = PropertiesFile::storeAsAppendLog;
+        options.saveInBackground = saveInBackground;
+        options.millisecondsBeforeSaving = saveInBackground ? 0 : -1;
+        return options;
+    }
+
+    void expectValues (const File& file, const StringPairArray& expected)
+    {
+        PropertiesFile props (file, createOptions (false));
+        expect (props.isValidFile());
+        expectEquals (props.getAllProperties().size(), expected.size());
+        expect (props.getAllProperties() == expected);
+    }
+
+    void runTest()
+    {
+        beginTest ("Append log");
+
+        TemporaryFile tempFile (".settings");
+        const File& file = tempFile.getFile();
+        StringPairArray expected, beforeLastChange;
+
+        {
+            PropertiesFile props (file, createOptions (false));
+
+            for (int i = 0; i < 50; ++i)
+                props.setValue ("key" + String (i), "value" + String (i));
+
+            expect (props.save());
+            const int64 compactedSize = file.getSize();
+
+            props.setValue ("key3", "changed");
+            props.removeValue ("key7");
+            props.setValue ("newKey", "new");
+            expect (props.save());
+            expect (file.getSize() > compactedSize && file.getSize() < compactedSize + 100);
+
+            beforeLastChange = props.getAllProperties();
+            props.setValue ("key10", "changed again");
+            expect (props.save());
+            expected = props.getAllProperties();
+        }
+
+        {
+            FileInputStream in (file);
+            expect (in.readInt() == PropertyFileConstants::magicNumberLog);
+        }
+
+        expectValues (file, expected);
+
+        beginTest ("Truncated append log");
+
+        {
+            MemoryBlock data;
+            expect (file.loadFileAsData (data));
+            data.setSize (data.getSize() - 3);
+            expect (file.replaceWithData (data.getData(), data.getSize()));
+        }
+
+        expectValues (file, beforeLastChange);
+
+        beginTest ("Background save on destruction");
+
+        {
+            PropertiesFile props (file, createOptions (true));
+
+            for (int i = 0; i < 20; ++i)
+                props.setValue ("background", i);
+
+            expected = props.getAllProperties();
+        }
+
+        expectValues (file, expected);
+    }
+};
+
+static PropertiesFileTests propertiesFileTests;
+
+#endif
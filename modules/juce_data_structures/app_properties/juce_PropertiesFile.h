@@ -51,7 +51,15 @@ public:
     {
         storeAsBinary,
         storeAsCompressedBinary,
-        storeAsXML
+        storeAsXML,
+
+        /** The file is written in the binary format, and after that, each save just appends
+            the values that have changed since the previous one to the end of the file. When
+            the appended changes grow larger than the rest of the file, the whole file is
+            rewritten. This is much quicker than the other formats when there are lots of
+            values but only a few of them change at a time.
+        */
+        storeAsAppendLog
     };
 
     //==============================================================================
@@ -123,6 +131,14 @@ public:
         */
         StorageFormat storageFormat;
 
+        /** If true, the saves that happen automatically after a value has changed (see
+            millisecondsBeforeSaving) take a copy of the values and write them to disk on a
+            background thread, so that the thread that changed the values isn't held up.
+            Explicit calls to save() and saveIfNeeded() still write the file before returning.
+            The default constructor sets this to false.
+        */
+        bool saveInBackground;
+
         /** An optional InterprocessLock object that will be used to prevent multiple threads or
             processes from writing to the file at the same time. The PropertiesFile will keep a
             pointer to this object but will not take ownership of it - the caller is responsible for
@@ -167,7 +183,8 @@ public:
                     const Options& options);
 
     /** Destructor.
-        When deleted, the file will first call saveIfNeeded() to flush any changes to disk.
+        When deleted, the file will first call saveIfNeeded() to flush any changes to disk,
+        and will wait for any background save to finish.
     */
     ~PropertiesFile();
 
@@ -192,6 +209,11 @@ public:
     /** This will force a write-to-disk of the current values, regardless of whether
         anything has changed since the last save.
 
+        The file is written to a temporary file which then replaces the original, so if
+        something goes wrong, the old file will be left intact. (The storeAsAppendLog
+        format appends to the existing file instead, and when loading, ignores a set of
+        changes that was only partly written).
+
         Returns false if it fails to write to the file for some reason (maybe because
         it's read-only or the directory doesn't exist or something).
 
@@ -224,19 +246,35 @@ protected:
 
 private:
     //==============================================================================
+    class SaveThread;
+    friend class SaveThread;
+
     File file;
     Options options;
     bool loadedOk, needsWriting;
+    CriticalSection writeLock;
+    ScopedPointer<SaveThread> saveThread;
+
+    // the values that the append-log file holds, and its size
+    StringPairArray loggedValues;
+    int64 logCompactedSize, logAppendedSize;
+    bool logNeedsCompacting;
 
     typedef const ScopedPointer<InterProcessLock::ScopedLockType> ProcessScopedLock;
     InterProcessLock::ScopedLockType* createProcessLock() const;
 
     void timerCallback();
-    bool saveAsXml();
-    bool saveAsBinary();
+    void startBackgroundSave();
+    bool writeValues (const StringPairArray&);
+    bool saveAsXml (const StringPairArray&);
+    bool saveAsBinary (const StringPairArray&);
+    bool saveAsLog (const StringPairArray&);
+    bool compactLog (const StringPairArray&);
     bool loadAsXml();
     bool loadAsBinary();
     bool loadAsBinary (InputStream&);
+    bool loadAsLog (InputStream&);
+    void readValues (InputStream&);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PropertiesFile)
 };
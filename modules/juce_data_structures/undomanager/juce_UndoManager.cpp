@@ -27,13 +27,23 @@ struct UndoManager::ActionSet
 {
     ActionSet (const String& transactionName)
         : name (transactionName),
-          time (Time::getCurrentTime())
+          time (Time::getCurrentTime()),
+          storedDataPosition (-1),
+          storedDataSize (0),
+          isStored (false)
     {}
 
     OwnedArray <UndoableAction> actions;
     String name;
     Time time;
 
+    // When the transaction has been stored, this holds the compressed data from its
+    // actions, unless it's been written to the storage file at storedDataPosition.
+    MemoryBlock storedData;
+    int64 storedDataPosition;
+    int storedDataSize;
+    bool isStored;
+
     bool perform() const
     {
         for (int i = 0; i < actions.size(); ++i)
@@ -52,12 +62,17 @@ struct UndoManager::ActionSet
         return true;
     }
 
-    int getTotalSize() const
+    static int getSizeOf (UndoableAction& action, const bool includeData)
+    {
+        return action.getSizeInUnits() + (includeData ? action.getSizeOfData() : 0);
+    }
+
+    int getTotalSize (const bool includeData) const
     {
         int total = 0;
 
         for (int i = actions.size(); --i >= 0;)
-            total += actions.getUnchecked(i)->getSizeInUnits();
+            total += getSizeOf (*actions.getUnchecked(i), includeData);
 
         return total;
     }
@@ -68,8 +83,14 @@ UndoManager::UndoManager (const int maxNumberOfUnitsToKeep,
                           const int minimumTransactions)
    : totalUnitsStored (0),
      nextIndex (0),
+     oldTransactionStorage (discardOldTransactions),
+     compressedBytesInMemory (0),
+     storageFileSize (0),
+     coalescingTime (0),
+     lastActionTime (0),
      newTransaction (true),
-     reentrancyCheck (false)
+     reentrancyCheck (false),
+     canCoalesceWithLastAction (false)
 {
     setMaxNumberOfStoredUnits (maxNumberOfUnitsToKeep,
                                minimumTransactions);
@@ -85,6 +106,10 @@ void UndoManager::clearUndoHistory()
     transactions.clear();
     totalUnitsStored = 0;
     nextIndex = 0;
+    compressedBytesInMemory = 0;
+    storageFile = nullptr;
+    storageFileSize = 0;
+    canCoalesceWithLastAction = false;
     sendChangeMessage();
 }
 
@@ -100,6 +125,47 @@ void UndoManager::setMaxNumberOfStoredUnits (const int maxNumberOfUnitsToKeep,
     minimumTransactionsToKeep  = jmax (1, minimumTransactions);
 }
 
+void UndoManager::setOldTransactionStorage (const OldTransactionStorage newStorageMethod)
+{
+    oldTransactionStorage = newStorageMethod;
+
+    // the actions' data is only counted when it can be stored, so the total has to be redone..
+    totalUnitsStored = 0;
+
+    for (int i = transactions.size(); --i >= 0;)
+        totalUnitsStored += transactions.getUnchecked(i)->getTotalSize (isCountingActionData());
+}
+
+bool UndoManager::isCountingActionData() const noexcept
+{
+    return oldTransactionStorage != discardOldTransactions;
+}
+
+void UndoManager::setTransactionCoalescingTime (const int maxMillisecondsBetweenActions)
+{
+    coalescingTime = jmax (0, maxMillisecondsBetweenActions);
+}
+
+UndoManager::MemoryStatistics UndoManager::getMemoryStatistics() const
+{
+    MemoryStatistics stats;
+    stats.numTransactions = transactions.size();
+    stats.numStoredTransactions = 0;
+    stats.numUnitsInMemory = totalUnitsStored;
+    stats.numCompressedBytesInMemory = compressedBytesInMemory;
+    stats.numBytesInFile = storageFileSize;
+
+    for (int i = 0; i < transactions.size(); ++i)
+    {
+        const ActionSet* const s = transactions.getUnchecked(i);
+
+        if (s->storedData.getSize() > 0 || s->storedDataPosition >= 0)
+            ++stats.numStoredTransactions;
+    }
+
+    return stats;
+}
+
 //==============================================================================
 bool UndoManager::perform (UndoableAction* const newAction, const String& actionName)
 {
@@ -120,29 +186,40 @@ bool UndoManager::perform (UndoableAction* const newAction, const String& action
         if (action->perform())
         {
             ActionSet* actionSet = getCurrentSet();
+            const uint32 now = Time::getMillisecondCounter();
 
-            if (actionSet != nullptr && ! newTransaction)
+            const bool canCoalesce = actionSet != nullptr
+                                       && (! newTransaction
+                                            || (canCoalesceWithLastAction
+                                                 && now - lastActionTime <= (uint32) coalescingTime
+                                                 && ! actionSet->isStored));
+
+            if (canCoalesce)
             {
                 if (UndoableAction* const lastAction = actionSet->actions.getLast())
                 {
                     if (UndoableAction* const coalescedAction = lastAction->createCoalescedAction (action))
                     {
                         action = coalescedAction;
-                        totalUnitsStored -= lastAction->getSizeInUnits();
+                        totalUnitsStored -= ActionSet::getSizeOf (*lastAction, isCountingActionData());
                         actionSet->actions.removeLast();
+                        newTransaction = false;
                     }
                 }
             }
-            else
+
+            if (actionSet == nullptr || newTransaction)
             {
                 actionSet = new ActionSet (currentTransactionName);
                 transactions.insert (nextIndex, actionSet);
                 ++nextIndex;
             }
 
-            totalUnitsStored += action->getSizeInUnits();
+            totalUnitsStored += ActionSet::getSizeOf (*action, isCountingActionData());
             actionSet->actions.add (action.release());
             newTransaction = false;
+            canCoalesceWithLastAction = coalescingTime > 0;
+            lastActionTime = now;
 
             clearFutureTransactions();
             sendChangeMessage();
@@ -156,17 +233,20 @@ bool UndoManager::perform (UndoableAction* const newAction, const String& action
 void UndoManager::clearFutureTransactions()
 {
     while (nextIndex < transactions.size())
+        removeTransaction (transactions.size() - 1);
+
+    if (oldTransactionStorage != discardOldTransactions)
     {
-        totalUnitsStored -= transactions.getLast()->getTotalSize();
-        transactions.removeLast();
+        for (int i = 0; i < nextIndex - minimumTransactionsToKeep
+                          && totalUnitsStored + compressedBytesInMemory > maxNumUnitsToKeep; ++i)
+            storeTransaction (*transactions.getUnchecked(i));
     }
 
     while (nextIndex > 0
-            && totalUnitsStored > maxNumUnitsToKeep
+            && totalUnitsStored + compressedBytesInMemory > maxNumUnitsToKeep
             && transactions.size() > minimumTransactionsToKeep)
     {
-        totalUnitsStored -= transactions.getFirst()->getTotalSize();
-        transactions.remove (0);
+        removeTransaction (0);
         --nextIndex;
 
         // if this fails, then some actions may not be returning
@@ -175,6 +255,143 @@ void UndoManager::clearFutureTransactions()
     }
 }
 
+void UndoManager::removeTransaction (const int index)
+{
+    const ActionSet* const s = transactions.getUnchecked (index);
+    totalUnitsStored -= s->getTotalSize (isCountingActionData());
+    compressedBytesInMemory -= (int64) s->storedData.getSize();
+    transactions.remove (index);
+}
+
+//==============================================================================
+void UndoManager::storeTransaction (ActionSet& s)
+{
+    if (s.isStored)
+        return;
+
+    const int oldSize = s.getTotalSize (isCountingActionData());
+    MemoryOutputStream compressedData;
+    bool anyActionsStored = false;
+
+    {
+        GZIPCompressorOutputStream compressor (&compressedData);
+
+        for (int i = 0; i < s.actions.size(); ++i)
+        {
+            MemoryOutputStream actionData;
+
+            if (s.actions.getUnchecked(i)->storeData (actionData))
+            {
+                compressor.writeCompressedInt (i);
+                compressor.writeCompressedInt ((int) actionData.getDataSize());
+                compressor << actionData;
+                anyActionsStored = true;
+            }
+        }
+
+        compressor.writeCompressedInt (-1);
+    }
+
+    // (if none of the actions could store anything, the set is still marked as
+    // stored, so that they don't get asked again)
+    s.isStored = true;
+
+    if (anyActionsStored)
+    {
+        if (oldTransactionStorage != moveOldTransactionsToFile
+             || ! writeToStorageFile (compressedData, s))
+        {
+            s.storedData = compressedData.getMemoryBlock();
+            compressedBytesInMemory += (int64) s.storedData.getSize();
+        }
+    }
+
+    totalUnitsStored += s.getTotalSize (isCountingActionData()) - oldSize;
+}
+
+bool UndoManager::writeToStorageFile (const MemoryOutputStream& data, ActionSet& s)
+{
+    if (storageFile == nullptr)
+        storageFile = new TemporaryFile (".undo");
+
+    FileOutputStream out (storageFile->getFile());
+
+    if (out.failedToOpen())
+        return false;
+
+    const int64 position = out.getPosition();
+
+    if (! out.write (data.getData(), (int) data.getDataSize()))
+        return false;
+
+    out.flush();
+
+    s.storedDataPosition = position;
+    s.storedDataSize = (int) data.getDataSize();
+    storageFileSize = out.getPosition();
+    return true;
+}
+
+bool UndoManager::restoreTransaction (ActionSet& s)
+{
+    if (! s.isStored)
+        return true;
+
+    MemoryBlock data;
+
+    if (s.storedDataPosition >= 0)
+    {
+        if (storageFile == nullptr)
+            return false;
+
+        FileInputStream in (storageFile->getFile());
+
+        if (in.failedToOpen()
+             || ! in.setPosition (s.storedDataPosition)
+             || in.readIntoMemoryBlock (data, s.storedDataSize) != s.storedDataSize)
+            return false;
+    }
+    else
+    {
+        data.swapWith (s.storedData);
+        compressedBytesInMemory -= (int64) data.getSize();
+    }
+
+    const int oldSize = s.getTotalSize (isCountingActionData());
+
+    if (data.getSize() > 0)
+    {
+        MemoryInputStream compressedData (data, false);
+        GZIPDecompressorInputStream decompressor (compressedData);
+
+        for (;;)
+        {
+            const int index = decompressor.readCompressedInt();
+
+            if (index < 0 || decompressor.isExhausted())
+                break;
+
+            MemoryBlock actionData;
+            const int size = decompressor.readCompressedInt();
+
+            if (decompressor.readIntoMemoryBlock (actionData, size) != size)
+                return false;
+
+            if (UndoableAction* const action = s.actions [index])
+            {
+                MemoryInputStream actionStream (actionData, false);
+                action->restoreData (actionStream);
+            }
+        }
+    }
+
+    s.isStored = false;
+    s.storedDataPosition = -1;
+    s.storedDataSize = 0;
+    totalUnitsStored += s.getTotalSize (isCountingActionData()) - oldSize;
+    return true;
+}
+
 void UndoManager::beginNewTransaction (const String& actionName)
 {
     newTransaction = true;
@@ -195,11 +412,12 @@ bool UndoManager::canRedo() const   { return getNextSet()    != nullptr; }
 
 bool UndoManager::undo()
 {
-    if (const ActionSet* const s = getCurrentSet())
+    if (ActionSet* const s = getCurrentSet())
     {
         const ScopedValueSetter<bool> setter (reentrancyCheck, true);
+        canCoalesceWithLastAction = false;
 
-        if (s->undo())
+        if (restoreTransaction (*s) && s->undo())
             --nextIndex;
         else
             clearUndoHistory();
@@ -214,11 +432,12 @@ bool UndoManager::undo()
 
 bool UndoManager::redo()
 {
-    if (const ActionSet* const s = getNextSet())
+    if (ActionSet* const s = getNextSet())
     {
         const ScopedValueSetter<bool> setter (reentrancyCheck, true);
+        canCoalesceWithLastAction = false;
 
-        if (s->perform())
+        if (restoreTransaction (*s) && s->perform())
             ++nextIndex;
         else
             clearUndoHistory();
@@ -98,6 +98,68 @@ public:
     void setMaxNumberOfStoredUnits (int maxNumberOfUnitsToKeep,
                                     int minimumTransactionsToKeep);
 
+    //==============================================================================
+    /** The ways in which an UndoManager can deal with its older transactions when
+        they take up more space than setMaxNumberOfStoredUnits() allows.
+        @see setOldTransactionStorage
+    */
+    enum OldTransactionStorage
+    {
+        discardOldTransactions,     /**< The oldest transactions are deleted. This is the default. */
+        compressOldTransactions,    /**< The data in older transactions is GZIP-compressed and kept in memory.
+                                         The compressed data counts towards the space used, and the oldest
+                                         transactions are deleted if there's still too much of it. */
+        moveOldTransactionsToFile   /**< The data in older transactions is GZIP-compressed and written to a
+                                         temporary file, which is deleted along with the UndoManager. */
+    };
+
+    /** Changes what happens to the older transactions when the history takes up too much space.
+
+        Only actions which implement UndoableAction::storeData() can be compressed or moved
+        to a file - any others stay in memory, and are deleted when the limit is exceeded
+        as usual. The most recent minimumTransactionsToKeep transactions are never touched,
+        and a transaction that has been stored is reloaded when it's about to be undone.
+
+        While old transactions are being compressed or moved, the size of each action's
+        data (UndoableAction::getSizeOfData()) is added to its size in units. The ValueTree
+        class's actions report the sizes of their property values, so for ValueTree edits
+        the limit that you give to setMaxNumberOfStoredUnits() becomes roughly a memory
+        budget in bytes. With discardOldTransactions, only getSizeInUnits() is counted.
+
+        @see getMemoryStatistics
+    */
+    void setOldTransactionStorage (OldTransactionStorage newStorageMethod);
+
+    /** Lets transactions which follow each other closely be merged together.
+
+        If this is more than zero, then when the first action of a new transaction is
+        performed within this many milliseconds of the previous action, and the two
+        actions can be coalesced (see UndoableAction::createCoalescedAction()), the new
+        action is merged into the previous transaction instead of starting a new one.
+        This stops things like slider drags, which set the same ValueTree property over
+        and over again, from filling up the history.
+
+        The default is 0, which turns this off.
+    */
+    void setTransactionCoalescingTime (int maxMillisecondsBetweenActions);
+
+    /** Describes the space taken up by an UndoManager's history.
+        @see getMemoryStatistics
+    */
+    struct MemoryStatistics
+    {
+        int numTransactions;                /**< The number of transactions in the history. */
+        int numStoredTransactions;          /**< The number of these whose data has been compressed or moved to a file. */
+        int numUnitsInMemory;               /**< The size of the UndoableAction objects, as returned by getNumberOfUnitsTakenUpByStoredCommands(). */
+        int64 numCompressedBytesInMemory;   /**< The size of the compressed data that's being kept in memory. */
+        int64 numBytesInFile;               /**< The size of the temporary file. This includes space that was used by transactions which have since been deleted. */
+    };
+
+    /** Returns a summary of the space taken up by the history.
+        @see setOldTransactionStorage
+    */
+    MemoryStatistics getMemoryStatistics() const;
+
     //==============================================================================
     /** Performs an action and adds it to the undo history list.
 
@@ -221,10 +283,20 @@ private:
     OwnedArray<ActionSet> transactions;
     String currentTransactionName;
     int totalUnitsStored, maxNumUnitsToKeep, minimumTransactionsToKeep, nextIndex;
-    bool newTransaction, reentrancyCheck;
+    OldTransactionStorage oldTransactionStorage;
+    ScopedPointer<TemporaryFile> storageFile;
+    int64 compressedBytesInMemory, storageFileSize;
+    int coalescingTime;
+    uint32 lastActionTime;
+    bool newTransaction, reentrancyCheck, canCoalesceWithLastAction;
     ActionSet* getCurrentSet() const noexcept;
     ActionSet* getNextSet() const noexcept;
     void clearFutureTransactions();
+    void removeTransaction (int index);
+    void storeTransaction (ActionSet&);
+    bool writeToStorageFile (const MemoryOutputStream&, ActionSet&);
+    bool restoreTransaction (ActionSet&);
+    bool isCountingActionData() const noexcept;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UndoManager)
 };
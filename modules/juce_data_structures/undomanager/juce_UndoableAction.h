@@ -94,6 +94,38 @@ public:
         If it's not possible to merge the two actions, the method should return zero.
     */
     virtual UndoableAction* createCoalescedAction (UndoableAction* nextAction)  { (void) nextAction; return nullptr; }
+
+    //==============================================================================
+    /** Can be overridden to let the UndoManager move this action's data out of memory.
+
+        If an UndoManager has been told to compress its older transactions or move them
+        to a file (see UndoManager::setOldTransactionStorage()), it'll call this for the
+        actions in those transactions. If your action holds a large amount of data, it
+        can write that data to the stream, release it, and return true. Before the action
+        is next undone or performed, restoreData() will be called with the same data.
+
+        Once the data has been released, getSizeOfData() should return a smaller value.
+
+        The default implementation does nothing and returns false, in which case the
+        action is left as it is.
+    */
+    virtual bool storeData (OutputStream& destStream)        { (void) destStream; return false; }
+
+    /** Reloads the data that was written by storeData().
+        @see storeData
+    */
+    virtual void restoreData (InputStream& sourceStream)     { (void) sourceStream; }
+
+    /** Returns the number of bytes of data that this action is holding in memory.
+
+        This is only used by an UndoManager that has been told to compress or move its older
+        transactions (see UndoManager::setOldTransactionStorage()), which adds it to the value
+        returned by getSizeInUnits(), so that its limit becomes a memory budget. If your action
+        implements storeData(), this should return the size of the data that it can release.
+
+        The default implementation returns 0.
+    */
+    virtual int getSizeOfData()                              { return 0; }
 };
 
 
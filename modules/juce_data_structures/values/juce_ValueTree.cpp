@@ -23,20 +23,368 @@
   ==============================================================================
 */
 
+/*  Holds the data for ValueTree's indexed binary format, from which the nodes of a tree are
+    loaded as they're needed.
+
+    The format begins with a 16-byte header: the bytes 0xff 'V' 'T' '2' (a 0xff byte can't
+    begin the type name that the original format starts with), then the total size, the offset
+    of the identifier table and the offset of the root node, as little-endian uint32s measured
+    from the start of the header. The identifier table is a compressed int count followed by
+    that many strings. The layout of the nodes is handled by ValueTree::SharedObject.
+*/
+class IndexedValueTreeData  : public ReferenceCountedObject
+{
+public:
+    IndexedValueTreeData (const void* const sourceData, const size_t sourceDataSize)
+        : dataCopy (sourceData, sourceDataSize)
+    {
+        initialise (dataCopy.getData(), dataCopy.getSize());
+    }
+
+    explicit IndexedValueTreeData (MemoryBlock& blockToTakeOver)
+    {
+        dataCopy.swapWith (blockToTakeOver);
+        initialise (dataCopy.getData(), dataCopy.getSize());
+    }
+
+    explicit IndexedValueTreeData (MemoryMappedFile* const mappedFileToUse)
+        : mappedFile (mappedFileToUse)
+    {
+        initialise (mappedFile->getData(), mappedFile->getSize());
+    }
+
+    typedef ReferenceCountedObjectPtr<IndexedValueTreeData> Ptr;
+
+    enum { headerSize = 16 };
+
+    static bool isMagicNumberStart (const char firstByte) noexcept
+    {
+        return (uint8) firstByte == 0xff;
+    }
+
+    static bool isIndexedFormat (const void* const d, const size_t size) noexcept
+    {
+        const char* const c = static_cast <const char*> (d);
+        return size >= headerSize && isMagicNumberStart (c[0]) && c[1] == 'V' && c[2] == 'T' && c[3] == '2';
+    }
+
+    // Reads the rest of an indexed block from a stream, after its first byte has been read.
+    static IndexedValueTreeData* createFromStream (InputStream& input)
+    {
+        char header [headerSize];
+        header[0] = (char) 0xff;
+
+        if (input.read (header + 1, headerSize - 1) == headerSize - 1 && isIndexedFormat (header, headerSize))
+        {
+            const size_t totalSize = ByteOrder::littleEndianInt (header + 4);
+            const int64 numRemaining = input.getNumBytesRemaining();
+
+            if (totalSize >= headerSize && totalSize <= 0x7fffffff
+                 && (numRemaining < 0 || (int64) (totalSize - headerSize) <= numRemaining))
+            {
+                const int numToRead = (int) (totalSize - headerSize);
+
+                if (numRemaining >= 0)
+                {
+                    MemoryBlock block (totalSize);
+                    block.copyFrom (header, 0, headerSize);
+
+                    if (input.read (static_cast <char*> (block.getData()) + headerSize, numToRead) == numToRead)
+                        return new IndexedValueTreeData (block);
+                }
+                else
+                {
+                    // If the stream can't tell us its length, the size in the header can't be
+                    // trusted, so let the block grow as the data actually arrives.
+                    MemoryBlock block (header, headerSize);
+
+                    if (input.readIntoMemoryBlock (block, numToRead) == numToRead)
+                        return new IndexedValueTreeData (block);
+                }
+            }
+        }
+
+        jassertfalse;  // trying to read corrupted data!
+        return nullptr;
+    }
+
+    const char* getData() const noexcept                { return data; }
+    uint32 getSize() const noexcept                     { return dataSize; }
+    uint32 getRootOffset() const noexcept               { return rootOffset; }
+    uint32 getIdentifierTableOffset() const noexcept    { return identifierTableOffset; }
+
+    const Identifier* getIdentifier (const int index) const noexcept
+    {
+        return isPositiveAndBelow (index, identifiers.size()) ? &identifiers.getReference (index) : nullptr;
+    }
+
+    //==============================================================================
+    class Writer
+    {
+    public:
+        Writer() {}
+
+        int getIdentifierIndex (const Identifier& identifier)
+        {
+            const pointer_sized_int key = (pointer_sized_int) identifier.getCharPointer().getAddress();
+
+            if (identifierIndexes.contains (key))
+                return identifierIndexes [key];
+
+            const int index = identifiers.size();
+            identifierIndexes.set (key, index);
+            identifiers.add (identifier);
+            return index;
+        }
+
+        uint32 getNextOffset() const noexcept
+        {
+            // The indexed format can't hold more than 4GB!
+            jassert (body.getDataSize() < 0xffffffff - headerSize);
+
+            return (uint32) (headerSize + body.getDataSize());
+        }
+
+        void writeTo (OutputStream& output, const uint32 rootOffset)
+        {
+            const uint32 tableOffset = getNextOffset();
+            body.writeCompressedInt (identifiers.size());
+
+            for (int i = 0; i < identifiers.size(); ++i)
+                body.writeString (identifiers.getReference(i).toString());
+
+            output.writeByte ((char) 0xff);
+            output.write ("VT2", 3);
+            output.writeInt ((int) getNextOffset());
+            output.writeInt ((int) tableOffset);
+            output.writeInt ((int) rootOffset);
+            output << body;
+        }
+
+        MemoryOutputStream body;
+
+    private:
+        HashMap<pointer_sized_int, int> identifierIndexes;
+        Array<Identifier> identifiers;
+
+        JUCE_DECLARE_NON_COPYABLE (Writer)
+    };
+
+private:
+    //==============================================================================
+    MemoryBlock dataCopy;
+    ScopedPointer<MemoryMappedFile> mappedFile;
+    const char* data;
+    uint32 dataSize, rootOffset, identifierTableOffset;
+    Array<Identifier> identifiers;
+
+    void initialise (const void* const d, const size_t size)
+    {
+        data = static_cast <const char*> (d);
+        dataSize = 0;
+        rootOffset = 0;
+        identifierTableOffset = 0;
+
+        if (! isIndexedFormat (d, size))
+            return;
+
+        const uint32 totalSize     = ByteOrder::littleEndianInt (data + 4);
+        const uint32 tableOffset   = ByteOrder::littleEndianInt (data + 8);
+        const uint32 rootNode      = ByteOrder::littleEndianInt (data + 12);
+
+        if (totalSize > size || tableOffset < headerSize || tableOffset >= totalSize)
+        {
+            jassertfalse;  // trying to read corrupted data!
+            return;
+        }
+
+        MemoryInputStream in (data + tableOffset, totalSize - tableOffset, false);
+        const int numIdentifiers = in.readCompressedInt();
+
+        if (numIdentifiers < 0 || numIdentifiers > (int) (totalSize - tableOffset))
+        {
+            jassertfalse;  // trying to read corrupted data!
+            return;
+        }
+
+        identifiers.ensureStorageAllocated (numIdentifiers);
+
+        for (int i = 0; i < numIdentifiers; ++i)
+        {
+            const String name (in.readString());
+
+            if (name.isEmpty())
+            {
+                jassertfalse;  // trying to read corrupted data!
+                identifiers.clear();
+                return;
+            }
+
+            identifiers.add (Identifier (name));
+        }
+
+        dataSize = totalSize;
+        identifierTableOffset = tableOffset;
+        rootOffset = rootNode;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (IndexedValueTreeData)
+};
+
+//==============================================================================
+// An immutable copy of a node, which is shared by all the snapshots that contain it.
+class ValueTree::SnapshotNode  : public ReferenceCountedObject
+{
+public:
+    SnapshotNode (const Identifier& type_, const NamedValueSet& properties_)
+        : type (type_), properties (properties_)
+    {
+    }
+
+    typedef ReferenceCountedObjectPtr<SnapshotNode> Ptr;
+
+    // Roughly how many bytes this node and its sub-nodes use, not counting the parts
+    // that it shares with the equivalent position in another snapshot.
+    static int estimateUnsharedSize (const SnapshotNode* const node, const SnapshotNode* const other) noexcept
+    {
+        if (node == nullptr || node == other)
+            return 0;
+
+        int total = (int) sizeof (SnapshotNode)
+                      + node->properties.size() * (int) (sizeof (Identifier) + sizeof (var) + 16)
+                      + node->children.size() * (int) sizeof (SnapshotNode*);
+
+        for (int i = 0; i < node->children.size(); ++i)
+            total += estimateUnsharedSize (node->children.getObjectPointerUnchecked (i),
+                                           (other != nullptr && i < other->children.size())
+                                               ? other->children.getObjectPointerUnchecked (i) : nullptr);
+
+        return total;
+    }
+
+    const Identifier type;
+    const NamedValueSet properties;
+    ReferenceCountedArray<SnapshotNode> children;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (SnapshotNode)
+};
+
+//==============================================================================
+class ValueTree::NotificationRecorder  : public ReferenceCountedObject
+{
+public:
+    NotificationRecorder() noexcept
+        : numChangesRecorded (0), numListenerCallbacks (0)
+    {
+    }
+
+    typedef ReferenceCountedObjectPtr<NotificationRecorder> Ptr;
+
+    void addChange (const Change::Type type, SharedObject* const tree,
+                    SharedObject* const child, const Identifier& property)
+    {
+        ++numChangesRecorded;
+
+        if (type != Change::childAdded && type != Change::childRemoved)
+        {
+            const ChangeKey key = { type, tree, property };
+
+            if (uniqueChanges.contains (key))
+                return;
+
+            uniqueChanges.set (key, changes.size());
+        }
+
+        Change c;
+        c.type = type;
+        c.tree = ValueTree (tree);
+        c.child = ValueTree (child);
+        c.property = property;
+        changes.add (c);
+    }
+
+    void addParentChanges (SharedObject* tree);
+    int deliver();
+
+    bool hasPendingChanges() const noexcept     { return changes.size() > 0; }
+    int getNumPendingChanges() const noexcept   { return changes.size(); }
+
+    int numChangesRecorded, numListenerCallbacks;
+
+    //==============================================================================
+    class DeliveryMessage  : public CallbackMessage
+    {
+    public:
+        DeliveryMessage (NotificationRecorder* const recorder_) noexcept  : recorder (recorder_) {}
+
+        void messageCallback()      { recorder->deliver(); }
+
+    private:
+        const NotificationRecorder::Ptr recorder;
+
+        JUCE_DECLARE_NON_COPYABLE (DeliveryMessage)
+    };
+
+private:
+    //==============================================================================
+    struct ChangeKey
+    {
+        Change::Type type;
+        const SharedObject* tree;
+        Identifier property;
+
+        bool operator== (const ChangeKey& other) const noexcept
+        {
+            return tree == other.tree && property == other.property && type == other.type;
+        }
+    };
+
+    struct ChangeKeyHash
+    {
+        static int generateHash (const ChangeKey& key, const int upperLimit) noexcept
+        {
+            const uint32 h = (uint32) (((pointer_sized_int) key.tree) >> 3)
+                              ^ ((uint32) (((pointer_sized_int) key.property.getCharPointer().getAddress()) >> 2) * 31)
+                              ^ (uint32) key.type;
+            return (int) (h % (uint32) upperLimit);
+        }
+    };
+
+    // The changes that need to go to the listeners of one of the objects in the tree
+    struct ListenerGroup
+    {
+        ReferenceCountedObjectPtr<SharedObject> owner;
+        Array<Change> changes;
+    };
+
+    Array<Change> changes;
+    HashMap<ChangeKey, int, ChangeKeyHash> uniqueChanges;
+
+    static void addToListenerGroups (OwnedArray<ListenerGroup>&, HashMap<pointer_sized_int, int>&,
+                                     SharedObject*, const Change&);
+
+    JUCE_DECLARE_NON_COPYABLE (NotificationRecorder)
+};
+
+//==============================================================================
 class ValueTree::SharedObject  : public ReferenceCountedObject
 {
 public:
     typedef ReferenceCountedObjectPtr<SharedObject> Ptr;
 
     explicit SharedObject (const Identifier& t) noexcept
-        : type (t), parent (nullptr)
+        : type (t), parent (nullptr), recorder (nullptr), unloadedChildrenOffset (0)
     {
     }
 
     SharedObject (const SharedObject& other)
         : ReferenceCountedObject(),
-          type (other.type), properties (other.properties), parent (nullptr)
+          type (other.type), properties (other.properties), parent (nullptr),
+          recorder (nullptr), unloadedChildrenOffset (0), cachedSnapshot (other.cachedSnapshot)
     {
+        other.ensureChildrenLoaded();
+
         for (int i = 0; i < other.children.size(); ++i)
         {
             SharedObject* const child = new SharedObject (*other.children.getObjectPointerUnchecked(i));
@@ -67,10 +415,19 @@ public:
 
     void sendPropertyChangeMessage (const Identifier& property)
     {
-        ValueTree tree (this);
+        invalidateSnapshots();
 
-        for (ValueTree::SharedObject* t = this; t != nullptr; t = t->parent)
-            t->sendPropertyChangeMessage (tree, property);
+        if (NotificationRecorder* const batch = findRecorder())
+        {
+            batch->addChange (Change::propertyChanged, this, nullptr, property);
+        }
+        else
+        {
+            ValueTree tree (this);
+
+            for (ValueTree::SharedObject* t = this; t != nullptr; t = t->parent)
+                t->sendPropertyChangeMessage (tree, property);
+        }
     }
 
     void sendChildAddedMessage (ValueTree& tree, ValueTree& child)
@@ -82,10 +439,19 @@ public:
 
     void sendChildAddedMessage (ValueTree child)
     {
-        ValueTree tree (this);
+        invalidateSnapshots();
+
+        if (NotificationRecorder* const batch = findRecorder())
+        {
+            batch->addChange (Change::childAdded, this, child.object, Identifier());
+        }
+        else
+        {
+            ValueTree tree (this);
 
-        for (ValueTree::SharedObject* t = this; t != nullptr; t = t->parent)
-            t->sendChildAddedMessage (tree, child);
+            for (ValueTree::SharedObject* t = this; t != nullptr; t = t->parent)
+                t->sendChildAddedMessage (tree, child);
+        }
     }
 
     void sendChildRemovedMessage (ValueTree& tree, ValueTree& child)
@@ -97,10 +463,19 @@ public:
 
     void sendChildRemovedMessage (ValueTree child)
     {
-        ValueTree tree (this);
+        invalidateSnapshots();
 
-        for (ValueTree::SharedObject* t = this; t != nullptr; t = t->parent)
-            t->sendChildRemovedMessage (tree, child);
+        if (NotificationRecorder* const batch = findRecorder())
+        {
+            batch->addChange (Change::childRemoved, this, child.object, Identifier());
+        }
+        else
+        {
+            ValueTree tree (this);
+
+            for (ValueTree::SharedObject* t = this; t != nullptr; t = t->parent)
+                t->sendChildRemovedMessage (tree, child);
+        }
     }
 
     void sendChildOrderChangedMessage (ValueTree& tree)
@@ -112,10 +487,27 @@ public:
 
     void sendChildOrderChangedMessage()
     {
-        ValueTree tree (this);
+        invalidateSnapshots();
+
+        if (NotificationRecorder* const batch = findRecorder())
+        {
+            batch->addChange (Change::childOrderChanged, this, nullptr, Identifier());
+        }
+        else
+        {
+            ValueTree tree (this);
 
-        for (ValueTree::SharedObject* t = this; t != nullptr; t = t->parent)
-            t->sendChildOrderChangedMessage (tree);
+            for (ValueTree::SharedObject* t = this; t != nullptr; t = t->parent)
+                t->sendChildOrderChangedMessage (tree);
+        }
+    }
+
+    void sendParentChangeMessage (NotificationRecorder* const batch)
+    {
+        if (batch != nullptr)
+            batch->addParentChanges (this);
+        else
+            sendParentChangeMessage();
     }
 
     void sendParentChangeMessage()
@@ -131,6 +523,16 @@ public:
                 v->listeners.call (&ValueTree::Listener::valueTreeParentChanged, tree);
     }
 
+    // Returns the batch that's holding back notifications for this tree, if there is one.
+    NotificationRecorder* findRecorder() const noexcept
+    {
+        for (const SharedObject* t = this; t != nullptr; t = t->parent)
+            if (t->recorder != nullptr)
+                return t->recorder;
+
+        return nullptr;
+    }
+
     const var& getProperty (const Identifier& name) const noexcept
     {
         return properties [name];
@@ -212,6 +614,8 @@ public:
 
     ValueTree getChildWithName (const Identifier& typeToMatch) const
     {
+        ensureChildrenLoaded();
+
         for (int i = 0; i < children.size(); ++i)
         {
             SharedObject* const s = children.getObjectPointerUnchecked (i);
@@ -224,6 +628,8 @@ public:
 
     ValueTree getOrCreateChildWithName (const Identifier& typeToMatch, UndoManager* undoManager)
     {
+        ensureChildrenLoaded();
+
         for (int i = 0; i < children.size(); ++i)
         {
             SharedObject* const s = children.getObjectPointerUnchecked (i);
@@ -239,6 +645,8 @@ public:
 
     ValueTree getChildWithProperty (const Identifier& propertyName, const var& propertyValue) const
     {
+        ensureChildrenLoaded();
+
         for (int i = 0; i < children.size(); ++i)
         {
             SharedObject* const s = children.getObjectPointerUnchecked (i);
@@ -280,12 +688,14 @@ public:
                     child->parent->removeChild (child->parent->children.indexOf (child), undoManager);
                 }
 
+                ensureChildrenLoaded();
+
                 if (undoManager == nullptr)
                 {
                     children.insert (index, child);
                     child->parent = this;
                     sendChildAddedMessage (ValueTree (child));
-                    child->sendParentChangeMessage();
+                    child->sendParentChangeMessage (findRecorder());
                 }
                 else
                 {
@@ -306,6 +716,7 @@ public:
 
     void removeChild (const int childIndex, UndoManager* const undoManager)
     {
+        ensureChildrenLoaded();
         const Ptr child (children.getObjectPointer (childIndex));
 
         if (child != nullptr)
@@ -315,7 +726,7 @@ public:
                 children.remove (childIndex);
                 child->parent = nullptr;
                 sendChildRemovedMessage (ValueTree (child));
-                child->sendParentChangeMessage();
+                child->sendParentChangeMessage (findRecorder());
             }
             else
             {
@@ -326,12 +737,16 @@ public:
 
     void removeAllChildren (UndoManager* const undoManager)
     {
+        ensureChildrenLoaded();
+
         while (children.size() > 0)
             removeChild (children.size() - 1, undoManager);
     }
 
     void moveChild (int currentIndex, int newIndex, UndoManager* undoManager)
     {
+        ensureChildrenLoaded();
+
         // The source index must be a valid index!
         jassert (isPositiveAndBelow (currentIndex, children.size()));
 
@@ -355,6 +770,7 @@ public:
 
     void reorderChildren (const OwnedArray<ValueTree>& newOrder, UndoManager* undoManager)
     {
+        ensureChildrenLoaded();
         jassert (newOrder.size() == children.size());
 
         if (undoManager == nullptr)
@@ -385,6 +801,9 @@ public:
 
     bool isEquivalentTo (const SharedObject& other) const
     {
+        ensureChildrenLoaded();
+        other.ensureChildrenLoaded();
+
         if (type != other.type
              || properties.size() != other.properties.size()
              || children.size() != other.children.size()
@@ -400,6 +819,8 @@ public:
 
     XmlElement* createXml() const
     {
+        ensureChildrenLoaded();
+
         XmlElement* const xml = new XmlElement (type.toString());
         properties.copyToXmlAttributes (*xml);
 
@@ -411,6 +832,8 @@ public:
 
     void writeToStream (OutputStream& output) const
     {
+        ensureChildrenLoaded();
+
         output.writeString (type.toString());
         output.writeCompressedInt (properties.size());
 
@@ -440,6 +863,316 @@ public:
         }
     }
 
+    //==============================================================================
+    // If a node has a snapshot, then so do all of its sub-nodes, so this can stop at the
+    // first parent that doesn't have one.
+    void invalidateSnapshots() noexcept
+    {
+        for (SharedObject* t = this; t != nullptr && t->cachedSnapshot != nullptr; t = t->parent)
+            t->cachedSnapshot = nullptr;
+    }
+
+    SnapshotNode* getSnapshot()
+    {
+        if (cachedSnapshot == nullptr)
+        {
+            ensureChildrenLoaded();
+
+            SnapshotNode* const s = new SnapshotNode (type, properties);
+            s->children.ensureStorageAllocated (children.size());
+
+            for (int i = 0; i < children.size(); ++i)
+                s->children.add (children.getObjectPointerUnchecked(i)->getSnapshot());
+
+            cachedSnapshot = s;
+        }
+
+        return cachedSnapshot;
+    }
+
+    static SharedObject* createFromSnapshot (SnapshotNode& snapshot)
+    {
+        SharedObject* const s = new SharedObject (snapshot.type);
+        s->properties = snapshot.properties;
+        s->children.ensureStorageAllocated (snapshot.children.size());
+
+        for (int i = 0; i < snapshot.children.size(); ++i)
+        {
+            SharedObject* const child = createFromSnapshot (*snapshot.children.getObjectPointerUnchecked(i));
+            child->parent = s;
+            s->children.add (child);
+        }
+
+        s->cachedSnapshot = &snapshot;
+        return s;
+    }
+
+    void restoreSnapshot (SnapshotNode& target, UndoManager* const undoManager)
+    {
+        if (cachedSnapshot == &target)
+            return;
+
+        jassert (type == target.type);
+
+        for (int i = properties.size(); --i >= 0;)
+            if (! target.properties.contains (properties.getName (i)))
+                removeProperty (properties.getName (i), undoManager);
+
+        for (int i = 0; i < target.properties.size(); ++i)
+            setProperty (target.properties.getName (i), target.properties.getValueAt (i), undoManager);
+
+        restoreChildren (target, undoManager);
+
+        // (a listener may have made some other changes in response to the ones made here)
+        if (matchesSnapshot (target))
+            cachedSnapshot = &target;
+    }
+
+    void restoreChildren (SnapshotNode& target, UndoManager* const undoManager)
+    {
+        ensureChildrenLoaded();
+
+        // The snapshots of the current children and of the target's children, so that any
+        // children which are unchanged but have moved can be found.
+        HashMap<pointer_sized_int, int> currentStates, targetStates;
+        bool statesFound = false;
+
+        for (int i = 0; i < target.children.size();)
+        {
+            SnapshotNode* const wanted = target.children.getObjectPointerUnchecked(i);
+            const Ptr current (children.getObjectPointer (i));
+
+            if (current != nullptr && current->cachedSnapshot == wanted)
+            {
+                ++i;
+                continue;
+            }
+
+            // If this is the start of a run of changed children which are followed by some
+            // unchanged ones in the same places, then they can all just be changed in-place.
+            const int runEnd = findEndOfChangedRun (target, i);
+
+            if (runEnd > i)
+            {
+                for (; i < runEnd; ++i)
+                {
+                    const Ptr child (children.getObjectPointer (i));
+
+                    if (child != nullptr)
+                        child->restoreSnapshot (*target.children.getObjectPointerUnchecked(i), undoManager);
+                }
+
+                continue;
+            }
+
+            if (! statesFound)
+            {
+                statesFound = true;
+
+                for (int j = 0; j < children.size(); ++j)
+                    if (SnapshotNode* const state = children.getObjectPointerUnchecked(j)->cachedSnapshot)
+                        currentStates.set ((pointer_sized_int) state, j);
+
+                for (int j = 0; j < target.children.size(); ++j)
+                    targetStates.set ((pointer_sized_int) target.children.getObjectPointerUnchecked(j), j);
+            }
+
+            const bool currentIsWantedElsewhere = current != nullptr && current->cachedSnapshot != nullptr
+                                                    && targetStates.contains ((pointer_sized_int) current->cachedSnapshot.get());
+
+            const int existingIndex = currentStates.contains ((pointer_sized_int) wanted)
+                                        ? indexOfChildInState (*wanted, i + 1) : -1;
+
+            if (existingIndex > i)
+            {
+                if (current != nullptr && ! currentIsWantedElsewhere)
+                {
+                    removeChild (i, undoManager);
+                    continue;
+                }
+
+                moveChild (existingIndex, i, undoManager);
+            }
+            else if (current != nullptr && ! currentIsWantedElsewhere && current->type == wanted->type)
+            {
+                current->restoreSnapshot (*wanted, undoManager);
+            }
+            else
+            {
+                addChild (createFromSnapshot (*wanted), i, undoManager);
+            }
+
+            ++i;
+        }
+
+        while (children.size() > target.children.size())
+            removeChild (children.size() - 1, undoManager);
+    }
+
+    int findEndOfChangedRun (const SnapshotNode& target, const int start) const noexcept
+    {
+        const int num = jmin (children.size(), target.children.size());
+        int end = start;
+
+        while (end < num)
+        {
+            const SharedObject* const child = children.getObjectPointerUnchecked (end);
+            const SnapshotNode* const wanted = target.children.getObjectPointerUnchecked (end);
+
+            if (child->cachedSnapshot == wanted)
+                return end;
+
+            if (child->type != wanted->type)
+                return start;
+
+            ++end;
+        }
+
+        return children.size() == target.children.size() ? end : start;
+    }
+
+    int indexOfChildInState (const SnapshotNode& state, const int startIndex) const noexcept
+    {
+        for (int i = startIndex; i < children.size(); ++i)
+            if (children.getObjectPointerUnchecked(i)->cachedSnapshot == &state)
+                return i;
+
+        return -1;
+    }
+
+    bool matchesSnapshot (const SnapshotNode& target) const
+    {
+        if (children.size() != target.children.size() || properties != target.properties)
+            return false;
+
+        for (int i = 0; i < children.size(); ++i)
+            if (children.getObjectPointerUnchecked(i)->cachedSnapshot.get() != target.children.getObjectPointerUnchecked(i))
+                return false;
+
+        return true;
+    }
+
+    //==============================================================================
+    /*  In the indexed format, each node is a compressed int index of its type in the identifier
+        table, a compressed int number of properties followed by the index of each property's name
+        and its value, and then a compressed int number of children followed by the uint32 offset
+        of each child. Children are always written before their parents, so the writer never needs
+        to go back and fill in an offset, and a reader can't be sent round in circles.
+    */
+    uint32 writeToIndexedData (IndexedValueTreeData::Writer& writer) const
+    {
+        ensureChildrenLoaded();
+
+        Array<uint32> childOffsets;
+        childOffsets.ensureStorageAllocated (children.size());
+
+        for (int i = 0; i < children.size(); ++i)
+            childOffsets.add (children.getObjectPointerUnchecked(i)->writeToIndexedData (writer));
+
+        const uint32 offset = writer.getNextOffset();
+        OutputStream& output = writer.body;
+
+        output.writeCompressedInt (writer.getIdentifierIndex (type));
+        output.writeCompressedInt (properties.size());
+
+        for (int j = 0; j < properties.size(); ++j)
+        {
+            output.writeCompressedInt (writer.getIdentifierIndex (properties.getName (j)));
+            properties.getValueAt(j).writeToStream (output);
+        }
+
+        output.writeCompressedInt (childOffsets.size());
+
+        for (int i = 0; i < childOffsets.size(); ++i)
+            output.writeInt ((int) childOffsets.getUnchecked(i));
+
+        return offset;
+    }
+
+    // Creates a node from the indexed data. Its offset must be before the end offset.
+    static SharedObject* readFromIndexedData (IndexedValueTreeData& source, const uint32 offset, const uint32 endOffset)
+    {
+        if (offset < IndexedValueTreeData::headerSize || offset >= endOffset || endOffset > source.getSize())
+            return nullptr;
+
+        MemoryInputStream input (source.getData() + offset, endOffset - offset, false);
+
+        const Identifier* const nodeType = source.getIdentifier (input.readCompressedInt());
+        const int numProps = input.readCompressedInt();
+
+        if (nodeType == nullptr || numProps < 0)
+            return nullptr;
+
+        ScopedPointer<SharedObject> s (new SharedObject (*nodeType));
+
+        for (int i = 0; i < numProps; ++i)
+        {
+            const Identifier* const name = source.getIdentifier (input.readCompressedInt());
+
+            if (name == nullptr)
+                return nullptr;
+
+            s->properties.set (*name, var::readFromStream (input));
+        }
+
+        const uint32 childListOffset = offset + (uint32) input.getPosition();
+        const int numChildren = input.readCompressedInt();
+
+        if (numChildren < 0 || numChildren > input.getNumBytesRemaining() / 4)
+            return nullptr;
+
+        if (numChildren > 0)
+        {
+            s->unloadedChildren = &source;
+            s->unloadedChildrenOffset = childListOffset;
+        }
+
+        return s.release();
+    }
+
+    static SharedObject* readRootFromIndexedData (IndexedValueTreeData* const source)
+    {
+        if (source == nullptr || source->getRootOffset() == 0)
+            return nullptr;
+
+        SharedObject* const root = readFromIndexedData (*source, source->getRootOffset(),
+                                                        source->getIdentifierTableOffset());
+        jassert (root != nullptr);  // trying to read corrupted data!
+        return root;
+    }
+
+    void ensureChildrenLoaded() const
+    {
+        if (unloadedChildren != nullptr)
+            const_cast <SharedObject*> (this)->loadChildren();
+    }
+
+    void loadChildren()
+    {
+        const IndexedValueTreeData::Ptr source (unloadedChildren);
+        unloadedChildren = nullptr;
+
+        MemoryInputStream input (source->getData() + unloadedChildrenOffset,
+                                 source->getSize() - unloadedChildrenOffset, false);
+
+        const int numChildren = input.readCompressedInt();
+        children.ensureStorageAllocated (numChildren);
+
+        for (int i = 0; i < numChildren; ++i)
+        {
+            SharedObject* const child = readFromIndexedData (*source, (uint32) input.readInt(), unloadedChildrenOffset);
+
+            if (child == nullptr)
+            {
+                jassertfalse;  // trying to read corrupted data!
+                break;
+            }
+
+            child->parent = this;
+            children.add (child);
+        }
+    }
+
     //==============================================================================
     class SetPropertyAction  : public UndoableAction
     {
@@ -479,6 +1212,31 @@ public:
             return (int) sizeof (*this); //xxx should be more accurate
         }
 
+        int getSizeOfData()
+        {
+            return getSizeOfValue (newValue) + getSizeOfValue (oldValue);
+        }
+
+        bool storeData (OutputStream& output)
+        {
+            // small values aren't worth the trouble of moving
+            if (getSizeOfData() < 256
+                 || ! (canBeStored (newValue) && canBeStored (oldValue)))
+                return false;
+
+            newValue.writeToStream (output);
+            oldValue.writeToStream (output);
+            newValue = var::null;
+            oldValue = var::null;
+            return true;
+        }
+
+        void restoreData (InputStream& input)
+        {
+            newValue = var::readFromStream (input);
+            oldValue = var::readFromStream (input);
+        }
+
         UndoableAction* createCoalescedAction (UndoableAction* nextAction)
         {
             if (! (isAddingNewProperty || isDeletingProperty))
@@ -495,10 +1253,43 @@ public:
     private:
         const Ptr target;
         const Identifier name;
-        const var newValue;
-        var oldValue;
+        var newValue, oldValue;
         const bool isAddingNewProperty : 1, isDeletingProperty : 1;
 
+        static int getSizeOfValue (const var& v)
+        {
+            if (v.isString())
+                return (int) v.toString().getNumBytesAsUTF8();
+
+            if (const MemoryBlock* const mb = v.getBinaryData())
+                return (int) mb->getSize();
+
+            if (const Array<var>* const array = v.getArray())
+            {
+                int total = 0;
+
+                for (int i = array->size(); --i >= 0;)
+                    total += (int) sizeof (var) + getSizeOfValue (array->getReference(i));
+
+                return total;
+            }
+
+            return 0;
+        }
+
+        static bool canBeStored (const var& v)
+        {
+            if (v.isObject() || v.isMethod())
+                return false;
+
+            if (const Array<var>* const array = v.getArray())
+                for (int i = array->size(); --i >= 0;)
+                    if (! canBeStored (array->getReference(i)))
+                        return false;
+
+            return true;
+        }
+
         JUCE_DECLARE_NON_COPYABLE (SetPropertyAction)
     };
 
@@ -544,15 +1335,60 @@ public:
 
         int getSizeInUnits()
         {
-            return (int) sizeof (*this); //xxx should be more accurate
+            return (int) sizeof (*this); //xxx should be more accurate
+        }
+
+    private:
+        const Ptr target, child;
+        const int childIndex;
+        const bool isDeleting;
+
+        JUCE_DECLARE_NON_COPYABLE (AddOrRemoveChildAction)
+    };
+
+    //==============================================================================
+    class RestoreSnapshotAction  : public UndoableAction
+    {
+    public:
+        RestoreSnapshotAction (SharedObject* const target_, SnapshotNode* const stateBefore_,
+                               SnapshotNode* const stateAfter_) noexcept
+            : target (target_), stateBefore (stateBefore_), stateAfter (stateAfter_),
+              sizeInUnits ((int) sizeof (*this) + SnapshotNode::estimateUnsharedSize (stateAfter_, stateBefore_))
+        {
+        }
+
+        bool perform()
+        {
+            target->restoreSnapshot (*stateAfter, nullptr);
+            return true;
+        }
+
+        bool undo()
+        {
+            target->restoreSnapshot (*stateBefore, nullptr);
+            return true;
+        }
+
+        int getSizeInUnits()
+        {
+            return sizeInUnits;
+        }
+
+        UndoableAction* createCoalescedAction (UndoableAction* nextAction)
+        {
+            if (RestoreSnapshotAction* const next = dynamic_cast <RestoreSnapshotAction*> (nextAction))
+                if (next->target == target && next->stateBefore == stateAfter)
+                    return new RestoreSnapshotAction (target, stateBefore, next->stateAfter);
+
+            return nullptr;
         }
 
     private:
-        const Ptr target, child;
-        const int childIndex;
-        const bool isDeleting;
+        const Ptr target;
+        const SnapshotNode::Ptr stateBefore, stateAfter;
+        const int sizeInUnits;
 
-        JUCE_DECLARE_NON_COPYABLE (AddOrRemoveChildAction)
+        JUCE_DECLARE_NON_COPYABLE (RestoreSnapshotAction)
     };
 
     //==============================================================================
@@ -603,12 +1439,93 @@ public:
     ReferenceCountedArray<SharedObject> children;
     SortedSet<ValueTree*> valueTreesWithListeners;
     SharedObject* parent;
+    NotificationRecorder* recorder;
+    IndexedValueTreeData::Ptr unloadedChildren;
+    uint32 unloadedChildrenOffset;
+    SnapshotNode::Ptr cachedSnapshot;
 
 private:
     SharedObject& operator= (const SharedObject&);
     JUCE_LEAK_DETECTOR (SharedObject)
 };
 
+//==============================================================================
+void ValueTree::NotificationRecorder::addParentChanges (SharedObject* const tree)
+{
+    for (int i = tree->children.size(); --i >= 0;)
+        addParentChanges (tree->children.getObjectPointerUnchecked (i));
+
+    if (tree->valueTreesWithListeners.size() > 0)
+        addChange (Change::parentChanged, tree, nullptr, Identifier());
+}
+
+void ValueTree::NotificationRecorder::addToListenerGroups (OwnedArray<ListenerGroup>& groups,
+                                                           HashMap<pointer_sized_int, int>& groupIndexes,
+                                                           SharedObject* const owner, const Change& change)
+{
+    if (owner->valueTreesWithListeners.size() > 0)
+    {
+        const pointer_sized_int key = (pointer_sized_int) owner;
+
+        if (! groupIndexes.contains (key))
+        {
+            ListenerGroup* const g = new ListenerGroup();
+            g->owner = owner;
+            groupIndexes.set (key, groups.size());
+            groups.add (g);
+        }
+
+        groups.getUnchecked (groupIndexes [key])->changes.add (change);
+    }
+}
+
+int ValueTree::NotificationRecorder::deliver()
+{
+    const Ptr deletionProtector (this);
+
+    // Any changes that the listeners make while this is delivering will go into a new set.
+    Array<Change> changesToDeliver;
+    changesToDeliver.swapWithArray (changes);
+    uniqueChanges.clear();
+
+    OwnedArray<ListenerGroup> groups;
+    HashMap<pointer_sized_int, int> groupIndexes;
+
+    for (int i = 0; i < changesToDeliver.size(); ++i)
+    {
+        const Change& c = changesToDeliver.getReference (i);
+
+        if (c.type == Change::parentChanged)
+        {
+            addToListenerGroups (groups, groupIndexes, c.tree.object, c);
+        }
+        else
+        {
+            for (SharedObject* t = c.tree.object; t != nullptr; t = t->parent)
+                addToListenerGroups (groups, groupIndexes, t, c);
+        }
+    }
+
+    int numCallbacks = 0;
+
+    for (int i = 0; i < groups.size(); ++i)
+    {
+        const ListenerGroup& g = *groups.getUnchecked (i);
+
+        for (int j = g.owner->valueTreesWithListeners.size(); --j >= 0;)
+        {
+            if (ValueTree* const v = g.owner->valueTreesWithListeners[j])
+            {
+                numCallbacks += v->listeners.size();
+                v->listeners.call (&ValueTree::Listener::valueTreeChangesBatched, g.changes);
+            }
+        }
+    }
+
+    numListenerCallbacks += numCallbacks;
+    return numCallbacks;
+}
+
 //==============================================================================
 ValueTree::ValueTree() noexcept
 {
@@ -822,13 +1739,20 @@ Value ValueTree::getPropertyAsValue (const Identifier& name, UndoManager* const
 //==============================================================================
 int ValueTree::getNumChildren() const
 {
-    return object == nullptr ? 0 : object->children.size();
+    if (object == nullptr)
+        return 0;
+
+    object->ensureChildrenLoaded();
+    return object->children.size();
 }
 
 ValueTree ValueTree::getChild (int index) const
 {
-    return ValueTree (object != nullptr ? object->children.getObjectPointer (index)
-                                        : static_cast <SharedObject*> (nullptr));
+    if (object == nullptr)
+        return ValueTree::invalid;
+
+    object->ensureChildrenLoaded();
+    return ValueTree (object->children.getObjectPointer (index));
 }
 
 ValueTree ValueTree::getChildWithName (const Identifier& type) const
@@ -892,6 +1816,7 @@ void ValueTree::moveChild (int currentIndex, int newIndex, UndoManager* undoMana
 void ValueTree::createListOfChildren (OwnedArray<ValueTree>& list) const
 {
     jassert (object != nullptr);
+    object->ensureChildrenLoaded();
 
     for (int i = 0; i < object->children.size(); ++i)
         list.add (new ValueTree (object->children.getObjectPointerUnchecked(i)));
@@ -958,13 +1883,33 @@ void ValueTree::writeToStream (OutputStream& output) const
     SharedObject::writeObjectToStream (output, object);
 }
 
+void ValueTree::writeToIndexedStream (OutputStream& output) const
+{
+    IndexedValueTreeData::Writer writer;
+    const uint32 rootOffset = object != nullptr ? object->writeToIndexedData (writer) : 0;
+    writer.writeTo (output, rootOffset);
+}
+
 ValueTree ValueTree::readFromStream (InputStream& input)
 {
-    const String type (input.readString());
+    const char firstByte = input.readByte();
 
-    if (type.isEmpty())
+    if (firstByte == 0)
         return ValueTree::invalid;
 
+    if (IndexedValueTreeData::isMagicNumberStart (firstByte))
+    {
+        const IndexedValueTreeData::Ptr source (IndexedValueTreeData::createFromStream (input));
+        return ValueTree (SharedObject::readRootFromIndexedData (source));
+    }
+
+    MemoryOutputStream typeName;
+
+    for (char c = firstByte; c != 0; c = input.readByte())
+        typeName.writeByte (c);
+
+    const String type (typeName.toUTF8());
+
     ValueTree v (type);
 
     const int numProps = input.readCompressedInt();
@@ -999,10 +1944,39 @@ ValueTree ValueTree::readFromStream (InputStream& input)
 
 ValueTree ValueTree::readFromData (const void* const data, const size_t numBytes)
 {
+    if (IndexedValueTreeData::isIndexedFormat (data, numBytes))
+    {
+        const IndexedValueTreeData::Ptr source (new IndexedValueTreeData (data, numBytes));
+        return ValueTree (SharedObject::readRootFromIndexedData (source));
+    }
+
     MemoryInputStream in (data, numBytes, false);
     return readFromStream (in);
 }
 
+ValueTree ValueTree::readFromFile (const File& file)
+{
+    ScopedPointer<MemoryMappedFile> mappedFile (new MemoryMappedFile (file, MemoryMappedFile::readOnly));
+
+    if (mappedFile->getData() != nullptr)
+    {
+        if (IndexedValueTreeData::isIndexedFormat (mappedFile->getData(), mappedFile->getSize()))
+        {
+            const IndexedValueTreeData::Ptr source (new IndexedValueTreeData (mappedFile.release()));
+            return ValueTree (SharedObject::readRootFromIndexedData (source));
+        }
+
+        return readFromData (mappedFile->getData(), mappedFile->getSize());
+    }
+
+    FileInputStream in (file);
+
+    if (in.openedOk())
+        return readFromStream (in);
+
+    return ValueTree::invalid;
+}
+
 ValueTree ValueTree::readFromGZIPData (const void* const data, const size_t numBytes)
 {
     MemoryInputStream in (data, numBytes, false);
@@ -1010,8 +1984,191 @@ ValueTree ValueTree::readFromGZIPData (const void* const data, const size_t numB
     return readFromStream (gzipStream);
 }
 
+//==============================================================================
+ValueTree::Snapshot ValueTree::createSnapshot() const
+{
+    return Snapshot (object != nullptr ? object->getSnapshot() : nullptr);
+}
+
+void ValueTree::restoreSnapshot (const Snapshot& snapshot, UndoManager* const undoManager)
+{
+    // You can only restore a snapshot of the same type of tree!
+    jassert (object != nullptr && snapshot.node != nullptr && object->type == snapshot.node->type);
+
+    if (object != nullptr && snapshot.node != nullptr && object->type == snapshot.node->type)
+    {
+        if (undoManager == nullptr)
+            object->restoreSnapshot (*snapshot.node, nullptr);
+        else
+            undoManager->perform (new SharedObject::RestoreSnapshotAction (object, object->getSnapshot(), snapshot.node));
+    }
+}
+
+UndoableAction* ValueTree::createUndoActionFrom (const Snapshot& previousState)
+{
+    // The snapshot must be an earlier state of this tree!
+    jassert (object != nullptr && previousState.node != nullptr && object->type == previousState.node->type);
+
+    if (object != nullptr && previousState.node != nullptr && object->type == previousState.node->type)
+        return new SharedObject::RestoreSnapshotAction (object, previousState.node, object->getSnapshot());
+
+    return nullptr;
+}
+
+//==============================================================================
+ValueTree::Snapshot::Snapshot() noexcept {}
+ValueTree::Snapshot::Snapshot (SnapshotNode* const node_) noexcept  : node (node_) {}
+ValueTree::Snapshot::Snapshot (const Snapshot& other) noexcept  : node (other.node) {}
+ValueTree::Snapshot::~Snapshot() {}
+
+ValueTree::Snapshot& ValueTree::Snapshot::operator= (const Snapshot& other) noexcept
+{
+    node = other.node;
+    return *this;
+}
+
+bool ValueTree::Snapshot::operator== (const Snapshot& other) const noexcept     { return node == other.node; }
+bool ValueTree::Snapshot::operator!= (const Snapshot& other) const noexcept     { return node != other.node; }
+bool ValueTree::Snapshot::isValid() const noexcept                              { return node != nullptr; }
+
+Identifier ValueTree::Snapshot::getType() const
+{
+    return node != nullptr ? node->type : Identifier();
+}
+
+bool ValueTree::Snapshot::hasType (const Identifier& typeName) const
+{
+    return node != nullptr && node->type == typeName;
+}
+
+int ValueTree::Snapshot::getNumProperties() const
+{
+    return node != nullptr ? node->properties.size() : 0;
+}
+
+Identifier ValueTree::Snapshot::getPropertyName (const int index) const
+{
+    return node != nullptr ? node->properties.getName (index) : Identifier();
+}
+
+const var& ValueTree::Snapshot::getProperty (const Identifier& name) const
+{
+    return node != nullptr ? node->properties [name] : var::null;
+}
+
+var ValueTree::Snapshot::getProperty (const Identifier& name, const var& defaultReturnValue) const
+{
+    return node != nullptr ? node->properties.getWithDefault (name, defaultReturnValue) : defaultReturnValue;
+}
+
+const var& ValueTree::Snapshot::operator[] (const Identifier& name) const
+{
+    return getProperty (name);
+}
+
+bool ValueTree::Snapshot::hasProperty (const Identifier& name) const
+{
+    return node != nullptr && node->properties.contains (name);
+}
+
+int ValueTree::Snapshot::getNumChildren() const
+{
+    return node != nullptr ? node->children.size() : 0;
+}
+
+ValueTree::Snapshot ValueTree::Snapshot::getChild (const int index) const
+{
+    return Snapshot (node != nullptr ? node->children.getObjectPointer (index)
+                                     : static_cast <SnapshotNode*> (nullptr));
+}
+
+ValueTree::Snapshot ValueTree::Snapshot::getChildWithName (const Identifier& type) const
+{
+    if (node != nullptr)
+        for (int i = 0; i < node->children.size(); ++i)
+            if (node->children.getObjectPointerUnchecked(i)->type == type)
+                return Snapshot (node->children.getObjectPointerUnchecked(i));
+
+    return Snapshot();
+}
+
+ValueTree ValueTree::Snapshot::createValueTree() const
+{
+    return ValueTree (node != nullptr ? SharedObject::createFromSnapshot (*node)
+                                      : static_cast <SharedObject*> (nullptr));
+}
+
+//==============================================================================
+ValueTree::ScopedNotificationBatch::ScopedNotificationBatch (const ValueTree& treeToBatch,
+                                                             const bool deliverAsynchronously_)
+    : tree (treeToBatch), deliverAsynchronously (deliverAsynchronously_)
+{
+    if (tree.object != nullptr && tree.object->findRecorder() == nullptr)
+    {
+        recorder = new NotificationRecorder();
+        tree.object->recorder = recorder;
+    }
+}
+
+ValueTree::ScopedNotificationBatch::~ScopedNotificationBatch()
+{
+    if (recorder != nullptr)
+    {
+        tree.object->recorder = nullptr;
+
+        if (recorder->hasPendingChanges())
+        {
+            if (deliverAsynchronously && MessageManager::getInstanceWithoutCreating() != nullptr)
+                (new NotificationRecorder::DeliveryMessage (recorder))->post();
+            else
+                recorder->deliver();
+        }
+    }
+}
+
+void ValueTree::ScopedNotificationBatch::deliverChanges()
+{
+    if (recorder != nullptr)
+        recorder->deliver();
+}
+
+int ValueTree::ScopedNotificationBatch::getNumChangesRecorded() const noexcept
+{
+    return recorder != nullptr ? recorder->numChangesRecorded : 0;
+}
+
+int ValueTree::ScopedNotificationBatch::getNumPendingChanges() const noexcept
+{
+    return recorder != nullptr ? recorder->getNumPendingChanges() : 0;
+}
+
+int ValueTree::ScopedNotificationBatch::getNumListenerCallbacks() const noexcept
+{
+    return recorder != nullptr ? recorder->numListenerCallbacks : 0;
+}
+
+//==============================================================================
 void ValueTree::Listener::valueTreeRedirected (ValueTree&) {}
 
+void ValueTree::Listener::valueTreeChangesBatched (const Array<Change>& changes)
+{
+    for (int i = 0; i < changes.size(); ++i)
+    {
+        const Change& c = changes.getReference (i);
+        ValueTree tree (c.tree), child (c.child);
+
+        switch (c.type)
+        {
+            case Change::propertyChanged:       valueTreePropertyChanged (tree, c.property); break;
+            case Change::childAdded:            valueTreeChildAdded (tree, child); break;
+            case Change::childRemoved:          valueTreeChildRemoved (tree, child); break;
+            case Change::childOrderChanged:     valueTreeChildOrderChanged (tree); break;
+            case Change::parentChanged:         valueTreeParentChanged (tree); break;
+            default:                            jassertfalse; break;
+        }
+    }
+}
+
 //==============================================================================
 #if JUCE_UNIT_TESTS
 
@@ -1095,8 +2252,217 @@ public:
 
             ValueTree v4 = v2.createCopy();
             expect (v1.isEquivalentTo (v4));
+
+            MemoryOutputStream indexed;
+            v1.writeToIndexedStream (indexed);
+            indexed.writeInt (1234);
+
+            const ValueTree v5 (ValueTree::readFromData (indexed.getData(), indexed.getDataSize()));
+            expect (v1.isEquivalentTo (v5));
+
+            MemoryInputStream indexedIn (indexed.getData(), indexed.getDataSize(), false);
+            expect (v1.isEquivalentTo (ValueTree::readFromStream (indexedIn)));
+            expectEquals (indexedIn.readInt(), 1234);
+        }
+
+        {
+            TemporaryFile tempFile;
+            ValueTree v1 (createRandomTree (nullptr, 0));
+
+            {
+                FileOutputStream out (tempFile.getFile());
+                v1.writeToIndexedStream (out);
+            }
+
+            expect (v1.isEquivalentTo (ValueTree::readFromFile (tempFile.getFile())));
+        }
+
+        beginTest ("Snapshots");
+
+        for (int i = 10; --i >= 0;)
+        {
+            Random r;
+            ValueTree v1 (createRandomTree (nullptr, 0));
+            const ValueTree::Snapshot s1 (v1.createSnapshot());
+
+            expect (s1.createValueTree().isEquivalentTo (v1));
+            expect (v1.createSnapshot() == s1);
+
+            const ValueTree copy (v1.createCopy());
+            const int numChildren = v1.getNumChildren();
+            const int changedIndex = r.nextInt (numChildren + 1);
+
+            if (changedIndex < numChildren)
+                v1.getChild (changedIndex).setProperty ("changed", r.nextInt(), nullptr);
+            else
+                v1.addChild (createRandomTree (nullptr, 1), r.nextInt (numChildren + 1), nullptr);
+
+            const ValueTree::Snapshot s2 (v1.createSnapshot());
+            expect (s2 != s1);
+            expect (s2.createValueTree().isEquivalentTo (v1));
+            expect (s1.createValueTree().isEquivalentTo (copy));
+
+            if (changedIndex < numChildren)
+                for (int j = 0; j < numChildren; ++j)
+                    expect ((s2.getChild (j) == s1.getChild (j)) == (j != changedIndex));
+
+            UndoManager undoManager;
+            v1.restoreSnapshot (s1, &undoManager);
+            expect (v1.isEquivalentTo (copy));
+            expect (v1.createSnapshot() == s1);
+
+            undoManager.undo();
+            expect (v1.createSnapshot().createValueTree().isEquivalentTo (s2.createValueTree()));
+
+            v1.removeChild (0, nullptr);
+            undoManager.perform (v1.createUndoActionFrom (s2));
+            undoManager.undo();
+            expect (v1.isEquivalentTo (s2.createValueTree()));
+        }
+
+        beginTest ("ScopedNotificationBatch");
+
+        const Identifier typeA ("a"), typeB ("b"), prop1 ("p1"), prop2 ("p2");
+        ValueTree root (typeA), child (typeB);
+        root.addChild (child, -1, nullptr);
+
+        CountingListener rootListener, childListener;
+        root.addListener (&rootListener);
+        child.addListener (&childListener);
+
+        {
+            ValueTree::ScopedNotificationBatch batch (root);
+
+            for (int i = 0; i < 100; ++i)
+            {
+                child.setProperty (prop1, i, nullptr);
+                root.setProperty (prop2, i, nullptr);
+            }
+
+            ValueTree::ScopedNotificationBatch innerBatch (child);
+            expectEquals (innerBatch.getNumChangesRecorded(), 0);
+
+            ValueTree newChild (typeB);
+            root.addChild (newChild, -1, nullptr);
+            root.removeChild (newChild, nullptr);
+
+            expectEquals (rootListener.numCallbacks + childListener.numCallbacks, 0);
+            expectEquals (batch.getNumChangesRecorded(), 202);
+            expectEquals (batch.getNumPendingChanges(), 4);
+        }
+
+        expectEquals (rootListener.numBatches, 1);
+        expectEquals (rootListener.numProperties, 2);
+        expectEquals (rootListener.numChildChanges, 2);
+        expectEquals (childListener.numBatches, 1);
+        expectEquals (childListener.numProperties, 1);
+        expect (child [prop1] == var (99) && root [prop2] == var (99));
+
+        {
+            ValueTree::ScopedNotificationBatch batch (child);
+            child.setProperty (prop2, 1, nullptr);
+            child.setProperty (prop2, 2, nullptr);
+            batch.deliverChanges();
+
+            expectEquals (batch.getNumListenerCallbacks(), 2);
+            expectEquals (batch.getNumPendingChanges(), 0);
+        }
+
+        expectEquals (rootListener.numProperties, 3);
+        expectEquals (childListener.numProperties, 2);
+
+        root.removeListener (&rootListener);
+        child.removeListener (&childListener);
+
+        beginTest ("Stored undo history");
+
+        for (int storage = UndoManager::compressOldTransactions; storage <= UndoManager::moveOldTransactionsToFile; ++storage)
+        {
+            UndoManager undoManager (100000, 2);
+            undoManager.setOldTransactionStorage ((UndoManager::OldTransactionStorage) storage);
+            ValueTree v (typeA);
+
+            for (int i = 0; i < 20; ++i)
+            {
+                undoManager.beginNewTransaction();
+                v.setProperty (prop1, String (i) + String::repeatedString ("x", 10000), &undoManager);
+            }
+
+            const UndoManager::MemoryStatistics stats (undoManager.getMemoryStatistics());
+            expectEquals (stats.numTransactions, 20);
+            expect (stats.numStoredTransactions > 0);
+            expect (stats.numUnitsInMemory + stats.numCompressedBytesInMemory <= 100000);
+
+            for (int i = 19; --i >= 0;)
+            {
+                undoManager.undo();
+                expect (v [prop1].toString().startsWith (String (i) + "x"));
+            }
+        }
+
+        {
+            // with the default settings, the property values aren't counted, so big values
+            // don't push the older transactions out of the history
+            UndoManager undoManager;
+            ValueTree v (typeA);
+            v.setProperty (prop1, 0, nullptr);
+
+            for (int i = 1; i <= 100; ++i)
+            {
+                undoManager.beginNewTransaction();
+                v.setProperty (prop1, String (i) + String::repeatedString ("x", 10000), &undoManager);
+            }
+
+            expectEquals (undoManager.getMemoryStatistics().numTransactions, 100);
+            expect (undoManager.getNumberOfUnitsTakenUpByStoredCommands() < 30000);
+
+            // ..but once they can be stored, they count towards the limit
+            undoManager.setOldTransactionStorage (UndoManager::compressOldTransactions);
+            expect (undoManager.getNumberOfUnitsTakenUpByStoredCommands() > 100 * 10000);
+
+            while (undoManager.undo())
+            {}
+
+            expect (v [prop1] == var (0));
+        }
+
+        {
+            UndoManager undoManager;
+            undoManager.setTransactionCoalescingTime (10000);
+            ValueTree v (typeA);
+            v.setProperty (prop1, 0, nullptr);
+
+            for (int i = 1; i <= 10; ++i)
+            {
+                undoManager.beginNewTransaction();
+                v.setProperty (prop1, i, &undoManager);
+            }
+
+            expectEquals (undoManager.getMemoryStatistics().numTransactions, 1);
+            undoManager.undo();
+            expect (v [prop1] == var (0));
         }
     }
+
+    // Uses the default valueTreeChangesBatched(), which replays the individual callbacks
+    struct CountingListener  : public ValueTree::Listener
+    {
+        CountingListener() : numBatches (0), numCallbacks (0), numProperties (0), numChildChanges (0) {}
+
+        void valueTreeChangesBatched (const Array<ValueTree::Change>& changes)
+        {
+            ++numBatches;
+            ValueTree::Listener::valueTreeChangesBatched (changes);
+        }
+
+        void valueTreePropertyChanged (ValueTree&, const Identifier&)  { ++numCallbacks; ++numProperties; }
+        void valueTreeChildAdded (ValueTree&, ValueTree&)               { ++numCallbacks; ++numChildChanges; }
+        void valueTreeChildRemoved (ValueTree&, ValueTree&)             { ++numCallbacks; ++numChildChanges; }
+        void valueTreeChildOrderChanged (ValueTree&)                    { ++numCallbacks; }
+        void valueTreeParentChanged (ValueTree&)                        { ++numCallbacks; }
+
+        int numBatches, numCallbacks, numProperties, numChildChanges;
+    };
 };
 
 static ValueTreeTests valueTreeTests;
@@ -128,6 +128,59 @@ public:
     /** Returns a deep copy of this tree and all its sub-nodes. */
     ValueTree createCopy() const;
 
+    //==============================================================================
+    class Snapshot;
+
+    /** Returns a read-only snapshot of the current state of this tree and all its sub-nodes.
+
+        Unlike createCopy(), this doesn't copy the whole tree. Each node remembers the last
+        snapshot that was taken of it, and keeps it until the node or one of its sub-nodes
+        is changed. So if nothing has changed since the last snapshot, this simply returns
+        it again, and if only a few nodes have changed, only those nodes and their parents
+        are copied, and the new snapshot shares everything else with the old one. (Each
+        node that is copied includes its list of children, so a node with a very large
+        number of children makes its snapshots bigger).
+
+        This must be called on the thread that's using the tree, but the Snapshot that it
+        returns can be used freely by any thread, e.g. to save or render the state in the
+        background while the tree carries on being edited.
+
+        @see Snapshot, restoreSnapshot
+    */
+    Snapshot createSnapshot() const;
+
+    /** Changes this tree and its sub-nodes to match a snapshot.
+
+        This makes the smallest set of changes that it can find, by skipping any sub-trees
+        that are still in the state that the snapshot holds, so restoring a recent snapshot
+        of a large tree is quick. The changes are made with setProperty(), addChild(), etc,
+        so all the usual listener callbacks will happen.
+
+        The snapshot must have the same type as this tree. If an UndoManager is supplied,
+        the whole change is stored in it as a single action which holds the two snapshots.
+
+        @see createSnapshot, createUndoActionFrom
+    */
+    void restoreSnapshot (const Snapshot& snapshot, UndoManager* undoManager);
+
+    /** Creates an UndoableAction that will switch this tree between an earlier snapshot
+        and its current state.
+
+        This lets you make a batch of changes without an UndoManager, and then store the
+        whole change as one action which only holds two snapshots, rather than an action for
+        each individual change. e.g.
+        @code
+        const ValueTree::Snapshot stateBefore (tree.createSnapshot());
+
+        loadPreset (tree, presetFile);   // (changes the tree without using an UndoManager)
+
+        undoManager.perform (tree.createUndoActionFrom (stateBefore));
+        @endcode
+
+        @see createSnapshot, restoreSnapshot
+    */
+    UndoableAction* createUndoActionFrom (const Snapshot& previousState);
+
     //==============================================================================
     /** Returns the type of this node.
         The type is specified when the ValueTree is created.
@@ -349,17 +402,57 @@ public:
     */
     void writeToStream (OutputStream& output) const;
 
-    /** Reloads a tree from a stream that was written with writeToStream(). */
+    /** Stores this tree (and all its children) in an indexed binary format.
+
+        This format keeps a single table of all the identifiers that the tree uses, so
+        it's much smaller than the one that writeToStream() produces when lots of nodes
+        share the same property names. It also stores the position of each sub-tree,
+        so that when it's loaded with readFromFile() or readFromData(), only the top
+        node is created straight away, and each node's children are only loaded when
+        something first asks for them.
+
+        The data can be read back with readFromStream(), readFromData() or readFromFile(),
+        but older versions of the library can't read it.
+
+        Note that because a tree loaded from this format creates its children the first
+        time they're accessed, even const methods such as getChild() or getNumChildren()
+        may modify it, so if more than one thread needs to read the same tree, you must
+        make sure they don't do so at the same time.
+    */
+    void writeToIndexedStream (OutputStream& output) const;
+
+    /** Reloads a tree from a stream that was written with writeToStream() or
+        writeToIndexedStream().
+    */
     static ValueTree readFromStream (InputStream& input);
 
-    /** Reloads a tree from a data block that was written with writeToStream(). */
+    /** Reloads a tree from a data block that was written with writeToStream() or
+        writeToIndexedStream().
+
+        If the data is in the indexed format, it's copied, and the tree's children will be
+        created from the copy as they're needed.
+    */
     static ValueTree readFromData (const void* data, size_t numBytes);
 
+    /** Reloads a tree from a file that was written with writeToStream() or
+        writeToIndexedStream().
+
+        If the file is in the indexed format, it's memory-mapped rather than being read,
+        and the tree's children are created from the mapped data as they're needed, so
+        opening a large file is very quick, and only the parts of it that you actually
+        use will be loaded. The file will stay mapped until all of the tree has been
+        loaded or deleted, so it mustn't be modified during that time.
+    */
+    static ValueTree readFromFile (const File& file);
+
     /** Reloads a tree from a data block that was written with writeToStream() and
         then zipped using GZIPCompressorOutputStream.
     */
     static ValueTree readFromGZIPData (const void* data, size_t numBytes);
 
+    //==============================================================================
+    struct Change;
+
     //==============================================================================
     /** Listener class for events that happen to a ValueTree.
 
@@ -428,6 +521,22 @@ public:
             will be made.
         */
         virtual void valueTreeRedirected (ValueTree& treeWhichHasBeenChanged);
+
+        /** This method is called when a ScopedNotificationBatch ends, with the changes that
+            were made to this tree (or to any of its sub-trees) while the batch was active.
+
+            Each property change appears only once in the list, however many times the property
+            was set, and the changes are in the order in which they first happened.
+
+            The default implementation simply calls the other callbacks for each change in turn,
+            so you only need to override it if you can deal with a whole set of changes more
+            efficiently, e.g. by only repainting once. If your listener might be deleted by one
+            of its own callbacks, you should also override this, because the default version
+            can't detect that happening part-way through the list.
+
+            @see ScopedNotificationBatch
+        */
+        virtual void valueTreeChangesBatched (const Array<Change>& changes);
     };
 
     /** Adds a listener to receive callbacks when this node is changed.
@@ -454,6 +563,9 @@ public:
     */
     void sendPropertyChangeMessage (const Identifier& property);
 
+    //==============================================================================
+    class ScopedNotificationBatch;
+
     //==============================================================================
     /** This method uses a comparator object to sort the tree's children into order.
 
@@ -497,7 +609,10 @@ public:
 private:
     //==============================================================================
     class SharedObject;
+    class NotificationRecorder;
+    class SnapshotNode;
     friend class SharedObject;
+    friend class NotificationRecorder;
 
     ReferenceCountedObjectPtr<SharedObject> object;
     ListenerList<Listener> listeners;
@@ -523,5 +638,194 @@ private:
     explicit ValueTree (SharedObject*);
 };
 
+//==============================================================================
+/**
+    Describes one of the changes that was made to a tree while a ScopedNotificationBatch
+    was active.
+
+    @see ValueTree::Listener::valueTreeChangesBatched
+*/
+struct JUCE_API  ValueTree::Change
+{
+    /** The different types of change. */
+    enum Type
+    {
+        propertyChanged,    /**< A property of the tree was changed, or removed. */
+        childAdded,         /**< The child was added to the tree. */
+        childRemoved,       /**< The child was removed from the tree. */
+        childOrderChanged,  /**< The tree's children were re-ordered. */
+        parentChanged       /**< The tree was added to or removed from a parent. */
+    };
+
+    /** The type of change. */
+    Type type;
+
+    /** The tree that was changed. For childAdded and childRemoved, this is the parent. */
+    ValueTree tree;
+
+    /** For childAdded and childRemoved changes, this is the child. */
+    ValueTree child;
+
+    /** For propertyChanged changes, this is the property. */
+    Identifier property;
+};
+
+//==============================================================================
+/**
+    Holds back the listener callbacks for a tree while you make a lot of changes to it.
+
+    While one of these objects exists, any changes that are made to the tree it was
+    given (or to any of its sub-trees) are recorded instead of being sent to listeners
+    straight away. Repeated changes to the same property are merged. When the batch
+    ends, each ValueTree that has listeners gets a single
+    Listener::valueTreeChangesBatched() callback with the changes that affect it.
+
+    e.g. @code
+    {
+        ValueTree::ScopedNotificationBatch batch (presetTree);
+
+        for (int i = 0; i < parameters.size(); ++i)
+            presetTree.setProperty (parameters[i]->getID(), parameters[i]->getValue(), nullptr);
+
+    } // (the listeners are called here)
+    @endcode
+
+    The listeners that are called, and the order in which the trees' parents are searched
+    for them, depend on the state of the tree when the batch ends rather than when each
+    change was made.
+
+    If the tree is already inside a batch, the new batch has no effect, and the changes
+    are delivered when the outer batch ends.
+
+    @see Listener::valueTreeChangesBatched
+*/
+class JUCE_API  ValueTree::ScopedNotificationBatch
+{
+public:
+    /** Starts batching the notifications for a tree and all of its sub-trees.
+
+        If deliverAsynchronously is true, the changes will be delivered by a message on
+        the message thread after the batch ends, instead of by the destructor. Any
+        changes that are made after the batch has ended may be delivered before that
+        message arrives.
+    */
+    explicit ScopedNotificationBatch (const ValueTree& treeToBatch,
+                                      bool deliverAsynchronously = false);
+
+    /** Ends the batch, and delivers any changes that were recorded. */
+    ~ScopedNotificationBatch();
+
+    /** Immediately delivers the changes that have been recorded so far.
+        The batch carries on recording changes afterwards.
+    */
+    void deliverChanges();
+
+    /** Returns the number of notifications that have been held back by this batch. */
+    int getNumChangesRecorded() const noexcept;
+
+    /** Returns the number of distinct changes that are waiting to be delivered. */
+    int getNumPendingChanges() const noexcept;
+
+    /** Returns the number of listener callbacks that deliverChanges() has made so far. */
+    int getNumListenerCallbacks() const noexcept;
+
+private:
+    ValueTree tree;
+    ReferenceCountedObjectPtr<NotificationRecorder> recorder;
+    const bool deliverAsynchronously;
+
+    JUCE_DECLARE_NON_COPYABLE (ScopedNotificationBatch)
+};
+
+//==============================================================================
+/**
+    A read-only copy of the state of a ValueTree at a particular moment.
+
+    Snapshots are created with ValueTree::createSnapshot(). They're cheap to create and
+    copy, because they share any nodes that haven't changed with earlier snapshots of the
+    same tree, and because they can never change, a snapshot can be read by any number of
+    threads at the same time.
+
+    Note that the property values are shared rather than copied, so if you store objects
+    in a tree's properties, rather than simple values, those objects aren't protected.
+
+    @see ValueTree::createSnapshot, ValueTree::restoreSnapshot
+*/
+class JUCE_API  ValueTree::Snapshot
+{
+public:
+    /** Creates an invalid snapshot. */
+    Snapshot() noexcept;
+
+    /** Creates another reference to the same snapshot. */
+    Snapshot (const Snapshot& other) noexcept;
+
+    /** Makes this refer to another snapshot. */
+    Snapshot& operator= (const Snapshot& other) noexcept;
+
+    /** Destructor. */
+    ~Snapshot();
+
+    /** Returns true if both snapshots refer to exactly the same saved state.
+        Two snapshots of a tree will be equal if nothing changed between them, but note that
+        this isn't a value comparison - independently created trees which contain the same
+        data aren't considered equal.
+    */
+    bool operator== (const Snapshot& other) const noexcept;
+
+    /** Returns true if the snapshots refer to different saved states. */
+    bool operator!= (const Snapshot& other) const noexcept;
+
+    /** Returns true if this snapshot holds some data. */
+    bool isValid() const noexcept;
+
+    //==============================================================================
+    /** Returns the type of the node. @see ValueTree::getType */
+    Identifier getType() const;
+
+    /** Returns true if the node has this type. @see ValueTree::hasType */
+    bool hasType (const Identifier& typeName) const;
+
+    /** Returns the number of properties that the node has. */
+    int getNumProperties() const;
+
+    /** Returns the name of one of the node's properties. */
+    Identifier getPropertyName (int index) const;
+
+    /** Returns the value of a property, or a void variant if it doesn't exist. */
+    const var& getProperty (const Identifier& name) const;
+
+    /** Returns the value of a property, or a default value if it doesn't exist. */
+    var getProperty (const Identifier& name, const var& defaultReturnValue) const;
+
+    /** Returns the value of a property, or a void variant if it doesn't exist. */
+    const var& operator[] (const Identifier& name) const;
+
+    /** Returns true if the node has a property with this name. */
+    bool hasProperty (const Identifier& name) const;
+
+    /** Returns the number of child nodes. */
+    int getNumChildren() const;
+
+    /** Returns one of the child nodes, or an invalid snapshot if the index is out of range. */
+    Snapshot getChild (int index) const;
+
+    /** Returns the first child node with the given type, or an invalid snapshot if there isn't one. */
+    Snapshot getChildWithName (const Identifier& type) const;
+
+    //==============================================================================
+    /** Creates a new ValueTree which holds a deep copy of this state.
+        This can be called on any thread.
+    */
+    ValueTree createValueTree() const;
+
+private:
+    //==============================================================================
+    friend class ValueTree;
+    ReferenceCountedObjectPtr<SnapshotNode> node;
+
+    explicit Snapshot (SnapshotNode*) noexcept;
+};
+
 
 #endif   // __JUCE_VALUETREE_JUCEHEADER__
@@ -29,7 +29,9 @@ InterprocessConnection::InterprocessConnection (const bool callbacksOnMessageThr
       callbackConnectionState (false),
       useMessageThread (callbacksOnMessageThread),
       magicMessageHeader (magicMessageHeaderNumber),
-      pipeReceiveMessageTimeout (-1)
+      pipeReceiveMessageTimeout (-1),
+      connectionManager (nullptr),
+      usingConnectionManager (false)
 {
 }
 
@@ -54,7 +56,7 @@ bool InterprocessConnection::connectToSocket (const String& hostName,
     if (socket->connect (hostName, portNumber, timeOutMillisecs))
     {
         connectionMadeInt();
-        startThread();
+        startReading();
         return true;
     }
     else
@@ -81,13 +83,14 @@ bool InterprocessConnection::connectToPipe (const String& pipeName, const int ti
     return false;
 }
 
-bool InterprocessConnection::createPipe (const String& pipeName, const int timeoutMs)
+bool InterprocessConnection::createPipe (const String& pipeName, const int timeoutMs,
+                                         const bool useSharedMemory)
 {
     disconnect();
 
     ScopedPointer <NamedPipe> newPipe (new NamedPipe());
 
-    if (newPipe->createNewPipe (pipeName))
+    if (newPipe->createNewPipe (pipeName, useSharedMemory))
     {
         const ScopedLock sl (pipeAndSocketLock);
         pipeReceiveMessageTimeout = timeoutMs;
@@ -98,8 +101,24 @@ bool InterprocessConnection::createPipe (const String& pipeName, const int timeo
     return false;
 }
 
+void InterprocessConnection::setConnectionManager (InterprocessConnectionManager* const newManager)
+{
+    // this can only be changed before the connection is made!
+    jassert (! isConnected());
+
+    connectionManager = newManager;
+}
+
 void InterprocessConnection::disconnect()
 {
+    // (this must be done before the socket is closed, so that its handle can't be
+    // re-used while the manager is still watching it)
+    if (usingConnectionManager)
+    {
+        connectionManager->removeConnection (*this);
+        usingConnectionManager = false;
+    }
+
     if (socket != nullptr)
         socket->close();
 
@@ -123,7 +142,7 @@ bool InterprocessConnection::isConnected() const
 
     return ((socket != nullptr && socket->isConnected())
               || (pipe != nullptr && pipe->isOpen()))
-            && isThreadRunning();
+            && (isThreadRunning() || usingConnectionManager);
 }
 
 String InterprocessConnection::getConnectedHostName() const
@@ -143,12 +162,104 @@ String InterprocessConnection::getConnectedHostName() const
 }
 
 //==============================================================================
+#if JUCE_LINUX
+namespace InterprocessConnectionHelpers
+{
+    // How long a write to a non-blocking socket will wait for the other end to make
+    // room, before the connection is given up for dead.
+    enum { socketWriteTimeoutMs = 10000 };
+
+    // Writes a list of buffers with as few system calls as possible, waiting if the
+    // socket isn't blocking and its buffer is full.
+    static bool writeBuffers (const int socketHandle, iovec* buffers, int numBuffers)
+    {
+        const uint32 startTime = Time::getMillisecondCounter();
+
+        while (numBuffers > 0)
+        {
+            msghdr header;
+            zerostruct (header);
+            header.msg_iov = buffers;
+            header.msg_iovlen = (size_t) numBuffers;
+
+            const ssize_t bytesWritten = sendmsg (socketHandle, &header, MSG_NOSIGNAL);
+
+            if (bytesWritten < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    const int timeLeft = (int) socketWriteTimeoutMs - (int) (Time::getMillisecondCounter() - startTime);
+
+                    pollfd pfd;
+                    pfd.fd = socketHandle;
+                    pfd.events = POLLOUT;
+                    pfd.revents = 0;
+
+                    const int result = timeLeft > 0 ? poll (&pfd, 1, timeLeft) : 0;
+
+                    if (result == 0 || (result < 0 && errno != EINTR))
+                    {
+                        // part of a message may already have been sent, so the stream can't
+                        // be used again - shutting it down means that the connection's
+                        // reader will see it as lost
+                        ::shutdown (socketHandle, SHUT_RDWR);
+                        return false;
+                    }
+                }
+                else if (errno != EINTR)
+                {
+                    return false;
+                }
+
+                continue;
+            }
+
+            size_t bytesLeft = (size_t) bytesWritten;
+
+            while (numBuffers > 0 && bytesLeft >= buffers->iov_len)
+            {
+                bytesLeft -= buffers->iov_len;
+                ++buffers;
+                --numBuffers;
+            }
+
+            if (numBuffers > 0)
+            {
+                buffers->iov_base = addBytesToPointer (buffers->iov_base, bytesLeft);
+                buffers->iov_len -= bytesLeft;
+            }
+        }
+
+        return true;
+    }
+}
+#endif
+
 bool InterprocessConnection::sendMessage (const MemoryBlock& message)
 {
     uint32 messageHeader[2];
     messageHeader [0] = ByteOrder::swapIfBigEndian (magicMessageHeader);
     messageHeader [1] = ByteOrder::swapIfBigEndian ((uint32) message.getSize());
 
+   #if JUCE_LINUX
+    {
+        // The header and message are sent straight from where they are, without
+        // being copied into a single block first
+        const ScopedLock sl (pipeAndSocketLock);
+
+        if (socket != nullptr)
+        {
+            iovec buffers[2];
+            buffers[0].iov_base = messageHeader;
+            buffers[0].iov_len  = sizeof (messageHeader);
+            buffers[1].iov_base = message.getData();
+            buffers[1].iov_len  = message.getSize();
+
+            return InterprocessConnectionHelpers::writeBuffers (socket->getRawSocketHandle(), buffers, 2);
+        }
+    }
+   #endif
+
     MemoryBlock messageData (sizeof (messageHeader) + message.getSize());
     messageData.copyFrom (messageHeader, 0, sizeof (messageHeader));
     messageData.copyFrom (message.getData(), sizeof (messageHeader), message.getSize());
@@ -171,7 +282,7 @@ void InterprocessConnection::initialiseWithSocket (StreamingSocket* const socket
     jassert (socket == nullptr);
     socket = socket_;
     connectionMadeInt();
-    startThread();
+    startReading();
 }
 
 void InterprocessConnection::initialiseWithPipe (NamedPipe* const pipe_)
@@ -182,6 +293,15 @@ void InterprocessConnection::initialiseWithPipe (NamedPipe* const pipe_)
     startThread();
 }
 
+void InterprocessConnection::startReading()
+{
+    usingConnectionManager = connectionManager != nullptr
+                              && connectionManager->addConnection (*this);
+
+    if (! usingConnectionManager)
+        startThread();
+}
+
 //==============================================================================
 struct ConnectionStateMessage  : public MessageManager::MessageBase
 {
@@ -234,9 +354,11 @@ void InterprocessConnection::connectionLostInt()
 
 struct DataDeliveryMessage  : public Message
 {
-    DataDeliveryMessage (InterprocessConnection* ipc, const MemoryBlock& d)
-        : owner (ipc), data (d)
-    {}
+    DataDeliveryMessage (InterprocessConnection* ipc, MemoryBlock& d)
+        : owner (ipc)
+    {
+        data.swapWith (d);
+    }
 
     void messageCallback()
     {
@@ -248,7 +370,7 @@ struct DataDeliveryMessage  : public Message
     MemoryBlock data;
 };
 
-void InterprocessConnection::deliverDataInt (const MemoryBlock& data)
+void InterprocessConnection::deliverDataInt (MemoryBlock& data)
 {
     jassert (callbackConnectionState);
 
@@ -27,6 +27,7 @@
 #define __JUCE_INTERPROCESSCONNECTION_JUCEHEADER__
 
 class InterprocessConnectionServer;
+class InterprocessConnectionManager;
 class MemoryBlock;
 
 
@@ -94,7 +95,8 @@ public:
 
         For this to work, another process on the same computer must already have opened
         an InterprocessConnection object and used createPipe() to create a pipe for this
-        to connect to.
+        to connect to. If that pipe was created to use shared memory, this connection will
+        use it too.
 
         @param pipeName     the name to use for the pipe - this should be unique to your app
         @param pipeReceiveMessageTimeoutMs  a timeout length to be used when reading or writing
@@ -112,10 +114,32 @@ public:
         @param pipeName     the name to use for the pipe - this should be unique to your app
         @param pipeReceiveMessageTimeoutMs  a timeout length to be used when reading or writing
                                             to the pipe, or -1 for an infinite timeout.
+        @param useSharedMemory  if true, the messages will be passed through ring buffers in
+                                shared memory rather than a system pipe, where that's supported.
+                                This avoids a system call for each message, so is much faster
+                                for streaming large amounts of data. If the shared memory can't
+                                be created, a normal pipe will be used.
         @returns true if the pipe was created, or false if it fails (e.g. if another process is
                  already using using the pipe).
+        @see NamedPipe::createNewPipe
     */
-    bool createPipe (const String& pipeName, int pipeReceiveMessageTimeoutMs);
+    bool createPipe (const String& pipeName, int pipeReceiveMessageTimeoutMs,
+                     bool useSharedMemory = false);
+
+    /** Makes this connection share the threads of an InterprocessConnectionManager,
+        rather than using a thread of its own to wait for incoming messages.
+
+        This must be called before the connection is made, and the manager must not be
+        deleted while this connection is still using it. For the connections created by
+        an InterprocessConnectionServer, you can call this in the constructor of your
+        connection class, or in your createConnectionObject() method.
+
+        Only socket connections can use a manager - pipes always have their own thread.
+        Pass nullptr to go back to using a separate thread.
+
+        @see InterprocessConnectionManager
+    */
+    void setConnectionManager (InterprocessConnectionManager* newManager);
 
     /** Disconnects and closes any currently-open sockets or pipes. */
     void disconnect();
@@ -187,13 +211,17 @@ private:
     const bool useMessageThread;
     const uint32 magicMessageHeader;
     int pipeReceiveMessageTimeout;
+    InterprocessConnectionManager* connectionManager;
+    bool usingConnectionManager;
 
     friend class InterprocessConnectionServer;
+    friend class InterprocessConnectionManager;
     void initialiseWithSocket (StreamingSocket*);
     void initialiseWithPipe (NamedPipe*);
+    void startReading();
     void connectionMadeInt();
     void connectionLostInt();
-    void deliverDataInt (const MemoryBlock&);
+    void deliverDataInt (MemoryBlock&);
     bool readNextMessageInt();
     void run();
 
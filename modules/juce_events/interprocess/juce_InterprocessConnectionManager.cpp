@@ -0,0 +1,647 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#if JUCE_LINUX
+
+struct InterprocessConnectionManager::Connection
+{
+    Connection (InterprocessConnection& owner_, const int socketHandle_) noexcept
+        : owner (&owner_), socketHandle (socketHandle_),
+          headerBytesRead (0), messageSize (-1), messageBytesRead (0)
+    {
+    }
+
+    InterprocessConnection* owner;  // this is cleared when the connection is removed
+    const int socketHandle;
+
+    uint32 header[2];
+    int headerBytesRead;
+
+    // the message that's being read - when the callbacks are made on the I/O thread,
+    // this block gets re-used for the next message
+    MemoryBlock message;
+    int messageSize, messageBytesRead;
+
+    JUCE_DECLARE_NON_COPYABLE (Connection)
+};
+
+//==============================================================================
+class InterprocessConnectionManager::IOThread  : public Thread
+{
+public:
+    IOThread (const int index)
+        : Thread ("Juce IPC I/O " + String (index)),
+          epollHandle (epoll_create (64)),
+          wakeupHandle (eventfd (0, 0)),
+          readBuffer ((size_t) readBufferSize),
+          failed (true)
+    {
+        if (epollHandle >= 0 && wakeupHandle >= 0)
+        {
+            epoll_event e;
+            zerostruct (e);
+            e.events = EPOLLIN;
+            e.data.ptr = nullptr;
+
+            if (epoll_ctl (epollHandle, EPOLL_CTL_ADD, wakeupHandle, &e) == 0)
+            {
+                failed = false;
+                startThread();
+            }
+        }
+    }
+
+    ~IOThread()
+    {
+        signalThreadShouldExit();
+
+        if (wakeupHandle >= 0)
+        {
+            const uint64 value = 1;
+            (void) ::write (wakeupHandle, &value, sizeof (value));
+        }
+
+        stopThread (4000);
+
+        if (wakeupHandle >= 0)  ::close (wakeupHandle);
+        if (epollHandle >= 0)   ::close (epollHandle);
+    }
+
+    // false if the thread couldn't be started, or has stopped after an error
+    bool isUsable() const
+    {
+        const ScopedLock sl (listLock);
+        return ! failed;
+    }
+
+    int getNumConnections() const
+    {
+        const ScopedLock sl (listLock);
+        return connections.size();
+    }
+
+    bool addConnection (InterprocessConnection& owner, const int socketHandle)
+    {
+        if (! isUsable())
+            return false;
+
+        const int flags = fcntl (socketHandle, F_GETFL, 0);
+
+        if (flags == -1 || fcntl (socketHandle, F_SETFL, flags | O_NONBLOCK) == -1)
+            return false;
+
+        Connection* const c = new Connection (owner, socketHandle);
+
+        {
+            const ScopedLock sl (listLock);
+            connections.add (c);
+        }
+
+        epoll_event e;
+        zerostruct (e);
+        e.events = EPOLLIN | EPOLLRDHUP;
+        e.data.ptr = c;
+
+        if (epoll_ctl (epollHandle, EPOLL_CTL_ADD, socketHandle, &e) == 0)
+            return true;
+
+        {
+            const ScopedLock sl (listLock);
+            connections.removeObject (c);
+        }
+
+        fcntl (socketHandle, F_SETFL, flags);
+        return false;
+    }
+
+    bool removeConnection (InterprocessConnection& owner)
+    {
+        // Taking the callback lock means that this waits for any callback that the
+        // connection is in the middle of making
+        const ScopedLock cl (callbackLock);
+        const ScopedLock sl (listLock);
+
+        for (int i = connections.size(); --i >= 0;)
+        {
+            Connection* const c = connections.getUnchecked (i);
+
+            if (c->owner == &owner)
+            {
+                removeLocked (*c);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void run()
+    {
+        epoll_event events [64];
+
+        while (! threadShouldExit())
+        {
+            {
+                // Removed connections are only deleted here, because the events from
+                // the last call to epoll_wait could still have been pointing to them
+                const ScopedLock sl (listLock);
+                removedConnections.clear();
+            }
+
+            const int numEvents = epoll_wait (epollHandle, events, numElementsInArray (events), -1);
+
+            if (numEvents < 0 && errno != EINTR)
+            {
+                jassertfalse; // epoll has failed, so none of these connections can be read from any more
+                dropAllConnections();
+                return;
+            }
+
+            for (int i = 0; i < numEvents; ++i)
+            {
+                Connection* const c = static_cast <Connection*> (events[i].data.ptr);
+
+                if (c == nullptr)
+                {
+                    uint64 value;
+                    (void) ::read (wakeupHandle, &value, sizeof (value));
+                    continue;
+                }
+
+                const ScopedLock cl (callbackLock);
+
+                if (c->owner != nullptr)
+                    readFrom (*c);
+            }
+        }
+    }
+
+private:
+    enum { readBufferSize = 65536 };
+
+    const int epollHandle, wakeupHandle;
+    CriticalSection callbackLock, listLock;
+    OwnedArray<Connection> connections, removedConnections;
+    HeapBlock<char> readBuffer;
+    bool failed;
+
+    void removeLocked (Connection& c)
+    {
+        epoll_event e;
+        zerostruct (e);
+        epoll_ctl (epollHandle, EPOLL_CTL_DEL, c.socketHandle, &e);
+
+        c.owner = nullptr;
+        connections.removeObject (&c, false);
+        removedConnections.add (&c);
+    }
+
+    // Called if the thread can't carry on: its connections are all reported as lost, and
+    // any new ones will be given their own threads instead.
+    void dropAllConnections()
+    {
+        const ScopedLock cl (callbackLock);
+
+        {
+            const ScopedLock sl (listLock);
+            failed = true;
+        }
+
+        for (;;)
+        {
+            InterprocessConnection* owner;
+
+            {
+                const ScopedLock sl (listLock);
+
+                if (connections.size() == 0)
+                    break;
+
+                Connection& c = *connections.getLast();
+                owner = c.owner;
+                removeLocked (c);
+            }
+
+            InterprocessConnectionManager::handleConnectionLost (*owner);
+        }
+    }
+
+    void readFrom (Connection& c)
+    {
+        // (This only does one read, so that a busy connection can't hold up the
+        // others. If there's more data waiting, epoll_wait will return it again)
+        const ssize_t bytesRead = recv (c.socketHandle, readBuffer, (size_t) readBufferSize, 0);
+
+        if (bytesRead > 0)
+        {
+            InterprocessConnectionManager::handleIncomingData (c, readBuffer, (int) bytesRead);
+        }
+        else if (bytesRead == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+            InterprocessConnection& owner = *c.owner;
+
+            {
+                const ScopedLock sl (listLock);
+                removeLocked (c);
+            }
+
+            InterprocessConnectionManager::handleConnectionLost (owner);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (IOThread)
+};
+
+#else
+
+class InterprocessConnectionManager::IOThread
+{
+public:
+    bool isUsable() const noexcept                                          { return false; }
+    int getNumConnections() const noexcept                                  { return 0; }
+    bool removeConnection (InterprocessConnection&) const noexcept          { return false; }
+};
+
+#endif
+
+//==============================================================================
+InterprocessConnectionManager::InterprocessConnectionManager (int numberOfThreads)
+{
+   #if JUCE_LINUX
+    if (numberOfThreads < 1)
+        numberOfThreads = SystemStats::getNumCpus();
+
+    for (int i = 0; i < numberOfThreads; ++i)
+    {
+        ScopedPointer<IOThread> t (new IOThread (i));
+
+        // (if the epoll or eventfd handles can't be created, the thread isn't used, and
+        // connections will fall back to having their own threads)
+        if (t->isUsable())
+            threads.add (t.release());
+    }
+   #else
+    (void) numberOfThreads;
+   #endif
+}
+
+InterprocessConnectionManager::~InterprocessConnectionManager()
+{
+    // You need to disconnect or delete all the connections that are using this
+    // manager before deleting it!
+    jassert (getNumConnections() == 0);
+}
+
+int InterprocessConnectionManager::getNumThreads() const noexcept
+{
+    return threads.size();
+}
+
+int InterprocessConnectionManager::getNumConnections() const
+{
+    int total = 0;
+
+    for (int i = threads.size(); --i >= 0;)
+        total += threads.getUnchecked(i)->getNumConnections();
+
+    return total;
+}
+
+//==============================================================================
+bool InterprocessConnectionManager::addConnection (InterprocessConnection& connection)
+{
+   #if JUCE_LINUX
+    if (connection.socket != nullptr)
+    {
+        IOThread* leastBusy = nullptr;
+
+        for (int i = 0; i < threads.size(); ++i)
+        {
+            IOThread* const t = threads.getUnchecked(i);
+
+            if (t->isUsable() && (leastBusy == nullptr || t->getNumConnections() < leastBusy->getNumConnections()))
+                leastBusy = t;
+        }
+
+        return leastBusy != nullptr
+                && leastBusy->addConnection (connection, connection.socket->getRawSocketHandle());
+    }
+   #else
+    (void) connection;
+   #endif
+
+    return false;
+}
+
+void InterprocessConnectionManager::removeConnection (InterprocessConnection& connection)
+{
+    for (int i = threads.size(); --i >= 0;)
+        if (threads.getUnchecked(i)->removeConnection (connection))
+            break;
+}
+
+#if JUCE_LINUX
+void InterprocessConnectionManager::handleIncomingData (Connection& c, const char* data, int numBytes)
+{
+    while (numBytes > 0 && c.owner != nullptr)
+    {
+        if (c.messageSize < 0)
+        {
+            const int num = jmin (numBytes, (int) sizeof (c.header) - c.headerBytesRead);
+            memcpy (addBytesToPointer (c.header, c.headerBytesRead), data, (size_t) num);
+            c.headerBytesRead += num;
+            data += num;
+            numBytes -= num;
+
+            if (c.headerBytesRead == (int) sizeof (c.header))
+            {
+                c.headerBytesRead = 0;
+
+                // (as in InterprocessConnection::readNextMessageInt(), a header with the
+                // wrong magic number, or an empty message, is just skipped)
+                if (ByteOrder::swapIfBigEndian (c.header[0]) == c.owner->magicMessageHeader)
+                {
+                    const int size = (int) ByteOrder::swapIfBigEndian (c.header[1]);
+
+                    if (size > 0)
+                    {
+                        c.message.setSize ((size_t) size);
+                        c.messageSize = size;
+                        c.messageBytesRead = 0;
+                    }
+                }
+            }
+        }
+        else
+        {
+            const int num = jmin (numBytes, c.messageSize - c.messageBytesRead);
+            c.message.copyFrom (data, c.messageBytesRead, (size_t) num);
+            c.messageBytesRead += num;
+            data += num;
+            numBytes -= num;
+
+            if (c.messageBytesRead == c.messageSize)
+            {
+                c.messageSize = -1;
+                c.owner->deliverDataInt (c.message);
+            }
+        }
+    }
+}
+
+void InterprocessConnectionManager::handleConnectionLost (InterprocessConnection& connection)
+{
+    {
+        const ScopedLock sl (connection.pipeAndSocketLock);
+        connection.socket = nullptr;
+    }
+
+    // (usingConnectionManager is left set, so that disconnect() will still go through
+    // removeConnection(), and wait for this callback to finish)
+    connection.connectionLostInt();
+}
+#endif
+
+//==============================================================================
+#if JUCE_UNIT_TESTS && JUCE_LINUX
+
+class InterprocessConnectionManagerTests  : public UnitTest
+{
+public:
+    InterprocessConnectionManagerTests() : UnitTest ("InterprocessConnectionManager") {}
+
+    class TestConnection  : public InterprocessConnection
+    {
+    public:
+        TestConnection (InterprocessConnectionManager& manager, const bool echo_)
+            : InterprocessConnection (false), echo (echo_)
+        {
+            setConnectionManager (&manager);
+        }
+
+        ~TestConnection()
+        {
+            disconnect();
+        }
+
+        void expectMessage (const MemoryBlock& message)
+        {
+            const ScopedLock sl (lock);
+            expectedMessages.add (message);
+        }
+
+        void connectionMade() {}
+
+        void connectionLost()
+        {
+            lost.signal();
+        }
+
+        void messageReceived (const MemoryBlock& message)
+        {
+            if (echo)
+            {
+                if (message.toString() == "disconnect")
+                    disconnect();
+                else
+                    sendMessage (message);
+            }
+            else
+            {
+                const ScopedLock sl (lock);
+
+                if (numMessagesReceived.get() >= expectedMessages.size()
+                     || message != expectedMessages.getReference (numMessagesReceived.get()))
+                    ++numMismatches;
+            }
+
+            ++numMessagesReceived;
+        }
+
+        const bool echo;
+        Atomic<int> numMessagesReceived, numMismatches;
+        WaitableEvent lost;
+
+    private:
+        CriticalSection lock;
+        Array<MemoryBlock> expectedMessages;
+    };
+
+    class TestServer  : public InterprocessConnectionServer
+    {
+    public:
+        TestServer (InterprocessConnectionManager& manager_)  : manager (manager_) {}
+
+        ~TestServer()
+        {
+            stop();
+            connections.clear();
+        }
+
+        InterprocessConnection* createConnectionObject()
+        {
+            TestConnection* const c = new TestConnection (manager, true);
+            connections.add (c);
+            return c;
+        }
+
+        InterprocessConnectionManager& manager;
+        OwnedArray<TestConnection, CriticalSection> connections;
+    };
+
+    static bool waitUntil (Atomic<int>& value, const int target)
+    {
+        for (int i = 0; i < 10000 && value.get() < target; ++i)
+            Thread::sleep (1);
+
+        return value.get() >= target;
+    }
+
+    static MemoryBlock createRandomData (Random& r, const int size)
+    {
+        MemoryBlock m ((size_t) size);
+
+        for (size_t i = 0; i < m.getSize(); ++i)
+            m[(int) i] = (char) r.nextInt (256);
+
+        return m;
+    }
+
+    static MemoryBlock createRandomMessage (Random& r, const int maxSize)
+    {
+        return createRandomData (r, 1 + r.nextInt (maxSize));
+    }
+
+    void runTest()
+    {
+        beginTest ("Many connections");
+
+        InterprocessConnectionManager serverManager (2), clientManager (2);
+        TestServer server (serverManager);
+        int port = 0;
+
+        for (int i = 0; i < 20 && port == 0; ++i)
+        {
+            port = 30000 + Random::getSystemRandom().nextInt (20000);
+
+            if (! server.beginWaitingForSocket (port))
+                port = 0;
+        }
+
+        expect (port != 0);
+
+        const int numClients = 8, numMessages = 20;
+        OwnedArray<TestConnection> clients;
+        Random r;
+
+        for (int i = 0; i < numClients; ++i)
+        {
+            TestConnection* const c = new TestConnection (clientManager, false);
+            clients.add (c);
+            expect (c->connectToSocket ("127.0.0.1", port, 1000));
+        }
+
+        expectEquals (clientManager.getNumConnections(), numClients);
+
+        for (int i = 0; i < numMessages; ++i)
+        {
+            for (int j = 0; j < numClients; ++j)
+            {
+                // (the bigger messages won't fit into a single read)
+                const MemoryBlock m (createRandomMessage (r, i == 0 ? 500000 : 200000));
+                clients[j]->expectMessage (m);
+                expect (clients[j]->sendMessage (m));
+            }
+        }
+
+        for (int i = 0; i < numClients; ++i)
+        {
+            expect (waitUntil (clients[i]->numMessagesReceived, numMessages));
+            expectEquals (clients[i]->numMismatches.get(), 0);
+        }
+
+        expectEquals (serverManager.getNumConnections(), numClients);
+
+        beginTest ("Messages split across reads");
+
+        {
+            StreamingSocket socket;
+            expect (socket.connect ("127.0.0.1", port, 1000));
+
+            uint32 header[2];
+            header[0] = ByteOrder::swapIfBigEndian ((uint32) 0xf2b49e2c);
+            header[1] = ByteOrder::swapIfBigEndian ((uint32) 1000);
+            const MemoryBlock body (createRandomData (r, 1000));
+            MemoryBlock data (header, sizeof (header));
+            data.append (body.getData(), body.getSize());
+
+            const int splits[] = { 0, 3, 5, 8, 600, 1008 };
+
+            for (int i = 0; i < numElementsInArray (splits) - 1; ++i)
+            {
+                const int num = splits[i + 1] - splits[i];
+                expectEquals (socket.write (static_cast <const char*> (data.getData()) + splits[i], num), num);
+                Thread::sleep (20);
+            }
+
+            MemoryBlock reply (data.getSize());
+            expectEquals (socket.read (reply.getData(), (int) reply.getSize(), true), (int) reply.getSize());
+            expect (reply == data);
+
+            beginTest ("Peer closing the connection");
+
+            TestConnection* const serverEnd = server.connections.getLast();
+            socket.close();
+            expect (serverEnd->lost.wait (5000));
+            expect (! serverEnd->isConnected());
+        }
+
+        // (the server accepts the clients in the order that they connected)
+        clients[0]->disconnect();
+        expectEquals (clientManager.getNumConnections(), numClients - 1);
+        expect (server.connections[0]->lost.wait (5000));
+
+        beginTest ("Disconnecting inside a callback");
+
+        expect (clients[1]->sendMessage (MemoryBlock ("disconnect", 10)));
+        expect (server.connections[1]->lost.wait (5000));
+        expect (clients[1]->lost.wait (5000));
+        expect (! clients[1]->isConnected());
+        expectEquals (clientManager.getNumConnections(), numClients - 2);
+        expectEquals (serverManager.getNumConnections(), numClients - 2);
+
+        clients.clear();
+        server.stop();
+        server.connections.clear();
+
+        expectEquals (clientManager.getNumConnections(), 0);
+        expectEquals (serverManager.getNumConnections(), 0);
+    }
+};
+
+static InterprocessConnectionManagerTests interprocessConnectionManagerTests;
+
+#endif
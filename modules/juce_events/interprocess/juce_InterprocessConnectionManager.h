@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_INTERPROCESSCONNECTIONMANAGER_JUCEHEADER__
+#define __JUCE_INTERPROCESSCONNECTIONMANAGER_JUCEHEADER__
+
+#include "juce_InterprocessConnection.h"
+
+
+//==============================================================================
+/**
+    Runs the socket connections of many InterprocessConnection objects on a small,
+    fixed set of threads.
+
+    Normally, each InterprocessConnection has its own thread which waits for incoming
+    data, so a process that talks to hundreds of others ends up with hundreds of threads.
+    If you give a set of connections an InterprocessConnectionManager (see
+    InterprocessConnection::setConnectionManager()), their sockets are shared out between
+    the manager's threads, each of which waits for data on all of its sockets at once.
+
+    e.g.
+    @code
+    InterprocessConnectionManager manager (4);
+
+    class WorkerConnection  : public InterprocessConnection
+    {
+    public:
+        WorkerConnection (InterprocessConnectionManager& m)
+            : InterprocessConnection (false)
+        {
+            setConnectionManager (&m);
+        }
+        ...
+    };
+    @endcode
+
+    If the connections were created with callbacksOnMessageThread = false, their
+    messageReceived() callbacks will be made on the manager's threads, so they should
+    return quickly, as other connections on the same thread will be kept waiting. In
+    particular, a callback mustn't block waiting for something that another connection
+    on the same manager has to receive, because that connection's data can't be read
+    until the callback returns.
+
+    The sockets are put into non-blocking mode, and if sendMessage() finds that the other
+    end isn't reading its data, it'll only wait for a few seconds for it to make room
+    before giving up and closing the connection, rather than blocking forever.
+
+    The manager must be deleted after all the connections that use it. Pipe connections
+    always use their own threads, and on platforms other than Linux, so do socket
+    connections.
+
+    @see InterprocessConnection, InterprocessConnectionServer
+*/
+class JUCE_API  InterprocessConnectionManager
+{
+public:
+    //==============================================================================
+    /** Creates a manager with a given number of threads.
+        If the number is less than 1, the number of CPUs will be used.
+    */
+    explicit InterprocessConnectionManager (int numberOfThreads = 2);
+
+    /** Destructor.
+        All the connections that were using this manager must have been disconnected or
+        deleted before this is called.
+    */
+    ~InterprocessConnectionManager();
+
+    //==============================================================================
+    /** Returns the number of threads that the manager is running. */
+    int getNumThreads() const noexcept;
+
+    /** Returns the number of connections that are currently using the manager. */
+    int getNumConnections() const;
+
+private:
+    //==============================================================================
+    class IOThread;
+    struct Connection;
+    friend class InterprocessConnection;
+    friend class IOThread;
+    OwnedArray<IOThread> threads;
+
+    bool addConnection (InterprocessConnection&);
+    void removeConnection (InterprocessConnection&);
+    static void handleIncomingData (Connection&, const char* data, int numBytes);
+    static void handleConnectionLost (InterprocessConnection&);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InterprocessConnectionManager)
+};
+
+
+#endif   // __JUCE_INTERPROCESSCONNECTIONMANAGER_JUCEHEADER__
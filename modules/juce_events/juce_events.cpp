@@ -57,6 +57,12 @@
  #include <X11/Xutil.h>
  #undef KeyPress
  #include <unistd.h>
+ #include <sys/eventfd.h>
+ #include <sys/epoll.h>
+ #include <sys/uio.h>
+ #include <poll.h>
+ #include <typeinfo>
+ #include <cxxabi.h>
 #endif
 
 //==============================================================================
@@ -75,6 +81,7 @@ namespace juce
 #include "timers/juce_MultiTimer.cpp"
 #include "timers/juce_Timer.cpp"
 #include "interprocess/juce_InterprocessConnection.cpp"
+#include "interprocess/juce_InterprocessConnectionManager.cpp"
 #include "interprocess/juce_InterprocessConnectionServer.cpp"
 // END_AUTOINCLUDE
 
@@ -82,6 +82,9 @@ namespace juce
 #ifndef __JUCE_INTERPROCESSCONNECTION_JUCEHEADER__
  #include "interprocess/juce_InterprocessConnection.h"
 #endif
+#ifndef __JUCE_INTERPROCESSCONNECTIONMANAGER_JUCEHEADER__
+ #include "interprocess/juce_InterprocessConnectionManager.h"
+#endif
 #ifndef __JUCE_INTERPROCESSCONNECTIONSERVER_JUCEHEADER__
  #include "interprocess/juce_InterprocessConnectionServer.h"
 #endif
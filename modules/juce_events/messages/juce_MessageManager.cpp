@@ -71,7 +71,7 @@ MessageManager* MessageManager::getInstance()
     return instance;
 }
 
-inline MessageManager* MessageManager::getInstanceWithoutCreating() noexcept
+MessageManager* MessageManager::getInstanceWithoutCreating() noexcept
 {
     return instance;
 }
@@ -336,6 +336,9 @@ JUCE_API void JUCE_CALLTYPE shutdownJuce_GUI()
 {
     JUCE_AUTORELEASEPOOL
     {
+        // (this is stopped first, as its listeners may be about to be deleted)
+        URL::shutdownAsyncRequests();
+
         DeletedAtShutdown::deleteAll();
         MessageManager::deleteInstance();
     }
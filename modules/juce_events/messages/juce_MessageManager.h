@@ -159,6 +159,70 @@ public:
     /** Deregisters a broadcast listener. */
     void deregisterBroadcastListener (ActionListener* listener);
 
+   #if JUCE_LINUX || DOXYGEN
+    //==============================================================================
+    /** Describes the messages of one class that have been delivered by the message queue.
+        @see MessageQueueStatistics
+    */
+    struct MessageTypeStatistics
+    {
+        /** The name of the message's class, e.g. "juce::AsyncUpdaterMessage". */
+        String typeName;
+
+        /** The number of messages of this type that have been delivered. */
+        int64 numMessages;
+
+        /** The time between the recent messages being posted and their callbacks starting. */
+        TimingHistory::Statistics latency;
+
+        /** The time taken by the recent messages' callbacks. */
+        TimingHistory::Statistics callbackTime;
+    };
+
+    /** Describes the activity of the message queue.
+        @see getMessageQueueStatistics
+    */
+    struct MessageQueueStatistics
+    {
+        /** The number of messages that have been collected while the statistics were enabled. */
+        int64 numMessages;
+
+        /** The number of times the message thread has collected a batch of waiting messages. */
+        int64 numBatches;
+
+        /** The largest number of messages that were waiting when a batch was collected. */
+        int maxQueueDepth;
+
+        /** The number of messages that have been posted but not yet delivered. */
+        int numPendingMessages;
+
+        /** The details for each class of message. */
+        Array<MessageTypeStatistics> messageTypes;
+    };
+
+    /** Starts or stops the collection of statistics about the message queue.
+
+        While this is enabled, each message is time-stamped when it's posted, and the
+        message thread measures how long it waited and how long its callback took. It's
+        off by default. The setting is remembered if the queue hasn't been created yet.
+        Linux only.
+
+        @see getMessageQueueStatistics
+    */
+    void setMessageQueueStatisticsEnabled (bool shouldBeEnabled);
+
+    /** Returns the statistics that have been gathered about the message queue.
+        This must be called on the message thread. Linux only.
+        @see setMessageQueueStatisticsEnabled, resetMessageQueueStatistics
+    */
+    MessageQueueStatistics getMessageQueueStatistics() const;
+
+    /** Clears the message queue statistics.
+        This must be called on the message thread. Linux only.
+    */
+    void resetMessageQueueStatistics();
+   #endif
+
     //==============================================================================
     /** Internal class used as the base class for all message objects.
         You shouldn't need to use this directly - see the CallbackMessage or Message
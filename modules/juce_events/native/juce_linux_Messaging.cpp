@@ -41,22 +41,37 @@ SelectionRequestCallback handleSelectionRequest = nullptr;
 ScopedXLock::ScopedXLock()       { XLockDisplay (display); }
 ScopedXLock::~ScopedXLock()      { XUnlockDisplay (display); }
 
+// (kept here, so that it can be set before the queue has been created)
+static Atomic<int> messageQueueStatisticsEnabled;
+
 //==============================================================================
+/*  Messages are posted by pushing them onto a lock-free list, and the message thread takes
+    all the waiting ones at once and then delivers them in order. The thread is woken with an
+    eventfd, which only needs to be written to by a post that finds the list empty.
+*/
 class InternalMessageQueue
 {
 public:
     InternalMessageQueue()
-        : bytesInSocket (0),
-          totalEventCount (0)
+        : firstInBatch (nullptr),
+          numInBatch (0),
+          totalEventCount (0),
+          statisticsEnabled (messageQueueStatisticsEnabled.get()),
+          numMessagesCollected (0),
+          numBatchesCollected (0),
+          maxQueueDepth (0)
     {
-        int ret = ::socketpair (AF_LOCAL, SOCK_STREAM, 0, fd);
-        (void) ret; jassert (ret == 0);
+        wakeupFd = eventfd (0, 0);
+        jassert (wakeupFd >= 0);
+        setNonBlocking (wakeupFd);
     }
 
     ~InternalMessageQueue()
     {
-        close (fd[0]);
-        close (fd[1]);
+        deleteList (incoming.exchange (nullptr));
+        deleteList (firstInBatch);
+
+        close (wakeupFd);
 
         clearSingletonInstance();
     }
@@ -64,26 +79,31 @@ public:
     //==============================================================================
     void postMessage (MessageManager::MessageBase* const msg)
     {
-        const int maxBytesInSocketQueue = 128;
+        QueuedMessage* const qm = new QueuedMessage (msg, statisticsEnabled.get() != 0 ? Time::getHighResolutionTicks() : 0);
+        ++numIncoming;
 
-        ScopedLock sl (lock);
-        queue.add (msg);
-
-        if (bytesInSocket < maxBytesInSocketQueue)
+        for (;;)
         {
-            ++bytesInSocket;
+            QueuedMessage* const head = incoming.get();
+            qm->next = head;
 
-            ScopedUnlock ul (lock);
-            const unsigned char x = 0xff;
-            size_t bytesWritten = write (fd[0], &x, 1);
-            (void) bytesWritten;
+            if (incoming.compareAndSetBool (qm, head))
+            {
+                if (head == nullptr)
+                {
+                    const uint64 one = 1;
+                    ssize_t bytesWritten = write (wakeupFd, &one, sizeof (one));
+                    (void) bytesWritten;
+                }
+
+                break;
+            }
         }
     }
 
     bool isEmpty() const
     {
-        ScopedLock sl (lock);
-        return queue.size() == 0;
+        return firstInBatch == nullptr && incoming.get() == nullptr;
     }
 
     bool dispatchNextEvent()
@@ -99,6 +119,12 @@ public:
     // Wait for an event (either XEvent, or an internal Message)
     bool sleepUntilEvent (const int timeoutMs)
     {
+        // The wakeup is cleared before checking for messages, so that anything
+        // posted after the check will be sure to wake us up again..
+        uint64 count;
+        ssize_t bytesRead = read (wakeupFd, &count, sizeof (count));
+        (void) bytesRead;
+
         if (! isEmpty())
             return true;
 
@@ -112,7 +138,7 @@ public:
         struct timeval tv;
         tv.tv_sec = 0;
         tv.tv_usec = timeoutMs * 1000;
-        int fd0 = getWaitHandle();
+        int fd0 = wakeupFd;
         int fdmax = fd0;
 
         fd_set readset;
@@ -131,17 +157,115 @@ public:
         return (ret > 0); // ret <= 0 if error or timeout
     }
 
+    //==============================================================================
+    void setStatisticsEnabled (const bool shouldBeEnabled) noexcept
+    {
+        statisticsEnabled.set (shouldBeEnabled ? 1 : 0);
+    }
+
+    MessageManager::MessageQueueStatistics getStatistics() const
+    {
+        MessageManager::MessageQueueStatistics stats;
+        stats.numMessages = numMessagesCollected;
+        stats.numBatches = numBatchesCollected;
+        stats.maxQueueDepth = maxQueueDepth;
+        stats.numPendingMessages = numInBatch + numIncoming.get();
+
+        for (int i = 0; i < typeStatistics.size(); ++i)
+        {
+            const TypeStatistics& ts = *typeStatistics.getUnchecked (i);
+
+            if (ts.numMessages > 0)
+            {
+                MessageManager::MessageTypeStatistics mts;
+                mts.typeName = ts.getTypeName();
+                mts.numMessages = ts.numMessages;
+                mts.latency = ts.latency.getStatistics();
+                mts.callbackTime = ts.callbackTime.getStatistics();
+                stats.messageTypes.add (mts);
+            }
+        }
+
+        return stats;
+    }
+
+    void resetStatistics()
+    {
+        numMessagesCollected = 0;
+        numBatchesCollected = 0;
+        maxQueueDepth = 0;
+
+        // (these are reset rather than deleted, because this may be called by a
+        // message callback which is in the middle of being measured)
+        for (int i = typeStatistics.size(); --i >= 0;)
+            typeStatistics.getUnchecked (i)->reset();
+    }
+
     //==============================================================================
     juce_DeclareSingleton_SingleThreaded_Minimal (InternalMessageQueue);
 
 private:
-    CriticalSection lock;
-    ReferenceCountedArray <MessageManager::MessageBase> queue;
-    int fd[2];
-    int bytesInSocket;
+    struct QueuedMessage
+    {
+        QueuedMessage (MessageManager::MessageBase* const message_, const int64 postTime_) noexcept
+            : message (message_), postTime (postTime_), next (nullptr)
+        {
+        }
+
+        const MessageManager::MessageBase::Ptr message;
+        const int64 postTime;
+        QueuedMessage* next;
+
+        JUCE_DECLARE_NON_COPYABLE (QueuedMessage)
+    };
+
+    struct TypeStatistics
+    {
+        TypeStatistics (const std::type_info& type_) noexcept  : type (type_), numMessages (0) {}
+
+        void reset() noexcept
+        {
+            numMessages = 0;
+            latency.reset();
+            callbackTime.reset();
+        }
+
+        String getTypeName() const
+        {
+            int status = 0;
+            char* const demangled = abi::__cxa_demangle (type.name(), nullptr, nullptr, &status);
+
+            if (demangled == nullptr)
+                return type.name();
+
+            const String name (demangled);
+            ::free (demangled);
+            return name;
+        }
+
+        const std::type_info& type;
+        int64 numMessages;
+        TimingHistory latency, callbackTime;
+
+        JUCE_DECLARE_NON_COPYABLE (TypeStatistics)
+    };
+
+    // Posted messages, most recent first. Any thread can push onto this, but only the
+    // message thread takes things off it, and it always takes the whole list.
+    Atomic<QueuedMessage*> incoming;
+    Atomic<int> numIncoming;
+
+    // The messages that the message thread has taken, in the order they were posted.
+    QueuedMessage* firstInBatch;
+    int numInBatch;
+
+    int wakeupFd;
     int totalEventCount;
 
-    int getWaitHandle() const noexcept      { return fd[1]; }
+    Atomic<int> statisticsEnabled;
+    int64 numMessagesCollected, numBatchesCollected;
+    int maxQueueDepth;
+    OwnedArray<TypeStatistics> typeStatistics;
 
     static bool setNonBlocking (int handle)
     {
@@ -153,6 +277,16 @@ private:
         return fcntl (handle, F_SETFL, socketFlags) == 0;
     }
 
+    static void deleteList (QueuedMessage* qm)
+    {
+        while (qm != nullptr)
+        {
+            QueuedMessage* const next = qm->next;
+            delete qm;
+            qm = next;
+        }
+    }
+
     static bool dispatchNextXEvent()
     {
         if (display == 0)
@@ -177,36 +311,97 @@ private:
         return true;
     }
 
-    MessageManager::MessageBase::Ptr popNextMessage()
+    void collectIncomingMessages()
+    {
+        // Reverse the list that was taken, to put the messages back into the order in which they were posted
+        QueuedMessage* qm = incoming.exchange (nullptr);
+        int num = 0;
+
+        while (qm != nullptr)
+        {
+            QueuedMessage* const next = qm->next;
+            qm->next = firstInBatch;
+            firstInBatch = qm;
+            qm = next;
+            ++num;
+        }
+
+        numInBatch = num;
+        numIncoming -= num;
+
+        if (statisticsEnabled.get() != 0 && num > 0)
+        {
+            numMessagesCollected += num;
+            ++numBatchesCollected;
+            maxQueueDepth = jmax (maxQueueDepth, num);
+        }
+    }
+
+    QueuedMessage* popNextMessage() noexcept
     {
-        const ScopedLock sl (lock);
+        if (firstInBatch == nullptr)
+            collectIncomingMessages();
+
+        QueuedMessage* const qm = firstInBatch;
 
-        if (bytesInSocket > 0)
+        if (qm != nullptr)
+        {
+            firstInBatch = qm->next;
+            --numInBatch;
+        }
+
+        return qm;
+    }
+
+    TypeStatistics& getStatisticsFor (const std::type_info& type)
+    {
+        for (int i = typeStatistics.size(); --i >= 0;)
         {
-            --bytesInSocket;
+            TypeStatistics* const ts = typeStatistics.getUnchecked (i);
 
-            const ScopedUnlock ul (lock);
-            unsigned char x;
-            size_t numBytes = read (fd[1], &x, 1);
-            (void) numBytes;
+            if (ts->type == type)
+                return *ts;
         }
 
-        return queue.removeAndReturn (0);
+        TypeStatistics* const ts = new TypeStatistics (type);
+        typeStatistics.add (ts);
+        return *ts;
     }
 
     bool dispatchNextInternalMessage()
     {
-        if (const MessageManager::MessageBase::Ptr msg = popNextMessage())
+        const ScopedPointer<QueuedMessage> qm (popNextMessage());
+
+        if (qm == nullptr)
+            return false;
+
+        MessageManager::MessageBase* const message = qm->message;
+        TypeStatistics* stats = nullptr;
+        int64 startTime = 0;
+
+        if (qm->postTime != 0 && statisticsEnabled.get() != 0)
         {
-            JUCE_TRY
-            {
-                msg->messageCallback();
-                return true;
-            }
-            JUCE_CATCH_EXCEPTION
+            stats = &getStatisticsFor (typeid (*message));
+            startTime = Time::getHighResolutionTicks();
+            stats->latency.addMeasurement (startTime - qm->postTime);
         }
 
-        return false;
+        bool delivered = false;
+
+        JUCE_TRY
+        {
+            message->messageCallback();
+            delivered = true;
+        }
+        JUCE_CATCH_EXCEPTION
+
+        if (stats != nullptr)
+        {
+            stats->callbackTime.addMeasurement (Time::getHighResolutionTicks() - startTime);
+            ++(stats->numMessages);
+        }
+
+        return delivered;
     }
 };
 
@@ -354,6 +549,35 @@ void MessageManager::doPlatformSpecificShutdown()
     }
 }
 
+void MessageManager::setMessageQueueStatisticsEnabled (const bool shouldBeEnabled)
+{
+    messageQueueStatisticsEnabled.set (shouldBeEnabled ? 1 : 0);
+
+    if (InternalMessageQueue* const queue = InternalMessageQueue::getInstanceWithoutCreating())
+        queue->setStatisticsEnabled (shouldBeEnabled);
+}
+
+MessageManager::MessageQueueStatistics MessageManager::getMessageQueueStatistics() const
+{
+    jassert (isThisTheMessageThread()); // the queue's statistics are only updated by the message thread
+
+    if (InternalMessageQueue* const queue = InternalMessageQueue::getInstanceWithoutCreating())
+        return queue->getStatistics();
+
+    MessageQueueStatistics stats;
+    stats.numMessages = stats.numBatches = 0;
+    stats.maxQueueDepth = stats.numPendingMessages = 0;
+    return stats;
+}
+
+void MessageManager::resetMessageQueueStatistics()
+{
+    jassert (isThisTheMessageThread()); // the queue's statistics are only updated by the message thread
+
+    if (InternalMessageQueue* const queue = InternalMessageQueue::getInstanceWithoutCreating())
+        queue->resetStatistics();
+}
+
 bool MessageManager::postMessageToSystemQueue (MessageManager::MessageBase* const message)
 {
     if (LinuxErrorHandling::errorOccurred)
@@ -397,3 +621,224 @@ bool MessageManager::dispatchNextMessageOnSystemQueue (bool returnIfNoPendingMes
 
     return false;
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class InternalMessageQueueTests  : public UnitTest
+{
+public:
+    InternalMessageQueueTests() : UnitTest ("InternalMessageQueue") {}
+
+    class TestMessage  : public MessageManager::MessageBase
+    {
+    public:
+        TestMessage (Array<int>& delivered_, const int number_, WaitableEvent* const deliveredEvent_ = nullptr)
+            : delivered (delivered_), number (number_), deliveredEvent (deliveredEvent_)
+        {
+        }
+
+        void messageCallback()
+        {
+            delivered.add (number);
+
+            if (deliveredEvent != nullptr)
+                deliveredEvent->signal();
+        }
+
+    private:
+        Array<int>& delivered;
+        const int number;
+        WaitableEvent* const deliveredEvent;
+    };
+
+    class PostingThread  : public Thread
+    {
+    public:
+        PostingThread (InternalMessageQueue& queue_, Array<int>& delivered_, const int firstNumber_,
+                       const int numMessages_, WaitableEvent* const deliveredEvent_)
+            : Thread ("message posting test"), queue (queue_), delivered (delivered_),
+              firstNumber (firstNumber_), numMessages (numMessages_), deliveredEvent (deliveredEvent_),
+              numTimeouts (0)
+        {
+        }
+
+        void run()
+        {
+            Random r (firstNumber);
+
+            for (int i = 0; i < numMessages; ++i)
+            {
+                queue.postMessage (new TestMessage (delivered, firstNumber + i, deliveredEvent));
+
+                // With an event to wait for, each message is posted to an empty queue, so has
+                // to wake the message thread. Otherwise, the pauses let the queue drain now and then.
+                if (deliveredEvent != nullptr)
+                {
+                    if (! deliveredEvent->wait (5000))
+                        ++numTimeouts;
+                }
+                else if (r.nextInt (500) == 0)
+                {
+                    Thread::sleep (1);
+                }
+            }
+        }
+
+        InternalMessageQueue& queue;
+        Array<int>& delivered;
+        const int firstNumber, numMessages;
+        WaitableEvent* const deliveredEvent;
+        int numTimeouts;
+    };
+
+    // acts as the message thread until the expected number of messages have arrived
+    void dispatchMessages (InternalMessageQueue& queue, const Array<int>& delivered,
+                           const int numExpected, int& numSleepsTimedOut)
+    {
+        const uint32 endTime = Time::getMillisecondCounter() + 30000;
+
+        while (delivered.size() < numExpected && Time::getMillisecondCounter() < endTime)
+            if (! queue.dispatchNextEvent())
+                if (! queue.sleepUntilEvent (1000))
+                    ++numSleepsTimedOut;
+    }
+
+    void runTest()
+    {
+        beginTest ("Posting from several threads");
+        {
+            InternalMessageQueue queue;
+            Array<int> delivered;
+            OwnedArray<PostingThread> threads;
+
+            const int numThreads = 4, numPerThread = 20000;
+
+            for (int i = 0; i < numThreads; ++i)
+                threads.add (new PostingThread (queue, delivered, i * numPerThread, numPerThread, nullptr));
+
+            for (int i = 0; i < numThreads; ++i)
+                threads.getUnchecked (i)->startThread();
+
+            int numSleepsTimedOut = 0;
+            dispatchMessages (queue, delivered, numThreads * numPerThread, numSleepsTimedOut);
+
+            for (int i = 0; i < numThreads; ++i)
+                threads.getUnchecked (i)->stopThread (5000);
+
+            expectEquals (delivered.size(), numThreads * numPerThread);
+            expect (queue.isEmpty());
+
+            // each thread's messages must arrive in the order it posted them
+            HeapBlock<int> nextExpected ((size_t) numThreads);
+
+            for (int i = 0; i < numThreads; ++i)
+                nextExpected[i] = i * numPerThread;
+
+            int numOutOfOrder = 0;
+
+            for (int i = 0; i < delivered.size(); ++i)
+            {
+                const int n = delivered.getUnchecked (i);
+                int& expected = nextExpected [n / numPerThread];
+
+                if (n != expected)
+                    ++numOutOfOrder;
+
+                expected = n + 1;
+            }
+
+            expectEquals (numOutOfOrder, 0);
+        }
+
+        beginTest ("No lost wakeups");
+        {
+            InternalMessageQueue queue;
+            Array<int> delivered;
+            WaitableEvent deliveredEvent;
+
+            const int numMessages = 2000;
+            PostingThread poster (queue, delivered, 0, numMessages, &deliveredEvent);
+            poster.startThread();
+
+            // Every message is posted while this thread is asleep waiting for one, so if a
+            // wakeup went missing, the sleep would time out..
+            int numSleepsTimedOut = 0;
+            dispatchMessages (queue, delivered, numMessages, numSleepsTimedOut);
+            poster.stopThread (10000);
+
+            expectEquals (delivered.size(), numMessages);
+            expectEquals (numSleepsTimedOut, 0);
+            expectEquals (poster.numTimeouts, 0);
+        }
+
+        beginTest ("Statistics");
+        {
+            InternalMessageQueue queue;
+            Array<int> delivered;
+
+            const int numMessages = 100;
+            int numSleepsTimedOut = 0;
+
+            queue.setStatisticsEnabled (true);
+
+            for (int i = 0; i < numMessages; ++i)
+                queue.postMessage (new TestMessage (delivered, i));
+
+            MessageManager::MessageQueueStatistics stats (queue.getStatistics());
+            expectEquals (stats.numPendingMessages, numMessages);
+
+            dispatchMessages (queue, delivered, numMessages, numSleepsTimedOut);
+            stats = queue.getStatistics();
+
+            expectEquals ((int) stats.numMessages, numMessages);
+            expectEquals ((int) stats.numBatches, 1);
+            expectEquals (stats.maxQueueDepth, numMessages);
+            expectEquals (stats.numPendingMessages, 0);
+            expectEquals (stats.messageTypes.size(), 1);
+            expect (stats.messageTypes.getReference (0).typeName.contains ("TestMessage"));
+            expectEquals ((int) stats.messageTypes.getReference (0).numMessages, numMessages);
+
+            queue.resetStatistics();
+            stats = queue.getStatistics();
+            expectEquals ((int) stats.numMessages, 0);
+            expectEquals (stats.messageTypes.size(), 0);
+
+            // nothing is measured while the statistics are disabled..
+            queue.setStatisticsEnabled (false);
+            delivered.clear();
+
+            for (int i = 0; i < numMessages; ++i)
+                queue.postMessage (new TestMessage (delivered, i));
+
+            dispatchMessages (queue, delivered, numMessages, numSleepsTimedOut);
+            stats = queue.getStatistics();
+
+            expectEquals (delivered.size(), numMessages);
+            expectEquals ((int) stats.numMessages, 0);
+            expectEquals (stats.messageTypes.size(), 0);
+        }
+
+        beginTest ("Statistics setting is remembered");
+        {
+            MessageManager::getInstance()->setMessageQueueStatisticsEnabled (true);
+
+            {
+                InternalMessageQueue queue;
+                Array<int> delivered;
+                int numSleepsTimedOut = 0;
+
+                queue.postMessage (new TestMessage (delivered, 0));
+                dispatchMessages (queue, delivered, 1, numSleepsTimedOut);
+
+                expectEquals ((int) queue.getStatistics().numMessages, 1);
+            }
+
+            MessageManager::getInstance()->setMessageQueueStatisticsEnabled (false);
+        }
+    }
+};
+
+static InternalMessageQueueTests internalMessageQueueTests;
+
+#endif
@@ -23,6 +23,16 @@
   ==============================================================================
 */
 
+/*  The running timers are kept in a hierarchical timing wheel, so that starting, stopping or
+    rescheduling a timer takes constant time, however many timers there are.
+
+    The first level of the wheel has a bucket for each of the next 256 milliseconds, and each
+    of the other levels has 64 buckets which each cover 64 times as long as one of the level
+    below's. As the wheel turns, the timers in an upper-level bucket are moved down into the
+    level below when their time comes near. The timers in the current bottom-level bucket are
+    due, so they're moved onto a list, and all of the timers on that list are called by a
+    single message.
+*/
 class Timer::TimerThread  : private Thread,
                             private DeletedAtShutdown,
                             private AsyncUpdater
@@ -32,7 +42,8 @@ public:
 
     TimerThread()
         : Thread ("Juce Timer"),
-          firstTimer (nullptr),
+          wheel (Time::getMillisecondCounter()),
+          threadWakeTime (wheel.getNextTick()),
           callbackNeeded (0)
     {
         triggerAsyncUpdate();
@@ -49,24 +60,12 @@ public:
 
     void run()
     {
-        uint32 lastTime = Time::getMillisecondCounter();
         MessageManager::MessageBase::Ptr messageToSend (new CallTimersMessage());
 
         while (! threadShouldExit())
         {
             const uint32 now = Time::getMillisecondCounter();
-
-            if (now == lastTime)
-            {
-                wait (1);
-                continue;
-            }
-
-            const int elapsed = (int) (now >= lastTime ? (now - lastTime)
-                                                       : (std::numeric_limits<uint32>::max() - (lastTime - now)));
-            lastTime = now;
-
-            const int timeUntilFirstTimer = getTimeUntilFirstTimer (elapsed);
+            const int timeUntilFirstTimer = advanceTo (now);
 
             if (timeUntilFirstTimer <= 0)
             {
@@ -99,6 +98,10 @@ public:
                         }
                     }
                 }
+                else
+                {
+                    wait (1);
+                }
             }
             else
             {
@@ -113,12 +116,10 @@ public:
     {
         const LockType::ScopedLockType sl (lock);
 
-        while (firstTimer != nullptr && firstTimer->countdownMs <= 0)
+        while (Timer* const t = wheel.getFirstDueTimer())
         {
-            Timer* const t = firstTimer;
-            t->countdownMs = t->periodMs;
-
             removeTimer (t);
+            t->dueTimeMs = Time::getMillisecondCounter() + (uint32) t->periodMs;
             addTimer (t);
 
             const LockType::ScopedUnlockType ul (lock);
@@ -170,23 +171,223 @@ public:
     {
         if (instance != nullptr)
         {
-            tim->countdownMs = newCounter;
+            tim->dueTimeMs = Time::getMillisecondCounter() + (uint32) newCounter;
             tim->periodMs = newCounter;
 
-            if ((tim->next != nullptr && tim->next->countdownMs < tim->countdownMs)
-                 || (tim->previous != nullptr && tim->previous->countdownMs > tim->countdownMs))
-            {
-                instance->removeTimer (tim);
-                instance->addTimer (tim);
-            }
+            instance->removeTimer (tim);
+            instance->addTimer (tim);
         }
     }
 
     static TimerThread* instance;
     static LockType lock;
 
+   #if JUCE_UNIT_TESTS
+    class WheelTests;
+   #endif
+
 private:
-    Timer* volatile firstTimer;
+    //==============================================================================
+    /* The timing wheel itself, which knows nothing about threads or the real time, so
+       that it can be turned by hand.
+    */
+    class Wheel
+    {
+    public:
+        Wheel (const uint32 startTime) noexcept
+            : nextTick (startTime), lastDueTimer (nullptr), numTimers (0)
+        {
+            zeromem (buckets, sizeof (buckets));
+        }
+
+        uint32 getNextTick() const noexcept         { return nextTick; }
+        Timer* getFirstDueTimer() const noexcept    { return buckets [dueBucket]; }
+
+        void add (Timer* const t) noexcept
+        {
+            insertIntoBucket (t, getBucketForTime (t->dueTimeMs));
+            ++numTimers;
+        }
+
+        void remove (Timer* const t) noexcept
+        {
+            if (t->previous != nullptr)
+            {
+                jassert (buckets [t->bucketIndex] != t);
+                t->previous->next = t->next;
+            }
+            else
+            {
+                jassert (buckets [t->bucketIndex] == t);
+                buckets [t->bucketIndex] = t->next;
+            }
+
+            if (t->next != nullptr)
+                t->next->previous = t->previous;
+            else if (t == lastDueTimer)
+                lastDueTimer = t->previous;
+
+            t->next = nullptr;
+            t->previous = nullptr;
+            t->bucketIndex = -1;
+            --numTimers;
+        }
+
+        // Turns the wheel up to the given time, and returns the number of milliseconds until
+        // the next timer will be due (or zero if some timers are due now).
+        int advanceTo (const uint32 now) noexcept
+        {
+            while ((int) (now - nextTick) >= 0)
+                processTick();
+
+            if (buckets [dueBucket] != nullptr)
+                return 0;
+
+            if (numTimers == 0)
+                return 1000;
+
+            // Look through the bottom level as far as the point where it'll be refilled from above
+            const int ticksUntilWrap = level0Size - (int) (nextTick & (level0Size - 1));
+
+            for (int i = 0; i < ticksUntilWrap; ++i)
+                if (buckets [(nextTick + (uint32) i) & (level0Size - 1)] != nullptr)
+                    return i + 1;
+
+            return ticksUntilWrap;
+        }
+
+        bool contains (Timer* const t) const noexcept
+        {
+            if (isPositiveAndBelow (t->bucketIndex, (int) numBuckets))
+                for (Timer* tt = buckets [t->bucketIndex]; tt != nullptr; tt = tt->next)
+                    if (tt == t)
+                        return true;
+
+            return false;
+        }
+
+    private:
+        enum
+        {
+            level0Bits = 8,
+            levelNBits = 6,
+            numLevels = 4,
+            level0Size = 1 << level0Bits,
+            levelNSize = 1 << levelNBits,
+            dueBucket = level0Size + (numLevels - 1) * levelNSize,
+            numBuckets = dueBucket + 1,
+            maxTicksAhead = (1 << (level0Bits + (numLevels - 1) * levelNBits)) - 1
+        };
+
+        // Each bucket is a doubly-linked list of timers, using their previous and next pointers.
+        // The last one holds the timers that are due, in the order they became due.
+        Timer* buckets [numBuckets];
+        uint32 nextTick;
+        Timer* lastDueTimer;
+        int numTimers;
+
+        int getBucketForTime (const uint32 dueTime) const noexcept
+        {
+            const int ticksAhead = (int) (dueTime - nextTick);
+
+            if (ticksAhead < 0)
+                return (int) (nextTick & (level0Size - 1)); // (overdue, so it'll be called on the next tick)
+
+            if (ticksAhead < level0Size)
+                return (int) (dueTime & (level0Size - 1));
+
+            const uint32 time = ticksAhead > maxTicksAhead ? nextTick + (uint32) maxTicksAhead : dueTime;
+            int shift = level0Bits;
+
+            for (int level = 1;; ++level)
+            {
+                if (level == numLevels - 1 || ((uint32) ticksAhead >> (shift + levelNBits)) == 0)
+                    return level0Size + (level - 1) * levelNSize + (int) ((time >> shift) & (levelNSize - 1));
+
+                shift += levelNBits;
+            }
+        }
+
+        void insertIntoBucket (Timer* const t, const int bucket) noexcept
+        {
+            t->bucketIndex = bucket;
+            t->previous = nullptr;
+            t->next = buckets [bucket];
+
+            if (t->next != nullptr)
+                t->next->previous = t;
+
+            buckets [bucket] = t;
+        }
+
+        void appendToDueList (Timer* const t) noexcept
+        {
+            t->bucketIndex = dueBucket;
+            t->next = nullptr;
+            t->previous = lastDueTimer;
+
+            if (lastDueTimer != nullptr)
+                lastDueTimer->next = t;
+            else
+                buckets [dueBucket] = t;
+
+            lastDueTimer = t;
+        }
+
+        // Moves all the timers in a bucket back into the wheel, which puts them into lower levels
+        void cascade (const int bucket) noexcept
+        {
+            Timer* t = buckets [bucket];
+            buckets [bucket] = nullptr;
+
+            while (t != nullptr)
+            {
+                Timer* const next = t->next;
+                insertIntoBucket (t, getBucketForTime (t->dueTimeMs));
+                t = next;
+            }
+        }
+
+        void processTick() noexcept
+        {
+            const int index = (int) (nextTick & (level0Size - 1));
+
+            if (index == 0)
+            {
+                // when the bottom level wraps around, the next bucket up is moved down into it,
+                // and so on up through the levels..
+                int shift = level0Bits;
+
+                for (int level = 1; level < numLevels; ++level)
+                {
+                    const int upperIndex = (int) ((nextTick >> shift) & (levelNSize - 1));
+                    cascade (level0Size + (level - 1) * levelNSize + upperIndex);
+
+                    if (upperIndex != 0)
+                        break;
+
+                    shift += levelNBits;
+                }
+            }
+
+            Timer* t = buckets [index];
+            buckets [index] = nullptr;
+
+            while (t != nullptr)
+            {
+                Timer* const next = t->next;
+                appendToDueList (t);
+                t = next;
+            }
+
+            ++nextTick;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (Wheel)
+    };
+
+    Wheel wheel;
+    uint32 threadWakeTime;
     Atomic <int> callbackNeeded;
 
     struct CallTimersMessage  : public MessageManager::MessageBase
@@ -203,74 +404,33 @@ private:
     //==============================================================================
     void addTimer (Timer* const t) noexcept
     {
-       #if JUCE_DEBUG
         // trying to add a timer that's already here - shouldn't get to this point,
         // so if you get this assertion, let me know!
-        jassert (! timerExists (t));
-       #endif
-
-        Timer* i = firstTimer;
-
-        if (i == nullptr || i->countdownMs > t->countdownMs)
-        {
-            t->next = firstTimer;
-            firstTimer = t;
-        }
-        else
-        {
-            while (i->next != nullptr && i->next->countdownMs <= t->countdownMs)
-                i = i->next;
-
-            jassert (i != nullptr);
-
-            t->next = i->next;
-            t->previous = i;
-            i->next = t;
-        }
-
-        if (t->next != nullptr)
-            t->next->previous = t;
+        jassert (! wheel.contains (t));
 
-        jassert ((t->next == nullptr || t->next->countdownMs >= t->countdownMs)
-                  && (t->previous == nullptr || t->previous->countdownMs <= t->countdownMs));
+        wheel.add (t);
 
-        notify();
+        // (only wake the thread if it's going to sleep past the time this timer's due)
+        if ((int) (t->dueTimeMs - threadWakeTime) < 0)
+            notify();
     }
 
     void removeTimer (Timer* const t) noexcept
     {
-       #if JUCE_DEBUG
         // trying to remove a timer that's not here - shouldn't get to this point,
         // so if you get this assertion, let me know!
-        jassert (timerExists (t));
-       #endif
-
-        if (t->previous != nullptr)
-        {
-            jassert (firstTimer != t);
-            t->previous->next = t->next;
-        }
-        else
-        {
-            jassert (firstTimer == t);
-            firstTimer = t->next;
-        }
-
-        if (t->next != nullptr)
-            t->next->previous = t->previous;
+        jassert (wheel.contains (t));
 
-        t->next = nullptr;
-        t->previous = nullptr;
+        wheel.remove (t);
     }
 
-    int getTimeUntilFirstTimer (const int numMillisecsElapsed) const
+    int advanceTo (const uint32 now)
     {
         const LockType::ScopedLockType sl (lock);
 
-        for (Timer* t = firstTimer; t != nullptr; t = t->next)
-            t->countdownMs -= numMillisecsElapsed;
-
-        return firstTimer != nullptr ? firstTimer->countdownMs : 1000;
+        const int timeUntilFirstTimer = wheel.advanceTo (now);
+        threadWakeTime = now + (uint32) jlimit (0, 50, timeUntilFirstTimer);
+        return timeUntilFirstTimer;
     }
 
     void handleAsyncUpdate()
@@ -278,17 +438,6 @@ private:
         startThread (7);
     }
 
-   #if JUCE_DEBUG
-    bool timerExists (Timer* const t) const noexcept
-    {
-        for (Timer* tt = firstTimer; tt != nullptr; tt = tt->next)
-            if (tt == t)
-                return true;
-
-        return false;
-    }
-   #endif
-
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimerThread)
 };
 
@@ -301,8 +450,9 @@ static SortedSet <Timer*> activeTimers;
 #endif
 
 Timer::Timer() noexcept
-   : countdownMs (0),
+   : dueTimeMs (0),
      periodMs (0),
+     bucketIndex (-1),
      previous (nullptr),
      next (nullptr)
 {
@@ -313,8 +463,9 @@ Timer::Timer() noexcept
 }
 
 Timer::Timer (const Timer&) noexcept
-   : countdownMs (0),
+   : dueTimeMs (0),
      periodMs (0),
+     bucketIndex (-1),
      previous (nullptr),
      next (nullptr)
 {
@@ -344,7 +495,7 @@ void Timer::startTimer (const int interval) noexcept
 
     if (periodMs == 0)
     {
-        countdownMs = interval;
+        dueTimeMs = Time::getMillisecondCounter() + (uint32) interval;
         periodMs = jmax (1, interval);
         TimerThread::add (this);
     }
@@ -375,3 +526,265 @@ void JUCE_CALLTYPE Timer::callPendingTimersSynchronously()
     if (TimerThread::instance != nullptr)
         TimerThread::instance->callTimersSynchronously();
 }
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+class Timer::TimerThread::WheelTests  : public UnitTest
+{
+public:
+    WheelTests() : UnitTest ("Timers") {}
+
+    // These are never started, they just get put into a wheel that the test turns by hand
+    struct TestTimer  : public Timer
+    {
+        TestTimer (const int period_) : period (period_), numCalls (0), isOverdue (false) {}
+        void timerCallback() {}
+
+        const int period;
+        int numCalls;
+        bool isOverdue;
+    };
+
+    void addToWheel (Wheel& wheel, TestTimer* const t, const uint32 dueTime)
+    {
+        t->dueTimeMs = dueTime;
+        t->isOverdue = (int) (dueTime - wheel.getNextTick()) < 0;
+        wheel.add (t);
+    }
+
+    /* Turns the wheel forward in random steps of up to maxStep milliseconds, and calls the timers
+       that become due, restarting those that have a period. A timer must be called by the first
+       step that reaches its due time, or by the next step if it was added after its due time.
+    */
+    void turnWheel (Wheel& wheel, uint32& now, const uint32 endTime, const int maxStep)
+    {
+        while ((int) (endTime - now) > 0)
+        {
+            const uint32 previous = now;
+            now += (uint32) jmin ((int) (endTime - now), 1 + random.nextInt (maxStep));
+
+            if (wheel.advanceTo (now) < 0)
+                ++numBadWaits;
+
+            while (TestTimer* const t = static_cast <TestTimer*> (wheel.getFirstDueTimer()))
+            {
+                wheel.remove (t);
+                ++(t->numCalls);
+                ++numCalls;
+
+                if ((int) (now - t->dueTimeMs) < 0)
+                    ++numEarly;
+                else if ((int) (t->dueTimeMs - previous) <= 0 && ! t->isOverdue)
+                    ++numMissed;
+
+                if (t->period > 0)
+                    addToWheel (wheel, t, now + (uint32) t->period);
+            }
+        }
+    }
+
+    void expectNoneMissed (const Wheel& wheel, const OwnedArray<TestTimer>& timers, const uint32 now)
+    {
+        expectEquals (numEarly, 0);
+        expectEquals (numMissed, 0);
+        expectEquals (numBadWaits, 0);
+
+        for (int i = 0; i < timers.size(); ++i)
+        {
+            const TestTimer* const t = timers.getUnchecked (i);
+
+            if (t->bucketIndex >= 0)
+                expect ((int) (t->dueTimeMs - now) > 0, "a timer that's due hasn't been called");
+
+            expect (t->bucketIndex < 0 || wheel.contains (const_cast <TestTimer*> (t)));
+        }
+    }
+
+    void clearWheel (Wheel& wheel, OwnedArray<TestTimer>& timers)
+    {
+        for (int i = 0; i < timers.size(); ++i)
+            if (timers.getUnchecked (i)->bucketIndex >= 0)
+                wheel.remove (timers.getUnchecked (i));
+
+        timers.clear();
+        numCalls = numEarly = numMissed = numBadWaits = 0;
+    }
+
+    void runTest()
+    {
+        OwnedArray<TestTimer> timers;
+        numCalls = numEarly = numMissed = numBadWaits = 0;
+
+        beginTest ("Wheel: level boundaries");
+        {
+            // Every timer here is due a millisecond either side of a point where an upper level
+            // cascades into the one below, and the wheel is turned a tick at a time, so each one
+            // has to be called at exactly its due time.
+            const uint32 startTime = 0xffff0000 + 123;
+            uint32 now = startTime;
+            Wheel wheel (now);
+
+            const int boundaryBits[] = { 8, 14, 20, 26 };
+
+            for (int i = 0; i < numElementsInArray (boundaryBits); ++i)
+            {
+                const uint32 boundary = ((startTime >> boundaryBits[i]) + 1) << boundaryBits[i];
+
+                for (int offset = -1; offset <= 1; ++offset)
+                {
+                    TestTimer* const t = new TestTimer (0);
+                    timers.add (t);
+                    addToWheel (wheel, t, boundary + (uint32) offset);
+                }
+            }
+
+            turnWheel (wheel, now, startTime + (1u << 26) + 10, 1);
+
+            expectEquals (numCalls, timers.size());
+            expectNoneMissed (wheel, timers, now);
+            clearWheel (wheel, timers);
+        }
+
+        beginTest ("Wheel: wrapping around");
+        {
+            uint32 now = 0xffffffff - 3000;
+            Wheel wheel (now);
+
+            for (int i = 0; i < 1000; ++i)
+            {
+                TestTimer* const t = new TestTimer (1 + random.nextInt (i < 500 ? 300 : 20000));
+                timers.add (t);
+                addToWheel (wheel, t, now + (uint32) t->period);
+            }
+
+            turnWheel (wheel, now, now + 60000, 1);
+            expectNoneMissed (wheel, timers, now);
+            turnWheel (wheel, now, now + 60000, 40);
+            expectNoneMissed (wheel, timers, now);
+
+            for (int i = 0; i < timers.size(); ++i)
+                expect (timers.getUnchecked (i)->numCalls > 0);
+
+            clearWheel (wheel, timers);
+        }
+
+        beginTest ("Wheel: overdue timers");
+        {
+            uint32 now = 5000;
+            Wheel wheel (now);
+            wheel.advanceTo (now);
+
+            for (int i = 0; i < 10; ++i)
+            {
+                TestTimer* const t = new TestTimer (0);
+                timers.add (t);
+                addToWheel (wheel, t, now - (uint32) (i * 100));
+            }
+
+            expectEquals (wheel.advanceTo (now + 1), 0);
+
+            turnWheel (wheel, now, now + 1, 1);
+            expectEquals (numCalls, timers.size());
+            expectNoneMissed (wheel, timers, now);
+            clearWheel (wheel, timers);
+        }
+
+        beginTest ("Wheel: long periods");
+        {
+            // 16.5 seconds is beyond the first upper level, and 19 and 25 hours are beyond the
+            // top of the wheel, so they have to go round it more than once
+            const int periods[] = { 1000, 16500, 70000, 3600 * 1000, 19 * 3600 * 1000, 25 * 3600 * 1000 };
+
+            uint32 now = 0xfff00000;
+            Wheel wheel (now);
+
+            for (int i = 0; i < numElementsInArray (periods); ++i)
+            {
+                TestTimer* const t = new TestTimer (periods[i]);
+                timers.add (t);
+                addToWheel (wheel, t, now + (uint32) t->period);
+            }
+
+            const int duration = 26 * 3600 * 1000, maxStep = 50;
+            turnWheel (wheel, now, now + (uint32) duration, maxStep);
+
+            expectNoneMissed (wheel, timers, now);
+
+            // (each timer's restarted when it's called, so the steps make its period a bit longer)
+            for (int i = 0; i < timers.size(); ++i)
+            {
+                expect (timers.getUnchecked (i)->numCalls <= duration / periods[i]);
+                expect (timers.getUnchecked (i)->numCalls >= duration / (periods[i] + maxStep));
+            }
+
+            clearWheel (wheel, timers);
+        }
+
+       #if JUCE_MODAL_LOOPS_PERMITTED
+        beginTest ("10000 timers");
+        {
+            // A benchmark, as well as a test: it runs lots of real timers for a few seconds,
+            // and logs how many were called and how much CPU the process used.
+            OwnedArray<CountingTimer> countingTimers;
+
+            for (int i = 0; i < 10000; ++i)
+                countingTimers.add (new CountingTimer (10 + random.nextInt (90)));
+
+            const clock_t startClock = clock();
+
+            for (int i = 0; i < countingTimers.size(); ++i)
+                countingTimers.getUnchecked (i)->start();
+
+            MessageManager::getInstance()->runDispatchLoopUntil (3000);
+            countingTimers.clear();
+
+            const double cpuMs = (clock() - startClock) * 1000.0 / CLOCKS_PER_SEC;
+
+            logMessage ("Timer callbacks: " + String (CountingTimer::totalCalls.get())
+                         + ", process CPU: " + String (roundToInt (cpuMs)) + " ms");
+
+            expect (CountingTimer::totalCalls.get() > 0);
+            expectEquals (CountingTimer::numEarly.get(), 0);
+        }
+       #endif
+    }
+
+private:
+    Random random;
+    int numCalls, numEarly, numMissed, numBadWaits;
+
+    struct CountingTimer  : public Timer
+    {
+        CountingTimer (const int period_) : period (period_), expectedDueTime (0) {}
+
+        void start()
+        {
+            startTimer (period);
+            expectedDueTime = dueTimeMs;
+        }
+
+        void timerCallback()
+        {
+            if ((int) (Time::getMillisecondCounter() - expectedDueTime) < 0)
+                ++numEarly;
+
+            // (by now, the timer's already been given the time of its next call)
+            expectedDueTime = dueTimeMs;
+            ++totalCalls;
+        }
+
+        const int period;
+        uint32 expectedDueTime;
+
+        static Atomic<int> totalCalls, numEarly;
+    };
+
+    static WheelTests instance;
+};
+
+Atomic<int> Timer::TimerThread::WheelTests::CountingTimer::totalCalls;
+Atomic<int> Timer::TimerThread::WheelTests::CountingTimer::numEarly;
+Timer::TimerThread::WheelTests Timer::TimerThread::WheelTests::instance;
+
+#endif
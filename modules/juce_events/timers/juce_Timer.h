@@ -125,7 +125,8 @@ public:
 private:
     class TimerThread;
     friend class TimerThread;
-    int countdownMs, periodMs;
+    uint32 dueTimeMs;
+    int periodMs, bucketIndex;
     Timer* previous;
     Timer* next;
 